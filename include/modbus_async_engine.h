@@ -0,0 +1,202 @@
+// include/modbus_async_engine.h
+
+#ifndef MODBUS_ASYNC_ENGINE_H
+#define MODBUS_ASYNC_ENGINE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace test_modbus_485 {
+
+/**
+ * @brief Outcome of one asynchronous transaction.
+ */
+struct ModbusAsyncResult {
+    int                      errorCode;  ///< 0 on success, otherwise an errno / libmodbus EMB* code.
+    std::vector<uint8_t>     response;   ///< Response PDU (function code + data) on success.
+    std::chrono::nanoseconds latency;    ///< Submission to completion.
+};
+
+/**
+ * @brief Line and timeout settings of one port.
+ */
+struct ModbusAsyncPortOptions {
+    int                       baudRate = 115200;
+    int                       bitsPerCharacter = 11;      ///< Start + data + parity/stop bits.
+    std::chrono::microseconds responseTimeout{500000};    ///< From end of request to first byte.
+    std::chrono::microseconds byteTimeout{0};             ///< Silence that ends a reply; 0 derives t3.5 + slack.
+    std::chrono::microseconds byteTimeoutSlack{5000};     ///< Added to the derived t3.5 (scheduler, USB latency).
+};
+
+/**
+ * @brief Runs Modbus RTU transactions on many serial ports from one thread.
+ *
+ * The engine frames requests itself and multiplexes every port with epoll;
+ * a timerfd per port provides the t3.5 inter-frame gap and the response and
+ * byte timeouts. submit() may be called from any thread; completions run on
+ * the thread that calls run()/runOnce(). Any file descriptor works as a port,
+ * e.g. ModbusUtils::getFileDescriptor() of a context that is no longer used
+ * directly, or one end of openPtyPair(). A port whose descriptor fails or
+ * hangs up completes all further requests with that error until it is removed.
+ */
+class ModbusAsyncEngine {
+public:
+    using Completion = std::function<void(const ModbusAsyncResult&)>;
+    using EventHandler = std::function<void(uint32_t events)>;
+
+    ModbusAsyncEngine();
+
+    /**
+     * @brief Destructor closes the engine's own descriptors, not the ports.
+     */
+    ~ModbusAsyncEngine();
+
+    /**
+     * @brief Create the epoll instance and wake-up eventfd.
+     * @return True on success.
+     */
+    bool initialize();
+
+    /**
+     * @brief Drive transactions on a serial file descriptor; call from the engine thread or before run().
+     * @param[in] fileDescriptor Open serial descriptor; switched to non-blocking, not owned.
+     * @param[in] options Line and timeout settings.
+     * @return Port handle, -1 on error.
+     */
+    int addPort(int fileDescriptor, const ModbusAsyncPortOptions& options = ModbusAsyncPortOptions());
+
+    /**
+     * @brief Stop driving a port; queued transactions complete with ECANCELED.
+     *
+     * Must not be called from a completion of the same port.
+     */
+    void removePort(int portHandle);
+
+    /**
+     * @brief Queue a request; thread-safe.
+     * @param[in] portHandle Port returned by addPort().
+     * @param[in] slaveIdentifier Unit ID, 0 for broadcast (completes after the frame is sent).
+     * @param[in] pdu Request PDU (function code + data), at most 253 bytes.
+     * @param[in] pduLength Length of the PDU.
+     * @param[in] completion Called once on the engine thread.
+     * @return False if the request was rejected; completion is then not called.
+     */
+    bool submit(int portHandle, int slaveIdentifier, const uint8_t* pdu, int pduLength, Completion completion);
+
+    /**
+     * @brief Future-returning variant of submit().
+     */
+    std::future<ModbusAsyncResult> submit(int portHandle, int slaveIdentifier, const uint8_t* pdu, int pduLength);
+
+    /**
+     * @brief Convenience wrappers building the request PDU.
+     */
+    std::future<ModbusAsyncResult> readHoldingRegisters(int portHandle, int slaveIdentifier,
+                                                        int startAddress, int numberOfRegisters);
+    std::future<ModbusAsyncResult> readCoils(int portHandle, int slaveIdentifier,
+                                             int startAddress, int numberOfCoils);
+    std::future<ModbusAsyncResult> writeMultipleRegisters(int portHandle, int slaveIdentifier,
+                                                          int startAddress, const uint16_t* source, int count);
+    std::future<ModbusAsyncResult> writeMultipleCoils(int portHandle, int slaveIdentifier,
+                                                      int startAddress, const uint8_t* source, int count);
+
+    /**
+     * @brief Watch an additional descriptor on the engine's epoll set (e.g. sockets).
+     * @return True on success.
+     */
+    bool watch(int fileDescriptor, uint32_t events, EventHandler handler);
+
+    /**
+     * @brief Change the event mask of a watched descriptor.
+     */
+    bool modifyWatch(int fileDescriptor, uint32_t events);
+
+    /**
+     * @brief Stop watching a descriptor; does not close it.
+     */
+    void unwatch(int fileDescriptor);
+
+    /**
+     * @brief Wait for and dispatch one batch of events.
+     * @param[in] timeoutMilliseconds epoll_wait timeout, -1 to block.
+     * @return Number of events handled, -1 on error.
+     */
+    int runOnce(int timeoutMilliseconds);
+
+    /**
+     * @brief Dispatch events until stop() is called.
+     */
+    void run();
+
+    /**
+     * @brief Make run() return; thread-safe.
+     */
+    void stop();
+
+    /**
+     * @brief Number of queued or in-flight transactions on a port; engine thread only.
+     */
+    size_t pendingCount(int portHandle) const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Transaction {
+        int               portHandle;
+        int               slaveIdentifier;
+        uint8_t           pdu[253];
+        int               pduLength;
+        Completion        completion;
+        Clock::time_point submitted;
+    };
+
+    enum class PortState { Idle, Gap, Sending, Awaiting };
+
+    struct Port {
+        int                       fileDescriptor;
+        int                       timerFileDescriptor;
+        ModbusAsyncPortOptions    options;
+        std::chrono::nanoseconds  characterTime;
+        std::chrono::nanoseconds  frameGap;
+        std::chrono::nanoseconds  byteTimeout;
+        std::deque<Transaction>   queue;
+        Transaction               current;
+        PortState                 state;
+        uint8_t                   transmit[256];
+        int                       transmitLength;
+        int                       transmitSent;
+        uint8_t                   receive[256];
+        int                       receiveLength;
+        int                       expectedLength;
+        int                       failure;
+        Clock::time_point         lastActivity;
+    };
+
+    void drainSubmissions();
+    void startNext(Port& port);
+    void sendFrame(Port& port);
+    void onPortEvent(Port& port, uint32_t events);
+    void onTimer(Port& port);
+    void finish(Port& port, int errorCode);
+    void armTimer(Port& port, Clock::time_point when);
+
+    int                                                    epollFileDescriptor_;
+    int                                                    wakeFileDescriptor_;
+    std::vector<std::unique_ptr<Port>>                     ports_;
+    std::unordered_map<int, std::shared_ptr<EventHandler>> handlers_;
+    std::mutex                                             submitMutex_;
+    std::vector<Transaction>                               submitted_;
+    std::atomic<bool>                                      running_;
+};
+
+} // namespace test_modbus_485
+
+#endif // MODBUS_ASYNC_ENGINE_H
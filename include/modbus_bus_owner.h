@@ -0,0 +1,230 @@
+// include/modbus_bus_owner.h
+
+#ifndef MODBUS_BUS_OWNER_H
+#define MODBUS_BUS_OWNER_H
+
+#include "modbus_metrics.h"
+#include "modbus_utils.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <ostream>
+#include <thread>
+#include <vector>
+
+namespace test_modbus_485 {
+
+/**
+ * @brief Priority classes of a ModbusBusOwner, most urgent first.
+ */
+enum class ModbusRequestPriority {
+    Control = 0,    ///< Setpoints and commands; served before any queued telemetry.
+    Telemetry = 1   ///< Polling reads.
+};
+
+/**
+ * @brief Outcome of a request run by a ModbusBusOwner.
+ */
+struct ModbusBusResult {
+    int                      result = -1;     ///< Return value of the ModbusUtils call; -1 on failure.
+    int                      errorCode = 0;   ///< errno when result is -1; ECANCELED if the owner stopped.
+    std::vector<uint16_t>    registers;       ///< Registers read, if any.
+    std::vector<uint8_t>     bits;            ///< Coils or inputs read, if any.
+    std::chrono::nanoseconds waited{0};       ///< Time spent queued before the bus took the request.
+};
+
+/**
+ * @brief Queue counters of one priority class.
+ */
+struct ModbusBusQueueStatistics {
+    uint64_t                 submitted = 0;
+    uint64_t                 completed = 0;
+    uint64_t                 failed = 0;         ///< Completed with result -1, cancelled ones included.
+    uint64_t                 depth = 0;          ///< Requests queued now.
+    uint64_t                 maximumDepth = 0;   ///< Deepest queue since the last reset.
+    LatencyHistogramSnapshot wait;               ///< Submit to start of the transaction.
+};
+
+/**
+ * @brief Snapshot of a ModbusBusOwner, indexed by ModbusRequestPriority.
+ */
+struct ModbusBusOwnerStatistics {
+    std::array<ModbusBusQueueStatistics, 2> queues;
+
+    /**
+     * @brief Print one row per priority class with counters and wait p50/p90/p99/max.
+     */
+    void print(std::ostream& stream) const;
+};
+
+/**
+ * @brief Serialises every transaction of one ModbusUtils instance on a dedicated thread.
+ *
+ * ModbusUtils is not thread-safe: two threads calling it on the same context
+ * interleave their frames on the line. A bus owner is the only thread that
+ * touches the instance once started; other threads post requests to it and
+ * get the result through a future or a callback. Posting is lock-free, one
+ * atomic exchange on an intrusive multi-producer queue per class, and only
+ * takes a mutex to wake the owner when it is idle. Control requests always
+ * go before queued telemetry, so a setpoint waits for at most the
+ * transaction already on the wire, however deep the polling backlog.
+ */
+class ModbusBusOwner {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @brief Work run on the owner thread; returns the ModbusUtils result and may fill registers or bits.
+     */
+    using Operation = std::function<int(ModbusUtils& modbus, modbus_t*& contextReference, ModbusBusResult& result)>;
+
+    /**
+     * @brief Called on the owner thread once a request finished; must not block.
+     */
+    using Completion = std::function<void(const ModbusBusResult& result)>;
+
+    /**
+     * @param[in] modbus Opened instance (or one with a transport); must outlive the owner.
+     * @param[in] contextReference Its context; must outlive the owner.
+     */
+    ModbusBusOwner(ModbusUtils& modbus, modbus_t*& contextReference);
+
+    /**
+     * @brief Destructor stops the thread, cancelling queued requests.
+     */
+    ~ModbusBusOwner();
+
+    ModbusBusOwner(const ModbusBusOwner&) = delete;
+    ModbusBusOwner& operator=(const ModbusBusOwner&) = delete;
+
+    /**
+     * @brief Start the owner thread.
+     * @return True on success, false if already running.
+     */
+    bool start();
+
+    /**
+     * @brief Finish the transaction in progress, cancel the queued ones with ECANCELED and join the thread.
+     */
+    void stop();
+
+    /**
+     * @brief Queue an operation for a slave.
+     * @param[in] slaveIdentifier Selected with setSlave() before the operation runs.
+     * @return Future of the result; cancelled immediately when the owner is not running.
+     */
+    std::future<ModbusBusResult> submit(int slaveIdentifier, ModbusRequestPriority priority, Operation operation);
+
+    /**
+     * @brief Queue an operation and report the result through a callback instead of a future.
+     */
+    void submit(int slaveIdentifier, ModbusRequestPriority priority, Operation operation, Completion completion);
+
+    std::future<ModbusBusResult> readCoils(int slaveIdentifier,
+                                           int startAddress,
+                                           int count,
+                                           ModbusRequestPriority priority = ModbusRequestPriority::Telemetry);
+    std::future<ModbusBusResult> readDiscreteInputs(int slaveIdentifier,
+                                                    int startAddress,
+                                                    int count,
+                                                    ModbusRequestPriority priority = ModbusRequestPriority::Telemetry);
+    std::future<ModbusBusResult> readHoldingRegisters(int slaveIdentifier,
+                                                      int startAddress,
+                                                      int count,
+                                                      ModbusRequestPriority priority =
+                                                          ModbusRequestPriority::Telemetry);
+    std::future<ModbusBusResult> readInputRegisters(int slaveIdentifier,
+                                                    int startAddress,
+                                                    int count,
+                                                    ModbusRequestPriority priority = ModbusRequestPriority::Telemetry);
+    std::future<ModbusBusResult> writeSingleCoil(int slaveIdentifier,
+                                                 int coilAddress,
+                                                 bool coilStatus,
+                                                 ModbusRequestPriority priority = ModbusRequestPriority::Control);
+    std::future<ModbusBusResult> writeSingleRegister(int slaveIdentifier,
+                                                     int registerAddress,
+                                                     uint16_t registerValue,
+                                                     ModbusRequestPriority priority = ModbusRequestPriority::Control);
+    std::future<ModbusBusResult> writeMultipleRegisters(int slaveIdentifier,
+                                                        int startAddress,
+                                                        std::vector<uint16_t> source,
+                                                        ModbusRequestPriority priority =
+                                                            ModbusRequestPriority::Control);
+
+    /**
+     * @brief Queue depths, counters and wait-time histograms per priority class.
+     */
+    ModbusBusOwnerStatistics statistics() const;
+
+    /**
+     * @brief Zero the counters and histograms; depths are kept.
+     */
+    void resetStatistics();
+
+private:
+    struct Request {
+        std::atomic<Request*>         next{nullptr};
+        int                           slaveIdentifier = 0;
+        Operation                     operation;
+        Completion                    completion;
+        std::promise<ModbusBusResult> promise;
+        bool                          hasPromise = false;
+        Clock::time_point             submitted;
+    };
+
+    /**
+     * @brief Intrusive multi-producer single-consumer queue (Vyukov); push is wait-free.
+     */
+    class RequestQueue {
+    public:
+        RequestQueue();
+
+        void push(Request* request);
+
+        /**
+         * @brief Oldest request, nullptr when empty or while a push is halfway through; consumer only.
+         */
+        Request* pop();
+
+    private:
+        Request               stub_;
+        std::atomic<Request*> back_;   ///< Most recently pushed, producers exchange it.
+        Request*              front_;  ///< Next to pop, consumer only.
+    };
+
+    struct QueueCounters {
+        RequestQueue          queue;
+        std::atomic<uint64_t> submitted{0};
+        std::atomic<uint64_t> completed{0};
+        std::atomic<uint64_t> failed{0};
+        std::atomic<uint64_t> depth{0};
+        std::atomic<uint64_t> maximumDepth{0};
+        LatencyHistogram      wait;
+    };
+
+    void enqueue(ModbusRequestPriority priority, Request* request);
+    Request* dequeue(QueueCounters*& counters);
+    void run();
+    void execute(Request* request, QueueCounters& counters, bool cancelled);
+
+    ModbusUtils&                 modbus_;
+    modbus_t*&                   context_;
+    std::array<QueueCounters, 2> queues_;
+    std::atomic<uint64_t>        queued_{0};
+    std::atomic<int>             submitters_{0};  ///< Threads between the running check and the push.
+    std::atomic<bool>            running_{false};
+    std::atomic<bool>            sleeping_{false};
+    std::mutex                   wakeMutex_;
+    std::condition_variable      wake_;
+    std::thread                  thread_;
+    int                          currentSlave_ = -1;
+};
+
+} // namespace test_modbus_485
+
+#endif // MODBUS_BUS_OWNER_H
@@ -0,0 +1,177 @@
+// include/modbus_bus_scheduler.h
+
+#ifndef MODBUS_BUS_SCHEDULER_H
+#define MODBUS_BUS_SCHEDULER_H
+
+#include "modbus_utils.h"
+#include "modbus_point_reader.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace test_modbus_485 {
+
+/**
+ * @brief Achieved vs. requested poll rate of one slave on the segment.
+ */
+struct ModbusSlaveStatistics {
+    int      slaveIdentifier;
+    double   requestedRateHz;   ///< Sum of 1/period over the slave's poll groups.
+    double   achievedRateHz;    ///< Successful group polls per second since the last reset.
+    uint64_t polls;             ///< Group polls attempted.
+    uint64_t failures;          ///< Group polls with at least one failed request.
+    uint64_t skippedForBackoff; ///< Due polls skipped because the slave was backing off.
+    double   busTimeMs;         ///< Time the bus spent on this slave.
+    bool     backingOff;        ///< Slave is currently excluded from polling.
+};
+
+/**
+ * @brief Polls many unit IDs on one RS-485 segment through a single port.
+ *
+ * Every poll group belongs to one slave and has its own period and priority.
+ * The scheduler runs the most urgent due group, switching the unit ID with
+ * setSlave() instead of reopening the port. A slave that stops answering is
+ * backed off exponentially, so a dead drop only costs one timeout per
+ * backoff interval instead of one per cycle.
+ */
+class ModbusBusScheduler {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @brief Called after every poll of a group with the group handle and its outcome.
+     */
+    using PollCallback = std::function<void(int groupHandle, bool success)>;
+
+    ModbusBusScheduler();
+
+    /**
+     * @brief Destructor closes the port.
+     */
+    ~ModbusBusScheduler();
+
+    /**
+     * @brief Open the serial port shared by all slaves of the segment.
+     * @return True if the port was opened.
+     */
+    bool open(const std::string& serialDevicePath,
+              int baudRate = 115200,
+              char parityMode = 'N',
+              int dataBits = 8,
+              int stopBits = 1);
+
+    /**
+     * @brief Close the serial port.
+     */
+    void close();
+
+    /**
+     * @brief Poll through a transport instead of the serial port, e.g. a ModbusLoopbackTransport.
+     * @param[in] transport Transport to use, not owned; nullptr goes back to the port.
+     */
+    void attachTransport(ModbusTransport* transport);
+
+    /**
+     * @brief Add a poll group for one slave.
+     * @param[in] slaveIdentifier Unit ID of the slave (1-247).
+     * @param[in] period Requested poll period.
+     * @param[in] priority Higher values are served first when several groups are due.
+     * @param[in] callback Optional callback invoked after each poll.
+     * @return Group handle, -1 on an invalid slave identifier or period.
+     */
+    int addPollGroup(int slaveIdentifier,
+                     std::chrono::microseconds period,
+                     int priority = 0,
+                     PollCallback callback = nullptr);
+
+    /**
+     * @brief Add a point to a poll group.
+     * @return Point handle inside the group's reader, -1 on a bad group or address.
+     */
+    int addPoint(int groupHandle, ModbusTable table, int address);
+
+    /**
+     * @brief Reader holding the points and last values of a group.
+     * @param[in] groupHandle Handle returned by addPollGroup(); throws std::out_of_range otherwise.
+     */
+    ModbusPointReader& group(int groupHandle);
+
+    /**
+     * @brief Configure the backoff applied to slaves that stop answering.
+     * @param[in] initialBackoff Backoff after the first failed poll.
+     * @param[in] maximumBackoff Upper bound for the doubling backoff.
+     */
+    void setBackoff(std::chrono::milliseconds initialBackoff,
+                    std::chrono::milliseconds maximumBackoff);
+
+    /**
+     * @brief Poll the most urgent due group, if any.
+     * @return True if a group was polled.
+     */
+    bool pollOnce();
+
+    /**
+     * @brief Earliest time at which a group becomes due.
+     */
+    Clock::time_point nextDeadline() const;
+
+    /**
+     * @brief Poll until running becomes false, sleeping between due groups.
+     */
+    void run(const std::atomic<bool>& running);
+
+    /**
+     * @brief Per-slave statistics since the last reset.
+     */
+    std::vector<ModbusSlaveStatistics> statistics() const;
+
+    /**
+     * @brief Restart the statistics window.
+     */
+    void resetStatistics();
+
+    /**
+     * @brief Utility and context used for the port, for direct transactions between polls.
+     */
+    ModbusUtils& utils();
+    modbus_t*& context();
+
+private:
+    struct PollGroup {
+        int                                slaveIdentifier;
+        std::chrono::microseconds          period;
+        int                                priority;
+        PollCallback                       callback;
+        std::unique_ptr<ModbusPointReader> reader;
+        Clock::time_point                  nextDue;
+    };
+
+    struct SlaveState {
+        int                       consecutiveFailures = 0;
+        Clock::time_point         backoffUntil{};
+        uint64_t                  polls = 0;
+        uint64_t                  successes = 0;
+        uint64_t                  failures = 0;
+        uint64_t                  skippedForBackoff = 0;
+        std::chrono::nanoseconds  busTime{0};
+    };
+
+    ModbusUtils                modbusUtils_;
+    modbus_t*                  context_;
+    int                        currentSlave_;
+    bool                       opened_;
+    std::vector<PollGroup>     groups_;
+    std::map<int, SlaveState>  slaves_;
+    std::chrono::milliseconds  initialBackoff_;
+    std::chrono::milliseconds  maximumBackoff_;
+    Clock::time_point          statisticsStart_;
+};
+
+} // namespace test_modbus_485
+
+#endif // MODBUS_BUS_SCHEDULER_H
@@ -0,0 +1,373 @@
+// include/modbus_capture.h
+
+#ifndef MODBUS_CAPTURE_H
+#define MODBUS_CAPTURE_H
+
+#include "modbus_metrics.h"
+#include "modbus_rtu_splitter.h"
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace test_modbus_485 {
+
+/**
+ * @brief Which side of the line a captured frame came from.
+ */
+enum class ModbusCaptureDirection : uint8_t {
+    Request,   ///< Master to slave.
+    Response,  ///< Slave to master.
+    Unknown    ///< Could not be told, e.g. for garbage.
+};
+
+/**
+ * @brief What the recorder made of a captured frame.
+ */
+enum class ModbusCaptureStatus : uint8_t {
+    Ok,         ///< Valid frame; a response matched the pending request.
+    Exception,  ///< Valid exception response.
+    Unmatched,  ///< Valid response with no request pending for its slave and function code.
+    Garbage     ///< Bytes that formed no frame with a valid CRC.
+};
+
+/**
+ * @brief Layout parameters of a new capture file.
+ */
+struct ModbusCaptureOptions {
+    size_t   segmentBytes = 1 << 20;   ///< Segment size; rounded up to whole pages.
+    uint32_t maximumSegments = 0;      ///< 0 grows the file without limit; otherwise the oldest segment is reused.
+    uint32_t baudRate = 0;             ///< Line parameters, kept for bus-utilisation statistics.
+    uint32_t bitsPerCharacter = 10;
+};
+
+/**
+ * @brief One record read back from a capture file.
+ */
+struct ModbusCaptureRecord {
+    uint64_t               timestamp;  ///< CLOCK_MONOTONIC nanoseconds at the first byte of the frame.
+    ModbusCaptureDirection direction;
+    ModbusCaptureStatus    status;
+    const uint8_t*         adu;        ///< Whole ADU, CRC included; valid while the reader stays open.
+    int                    length;
+};
+
+namespace capture_format {
+
+/**
+ * @brief First page of a capture file.
+ *
+ * The file is this header followed by fixed-size segments. Each segment
+ * starts with a SegmentHeader page holding its counters and a sparse time
+ * index, then packed records: a RecordHeader and the ADU, padded to 8 bytes.
+ */
+struct FileHeader {
+    char     magic[8];                  ///< "MBCAP01\0".
+    uint32_t version;
+    uint32_t headerBytes;               ///< Offset of the first segment.
+    uint64_t segmentBytes;
+    uint32_t maximumSegments;
+    uint32_t baudRate;
+    uint32_t bitsPerCharacter;
+    uint32_t indexInterval;             ///< Record bytes between two index entries.
+    uint64_t startRealtime;             ///< CLOCK_REALTIME nanoseconds when the file was created ...
+    uint64_t startMonotonic;            ///< ... and CLOCK_MONOTONIC at the same moment.
+};
+
+/**
+ * @brief First record at or after a multiple of indexInterval in a segment.
+ */
+struct IndexEntry {
+    uint64_t timestamp;
+    uint32_t offset;                    ///< From the start of the segment.
+    uint32_t record;                    ///< Number within the segment.
+};
+
+/**
+ * @brief First page of a segment; sequence 0 marks a segment not in use.
+ */
+struct SegmentHeader {
+    uint32_t   magic;                   ///< 'MBSG'.
+    uint32_t   indexCount;
+    uint64_t   sequence;                ///< 1 for the first segment written, then increasing.
+    uint64_t   firstTimestamp;
+    uint64_t   lastTimestamp;
+    uint64_t   firstRecord;             ///< Records written to the file before this segment.
+    uint32_t   recordCount;
+    uint32_t   usedBytes;               ///< From the start of the segment, header page included.
+    uint8_t    reserved[16];
+    IndexEntry index[252];
+};
+
+struct RecordHeader {
+    uint64_t timestamp;
+    uint16_t length;
+    uint8_t  direction;
+    uint8_t  status;
+    uint32_t reserved;
+};
+
+constexpr char     fileMagic[8] = {'M', 'B', 'C', 'A', 'P', '0', '1', '\0'};
+constexpr uint32_t fileVersion = 1;
+constexpr uint32_t segmentMagic = 0x4753424D;
+constexpr size_t   pageBytes = 4096;
+constexpr size_t   indexCapacity = sizeof(SegmentHeader::index) / sizeof(IndexEntry);
+
+static_assert(sizeof(FileHeader) <= pageBytes, "file header exceeds a page");
+static_assert(sizeof(SegmentHeader) == pageBytes, "segment header must fill one page");
+static_assert(sizeof(RecordHeader) == 16, "record header layout changed");
+
+} // namespace capture_format
+
+/**
+ * @brief Append-only recorder of Modbus frames into a memory-mapped capture file.
+ *
+ * Only the segment being written is mapped, so memory use stays at one
+ * segment however long the capture runs; the kernel writes finished pages
+ * back in the background. append() is a copy into the mapping and a few
+ * counter stores, with no system call except when a segment fills up.
+ * With maximumSegments set, the file stops growing and the oldest segment
+ * is overwritten, keeping the most recent maximumSegments * segmentBytes.
+ * Not thread-safe; one thread appends.
+ */
+class ModbusCaptureWriter {
+public:
+    ModbusCaptureWriter();
+
+    /**
+     * @brief Destructor closes the file.
+     */
+    ~ModbusCaptureWriter();
+
+    ModbusCaptureWriter(const ModbusCaptureWriter&) = delete;
+    ModbusCaptureWriter& operator=(const ModbusCaptureWriter&) = delete;
+
+    /**
+     * @brief Create or truncate a capture file.
+     * @return True on success.
+     */
+    bool open(const std::string& path, const ModbusCaptureOptions& options = ModbusCaptureOptions());
+
+    /**
+     * @brief Append one frame.
+     * @param[in] timestamp CLOCK_MONOTONIC nanoseconds; one earlier than the previous record is raised to it.
+     * @param[in] adu Frame bytes, at most 65535.
+     * @return False if the file is not open or a new segment could not be allocated.
+     */
+    bool append(uint64_t timestamp,
+                ModbusCaptureDirection direction,
+                ModbusCaptureStatus status,
+                const uint8_t* adu,
+                int length);
+
+    /**
+     * @brief Schedule write-back of the current segment and close the file.
+     */
+    void close();
+
+    /**
+     * @brief Records appended since open(), including overwritten ones.
+     */
+    uint64_t recordCount() const;
+
+    /**
+     * @brief CLOCK_MONOTONIC in nanoseconds, the clock capture timestamps use.
+     */
+    static uint64_t now();
+
+private:
+    bool startSegment(uint64_t timestamp);
+
+    int                            fileDescriptor_;
+    capture_format::FileHeader     header_;
+    uint8_t*                       segment_;
+    capture_format::SegmentHeader* segmentHeader_;
+    uint64_t                       segmentsStarted_;
+    uint64_t                       records_;
+    uint64_t                       lastTimestamp_;
+    uint32_t                       nextIndexOffset_;
+};
+
+/**
+ * @brief Reader of capture files written by ModbusCaptureWriter.
+ *
+ * The file is mapped read-only and its segments put in write order. seek()
+ * finds a time in O(log n): a binary search over the segments, one over the
+ * index of the segment found, then a scan of at most one index interval.
+ */
+class ModbusCaptureReader {
+public:
+    ModbusCaptureReader();
+
+    /**
+     * @brief Destructor closes the file.
+     */
+    ~ModbusCaptureReader();
+
+    ModbusCaptureReader(const ModbusCaptureReader&) = delete;
+    ModbusCaptureReader& operator=(const ModbusCaptureReader&) = delete;
+
+    /**
+     * @brief Map a capture file and position before its first record.
+     * @return True on success.
+     */
+    bool open(const std::string& path);
+
+    void close();
+
+    const capture_format::FileHeader& header() const;
+
+    /**
+     * @brief Records in the file; fewer than were written if segments were reused.
+     */
+    uint64_t recordCount() const;
+
+    /**
+     * @brief Timestamps of the first and last record, 0 for an empty file.
+     */
+    uint64_t firstTimestamp() const;
+    uint64_t lastTimestamp() const;
+
+    /**
+     * @brief Position before the first record with a timestamp at or after the given one.
+     */
+    void seek(uint64_t timestamp);
+
+    /**
+     * @brief Position before the first record.
+     */
+    void rewind();
+
+    /**
+     * @brief Read the record at the current position and advance.
+     * @return False at the end of the file.
+     */
+    bool next(ModbusCaptureRecord& record);
+
+private:
+    const capture_format::SegmentHeader* segment(size_t position) const;
+
+    int                  fileDescriptor_;
+    const uint8_t*       data_;
+    size_t               size_;
+    std::vector<size_t>  segments_;      ///< Offsets of segments in use, in write order.
+    size_t               segmentPosition_;
+    uint32_t             recordOffset_;  ///< Within segments_[segmentPosition_].
+};
+
+/**
+ * @brief Passive recorder: turns bytes read off a tapped line into capture records.
+ *
+ * Frames are cut by ModbusRtuFrameSplitter. A frame is taken as the response
+ * to the pending request if its slave and function code match and its length
+ * fits a response; otherwise as a request if its length fits one. Bytes that
+ * form no frame are recorded as one Garbage record per run. Timestamps are
+ * worked back from the time each chunk was read, one character time per
+ * byte, to the first byte of the frame.
+ */
+class ModbusCaptureRecorder {
+public:
+    /**
+     * @param[in] writer Open capture file.
+     * @param[in] baudRate Line rate; 0 stamps frames with the read time.
+     */
+    ModbusCaptureRecorder(ModbusCaptureWriter& writer, int baudRate, int bitsPerCharacter);
+
+    ModbusCaptureRecorder(const ModbusCaptureRecorder&) = delete;
+    ModbusCaptureRecorder& operator=(const ModbusCaptureRecorder&) = delete;
+
+    /**
+     * @brief Feed bytes read from the line.
+     * @param[in] receivedAt ModbusCaptureWriter::now() right after the read returned.
+     */
+    void push(const uint8_t* data, size_t length, uint64_t receivedAt);
+
+    /**
+     * @brief The line was silent for t3.5.
+     */
+    void gap();
+
+    uint64_t frameCount() const;
+    uint64_t garbageBytes() const;
+
+    /**
+     * @brief Records the writer refused, e.g. because the disk is full.
+     */
+    uint64_t droppedRecords() const;
+
+private:
+    struct Chunk {
+        uint64_t end;          ///< Stream position one past the last byte.
+        uint64_t receivedAt;
+    };
+
+    void onFrame(const uint8_t* frame, int length);
+    void onGarbage(const uint8_t* bytes, int length);
+    uint64_t timestampOf(int length);
+    void record(uint64_t timestamp, ModbusCaptureDirection direction, ModbusCaptureStatus status,
+                const uint8_t* adu, int length);
+
+    ModbusCaptureWriter&   writer_;
+    ModbusRtuFrameSplitter splitter_;
+    uint64_t               characterNanoseconds_;
+    std::deque<Chunk>      chunks_;
+    uint64_t               pushed_ = 0;
+    uint64_t               consumed_ = 0;
+    bool                   pending_ = false;
+    uint8_t                pendingSlave_ = 0;
+    uint8_t                pendingFunction_ = 0;
+    uint64_t               frames_ = 0;
+    uint64_t               garbage_ = 0;
+    uint64_t               dropped_ = 0;
+};
+
+/**
+ * @brief Traffic of one function code in a capture.
+ */
+struct ModbusCaptureFunctionStatistics {
+    int                      functionCode;
+    uint64_t                 requests = 0;
+    uint64_t                 responses = 0;
+    uint64_t                 exceptions = 0;
+    LatencyHistogramSnapshot responseTime;  ///< First byte of the request to first byte of the response.
+};
+
+/**
+ * @brief Summary of a time range of a capture.
+ */
+struct ModbusCaptureStatistics {
+    uint64_t firstTimestamp = 0;
+    uint64_t lastTimestamp = 0;
+    uint64_t records = 0;
+    uint64_t requests = 0;
+    uint64_t responses = 0;
+    uint64_t exceptions = 0;
+    uint64_t unmatched = 0;           ///< Responses with no request pending.
+    uint64_t unanswered = 0;          ///< Unicast requests followed by another request instead of a response.
+    uint64_t garbageBytes = 0;
+    uint64_t wireBytes = 0;           ///< Every captured byte, garbage included.
+    double   busUtilisation = 0.0;    ///< Fraction of the range the line carried data; 0 without a baud rate.
+    LatencyHistogramSnapshot responseTime;
+    std::vector<ModbusCaptureFunctionStatistics> functions;  ///< Function codes seen, ascending.
+
+    /**
+     * @brief Print counters, utilisation and a response-time table per function code.
+     */
+    void print(std::ostream& stream) const;
+
+    /**
+     * @brief Same content as CSV: a header line and one row per function code plus a total row.
+     */
+    void printCsv(std::ostream& stream) const;
+};
+
+/**
+ * @brief Summarise the records with timestamps in [from, to).
+ */
+ModbusCaptureStatistics collectCaptureStatistics(ModbusCaptureReader& reader, uint64_t from, uint64_t to);
+
+} // namespace test_modbus_485
+
+#endif // MODBUS_CAPTURE_H
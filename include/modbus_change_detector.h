@@ -0,0 +1,177 @@
+// include/modbus_change_detector.h
+
+#ifndef MODBUS_CHANGE_DETECTOR_H
+#define MODBUS_CHANGE_DETECTOR_H
+
+#include "modbus_register_map.h"
+#include "modbus_utils.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <ostream>
+#include <utility>
+#include <vector>
+
+namespace test_modbus_485 {
+
+/**
+ * @brief A point whose value changed, as reported to subscribers.
+ */
+struct ModbusChange {
+    int                                   slaveIdentifier;
+    ModbusTable                           table;
+    int                                   address;     ///< Bit, or first register of the point.
+    double                                previous;    ///< Value last reported; equal to value if initial.
+    double                                value;       ///< Engineering value (bits: 0 or 1).
+    bool                                  initial;     ///< First value ever seen for the point.
+    std::chrono::steady_clock::time_point timestamp;   ///< Poll time of the block that carried the change.
+};
+
+/**
+ * @brief Counters of a ModbusChangeDetector.
+ */
+struct ModbusChangeDetectorStatistics {
+    uint64_t updates = 0;         ///< Blocks fed.
+    uint64_t valuesCompared = 0;  ///< Registers and bits compared.
+    uint64_t valuesChanged = 0;   ///< Registers and bits that differed from the last poll.
+    uint64_t suppressed = 0;      ///< Point changes within their deadband.
+    uint64_t reported = 0;        ///< Changes passed to subscribers.
+    uint64_t callbacks = 0;       ///< Subscriber calls.
+
+    void print(std::ostream& stream) const;
+};
+
+/**
+ * @brief Report-by-exception stage between polling and the consumers of polled values.
+ *
+ * Keeps the last known image of every slave and table that was fed. Each
+ * polled block is compared with it (a plain loop over 32 values at a time
+ * the compiler vectorises, so an unchanged block costs one pass), and only
+ * values that differ are looked at further. A register covered by a point
+ * from addPoint() is decoded as that point and reported when it moved by
+ * at least the point's deadband from the value last reported, so slow drift
+ * is reported once it adds up; other registers and bits are reported on
+ * any change. Subscribers get the changes inside their range, in address
+ * order, once per block. The first value of every point is reported with
+ * initial set. Not thread-safe: feed it from the polling thread, which is
+ * also where subscribers are called; a subscriber must not feed, subscribe
+ * or unsubscribe.
+ */
+class ModbusChangeDetector {
+public:
+    /**
+     * @brief Receives the changes of one block that fall inside the subscribed range.
+     */
+    using Subscriber = std::function<void(const ModbusChange* changes, size_t count)>;
+
+    /**
+     * @brief Decode a register range as a point, with a deadband in engineering units.
+     * @param[in] deadband Smallest change reported; 0 reports every change.
+     */
+    void addPoint(int slaveIdentifier, ModbusTable table, const ModbusPoint& point, double deadband = 0.0);
+
+    /**
+     * @brief Every point of a register map, one deadband per point in point order (nullptr for none).
+     */
+    template<size_t N>
+    void addPoints(int slaveIdentifier, ModbusTable table, const ModbusRegisterMap<N>& map, const double* deadbands) {
+        for (size_t i = 0; i < N; ++i) {
+            addPoint(slaveIdentifier, table, map.point(i), deadbands ? deadbands[i] : 0.0);
+        }
+    }
+
+    /**
+     * @brief Get the changes of a range.
+     * @param[in] slaveIdentifier Slave, 0 for every slave.
+     * @return Subscription handle for unsubscribe().
+     */
+    int subscribe(int slaveIdentifier, ModbusTable table, int startAddress, int count, Subscriber subscriber);
+
+    void unsubscribe(int subscription);
+
+    /**
+     * @brief Feed a polled register block; subscribers are called before returning.
+     * @return Changes reported.
+     */
+    size_t updateRegisters(int slaveIdentifier,
+                           ModbusTable table,
+                           int startAddress,
+                           int count,
+                           const uint16_t* values,
+                           std::chrono::steady_clock::time_point polledAt = std::chrono::steady_clock::now());
+
+    /**
+     * @brief Feed a polled bit block, one byte per bit; subscribers are called before returning.
+     * @return Changes reported.
+     */
+    size_t updateBits(int slaveIdentifier,
+                      ModbusTable table,
+                      int startAddress,
+                      int count,
+                      const uint8_t* values,
+                      std::chrono::steady_clock::time_point polledAt = std::chrono::steady_clock::now());
+
+    /**
+     * @brief Forget the known image of a slave (0 for all), so its next values are reported as initial.
+     */
+    void forget(int slaveIdentifier);
+
+    ModbusChangeDetectorStatistics statistics() const;
+
+private:
+    struct PointState {
+        ModbusPoint point;
+        double      deadband;
+        double      reported;
+        bool        hasReported;
+    };
+
+    struct TableState {
+        std::vector<uint16_t>     values;   ///< Last known value per address; bits as 0 or 1.
+        std::vector<uint8_t>      known;    ///< 1 where a value was ever fed.
+        std::map<int, PointState> points;   ///< By address.
+    };
+
+    struct ChangedValue {
+        int      address;
+        uint16_t previous;
+        bool     initial;
+    };
+
+    struct Subscription {
+        int         identifier;
+        int         slaveIdentifier;   ///< 0 for every slave.
+        ModbusTable table;
+        int         startAddress;
+        int         endAddress;
+        Subscriber  subscriber;
+    };
+
+    template<typename Value>
+    size_t update(int slaveIdentifier,
+                  ModbusTable table,
+                  int startAddress,
+                  int count,
+                  const Value* values,
+                  std::chrono::steady_clock::time_point polledAt);
+
+    /**
+     * @brief Report a changed point if it moved past its deadband.
+     */
+    void evaluate(PointState& state, TableState& image, ModbusChange change);
+
+    void dispatch(int slaveIdentifier, ModbusTable table);
+
+    std::map<std::pair<int, int>, TableState> tables_;   ///< By (slave, table).
+    std::vector<Subscription>                 subscriptions_;
+    std::vector<ChangedValue>                 changed_;  ///< Values of the block being fed that differ.
+    std::vector<ModbusChange>                 changes_;  ///< Changes of the block being fed.
+    int                                       nextSubscription_ = 1;
+    ModbusChangeDetectorStatistics            counters_;
+};
+
+} // namespace test_modbus_485
+
+#endif // MODBUS_CHANGE_DETECTOR_H
@@ -0,0 +1,188 @@
+// include/modbus_cycle_planner.h
+
+#ifndef MODBUS_CYCLE_PLANNER_H
+#define MODBUS_CYCLE_PLANNER_H
+
+#include "modbus_utils.h"
+#include "modbus_point_reader.h"
+#include <cstdint>
+#include <vector>
+
+namespace test_modbus_485 {
+
+/**
+ * @brief Merges the reads and writes of one control cycle into as few
+ *        Modbus transactions as the slave allows.
+ *
+ * Operations are registered once and planned once; afterwards the caller
+ * refreshes the write buffers every cycle and calls execute(). All writes
+ * are sent before any read, so a cycle always reads back state that already
+ * includes its own setpoints.
+ */
+class ModbusCyclePlanner {
+public:
+    /**
+     * @brief Construct a planner that issues its transactions through the given utility.
+     * @param[in] modbusUtils Utility used to talk to the slave.
+     */
+    explicit ModbusCyclePlanner(ModbusUtils& modbusUtils);
+
+    /**
+     * @brief Register a holding-register write (FC16) for every cycle.
+     * @return Handle used with registerBuffer().
+     */
+    int addRegisterWrite(int startAddress, int numberOfRegisters);
+
+    /**
+     * @brief Register a coil write (FC15) for every cycle.
+     * @return Handle used with coilBuffer().
+     */
+    int addCoilWrite(int startAddress, int numberOfCoils);
+
+    /**
+     * @brief Register a holding-register read (FC03) for every cycle.
+     * @return Handle used with registerBuffer().
+     */
+    int addRegisterRead(int startAddress, int numberOfRegisters);
+
+    /**
+     * @brief Register a coil read (FC01) for every cycle.
+     * @return Handle used with coilBuffer().
+     */
+    int addCoilRead(int startAddress, int numberOfCoils);
+
+    /**
+     * @brief Declare that the slave mirrors a coil range as bit-packed holding registers.
+     *
+     * Coil n of the range is bit (n % 16) of register registerAddress + n / 16.
+     * Coil reads inside the range are then served from register reads, and
+     * coil writes that cover whole registers become register writes, so they
+     * can be merged with the other register traffic of the cycle.
+     * @param[in] coilAddress First coil of the mirrored range.
+     * @param[in] registerAddress Holding register that carries the first 16 coils.
+     * @param[in] numberOfCoils Number of mirrored coils.
+     */
+    void setCoilRegisterImage(int coilAddress, int registerAddress, int numberOfCoils);
+
+    /**
+     * @brief Allow or forbid folding a register write and a register read into FC23.
+     * @param[in] enabled False for slaves without Write/Read Multiple Registers support.
+     */
+    void setWriteAndReadEnabled(bool enabled);
+
+    /**
+     * @brief Set how many unused items a read may span to save one request.
+     * @param[in] table ModbusTable::HoldingRegisters or ModbusTable::Coils.
+     * @param[in] gapCost Cost of one extra request, in items; see coalesceReadRanges().
+     */
+    void setGapCost(ModbusTable table, int gapCost);
+
+    /**
+     * @brief Access the values of a register operation.
+     * @param[in] handle Handle returned by addRegisterWrite() or addRegisterRead().
+     * @return Source values for writes, last read values for reads, nullptr on a bad handle.
+     */
+    uint16_t* registerBuffer(int handle);
+
+    /**
+     * @brief Access the values of a coil operation.
+     * @param[in] handle Handle returned by addCoilWrite() or addCoilRead().
+     * @return Source values for writes, last read values for reads, nullptr on a bad handle.
+     */
+    uint8_t* coilBuffer(int handle);
+
+    /**
+     * @brief Build the merged transaction list from the registered operations.
+     * @return True if every operation fits into a valid Modbus request.
+     */
+    bool plan();
+
+    /**
+     * @brief Run one cycle: gather write buffers, send the planned transactions, scatter read results.
+     * @param[in,out] contextReference Modbus context; replaced if the port has to be reopened.
+     * @return True if every transaction succeeded; stops at the first failure.
+     */
+    bool execute(modbus_t*& contextReference);
+
+    /**
+     * @brief Function code of the transaction that made the last execute() fail, 0 if none.
+     */
+    int failedFunctionCode() const;
+
+    /**
+     * @brief Number of transactions the registered operations would take one by one.
+     */
+    int naiveTransactionCount() const;
+
+    /**
+     * @brief Number of transactions the plan sends per cycle.
+     */
+    int plannedTransactionCount() const;
+
+    /**
+     * @brief Round trips saved per cycle compared to issuing every operation separately.
+     */
+    int roundTripsSaved() const;
+
+private:
+    enum class OperationKind { RegisterWrite, CoilWrite, RegisterRead, CoilRead };
+
+    struct Operation {
+        OperationKind         kind;
+        int                   startAddress;
+        int                   count;
+        bool                  viaRegisterImage;
+        std::vector<uint16_t> registers;
+        std::vector<uint8_t>  coils;
+    };
+
+    struct Transaction {
+        int                   functionCode;
+        int                   writeAddress;
+        int                   writeCount;
+        int                   readAddress;
+        int                   readCount;
+        std::vector<int>      writeOperations;
+        std::vector<int>      readOperations;
+        std::vector<uint16_t> registerWriteBlock;
+        std::vector<uint16_t> registerReadBlock;
+        std::vector<uint8_t>  coilWriteBlock;
+        std::vector<uint8_t>  coilReadBlock;
+    };
+
+    struct Block {
+        int              startAddress;
+        int              endAddress;
+        std::vector<int> operations;
+    };
+
+    int addOperation(OperationKind kind, int startAddress, int count);
+    bool coveredByRegisterImage(const Operation& operation, bool requireWholeRegisters) const;
+    void operationSpan(const Operation& operation, int& startAddress, int& endAddress) const;
+    std::vector<Block> mergeBlocks(std::vector<int> operations, int maximumSpan) const;
+
+    /**
+     * @brief Group reads into blocks chosen by coalesceReadRanges().
+     * @return False if an operation spans more than maximumSpan, e.g. a coil read whose
+     *         register image is not aligned.
+     */
+    bool coalesceBlocks(const std::vector<int>& operations, int maximumSpan, int gapCost,
+                        std::vector<Block>& blocks) const;
+    void gatherWrites(Transaction& transaction);
+    void scatterReads(Transaction& transaction);
+
+    ModbusUtils&             modbusUtils_;
+    std::vector<Operation>   operations_;
+    std::vector<Transaction> transactions_;
+    int                      imageCoilAddress_;
+    int                      imageRegisterAddress_;
+    int                      imageCoilCount_;
+    bool                     writeAndReadEnabled_;
+    int                      registerGapCost_;
+    int                      coilGapCost_;
+    int                      failedFunctionCode_;
+};
+
+} // namespace test_modbus_485
+
+#endif // MODBUS_CYCLE_PLANNER_H
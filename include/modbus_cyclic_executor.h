@@ -0,0 +1,113 @@
+// include/modbus_cyclic_executor.h
+
+#ifndef MODBUS_CYCLIC_EXECUTOR_H
+#define MODBUS_CYCLIC_EXECUTOR_H
+
+#include "modbus_metrics.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+
+namespace test_modbus_485 {
+
+/**
+ * @brief What a ModbusCyclicExecutor does after a cycle ran past the next release time.
+ */
+enum class ModbusOverrunPolicy {
+    SkipMissed,   ///< Drop the releases already in the past and resume on the next slot of the grid.
+    CatchUp       ///< Run every missed release back to back until the schedule is met again.
+};
+
+/**
+ * @brief Period and thread setup of a ModbusCyclicExecutor.
+ */
+struct ModbusCyclicOptions {
+    std::chrono::nanoseconds period{std::chrono::milliseconds(20)};
+    ModbusOverrunPolicy      overrunPolicy = ModbusOverrunPolicy::SkipMissed;
+    int                      realtimePriority = 0;  ///< SCHED_FIFO priority 1-99; 0 keeps the current policy.
+    int                      cpu = -1;              ///< CPU to pin the loop thread to; -1 leaves the affinity alone.
+    bool                     lockMemory = false;    ///< mlockall() current and future pages, no page faults in the loop.
+};
+
+/**
+ * @brief Timing of a ModbusCyclicExecutor since the last reset.
+ */
+struct ModbusCyclicStatistics {
+    uint64_t                 cycles = 0;         ///< Cycles run.
+    uint64_t                 overruns = 0;       ///< Cycles that ended after the next release time.
+    uint64_t                 skippedCycles = 0;  ///< Releases dropped under SkipMissed.
+    LatencyHistogramSnapshot wakeLatency;        ///< Release time to start of the cycle.
+    LatencyHistogramSnapshot periodJitter;       ///< |start-to-start interval - period|.
+    LatencyHistogramSnapshot execution;          ///< Duration of the cycle callable.
+    LatencyHistogramSnapshot deadlineMiss;       ///< How far overrunning cycles ended past the next release.
+
+    /**
+     * @brief Print counters and p50/p90/p99/p99.9/max of every histogram.
+     */
+    void print(std::ostream& stream) const;
+};
+
+/**
+ * @brief Fixed-rate loop released at absolute deadlines on CLOCK_MONOTONIC.
+ *
+ * Release n is start + n * period, slept to with clock_nanosleep(TIMER_ABSTIME),
+ * so bus time and scheduling noise delay one cycle but never shift the ones
+ * after it. A cycle that runs past the next release is counted as an overrun
+ * and handled by the overrun policy. The loop runs on the calling thread,
+ * which configureThread() can switch to SCHED_FIFO, pin to a CPU and lock
+ * into memory.
+ */
+class ModbusCyclicExecutor {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @brief Body of one cycle.
+     * @param[in] cycleIndex Release number since run() started, gaps where releases were skipped.
+     * @return False to end the loop.
+     */
+    using Cycle = std::function<bool(uint64_t cycleIndex)>;
+
+    explicit ModbusCyclicExecutor(const ModbusCyclicOptions& options = ModbusCyclicOptions());
+
+    /**
+     * @brief Apply the priority, affinity and memory locking of the options to the calling thread.
+     * @return True if every requested setting was applied; failures are reported and the rest still applied.
+     */
+    bool configureThread();
+
+    /**
+     * @brief Run cycles on the calling thread until the callable returns false, stop() or the count is reached.
+     * @param[in] cycles Releases to run, skipped ones included; 0 for no limit.
+     * @return Cycles run.
+     */
+    uint64_t run(const Cycle& cycle, uint64_t cycles = 0);
+
+    /**
+     * @brief End run() after the current cycle; callable from any thread or a signal handler.
+     */
+    void stop();
+
+    const ModbusCyclicOptions& options() const;
+
+    ModbusCyclicStatistics statistics() const;
+
+    void resetStatistics();
+
+private:
+    ModbusCyclicOptions   options_;
+    std::atomic<bool>     stopRequested_{false};
+    std::atomic<uint64_t> cycles_{0};
+    std::atomic<uint64_t> overruns_{0};
+    std::atomic<uint64_t> skippedCycles_{0};
+    LatencyHistogram      wakeLatency_;
+    LatencyHistogram      periodJitter_;
+    LatencyHistogram      execution_;
+    LatencyHistogram      deadlineMiss_;
+};
+
+} // namespace test_modbus_485
+
+#endif // MODBUS_CYCLIC_EXECUTOR_H
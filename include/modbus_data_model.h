@@ -0,0 +1,70 @@
+// include/modbus_data_model.h
+
+#ifndef MODBUS_DATA_MODEL_H
+#define MODBUS_DATA_MODEL_H
+
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace test_modbus_485 {
+
+/**
+ * @brief Execute an FC20/FC21 request PDU against a register table.
+ *
+ * Files are views of the table: record r of file f is register
+ * (f - 1) * modbusFileRecordCount + r. Every sub-request must use
+ * reference type 6.
+ * @param[in] request Request PDU (function code first).
+ * @param[in] length PDU length.
+ * @param[in,out] registers Table the records live in.
+ * @param[in] numberOfRegisters Size of that table.
+ * @param[out] response Buffer of at least MODBUS_MAX_PDU_LENGTH bytes.
+ * @return Response PDU length; exception replies are 2 bytes (fc | 0x80, code).
+ */
+int processFileRecordRequest(const uint8_t* request, int length, uint16_t* registers, int numberOfRegisters,
+                             uint8_t* response);
+
+/**
+ * @brief The four Modbus tables of one slave, answering request PDUs in-process.
+ *
+ * Serves FC01-FC06, FC15, FC16, FC22 and FC23 with the exception codes a
+ * libmodbus slave would return, and FC20/FC21 through
+ * processFileRecordRequest() on the holding registers. All tables start at
+ * address 0. process() holds mutex(); lock it as well when touching the
+ * tables from elsewhere.
+ */
+class ModbusDataModel {
+public:
+    /**
+     * @param[in] numberOfBits Size of the coil and discrete input tables.
+     * @param[in] numberOfRegisters Size of the holding and input register tables.
+     */
+    explicit ModbusDataModel(int numberOfBits = 10000, int numberOfRegisters = 10000);
+
+    /**
+     * @brief Execute one request PDU against the tables.
+     * @param[in] request Request PDU (function code first).
+     * @param[in] length PDU length.
+     * @param[out] response Buffer of at least MODBUS_MAX_PDU_LENGTH bytes.
+     * @return Response PDU length; exception replies are 2 bytes (fc | 0x80, code).
+     */
+    int process(const uint8_t* request, int length, uint8_t* response);
+
+    std::vector<uint8_t>&  coils();
+    std::vector<uint8_t>&  discreteInputs();
+    std::vector<uint16_t>& holdingRegisters();
+    std::vector<uint16_t>& inputRegisters();
+    std::mutex&            mutex();
+
+private:
+    std::vector<uint8_t>  coils_;
+    std::vector<uint8_t>  discreteInputs_;
+    std::vector<uint16_t> holdingRegisters_;
+    std::vector<uint16_t> inputRegisters_;
+    std::mutex            mutex_;
+};
+
+} // namespace test_modbus_485
+
+#endif // MODBUS_DATA_MODEL_H
@@ -0,0 +1,47 @@
+// include/modbus_drive_points.h
+
+#ifndef MODBUS_DRIVE_POINTS_H
+#define MODBUS_DRIVE_POINTS_H
+
+#include "modbus_register_map.h"
+
+namespace test_modbus_485 {
+
+/**
+ * @brief Holding-register layout shared by serial_modbus_master and serial_modbus_slave.
+ */
+namespace drive_points {
+
+/**
+ * @brief Setpoints written by the master: RPM, steering angle in degrees.
+ */
+constexpr auto setpoints = makeRegisterMap(ModbusPoint{0, ModbusPointType::UInt16, 1.0},
+                                           ModbusPoint{1, ModbusPointType::Int16, 0.01});
+
+/**
+ * @brief Battery block: voltage (V), current (A), state of charge (%), temperature (°C).
+ */
+constexpr auto battery = makeRegisterMap(ModbusPoint{10, ModbusPointType::UInt16, 0.1},
+                                         ModbusPoint{11, ModbusPointType::Int16, 0.01},
+                                         ModbusPoint{12, ModbusPointType::UInt16, 0.1},
+                                         ModbusPoint{13, ModbusPointType::Int16, 1.0});
+
+/**
+ * @brief Charger block: voltage (V), current (A), charge cycles.
+ */
+constexpr auto charger = makeRegisterMap(ModbusPoint{20, ModbusPointType::UInt16, 0.1},
+                                         ModbusPoint{21, ModbusPointType::Int16, 0.01},
+                                         ModbusPoint{22, ModbusPointType::UInt16, 1.0});
+
+static_assert(setpoints.valid() && battery.valid() && charger.valid(), "overlapping drive points");
+static_assert(battery.count() == 4 && charger.count() == 3, "drive blocks changed size");
+
+enum SetpointIndex { Rpm, Angle };
+enum BatteryIndex { BatteryVoltage, BatteryCurrent, StateOfCharge, BatteryTemperature };
+enum ChargerIndex { ChargerVoltage, ChargerCurrent, ChargeCycles };
+
+} // namespace drive_points
+
+} // namespace test_modbus_485
+
+#endif // MODBUS_DRIVE_POINTS_H
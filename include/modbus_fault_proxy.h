@@ -0,0 +1,156 @@
+// include/modbus_fault_proxy.h
+
+#ifndef MODBUS_FAULT_PROXY_H
+#define MODBUS_FAULT_PROXY_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace test_modbus_485 {
+
+/**
+ * @brief Line faults a ModbusFaultProxy can inject.
+ */
+enum class ModbusFault {
+    CorruptCrc,      ///< Flip a bit in the CRC of the next response.
+    DropByte,        ///< Remove one byte from the middle of the next response.
+    DuplicateByte,   ///< Send one byte of the next response twice.
+    Truncate,        ///< Send only the first half of the next response.
+    StretchGap,      ///< Pause inside the next response for longer than the master's byte timeout.
+    SlaveStall,      ///< Swallow every request for stallDuration.
+    PortLoss         ///< Remove the master's port for portLossDuration, then bring up a new one at the same path.
+};
+
+constexpr int modbusFaultCount = 7;
+
+/**
+ * @brief Short name of a fault ("crc", "drop", "dup", "truncate", "gap", "stall", "port").
+ */
+const char* modbusFaultName(ModbusFault fault);
+
+/**
+ * @brief Fault from its short name.
+ * @return True if the name is known.
+ */
+bool parseModbusFault(const std::string& name, ModbusFault& fault);
+
+/**
+ * @brief Timing of the faults of a ModbusFaultProxy.
+ */
+struct ModbusFaultOptions {
+    std::chrono::microseconds stretchedGap{20000};     ///< Pause of StretchGap; the default byte timeout is t3.5 + 5 ms.
+    std::chrono::milliseconds stallDuration{100};
+    std::chrono::milliseconds portLossDuration{1000};
+};
+
+/**
+ * @brief When the last injected fault started and when the line was clean again.
+ */
+struct ModbusFaultEvent {
+    ModbusFault                           fault = ModbusFault::CorruptCrc;
+    std::chrono::steady_clock::time_point injected;  ///< Faulty frame started, stall started or port removed.
+    std::chrono::steady_clock::time_point cleared;   ///< Faulty frame sent, stall over or port back.
+    bool                                  active = false;
+};
+
+/**
+ * @brief Man-in-the-middle between a master and its slaves that breaks the line on request.
+ *
+ * The master opens linkPath(), a symlink to the slave end of a pty pair the
+ * proxy owns; the proxy forwards requests unchanged to the slave-side
+ * descriptor and forwards responses back frame by frame, so a fault can hit
+ * exactly one response. PortLoss closes the pty and removes the symlink,
+ * which the master sees as a dead port, and later points the symlink at a
+ * new pty, like a USB adapter that drops off and re-enumerates. Used by
+ * modbus_fault_bench to measure how long ModbusUtils takes to recover.
+ */
+class ModbusFaultProxy {
+public:
+    ModbusFaultProxy();
+
+    /**
+     * @brief Destructor stops the thread and removes the symlink; does not close the slave-side descriptor.
+     */
+    ~ModbusFaultProxy();
+
+    ModbusFaultProxy(const ModbusFaultProxy&) = delete;
+    ModbusFaultProxy& operator=(const ModbusFaultProxy&) = delete;
+
+    /**
+     * @brief Create the master's port at linkPath and start forwarding.
+     * @param[in] linkPath Path the master opens; an existing symlink there is replaced.
+     * @param[in] slaveFileDescriptor Raw, non-blocking descriptor of the slave side (e.g. a pty end a
+     *            ModbusSlaveSimulator serves).
+     * @param[in] baudRate Line rate, for the t3.5 that ends a partial response.
+     * @return True on success.
+     */
+    bool start(const std::string& linkPath, int slaveFileDescriptor, int baudRate,
+               const ModbusFaultOptions& options = ModbusFaultOptions());
+
+    void stop();
+
+    /**
+     * @brief Inject a fault: frame faults hit the next response, stalls and port loss start now.
+     * @return False while the previous fault is still active.
+     */
+    bool inject(ModbusFault fault);
+
+    /**
+     * @brief The last injected fault; cleared is valid once active is false.
+     */
+    ModbusFaultEvent lastFault() const;
+
+    const std::string& linkPath() const;
+
+    /**
+     * @brief Responses forwarded, faulty ones included.
+     */
+    uint64_t responseCount() const;
+
+    /**
+     * @brief Faults applied so far, indexed by ModbusFault.
+     */
+    std::array<uint64_t, modbusFaultCount> faultCounts() const;
+
+private:
+    bool openMasterPort();
+    void closeMasterPort();
+    void run();
+
+    /**
+     * @brief Forward one complete response, applying an armed frame fault.
+     */
+    void forwardResponse(const uint8_t* frame, int length);
+
+    bool writeMaster(const uint8_t* data, int length);
+
+    /**
+     * @brief Mark the active fault over; faultMutex_ held.
+     */
+    void clearFault();
+
+    std::string                            linkPath_;
+    int                                    masterFileDescriptor_;
+    int                                    slaveFileDescriptor_;
+    std::chrono::nanoseconds               frameGap_{0};
+    ModbusFaultOptions                     options_;
+    std::thread                            thread_;
+    std::atomic<bool>                      running_{false};
+
+    mutable std::mutex                     faultMutex_;
+    ModbusFaultEvent                       fault_;
+    bool                                   armed_ = false;          ///< A frame fault waits for the next response.
+    std::chrono::steady_clock::time_point  stallUntil_;
+    std::chrono::steady_clock::time_point  portBackAt_;
+    std::atomic<uint64_t>                  responses_{0};
+    std::array<uint64_t, modbusFaultCount> faultCounts_{};
+};
+
+} // namespace test_modbus_485
+
+#endif // MODBUS_FAULT_PROXY_H
@@ -0,0 +1,78 @@
+// include/modbus_image_slave.h
+
+#ifndef MODBUS_IMAGE_SLAVE_H
+#define MODBUS_IMAGE_SLAVE_H
+
+#include "modbus_metrics.h"
+#include "modbus_register_image.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+namespace test_modbus_485 {
+
+/**
+ * @brief Counters of a ModbusImageSlave.
+ */
+struct ModbusImageSlaveStatistics {
+    uint64_t                 requests = 0;     ///< Requests answered, including broadcasts.
+    uint64_t                 dropped = 0;      ///< Frames with a bad CRC or length, or for another slave.
+    LatencyHistogramSnapshot turnaround;       ///< Last request byte read to reply written.
+};
+
+/**
+ * @brief An RTU slave that answers from a ModbusRegisterImage on its own thread.
+ *
+ * The thread does nothing but frame requests, execute them against the
+ * image and write the reply: no modbus_reply(), no logging, no simulation.
+ * Whatever the slave pretends to measure is put into the image by other
+ * threads through ModbusRegisterImage::Update, so the turnaround a master
+ * sees is the slave's framing and a lock-free copy, not its workload.
+ */
+class ModbusImageSlave {
+public:
+    /**
+     * @param[in] image Tables to serve; must outlive the slave.
+     * @param[in] slaveIdentifier Address answered to; broadcasts are applied without a reply.
+     */
+    ModbusImageSlave(ModbusRegisterImage& image, int slaveIdentifier);
+
+    /**
+     * @brief Destructor stops the thread; does not close the descriptor.
+     */
+    ~ModbusImageSlave();
+
+    ModbusImageSlave(const ModbusImageSlave&) = delete;
+    ModbusImageSlave& operator=(const ModbusImageSlave&) = delete;
+
+    /**
+     * @brief Serve requests that arrive on a descriptor (a configured serial port or a pty end).
+     * @param[in] fileDescriptor Descriptor to serve, not owned.
+     * @param[in] baudRate Line speed; t3.5 of silence drops a partial frame.
+     * @param[in] bitsPerCharacter Start + data + parity/stop bits.
+     * @return True on success.
+     */
+    bool start(int fileDescriptor, int baudRate = 115200, int bitsPerCharacter = 10);
+
+    void stop();
+
+    ModbusImageSlaveStatistics statistics() const;
+
+private:
+    void run();
+
+    ModbusRegisterImage&     image_;
+    int                      slaveIdentifier_;
+    int                      fileDescriptor_;
+    std::chrono::nanoseconds frameSilence_;
+    std::thread              thread_;
+    std::atomic<bool>        running_;
+    std::atomic<uint64_t>    requests_;
+    std::atomic<uint64_t>    dropped_;
+    LatencyHistogram         turnaround_;
+};
+
+} // namespace test_modbus_485
+
+#endif // MODBUS_IMAGE_SLAVE_H
@@ -0,0 +1,74 @@
+// include/modbus_loopback_transport.h
+
+#ifndef MODBUS_LOOPBACK_TRANSPORT_H
+#define MODBUS_LOOPBACK_TRANSPORT_H
+
+#include "modbus_data_model.h"
+#include "modbus_transport.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace test_modbus_485 {
+
+/**
+ * @brief Line emulation of a ModbusLoopbackTransport.
+ */
+struct ModbusLoopbackOptions {
+    int                       baudRate = 115200;
+    int                       bitsPerCharacter = 10;
+    bool                      emulateWireTime = false;  ///< Hold each exchange for the time both frames take on the line.
+    std::chrono::microseconds turnaround{0};            ///< Extra slave processing time per request.
+};
+
+/**
+ * @brief In-process transport from a master straight to ModbusDataModel slaves.
+ *
+ * Every exchange runs the full RTU path in memory: the request ADU is built
+ * and CRC'd, checked and parsed on the slave side, answered from the data
+ * model, and the reply ADU is checked and unpacked again. Without wire-time
+ * emulation a transaction costs only framing, CRC and copies, which is what
+ * the software overhead of the layers above is measured against.
+ */
+class ModbusLoopbackTransport : public ModbusTransport {
+public:
+    explicit ModbusLoopbackTransport(const ModbusLoopbackOptions& options = ModbusLoopbackOptions());
+
+    /**
+     * @brief Answer requests to a slave identifier from a data model.
+     * @param[in] slaveIdentifier 1..247.
+     * @param[in] model Tables of that slave, not owned.
+     * @return True on success.
+     */
+    bool addSlave(int slaveIdentifier, ModbusDataModel& model);
+
+    /**
+     * @brief Bytes framed in both directions, CRC included.
+     */
+    uint64_t bytesTransferred() const;
+
+    int transact(int slaveIdentifier,
+                 const uint8_t* request,
+                 int requestLength,
+                 uint8_t* response,
+                 int responseCapacity) override;
+    void setTimeouts(std::chrono::microseconds responseTimeout,
+                     std::chrono::microseconds byteTimeout) override;
+    void flush() override;
+    bool reconnect() override;
+    int baudRate() const override;
+    int bitsPerCharacter() const override;
+
+private:
+    void holdLine(std::chrono::steady_clock::time_point& clock, std::chrono::nanoseconds duration) const;
+
+    ModbusLoopbackOptions                 options_;
+    std::array<ModbusDataModel*, 248>     slaves_{};
+    std::chrono::microseconds             responseTimeout_{500000};
+    std::atomic<uint64_t>                 bytes_{0};
+};
+
+} // namespace test_modbus_485
+
+#endif // MODBUS_LOOPBACK_TRANSPORT_H
@@ -0,0 +1,208 @@
+// include/modbus_metrics.h
+
+#ifndef MODBUS_METRICS_H
+#define MODBUS_METRICS_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+namespace test_modbus_485 {
+
+/**
+ * @brief Percentiles of a latency distribution, in microseconds.
+ */
+struct LatencySummary {
+    uint64_t count;
+    double   mean;
+    double   p50;
+    double   p90;
+    double   p99;
+    double   p999;
+    double   max;
+};
+
+/**
+ * @brief Point-in-time copy of a LatencyHistogram.
+ */
+struct LatencyHistogramSnapshot {
+    static constexpr int bucketCount = 240;
+
+    std::array<uint64_t, bucketCount> buckets{};
+    uint64_t                          count = 0;
+    uint64_t                          sumMicroseconds = 0;
+    uint64_t                          maxMicroseconds = 0;
+
+    /**
+     * @brief Latency below which the given fraction of samples fall.
+     * @param[in] quantile Fraction in [0, 1].
+     * @return Microseconds, within one bucket (12.5 %) of the exact value; 0 when empty.
+     */
+    double percentile(double quantile) const;
+
+    LatencySummary summary() const;
+};
+
+/**
+ * @brief Log-linear latency histogram, safe to record from any thread.
+ *
+ * Eight sub-buckets per power of two of microseconds, up to about 71 minutes.
+ * record() is a handful of relaxed atomic increments and never blocks.
+ */
+class LatencyHistogram {
+public:
+    LatencyHistogram();
+
+    void record(std::chrono::nanoseconds latency);
+
+    /**
+     * @brief Zero all buckets; samples recorded concurrently may be kept or lost.
+     */
+    void reset();
+
+    LatencyHistogramSnapshot snapshot() const;
+
+    /**
+     * @brief Bucket a value in microseconds falls into.
+     */
+    static int bucketIndex(uint64_t microseconds);
+
+    /**
+     * @brief Smallest value in microseconds of a bucket.
+     */
+    static uint64_t bucketLowerBound(int index);
+
+private:
+    std::array<std::atomic<uint64_t>, LatencyHistogramSnapshot::bucketCount> buckets_;
+    std::atomic<uint64_t> sumMicroseconds_;
+    std::atomic<uint64_t> maxMicroseconds_;
+};
+
+/**
+ * @brief Latency and error counters of one function code, one slave, or all traffic.
+ */
+struct ModbusMetricsEntry {
+    int                      key;          ///< Function code or slave ID; -1 for the total.
+    LatencyHistogramSnapshot latency;      ///< Completed transactions, successful or not.
+    uint64_t                 timeouts;
+    uint64_t                 crcErrors;
+    uint64_t                 exceptions;   ///< Exception responses from the slave.
+    uint64_t                 otherErrors;
+};
+
+/**
+ * @brief Recovery actions ModbusUtils takes after a failed transaction.
+ */
+enum class ModbusRecoveryKind {
+    Resync,   ///< Flush the line and retry (timeouts, CRC and framing errors).
+    Reopen    ///< Close and reopen the port (I/O errors).
+};
+
+/**
+ * @brief Time from the first failure to success or giving up, per recovery kind.
+ */
+struct ModbusRecoveryEntry {
+    LatencyHistogramSnapshot duration;
+    uint64_t                 recovered;
+    uint64_t                 failed;
+};
+
+/**
+ * @brief Snapshot of a ModbusMetrics instance.
+ */
+struct ModbusMetricsSnapshot {
+    ModbusMetricsEntry              total;
+    std::vector<ModbusMetricsEntry> functions;   ///< Function codes that saw traffic, ascending.
+    std::vector<ModbusMetricsEntry> slaves;      ///< Slaves that saw traffic, ascending.
+    ModbusRecoveryEntry             resync;
+    ModbusRecoveryEntry             reopen;
+    uint64_t                        reconnects;
+    uint64_t                        reconnectFailures;
+
+    /**
+     * @brief Print a table with count, p50/p90/p99/p99.9/max and error counters per row.
+     */
+    void print(std::ostream& stream) const;
+};
+
+/**
+ * @brief Always-on transaction instrumentation of a ModbusUtils instance.
+ *
+ * Histograms per function code and per slave are allocated on first use and
+ * live until destruction, so recording is lock-free and allocation-free after
+ * warm-up.
+ */
+class ModbusMetrics {
+public:
+    ModbusMetrics();
+    ~ModbusMetrics();
+
+    ModbusMetrics(const ModbusMetrics&) = delete;
+    ModbusMetrics& operator=(const ModbusMetrics&) = delete;
+
+    /**
+     * @brief Record one finished transaction.
+     * @param[in] slaveIdentifier Unit ID the request went to.
+     * @param[in] functionCode Modbus function code.
+     * @param[in] latency Time from sending the request to the reply or error.
+     * @param[in] errorCode 0 on success, otherwise errno as left by libmodbus.
+     */
+    void recordTransaction(int slaveIdentifier,
+                           int functionCode,
+                           std::chrono::nanoseconds latency,
+                           int errorCode);
+
+    /**
+     * @brief Count a reconnect attempt.
+     */
+    void recordReconnect(bool success);
+
+    /**
+     * @brief Record how long a recovery took.
+     * @param[in] kind Most drastic action that was taken.
+     * @param[in] duration From the start of the first failed attempt to the final result.
+     * @param[in] recovered Whether the transaction eventually succeeded.
+     */
+    void recordRecovery(ModbusRecoveryKind kind, std::chrono::nanoseconds duration, bool recovered);
+
+    ModbusMetricsSnapshot snapshot() const;
+
+    void reset();
+
+private:
+    struct Counters {
+        LatencyHistogram      latency;
+        std::atomic<uint64_t> timeouts{0};
+        std::atomic<uint64_t> crcErrors{0};
+        std::atomic<uint64_t> exceptions{0};
+        std::atomic<uint64_t> otherErrors{0};
+    };
+
+    struct Recovery {
+        LatencyHistogram      duration;
+        std::atomic<uint64_t> recovered{0};
+        std::atomic<uint64_t> failed{0};
+    };
+
+    static Counters* slot(std::atomic<Counters*>& entry);
+    static void record(Counters& counters, std::chrono::nanoseconds latency, int errorCode);
+    static ModbusMetricsEntry read(const Counters& counters, int key);
+    static void clear(Counters& counters);
+    static ModbusRecoveryEntry read(const Recovery& recovery);
+    static void clear(Recovery& recovery);
+
+    Counters                              total_;
+    std::array<std::atomic<Counters*>, 128> functions_;
+    std::array<std::atomic<Counters*>, 248> slaves_;
+    Recovery                              resync_;
+    Recovery                              reopen_;
+    std::atomic<uint64_t>                 reconnects_;
+    std::atomic<uint64_t>                 reconnectFailures_;
+};
+
+} // namespace test_modbus_485
+
+#endif // MODBUS_METRICS_H
@@ -0,0 +1,138 @@
+// include/modbus_point_reader.h
+
+#ifndef MODBUS_POINT_READER_H
+#define MODBUS_POINT_READER_H
+
+#include "modbus_utils.h"
+#include <cstdint>
+#include <vector>
+
+namespace test_modbus_485 {
+
+/**
+ * @brief A contiguous address range inside one table.
+ */
+struct ModbusReadRange {
+    int startAddress;
+    int count;
+};
+
+/**
+ * @brief Largest number of items one read request may return for a table (2000 bits, 125 registers).
+ */
+int maximumReadCount(ModbusTable table);
+
+/**
+ * @brief Default gap cost for a table, in items of that table.
+ *
+ * One extra RTU request costs roughly 13 frame bytes, two t3.5 gaps and the
+ * slave turnaround, about 32 character times, i.e. 16 registers or 256 bits.
+ */
+int defaultGapCost(ModbusTable table);
+
+/**
+ * @brief Compute the cheapest set of read requests covering the given ranges.
+ *
+ * Overlapping or adjacent ranges always share a request; beyond that the
+ * ranges are grouped so that (requests * gapCost + items read) is minimal,
+ * i.e. a gap is read through whenever it is shorter than gapCost.
+ * @param[in] ranges Ranges to cover, in any order.
+ * @param[in] maximumCount Largest count a single request may have.
+ * @param[in] gapCost Cost of one extra request, in items.
+ * @return Covering requests sorted by address; empty if a range exceeds maximumCount.
+ */
+std::vector<ModbusReadRange> coalesceReadRanges(std::vector<ModbusReadRange> ranges,
+                                                int maximumCount,
+                                                int gapCost);
+
+/**
+ * @brief Reads scattered points with the fewest FC01/FC02/FC03/FC04 requests.
+ *
+ * Points are registered once, plan() groups them per table with
+ * coalesceReadRanges(), and every read() scatters the results back to the
+ * individual points.
+ */
+class ModbusPointReader {
+public:
+    /**
+     * @brief Construct a reader that issues its requests through the given utility.
+     * @param[in] modbusUtils Utility used to talk to the slave.
+     */
+    explicit ModbusPointReader(ModbusUtils& modbusUtils);
+
+    /**
+     * @brief Register a point.
+     * @param[in] table Table the point lives in.
+     * @param[in] address Address of the point inside the table.
+     * @return Handle used with value() and isValid(), -1 on an invalid address.
+     */
+    int addPoint(ModbusTable table, int address);
+
+    /**
+     * @brief Set how many unused items are worth reading to save one request.
+     * @param[in] table Table the cost applies to.
+     * @param[in] gapCost Cost of one extra request, in items of that table.
+     */
+    void setGapCost(ModbusTable table, int gapCost);
+
+    /**
+     * @brief Group the registered points into read requests.
+     * @return True if a plan could be built.
+     */
+    bool plan();
+
+    /**
+     * @brief Issue every planned request and scatter the results to the points.
+     *
+     * A failed request invalidates only its own points; the remaining
+     * requests are still sent.
+     * @param[in,out] contextReference Modbus context; replaced if the port has to be reopened.
+     * @return True if every request succeeded.
+     */
+    bool read(modbus_t*& contextReference);
+
+    /**
+     * @brief Last value of a point: the register value, or 0/1 for bit tables.
+     */
+    uint16_t value(int handle) const;
+
+    /**
+     * @brief Whether the last read() delivered a value for the point.
+     */
+    bool isValid(int handle) const;
+
+    /**
+     * @brief Number of requests one read() sends.
+     */
+    int requestCount() const;
+
+    /**
+     * @brief Planned requests of one table.
+     */
+    std::vector<ModbusReadRange> requests(ModbusTable table) const;
+
+private:
+    struct Point {
+        ModbusTable table;
+        int         address;
+        int         request;
+        int         offset;
+    };
+
+    struct Request {
+        ModbusTable           table;
+        ModbusReadRange       range;
+        std::vector<uint16_t> registers;
+        std::vector<uint8_t>  bits;
+        bool                  valid;
+    };
+
+    ModbusUtils&         modbusUtils_;
+    std::vector<Point>   points_;
+    std::vector<Request> requests_;
+    int                  gapCosts_[4];
+};
+
+} // namespace test_modbus_485
+
+#endif // MODBUS_POINT_READER_H
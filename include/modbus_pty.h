@@ -0,0 +1,24 @@
+// include/modbus_pty.h
+
+#ifndef MODBUS_PTY_H
+#define MODBUS_PTY_H
+
+#include <string>
+
+namespace test_modbus_485 {
+
+/**
+ * @brief Open a raw pseudo-terminal pair to stand in for an RS-485 line.
+ *
+ * Whatever is written to one end arrives at the other, so a master and a
+ * slave can run in one process without hardware. The slave end can be
+ * opened by path (e.g. with ModbusUtils::openRtu()).
+ * @param[out] masterFileDescriptor Non-blocking master end.
+ * @param[out] slaveDevicePath Path of the slave end, e.g. /dev/pts/7.
+ * @return True on success.
+ */
+bool openPtyPair(int& masterFileDescriptor, std::string& slaveDevicePath);
+
+} // namespace test_modbus_485
+
+#endif // MODBUS_PTY_H
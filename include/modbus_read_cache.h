@@ -0,0 +1,191 @@
+// include/modbus_read_cache.h
+
+#ifndef MODBUS_READ_CACHE_H
+#define MODBUS_READ_CACHE_H
+
+#include "modbus_utils.h"
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace test_modbus_485 {
+
+/**
+ * @brief Counters of a ModbusReadCache.
+ */
+struct ModbusReadCacheStatistics {
+    uint64_t                 hits = 0;           ///< Reads served from a fresh entry.
+    uint64_t                 misses = 0;         ///< Reads that went to the bus.
+    uint64_t                 coalesced = 0;      ///< Reads served by another thread's read in flight.
+    uint64_t                 invalidations = 0;  ///< Writes that dropped entries or in-flight results.
+    std::chrono::nanoseconds busTimeSaved{0};    ///< Sum of the round trips hits and coalesced reads avoided.
+};
+
+/**
+ * @brief Short-lived read cache with single-flight deduplication, shared by ModbusUtils instances.
+ *
+ * Entries are keyed by (slave, table, address range) and live for the TTL of
+ * the configured range they fall into; reads outside every configured range
+ * use the default TTL, and a TTL of zero bypasses the cache. A read covered
+ * by a fresh entry is copied from it. A read overlapping one in flight waits
+ * for that result, then is served from it if it covers the range, or goes
+ * to the bus itself otherwise. Writes invalidate overlapping entries and keep
+ * results of overlapping reads already in flight from being stored.
+ * Thread-safe; attach with ModbusUtils::attachReadCache().
+ */
+class ModbusReadCache {
+public:
+    /**
+     * @param[in] defaultTimeToLive TTL of reads outside every configured range; 0 bypasses them.
+     */
+    explicit ModbusReadCache(std::chrono::microseconds defaultTimeToLive = std::chrono::microseconds(0));
+
+    /**
+     * @brief Cache reads that lie inside a range for a given time; later calls take precedence.
+     * @param[in] slaveIdentifier Slave, 0 for every slave.
+     */
+    void setTimeToLive(int slaveIdentifier,
+                       ModbusTable table,
+                       int startAddress,
+                       int count,
+                       std::chrono::microseconds timeToLive);
+
+    /**
+     * @brief Serve a read from the cache, from a read in flight, or by calling fetch.
+     * @param[out] destination Receives count values.
+     * @param[in] fetch Callable filling destination from the bus; returns count or -1 with errno set.
+     * @return count, or -1 with errno set.
+     */
+    template<typename Value, typename Fetch>
+    int read(int slaveIdentifier, ModbusTable table, int startAddress, int count, Value* destination, Fetch fetch);
+
+    /**
+     * @brief Drop everything a write to a range may have changed.
+     * @param[in] slaveIdentifier Slave written to, 0 for a broadcast.
+     */
+    void invalidate(int slaveIdentifier, ModbusTable table, int startAddress, int count);
+
+    /**
+     * @brief Drop all entries.
+     */
+    void clear();
+
+    ModbusReadCacheStatistics statistics() const;
+    void resetStatistics();
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Range {
+        int         slaveIdentifier;
+        ModbusTable table;
+        int         startAddress;
+        int         count;
+
+        bool covers(const Range& other) const;
+        bool overlaps(const Range& other) const;
+    };
+
+    struct TimeToLive {
+        Range                     range;
+        std::chrono::microseconds value;
+    };
+
+    struct Entry {
+        Range                    range;
+        std::vector<uint16_t>    values;
+        Clock::time_point        expires;
+        std::chrono::nanoseconds latency;
+    };
+
+    struct Flight {
+        Range range;
+        bool  done = false;
+        bool  stale = false;  ///< Overlapping write while in flight; do not store.
+    };
+
+    std::chrono::microseconds timeToLiveLocked(const Range& range) const;
+    const Entry* findFreshLocked(const Range& range, Clock::time_point now) const;
+    std::shared_ptr<Flight> findFlightLocked(const Range& range) const;
+    void storeLocked(const Range& range,
+                     std::vector<uint16_t>& values,
+                     std::chrono::microseconds timeToLive,
+                     std::chrono::nanoseconds latency);
+    void finishFlightLocked(const std::shared_ptr<Flight>& flight);
+
+    mutable std::mutex                   mutex_;
+    std::condition_variable              flightDone_;
+    std::chrono::microseconds            defaultTimeToLive_;
+    std::vector<TimeToLive>              timesToLive_;
+    std::vector<Entry>                   entries_;
+    std::vector<std::shared_ptr<Flight>> flights_;
+    ModbusReadCacheStatistics            statistics_;
+};
+
+template<typename Value, typename Fetch>
+int ModbusReadCache::read(int slaveIdentifier,
+                          ModbusTable table,
+                          int startAddress,
+                          int count,
+                          Value* destination,
+                          Fetch fetch) {
+    const Range range{slaveIdentifier, table, startAddress, count};
+    std::unique_lock<std::mutex> lock(mutex_);
+    const std::chrono::microseconds timeToLive = timeToLiveLocked(range);
+    if (timeToLive.count() <= 0 || slaveIdentifier == MODBUS_BROADCAST_ADDRESS) {
+        lock.unlock();
+        return fetch();
+    }
+
+    bool waited = false;
+    for (;;) {
+        if (const Entry* entry = findFreshLocked(range, Clock::now())) {
+            const int offset = startAddress - entry->range.startAddress;
+            for (int i = 0; i < count; ++i) {
+                destination[i] = static_cast<Value>(entry->values[offset + i]);
+            }
+            ++(waited ? statistics_.coalesced : statistics_.hits);
+            statistics_.busTimeSaved += entry->latency;
+            return count;
+        }
+        std::shared_ptr<Flight> flight = findFlightLocked(range);
+        if (!flight) {
+            break;
+        }
+        waited = true;
+        flightDone_.wait(lock, [&flight] { return flight->done; });
+    }
+
+    ++statistics_.misses;
+    std::shared_ptr<Flight> flight = std::make_shared<Flight>();
+    flight->range = range;
+    flights_.push_back(flight);
+    lock.unlock();
+
+    const Clock::time_point started = Clock::now();
+    const int result = fetch();
+    const int errorCode = errno;
+    const std::chrono::nanoseconds latency = Clock::now() - started;
+
+    std::vector<uint16_t> values;
+    if (result == count) {
+        values.assign(destination, destination + count);
+    }
+    lock.lock();
+    if (result == count && !flight->stale) {
+        storeLocked(range, values, timeToLive, latency);
+    }
+    finishFlightLocked(flight);
+    lock.unlock();
+    flightDone_.notify_all();
+    errno = errorCode;
+    return result;
+}
+
+} // namespace test_modbus_485
+
+#endif // MODBUS_READ_CACHE_H
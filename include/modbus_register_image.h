@@ -0,0 +1,132 @@
+// include/modbus_register_image.h
+
+#ifndef MODBUS_REGISTER_IMAGE_H
+#define MODBUS_REGISTER_IMAGE_H
+
+#include "modbus_utils.h"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+namespace test_modbus_485 {
+
+/**
+ * @brief The four tables of a slave over the full 0..65535 address range, shared under a seqlock.
+ *
+ * Tables are paged: a page of pageSize entries is allocated the first time
+ * something is written to it, and addresses on pages never written read as
+ * 0, so a slave with a few scattered blocks costs a few KiB rather than a
+ * full mapping. Writers (an Update, or write requests in process()) are
+ * serialised by a mutex and bump a sequence counter around their stores.
+ * Readers never take a lock: they copy the range and retry if the counter
+ * moved, so a reply always sees one complete update or none of it, and
+ * only ever waits out an update in progress, not the updater's thread.
+ */
+class ModbusRegisterImage {
+public:
+    static constexpr int addressCount = 65536;
+    static constexpr int pageSize = 256;
+
+    /**
+     * @brief A batch of stores that readers see all at once; holds the write lock while alive.
+     */
+    class Update {
+    public:
+        explicit Update(ModbusRegisterImage& image);
+        ~Update();
+
+        Update(const Update&) = delete;
+        Update& operator=(const Update&) = delete;
+
+        /**
+         * @brief Store registers in the holding or input register table.
+         */
+        void setRegisters(ModbusTable table, int startAddress, const uint16_t* source, int count);
+
+        /**
+         * @brief Store bits, one byte per bit, in the coil or discrete input table.
+         */
+        void setBits(ModbusTable table, int startAddress, const uint8_t* source, int count);
+
+    private:
+        ModbusRegisterImage&        image_;
+        std::lock_guard<std::mutex> lock_;
+    };
+
+    ModbusRegisterImage();
+    ~ModbusRegisterImage();
+
+    ModbusRegisterImage(const ModbusRegisterImage&) = delete;
+    ModbusRegisterImage& operator=(const ModbusRegisterImage&) = delete;
+
+    /**
+     * @brief Consistent copy of registers from the holding or input register table.
+     * @return False if the range leaves the address space.
+     */
+    bool readRegisters(ModbusTable table, int startAddress, int count, uint16_t* destination) const;
+
+    /**
+     * @brief Consistent copy of bits, one byte per bit, from the coil or discrete input table.
+     * @return False if the range leaves the address space.
+     */
+    bool readBits(ModbusTable table, int startAddress, int count, uint8_t* destination) const;
+
+    /**
+     * @brief Execute one request PDU against the image, like ModbusDataModel::process().
+     *
+     * Reads take no lock; writes take the write lock for the stores only.
+     * @param[in] request Request PDU (function code first).
+     * @param[in] length PDU length.
+     * @param[out] response Buffer of at least MODBUS_MAX_PDU_LENGTH bytes.
+     * @return Response PDU length; exception replies are 2 bytes (fc | 0x80, code).
+     */
+    int process(const uint8_t* request, int length, uint8_t* response);
+
+    /**
+     * @brief Pages allocated over all four tables; memory use is about pageSize * 2 bytes each.
+     */
+    size_t pageCount() const;
+
+    /**
+     * @brief Reads repeated because an update overlapped them.
+     */
+    uint64_t readRetries() const;
+
+private:
+    struct Page {
+        std::array<std::atomic<uint16_t>, pageSize> values;
+    };
+
+    static constexpr int pagesPerTable = addressCount / pageSize;
+
+    /**
+     * @brief Copy a range under the seqlock; Value is uint16_t for registers, uint8_t for bits.
+     */
+    template<typename Value>
+    void load(ModbusTable table, int startAddress, int count, Value* destination) const;
+
+    /**
+     * @brief Store one value; caller holds the write lock with the sequence odd.
+     */
+    void store(ModbusTable table, int address, uint16_t value);
+
+    /**
+     * @brief Value at an address for a caller holding the write lock.
+     */
+    uint16_t storedValue(ModbusTable table, int address) const;
+
+    void beginWrite();
+    void endWrite();
+
+    std::array<std::array<std::atomic<Page*>, pagesPerTable>, 4> pages_;
+    std::atomic<uint32_t>                                     sequence_;
+    std::atomic<size_t>                                       pageCount_;
+    mutable std::atomic<uint64_t>                             readRetries_;
+    std::mutex                                                writeMutex_;
+};
+
+} // namespace test_modbus_485
+
+#endif // MODBUS_REGISTER_IMAGE_H
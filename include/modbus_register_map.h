@@ -0,0 +1,325 @@
+// include/modbus_register_map.h
+
+#ifndef MODBUS_REGISTER_MAP_H
+#define MODBUS_REGISTER_MAP_H
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace test_modbus_485 {
+
+/**
+ * @brief Encoding of a point in the register table.
+ */
+enum class ModbusPointType {
+    UInt16,
+    Int16,
+    UInt32,   ///< Two registers.
+    Int32,    ///< Two registers.
+    Float32   ///< Two registers, IEEE 754 single precision.
+};
+
+/**
+ * @brief Register order of 32-bit points; bytes within a register are always big-endian on the wire.
+ */
+enum class ModbusWordOrder {
+    HighFirst,  ///< Most significant word at the lower address (Modicon order).
+    LowFirst    ///< Least significant word at the lower address ("word swapped").
+};
+
+/**
+ * @brief One point of a register map: engineering value = raw * scale.
+ */
+struct ModbusPoint {
+    int             address;
+    ModbusPointType type;
+    double          scale = 1.0;
+    ModbusWordOrder wordOrder = ModbusWordOrder::HighFirst;
+
+    constexpr int words() const {
+        return type == ModbusPointType::UInt16 || type == ModbusPointType::Int16 ? 1 : 2;
+    }
+
+    constexpr int end() const {
+        return address + words();
+    }
+
+    /**
+     * @brief Same encoding, so consecutive points can be decoded by one loop.
+     */
+    constexpr bool sameEncoding(const ModbusPoint& other) const {
+        return type == other.type && scale == other.scale && wordOrder == other.wordOrder;
+    }
+};
+
+/**
+ * @brief Engineering value of a point.
+ * @param[in] registers Registers of the point, starting at its address.
+ */
+template<typename Value = double>
+inline Value decodePoint(const ModbusPoint& point, const uint16_t* registers) {
+    const int high = point.wordOrder == ModbusWordOrder::HighFirst ? 0 : 1;
+    const uint32_t raw32 = point.words() == 2
+                               ? (static_cast<uint32_t>(registers[high]) << 16) | registers[1 - high]
+                               : registers[0];
+    const Value scale = static_cast<Value>(point.scale);
+    switch (point.type) {
+    case ModbusPointType::UInt16:
+        return static_cast<Value>(registers[0]) * scale;
+    case ModbusPointType::Int16:
+        return static_cast<Value>(static_cast<int16_t>(registers[0])) * scale;
+    case ModbusPointType::UInt32:
+        return static_cast<Value>(raw32) * scale;
+    case ModbusPointType::Int32:
+        return static_cast<Value>(static_cast<int32_t>(raw32)) * scale;
+    case ModbusPointType::Float32: {
+        float value;
+        std::memcpy(&value, &raw32, sizeof(value));
+        return static_cast<Value>(value) * scale;
+    }
+    }
+    return Value();
+}
+
+/**
+ * @brief Store an engineering value into the registers of a point, rounded and clamped to its type.
+ * @param[out] registers Registers of the point, starting at its address.
+ */
+template<typename Value>
+inline void encodePoint(const ModbusPoint& point, Value value, uint16_t* registers) {
+    const double scaled = static_cast<double>(value) / point.scale;
+    uint32_t raw32 = 0;
+    auto clamp = [scaled](double lowest, double highest) {
+        const double rounded = std::nearbyint(scaled);
+        return rounded < lowest ? lowest : (rounded > highest ? highest : rounded);
+    };
+    switch (point.type) {
+    case ModbusPointType::UInt16:
+        registers[0] = static_cast<uint16_t>(clamp(0.0, 65535.0));
+        return;
+    case ModbusPointType::Int16:
+        registers[0] = static_cast<uint16_t>(static_cast<int16_t>(clamp(-32768.0, 32767.0)));
+        return;
+    case ModbusPointType::UInt32:
+        raw32 = static_cast<uint32_t>(clamp(0.0, 4294967295.0));
+        break;
+    case ModbusPointType::Int32:
+        raw32 = static_cast<uint32_t>(static_cast<int32_t>(clamp(-2147483648.0, 2147483647.0)));
+        break;
+    case ModbusPointType::Float32: {
+        const float single = static_cast<float>(scaled);
+        std::memcpy(&raw32, &single, sizeof(raw32));
+        break;
+    }
+    }
+    const int high = point.wordOrder == ModbusWordOrder::HighFirst ? 0 : 1;
+    registers[high] = static_cast<uint16_t>(raw32 >> 16);
+    registers[1 - high] = static_cast<uint16_t>(raw32);
+}
+
+namespace detail {
+
+template<int High, typename Raw, typename Value>
+inline void decodeWordPairs(int count, const uint16_t* registers, Value scale, Value* values) {
+    for (int i = 0; i < count; ++i) {
+        const uint32_t bits = (static_cast<uint32_t>(registers[2 * i + High]) << 16) | registers[2 * i + 1 - High];
+        Raw raw;
+        std::memcpy(&raw, &bits, sizeof(raw));
+        values[i] = static_cast<Value>(raw) * scale;
+    }
+}
+
+template<typename Raw, typename Value>
+inline void decodeWordPairs(ModbusWordOrder wordOrder, int count, const uint16_t* registers, Value scale,
+                            Value* values) {
+    // Constant word offsets keep the loop vectorisable.
+    if (wordOrder == ModbusWordOrder::HighFirst) {
+        decodeWordPairs<0, Raw>(count, registers, scale, values);
+    } else {
+        decodeWordPairs<1, Raw>(count, registers, scale, values);
+    }
+}
+
+} // namespace detail
+
+/**
+ * @brief Decode count adjacent points of one encoding; plain loops the compiler vectorises.
+ * @param[in] registers Registers of the first point.
+ * @param[out] values One value per point.
+ */
+template<typename Value>
+inline void decodePoints(const ModbusPoint& encoding, int count, const uint16_t* registers, Value* values) {
+    const Value scale = static_cast<Value>(encoding.scale);
+    switch (encoding.type) {
+    case ModbusPointType::UInt16:
+        for (int i = 0; i < count; ++i) {
+            values[i] = static_cast<Value>(registers[i]) * scale;
+        }
+        return;
+    case ModbusPointType::Int16:
+        for (int i = 0; i < count; ++i) {
+            values[i] = static_cast<Value>(static_cast<int16_t>(registers[i])) * scale;
+        }
+        return;
+    case ModbusPointType::UInt32:
+        detail::decodeWordPairs<uint32_t>(encoding.wordOrder, count, registers, scale, values);
+        return;
+    case ModbusPointType::Int32:
+        detail::decodeWordPairs<int32_t>(encoding.wordOrder, count, registers, scale, values);
+        return;
+    case ModbusPointType::Float32:
+        detail::decodeWordPairs<float>(encoding.wordOrder, count, registers, scale, values);
+        return;
+    }
+}
+
+/**
+ * @brief Fixed set of points read and written as one register block.
+ *
+ * Built at compile time from a list of points, so master and slave share a
+ * single description of the layout:
+ * @code
+ * constexpr auto battery = makeRegisterMap(ModbusPoint{10, ModbusPointType::UInt16, 0.1},
+ *                                          ModbusPoint{11, ModbusPointType::Int16, 0.01});
+ * static_assert(battery.valid(), "overlapping points");
+ * planner.addRegisterRead(battery.startAddress(), battery.count());
+ * @endcode
+ * Adjacent points with the same encoding are grouped into runs when the map
+ * is built; decode() runs one tight loop per run, so large homogeneous maps
+ * decode at vector speed and small ones unroll to straight-line code.
+ *
+ * @tparam N Number of points; values are passed in point order.
+ */
+template<size_t N>
+class ModbusRegisterMap {
+public:
+    constexpr explicit ModbusRegisterMap(const std::array<ModbusPoint, N>& points)
+        : points_(points),
+          runs_(),
+          runCount_(0),
+          startAddress_(N ? points[0].address : 0),
+          endAddress_(N ? points[0].end() : 0) {
+        for (size_t i = 0; i < N; ++i) {
+            startAddress_ = points_[i].address < startAddress_ ? points_[i].address : startAddress_;
+            endAddress_ = points_[i].end() > endAddress_ ? points_[i].end() : endAddress_;
+            if (runCount_ > 0) {
+                Run& last = runs_[runCount_ - 1];
+                const ModbusPoint& previous = points_[i - 1];
+                if (points_[i].address == previous.end() && points_[i].sameEncoding(previous)) {
+                    ++last.count;
+                    continue;
+                }
+            }
+            runs_[runCount_] = Run{i, 1};
+            ++runCount_;
+        }
+    }
+
+    constexpr size_t size() const {
+        return N;
+    }
+
+    constexpr const ModbusPoint& point(size_t index) const {
+        return points_[index];
+    }
+
+    /**
+     * @brief Lowest register address of the block.
+     */
+    constexpr int startAddress() const {
+        return startAddress_;
+    }
+
+    /**
+     * @brief Registers from the lowest to the highest address, gaps included.
+     */
+    constexpr int count() const {
+        return endAddress_ - startAddress_;
+    }
+
+    /**
+     * @brief Loops decode() runs; 1 when all points are adjacent and encoded alike.
+     */
+    constexpr size_t runCount() const {
+        return runCount_;
+    }
+
+    /**
+     * @brief True if no two points share a register and no address is negative.
+     */
+    constexpr bool valid() const {
+        for (size_t i = 0; i < N; ++i) {
+            if (points_[i].address < 0 || points_[i].end() > 65536) {
+                return false;
+            }
+            for (size_t j = i + 1; j < N; ++j) {
+                if (points_[i].address < points_[j].end() && points_[j].address < points_[i].end()) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief Engineering value of one point.
+     * @param[in] block count() registers starting at startAddress().
+     */
+    template<size_t Index, typename Value = double>
+    Value value(const uint16_t* block) const {
+        static_assert(Index < N, "point index out of range");
+        return decodePoint<Value>(points_[Index], block + (points_[Index].address - startAddress_));
+    }
+
+    /**
+     * @brief Decode every point.
+     * @param[in] block count() registers starting at startAddress().
+     * @param[out] values N values in point order.
+     */
+    template<typename Value>
+    void decode(const uint16_t* block, Value* values) const {
+        for (size_t run = 0; run < runCount_; ++run) {
+            const ModbusPoint& first = points_[runs_[run].first];
+            decodePoints(first, runs_[run].count, block + (first.address - startAddress_), values + runs_[run].first);
+        }
+    }
+
+    /**
+     * @brief Encode every point; registers in gaps between points are left untouched.
+     * @param[in] values N values in point order.
+     * @param[out] block count() registers starting at startAddress().
+     */
+    template<typename Value>
+    void encode(const Value* values, uint16_t* block) const {
+        for (size_t i = 0; i < N; ++i) {
+            encodePoint(points_[i], values[i], block + (points_[i].address - startAddress_));
+        }
+    }
+
+private:
+    struct Run {
+        size_t first;
+        int    count;
+    };
+
+    std::array<ModbusPoint, N> points_;
+    std::array<Run, N>         runs_;
+    size_t                     runCount_;
+    int                        startAddress_;
+    int                        endAddress_;
+};
+
+/**
+ * @brief Build a ModbusRegisterMap from points, usually as a constexpr variable.
+ */
+template<typename... Points>
+constexpr ModbusRegisterMap<sizeof...(Points)> makeRegisterMap(const Points&... points) {
+    return ModbusRegisterMap<sizeof...(Points)>(std::array<ModbusPoint, sizeof...(Points)>{{points...}});
+}
+
+} // namespace test_modbus_485
+
+#endif // MODBUS_REGISTER_MAP_H
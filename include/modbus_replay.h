@@ -0,0 +1,284 @@
+// include/modbus_replay.h
+
+#ifndef MODBUS_REPLAY_H
+#define MODBUS_REPLAY_H
+
+#include "modbus_capture.h"
+#include "modbus_metrics.h"
+#include "modbus_transport.h"
+#include "modbus_utils.h"
+#include <modbus.h>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <mutex>
+#include <ostream>
+#include <thread>
+#include <vector>
+
+namespace test_modbus_485 {
+
+/**
+ * @brief A recorded request and the response that followed it.
+ */
+struct ModbusReplayTransaction {
+    uint64_t       timestamp;          ///< Capture time of the request.
+    uint64_t       responseTimestamp;  ///< Capture time of the response; equal to timestamp if there was none.
+    const uint8_t* request;            ///< Request ADU, CRC included.
+    int            requestLength;
+    const uint8_t* response;           ///< Response ADU, CRC included; nullptr if none was recorded.
+    int            responseLength;
+};
+
+/**
+ * @brief Reads a capture as transactions, pairing each request with the response after it.
+ *
+ * Works straight off the reader's mapping, so replaying a capture of any
+ * length costs no memory beyond one lookahead record. Garbage and responses
+ * with no request are skipped.
+ */
+class ModbusReplaySource {
+public:
+    /**
+     * @param[in] reader Open capture; must outlive the source.
+     * @param[in] from Capture time of the first request to replay.
+     * @param[in] to Capture time the replay ends before.
+     */
+    ModbusReplaySource(ModbusCaptureReader& reader,
+                       uint64_t from = 0,
+                       uint64_t to = std::numeric_limits<uint64_t>::max());
+
+    /**
+     * @brief The next transaction.
+     * @return False at the end of the range.
+     */
+    bool next(ModbusReplayTransaction& transaction);
+
+private:
+    bool read(ModbusCaptureRecord& record);
+
+    ModbusCaptureReader& reader_;
+    uint64_t             to_;
+    ModbusCaptureRecord  lookahead_;
+    bool                 haveLookahead_;
+};
+
+/**
+ * @brief How fast a replay runs.
+ */
+struct ModbusReplayOptions {
+    double speed = 1.0;    ///< 1 keeps the recorded timing, N runs N times faster, 0 as fast as possible.
+};
+
+/**
+ * @brief Recorded and replayed outcome of one function code.
+ */
+struct ModbusReplayFunctionStatistics {
+    int                      functionCode;
+    uint64_t                 transactions = 0;
+    uint64_t                 mismatches = 0;
+    LatencyHistogramSnapshot recorded;   ///< Request to response in the capture.
+    LatencyHistogramSnapshot replayed;   ///< Duration of the ModbusUtils call in the replay.
+};
+
+/**
+ * @brief Result of a ModbusReplayMaster run.
+ */
+struct ModbusReplayStatistics {
+    uint64_t                 transactions = 0;   ///< Requests replayed.
+    uint64_t                 matched = 0;        ///< Outcome and data as recorded.
+    uint64_t                 mismatches = 0;
+    uint64_t                 unsupported = 0;    ///< Requests of function codes ModbusUtils has no call for.
+    std::chrono::nanoseconds recordedSpan{0};    ///< Capture time from the first to the last request.
+    std::chrono::nanoseconds replayDuration{0};
+    std::chrono::nanoseconds maximumLag{0};      ///< Largest delay of a request behind its scaled schedule.
+    LatencyHistogramSnapshot recorded;
+    LatencyHistogramSnapshot replayed;
+    std::vector<ModbusReplayFunctionStatistics> functions;  ///< Function codes replayed, ascending.
+
+    /**
+     * @brief Print counters and recorded vs. replayed latency per function code.
+     */
+    void print(std::ostream& stream) const;
+
+    /**
+     * @brief Same as CSV, one row per function code and distribution plus totals.
+     */
+    void printCsv(std::ostream& stream) const;
+};
+
+/**
+ * @brief Replays the requests of a capture through a ModbusUtils instance.
+ *
+ * Each recorded request is turned back into the matching ModbusUtils call
+ * and issued on schedule: at the recorded offsets from the first request,
+ * divided by the speed. The outcome is checked against the recording: the
+ * data of a read, success of a write, the exception code of an exception
+ * response, and a timeout where no response was recorded. For every
+ * transaction with a recorded response the call duration is kept next to
+ * the recorded response time, so runs of two ModbusUtils versions over the
+ * same capture can be compared.
+ * Retries of the instance should be off (maximumResyncRetries = 0), since
+ * retries in the original traffic are already in the capture.
+ */
+class ModbusReplayMaster {
+public:
+    ModbusReplayMaster(ModbusUtils& modbus,
+                       modbus_t*& contextReference,
+                       const ModbusReplayOptions& options = ModbusReplayOptions());
+
+    /**
+     * @brief Replay every transaction of a source; returns when it is exhausted or stop() is called.
+     * @return True if every replayed transaction matched.
+     */
+    bool run(ModbusReplaySource& source);
+
+    /**
+     * @brief Make run() return after the current transaction; callable from any thread or a signal handler.
+     */
+    void stop();
+
+    /**
+     * @brief Counters and latency distributions of the last run().
+     */
+    ModbusReplayStatistics statistics() const;
+
+private:
+    struct FunctionCounters {
+        uint64_t         transactions = 0;
+        uint64_t         mismatches = 0;
+        LatencyHistogram recorded;
+        LatencyHistogram replayed;
+    };
+
+    /**
+     * @brief Issue one request through modbus_ and compare the outcome with the recorded response.
+     * @return 1 on match, 0 on mismatch, -1 if the function code is not supported.
+     */
+    int replay(const ModbusReplayTransaction& transaction);
+
+    void reset();
+
+    ModbusUtils&                      modbus_;
+    modbus_t*&                        contextReference_;
+    ModbusReplayOptions               options_;
+    std::atomic<bool>                 stopRequested_;
+    std::array<FunctionCounters, 128> functions_;
+    LatencyHistogram                  recorded_;
+    LatencyHistogram                  replayed_;
+    ModbusReplayStatistics            counters_;
+};
+
+/**
+ * @brief Counters of a ModbusReplaySlave.
+ */
+struct ModbusReplaySlaveStatistics {
+    uint64_t requests = 0;     ///< Requests received.
+    uint64_t answered = 0;     ///< Matched a recorded request and got its recorded response.
+    uint64_t silent = 0;       ///< Matched a request that had no response in the recording.
+    uint64_t unexpected = 0;   ///< Matched nothing within the lookahead window; left unanswered.
+    uint64_t skipped = 0;      ///< Recorded transactions passed over to find a match.
+};
+
+/**
+ * @brief Plays the slaves of a capture: answers each request with its recorded response.
+ *
+ * Requests are matched byte for byte against the next recorded requests,
+ * looking a bounded window ahead, so a master that leaves out or reorders
+ * a few transactions stays in step. The reply is held back for the
+ * recorded request-to-response time divided by the speed. Serve a
+ * descriptor with start() (e.g. the master end of openPtyPair()), or
+ * answer in-process through ModbusReplayTransport.
+ */
+class ModbusReplaySlave {
+public:
+    /**
+     * @param[in] source Transactions to play; must outlive the slave.
+     * @param[in] lookahead Recorded transactions searched for a match to a request.
+     */
+    ModbusReplaySlave(ModbusReplaySource& source,
+                      const ModbusReplayOptions& options = ModbusReplayOptions(),
+                      int lookahead = 64);
+
+    /**
+     * @brief Destructor stops the thread; does not close the descriptor.
+     */
+    ~ModbusReplaySlave();
+
+    ModbusReplaySlave(const ModbusReplaySlave&) = delete;
+    ModbusReplaySlave& operator=(const ModbusReplaySlave&) = delete;
+
+    /**
+     * @brief Find the recorded response to a request.
+     * @param[in] request Request ADU, CRC included.
+     * @param[out] response Buffer of MODBUS_RTU_MAX_ADU_LENGTH bytes for the response ADU.
+     * @param[out] delay Time the recorded slave took, divided by the speed.
+     * @return Response ADU length, 0 if the recording has no response, -1 if no recorded request matched.
+     */
+    int answer(const uint8_t* request, int length, uint8_t* response, std::chrono::nanoseconds& delay);
+
+    /**
+     * @brief Serve requests that arrive on a descriptor from a background thread.
+     * @return True on success.
+     */
+    bool start(int fileDescriptor);
+
+    void stop();
+
+    /**
+     * @brief True once every recorded transaction was played or skipped.
+     */
+    bool finished() const;
+
+    ModbusReplaySlaveStatistics statistics() const;
+
+private:
+    void run();
+
+    ModbusReplaySource&                 source_;
+    ModbusReplayOptions                 options_;
+    size_t                              lookahead_;
+    std::deque<ModbusReplayTransaction> window_;
+    bool                                exhausted_;
+    ModbusReplaySlaveStatistics         counters_;
+    mutable std::mutex                  mutex_;
+    int                                 fileDescriptor_;
+    std::thread                         thread_;
+    std::atomic<bool>                   running_;
+};
+
+/**
+ * @brief In-process transport answered by a ModbusReplaySlave, for replaying both sides without a pty.
+ *
+ * A request the recording answered with silence fails with ETIMEDOUT at
+ * once instead of waiting out the response timeout.
+ */
+class ModbusReplayTransport : public ModbusTransport {
+public:
+    /**
+     * @param[in] slave Recorded slave side; must outlive the transport.
+     */
+    explicit ModbusReplayTransport(ModbusReplaySlave& slave);
+
+    int transact(int slaveIdentifier,
+                 const uint8_t* request,
+                 int requestLength,
+                 uint8_t* response,
+                 int responseCapacity) override;
+    void setTimeouts(std::chrono::microseconds responseTimeout,
+                     std::chrono::microseconds byteTimeout) override;
+    void flush() override;
+    bool reconnect() override;
+    int baudRate() const override;
+    int bitsPerCharacter() const override;
+
+private:
+    ModbusReplaySlave& slave_;
+};
+
+} // namespace test_modbus_485
+
+#endif // MODBUS_REPLAY_H
@@ -0,0 +1,157 @@
+// include/modbus_rtu_codec.h
+
+#ifndef MODBUS_RTU_CODEC_H
+#define MODBUS_RTU_CODEC_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace test_modbus_485 {
+
+/**
+ * @brief Initial value of a CRC16/MODBUS computation.
+ */
+constexpr uint16_t crc16Initial = 0xFFFF;
+
+/**
+ * @brief File record function codes, which libmodbus does not define.
+ */
+constexpr uint8_t modbusFcReadFileRecord = 0x14;
+constexpr uint8_t modbusFcWriteFileRecord = 0x15;
+
+/**
+ * @brief Most records one FC20 sub-request can read (response data length 0xF5) and one FC21 can write
+ *        (request data length 0xFB).
+ */
+constexpr int modbusMaxReadFileRecords = 121;
+constexpr int modbusMaxWriteFileRecords = 122;
+
+/**
+ * @brief Records per file; record numbers run from 0 to 9999.
+ */
+constexpr int modbusFileRecordCount = 10000;
+
+/**
+ * @brief CRC16/MODBUS (poly 0xA001 reflected, init 0xFFFF) of a byte range.
+ */
+uint16_t crc16(const uint8_t* data, size_t length);
+
+/**
+ * @brief Continue a CRC over more bytes, for frames that arrive in pieces.
+ *
+ * crc16Update(crc16Update(crc16Initial, a, n), b, m) equals the CRC of a
+ * followed by b. A frame followed by its own CRC (low byte first) leaves 0,
+ * which is how a stream can be searched for frame ends.
+ * Slicing-by-8: eight table lookups per 8 bytes instead of one per byte.
+ */
+uint16_t crc16Update(uint16_t crc, const uint8_t* data, size_t length);
+
+/**
+ * @brief Reference variant of crc16Update(), one table lookup per byte.
+ */
+uint16_t crc16UpdateBytewise(uint16_t crc, const uint8_t* data, size_t length);
+
+/**
+ * @brief Reference variant of crc16Update(), bit by bit without tables.
+ */
+uint16_t crc16UpdateBitwise(uint16_t crc, const uint8_t* data, size_t length);
+
+/**
+ * @brief Append the CRC of the first length bytes, low byte first.
+ * @return New frame length (length + 2).
+ */
+int appendCrc(uint8_t* frame, int length);
+
+/**
+ * @brief Check the trailing CRC of a complete RTU frame.
+ */
+bool checkCrc(const uint8_t* frame, int length);
+
+/**
+ * @brief Encode an FC01/FC02/FC03/FC04 request PDU.
+ * @return PDU length (5).
+ */
+int encodeReadRequest(uint8_t functionCode, int startAddress, int count, uint8_t* pdu);
+
+/**
+ * @brief Encode an FC05 request PDU.
+ * @return PDU length (5).
+ */
+int encodeWriteSingleCoil(int coilAddress, bool coilStatus, uint8_t* pdu);
+
+/**
+ * @brief Encode an FC06 request PDU.
+ * @return PDU length (5).
+ */
+int encodeWriteSingleRegister(int registerAddress, uint16_t registerValue, uint8_t* pdu);
+
+/**
+ * @brief Encode an FC15 request PDU from one byte per coil.
+ * @return PDU length.
+ */
+int encodeWriteMultipleCoils(int startAddress, const uint8_t* source, int count, uint8_t* pdu);
+
+/**
+ * @brief Encode an FC16 request PDU.
+ * @return PDU length.
+ */
+int encodeWriteMultipleRegisters(int startAddress, const uint16_t* source, int count, uint8_t* pdu);
+
+/**
+ * @brief Encode an FC23 request PDU.
+ * @return PDU length.
+ */
+int encodeWriteAndReadRegisters(int writeAddress, const uint16_t* source, int writeCount,
+                                int readAddress, int readCount, uint8_t* pdu);
+
+/**
+ * @brief Encode an FC20 request PDU with one sub-request (reference type 6).
+ * @return PDU length (9).
+ */
+int encodeReadFileRecord(int fileNumber, int recordNumber, int count, uint8_t* pdu);
+
+/**
+ * @brief Encode an FC21 request PDU with one sub-request (reference type 6).
+ * @return PDU length.
+ */
+int encodeWriteFileRecord(int fileNumber, int recordNumber, const uint16_t* source, int count, uint8_t* pdu);
+
+/**
+ * @brief Extract registers from an FC03/FC04/FC23 response PDU.
+ * @return Number of registers copied, -1 if the PDU is malformed or holds fewer than count.
+ */
+int decodeRegisters(const uint8_t* pdu, int length, uint16_t* destination, int count);
+
+/**
+ * @brief Extract bits, one byte per bit, from an FC01/FC02 response PDU.
+ * @return Number of bits copied, -1 if the PDU is malformed or holds fewer than count.
+ */
+int decodeBits(const uint8_t* pdu, int length, uint8_t* destination, int count);
+
+/**
+ * @brief Extract the records of an FC20 response PDU to a single sub-request.
+ * @return Number of records copied, -1 if the PDU is malformed or holds fewer than count.
+ */
+int decodeFileRecord(const uint8_t* pdu, int length, uint16_t* destination, int count);
+
+/**
+ * @brief Length of the RTU response a request ADU will get, derived from the request alone.
+ * @return ADU length including CRC, 0 for broadcast, -1 if only silence can end the reply.
+ */
+int expectedRtuResponseLength(const uint8_t* requestAdu, int length);
+
+/**
+ * @brief Length of an RTU response ADU from its leading bytes.
+ * @return Full length, 0 if more bytes are needed to tell, -1 for an unknown function code.
+ */
+int rtuResponseLength(const uint8_t* adu, int available);
+
+/**
+ * @brief Length of an RTU request ADU from its leading bytes.
+ * @return Full length, 0 if more bytes are needed to tell, -1 for an unknown function code.
+ */
+int rtuRequestLength(const uint8_t* adu, int available);
+
+} // namespace test_modbus_485
+
+#endif // MODBUS_RTU_CODEC_H
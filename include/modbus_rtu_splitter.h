@@ -0,0 +1,85 @@
+// include/modbus_rtu_splitter.h
+
+#ifndef MODBUS_RTU_SPLITTER_H
+#define MODBUS_RTU_SPLITTER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace test_modbus_485 {
+
+/**
+ * @brief Cuts a captured RTU byte stream (requests and responses mixed) into frames.
+ *
+ * Bytes can be pushed in pieces of any size. At each position the frame
+ * length implied by the header is tried as a request and as a response, and
+ * the candidate whose CRC checks is taken. For a function code the codec
+ * does not know, the stream is searched for the nearest position where the
+ * running CRC reaches zero, which is where a frame followed by its own CRC
+ * ends. Bytes that belong to no valid frame are skipped one at a time and
+ * counted. A line gap of at least t3.5 ends any partial frame, if the caller
+ * can see gaps.
+ */
+class ModbusRtuFrameSplitter {
+public:
+    /**
+     * @brief Receives each frame, CRC included; the bytes are only valid during the call.
+     */
+    using FrameCallback = std::function<void(const uint8_t* frame, int length)>;
+
+    /**
+     * @param[in] onFrame Receives each frame.
+     * @param[in] onDiscard Optional; receives each run of skipped bytes, in stream order with the frames.
+     */
+    explicit ModbusRtuFrameSplitter(FrameCallback onFrame, FrameCallback onDiscard = nullptr);
+
+    /**
+     * @brief Feed captured bytes; complete frames are reported before returning.
+     */
+    void push(const uint8_t* data, size_t length);
+
+    /**
+     * @brief The line was silent for t3.5: report what still forms a frame, discard the rest.
+     */
+    void gap();
+
+    /**
+     * @brief Frames reported so far.
+     */
+    uint64_t frameCount() const;
+
+    /**
+     * @brief Bytes skipped because no valid frame started at them.
+     */
+    uint64_t discardedBytes() const;
+
+private:
+    /**
+     * @brief Length of the frame starting at the front, 0 if more bytes are needed, -1 if none starts there.
+     */
+    int frameAtFront(bool final) const;
+
+    /**
+     * @brief True if a frame of a known function code with a valid CRC starts here.
+     */
+    static bool knownFrameAt(const uint8_t* frame, int available);
+
+    void discard();
+    void emit(int length);
+    void flushDiscarded();
+    void compact();
+
+    FrameCallback        onFrame_;
+    FrameCallback        onDiscard_;
+    std::vector<uint8_t> discardedRun_;
+    std::vector<uint8_t> buffer_;
+    size_t               front_ = 0;
+    uint64_t             frames_ = 0;
+    uint64_t             discarded_ = 0;
+};
+
+} // namespace test_modbus_485
+
+#endif // MODBUS_RTU_SPLITTER_H
@@ -0,0 +1,32 @@
+// include/modbus_serial_speed.h
+
+#ifndef MODBUS_SERIAL_SPEED_H
+#define MODBUS_SERIAL_SPEED_H
+
+namespace test_modbus_485 {
+
+/**
+ * @brief Termios Bxxx constant of a standard baud rate.
+ * @param[in] baudRate Rate in bit/s.
+ * @param[out] speedConstant Constant for cfsetispeed()/cfsetospeed().
+ * @return False if the platform has no constant for this rate.
+ */
+bool standardBaudRateConstant(int baudRate, unsigned int& speedConstant);
+
+/**
+ * @brief Set an arbitrary baud rate with termios2/BOTHER, leaving the other settings untouched.
+ * @param[in] fileDescriptor Open serial descriptor.
+ * @param[in] baudRate Rate in bit/s.
+ * @return True on success.
+ */
+bool setArbitraryBaudRate(int fileDescriptor, int baudRate);
+
+/**
+ * @brief Output baud rate the driver actually applied, as reported by TCGETS2.
+ * @return Rate in bit/s, -1 on error.
+ */
+int readBaudRate(int fileDescriptor);
+
+} // namespace test_modbus_485
+
+#endif // MODBUS_SERIAL_SPEED_H
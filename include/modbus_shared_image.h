@@ -0,0 +1,247 @@
+// include/modbus_shared_image.h
+
+#ifndef MODBUS_SHARED_IMAGE_H
+#define MODBUS_SHARED_IMAGE_H
+
+#include "modbus_utils.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <tuple>
+
+namespace test_modbus_485 {
+
+/**
+ * @brief Layout of a shared process image. One writer, any number of read-only mappers.
+ *
+ * The segment starts with a Header, followed by maximumBlocks BlockHeaders
+ * and the data area. Every block holds the last values polled for one
+ * (slave, table, start, count) range, as 16-bit words (bits as 0 or 1),
+ * behind its own seqlock: the writer makes sequence odd, stores the data,
+ * generation and timestamp, then makes it even again. Blocks are only
+ * appended; blockCount is published after the block is complete.
+ */
+namespace shared_image_format {
+
+constexpr char     magic[8] = {'M', 'B', 'S', 'H', 'M', '0', '1', '\0'};
+constexpr uint32_t version = 1;
+
+constexpr uint32_t stateLive = 1;     ///< A writer is publishing.
+constexpr uint32_t stateClosed = 2;   ///< The writer closed the image; data is final.
+
+struct Header {
+    char                  magic[8];
+    std::atomic<uint32_t> version;         ///< Stored last by the writer; 0 while the segment is being set up.
+    std::atomic<uint32_t> state;
+    uint32_t              maximumBlocks;
+    uint32_t              reserved;
+    uint64_t              dataWords;       ///< Size of the data area.
+    uint64_t              startRealtime;   ///< CLOCK_REALTIME ns when the image was created.
+    std::atomic<uint32_t> blockCount;
+    uint32_t              writerProcess;   ///< pid of the writer.
+    uint8_t               padding[16];
+};
+
+struct alignas(64) BlockHeader {
+    uint8_t               slaveIdentifier;
+    uint8_t               table;           ///< ModbusTable.
+    uint16_t              reserved;
+    uint32_t              startAddress;
+    uint32_t              count;
+    uint32_t              dataOffset;      ///< First word in the data area.
+    std::atomic<uint32_t> sequence;        ///< Odd while the writer updates the block.
+    uint32_t              reserved2;
+    std::atomic<uint64_t> generation;      ///< Publications of the block so far.
+    std::atomic<uint64_t> timestamp;       ///< CLOCK_MONOTONIC ns of the poll that produced the data.
+};
+
+static_assert(sizeof(Header) == 64, "shared image header layout changed");
+static_assert(sizeof(BlockHeader) == 64, "shared image block layout changed");
+static_assert(std::atomic<uint32_t>::is_always_lock_free && std::atomic<uint64_t>::is_always_lock_free &&
+                  std::atomic<uint16_t>::is_always_lock_free,
+              "shared image atomics must be lock-free to work across processes");
+
+} // namespace shared_image_format
+
+/**
+ * @brief Size of a shared process image.
+ */
+struct ModbusSharedImageOptions {
+    uint32_t maximumBlocks = 256;
+    size_t   dataWords = 1 << 18;   ///< Registers and bits over all blocks; 512 KiB.
+};
+
+/**
+ * @brief Generation and time of a block, read together with its data.
+ */
+struct ModbusSharedStamp {
+    uint64_t generation;   ///< 0 if the block was never published.
+    uint64_t timestamp;    ///< CLOCK_MONOTONIC ns of the poll; comparable across processes.
+};
+
+/**
+ * @brief Publishes polled values into a POSIX shared memory segment.
+ *
+ * Attach to the ModbusUtils instance that owns the bus with
+ * ModbusUtils::attachSharedImage(): every successful read is published as
+ * its (slave, table, start, count) block, the first read of a range
+ * creating the block. Readers in other processes never slow the writer
+ * down; publishing costs the copy into the segment. Thread-safe.
+ */
+class ModbusSharedImageWriter {
+public:
+    ModbusSharedImageWriter();
+    ~ModbusSharedImageWriter();
+
+    ModbusSharedImageWriter(const ModbusSharedImageWriter&) = delete;
+    ModbusSharedImageWriter& operator=(const ModbusSharedImageWriter&) = delete;
+
+    /**
+     * @brief Create the segment, replacing any earlier one of the same name.
+     * @param[in] name shm_open() name, e.g. "/modbus_485".
+     * @return True on success.
+     */
+    bool create(const std::string& name, const ModbusSharedImageOptions& options = ModbusSharedImageOptions());
+
+    /**
+     * @brief Mark the image closed and unmap it; the name is removed unless keep is set.
+     */
+    void close(bool keep = false);
+
+    /**
+     * @brief Publish a register block read from the holding or input register table.
+     * @param[in] timestamp CLOCK_MONOTONIC ns of the poll; 0 for now.
+     * @return False if the block table or the data area is full.
+     */
+    bool publishRegisters(int slaveIdentifier, ModbusTable table, int startAddress, int count,
+                          const uint16_t* values, uint64_t timestamp = 0);
+
+    /**
+     * @brief Publish a bit block, one byte per bit, read from the coil or discrete input table.
+     */
+    bool publishBits(int slaveIdentifier, ModbusTable table, int startAddress, int count,
+                     const uint8_t* values, uint64_t timestamp = 0);
+
+    /**
+     * @brief CLOCK_MONOTONIC in nanoseconds.
+     */
+    static uint64_t now();
+
+private:
+    template<typename Value>
+    bool publish(int slaveIdentifier, ModbusTable table, int startAddress, int count,
+                 const Value* values, uint64_t timestamp);
+
+    /**
+     * @brief Block of a range, appended on first use; -1 if full.
+     */
+    int block(int slaveIdentifier, ModbusTable table, int startAddress, int count);
+
+    std::string                                    name_;
+    int                                            fileDescriptor_;
+    uint8_t*                                       mapping_;
+    size_t                                         mappingBytes_;
+    shared_image_format::Header*                   header_;
+    shared_image_format::BlockHeader*              blocks_;
+    std::atomic<uint16_t>*                         data_;
+    uint64_t                                       dataUsed_;
+    std::map<std::tuple<int, int, int, int>, int>  blockIndex_;
+    std::mutex                                     mutex_;
+};
+
+/**
+ * @brief Read-only view of a shared process image, for any local process.
+ *
+ * Reads copy straight out of the mapping under the block's seqlock: no
+ * system call, no lock, nothing the writer waits for. A read is repeated
+ * only if the writer republished that block during the copy, which the
+ * poll rate bounds; a block left locked by a writer that died or stalled
+ * fails the read instead. Look a range up once with find() and read it by block
+ * index; a single register costs a few nanoseconds. Several threads may
+ * share one reader.
+ */
+class ModbusSharedImageReader {
+public:
+    ModbusSharedImageReader();
+    ~ModbusSharedImageReader();
+
+    ModbusSharedImageReader(const ModbusSharedImageReader&) = delete;
+    ModbusSharedImageReader& operator=(const ModbusSharedImageReader&) = delete;
+
+    /**
+     * @brief Map an image created by a ModbusSharedImageWriter.
+     * @return True on success.
+     */
+    bool open(const std::string& name);
+
+    void close();
+
+    /**
+     * @brief Block holding a whole range, -1 if none does (yet).
+     */
+    int find(int slaveIdentifier, ModbusTable table, int startAddress, int count) const;
+
+    /**
+     * @brief Consistent copy of registers of a block.
+     * @param[in] startAddress First register; the range must lie in the block.
+     * @param[out] stamp Optional; generation and poll time of the copy.
+     * @return False if the range is not in the block or the block is not a register block,
+     *         or if the writer died or stalled inside the block (the data is stale).
+     */
+    bool readRegisters(int block, int startAddress, int count, uint16_t* destination,
+                       ModbusSharedStamp* stamp = nullptr) const;
+
+    /**
+     * @brief Consistent copy of bits, one byte per bit, of a block.
+     */
+    bool readBits(int block, int startAddress, int count, uint8_t* destination,
+                  ModbusSharedStamp* stamp = nullptr) const;
+
+    /**
+     * @brief find() followed by readRegisters().
+     */
+    bool readRegisters(int slaveIdentifier, ModbusTable table, int startAddress, int count,
+                       uint16_t* destination, ModbusSharedStamp* stamp = nullptr) const;
+
+    /**
+     * @brief find() followed by readBits().
+     */
+    bool readBits(int slaveIdentifier, ModbusTable table, int startAddress, int count,
+                  uint8_t* destination, ModbusSharedStamp* stamp = nullptr) const;
+
+    /**
+     * @brief Blocks published so far.
+     */
+    int blockCount() const;
+
+    /**
+     * @brief Directory entry of a block (slave, table, range); not the data.
+     */
+    const shared_image_format::BlockHeader& blockHeader(int block) const;
+
+    /**
+     * @brief True once the writer closed the image; a new writer creates a new segment, so reopen.
+     */
+    bool writerClosed() const;
+
+private:
+    bool writerAlive() const;
+
+    template<typename Value>
+    bool read(int block, bool bits, int startAddress, int count, Value* destination,
+              ModbusSharedStamp* stamp) const;
+
+    int                                     fileDescriptor_;
+    const uint8_t*                          mapping_;
+    size_t                                  mappingBytes_;
+    const shared_image_format::Header*      header_;
+    const shared_image_format::BlockHeader* blocks_;
+    const std::atomic<uint16_t>*            data_;
+};
+
+} // namespace test_modbus_485
+
+#endif // MODBUS_SHARED_IMAGE_H
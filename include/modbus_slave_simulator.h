@@ -0,0 +1,95 @@
+// include/modbus_slave_simulator.h
+
+#ifndef MODBUS_SLAVE_SIMULATOR_H
+#define MODBUS_SLAVE_SIMULATOR_H
+
+#include <modbus.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <thread>
+
+namespace test_modbus_485 {
+
+/**
+ * @brief Line emulation of a ModbusSlaveSimulator.
+ */
+struct ModbusSimulatorOptions {
+    int                       baudRate = 115200;
+    int                       bitsPerCharacter = 10;
+    bool                      emulateWireTime = true;   ///< Delay replies by the time both frames would take on the line.
+    std::chrono::microseconds turnaround{0};            ///< Extra slave processing time per request.
+};
+
+/**
+ * @brief Serves any number of RTU slaves on one descriptor from a background thread.
+ *
+ * Requests are framed from their length fields and checked by CRC; frames
+ * for unknown slaves or with a bad CRC are dropped like on a real bus.
+ * Replies are built by modbus_reply() from each slave's own mapping, so
+ * the slave side behaves exactly like serial_modbus_slave; FC20/FC21 are
+ * answered by processFileRecordRequest() on the holding registers. A pty
+ * does not pace data, hence the optional wire-time emulation.
+ */
+class ModbusSlaveSimulator {
+public:
+    ModbusSlaveSimulator();
+
+    /**
+     * @brief Destructor stops the thread and frees the mappings; does not close the descriptor.
+     */
+    ~ModbusSlaveSimulator();
+
+    ModbusSlaveSimulator(const ModbusSlaveSimulator&) = delete;
+    ModbusSlaveSimulator& operator=(const ModbusSlaveSimulator&) = delete;
+
+    /**
+     * @brief Add a slave with all four tables starting at address 0; call before start().
+     * @return True on success.
+     */
+    bool addSlave(int slaveIdentifier, int numberOfBits = 10000, int numberOfRegisters = 10000);
+
+    /**
+     * @brief Table storage of a slave, nullptr if unknown. Not synchronised with the server thread.
+     */
+    modbus_mapping_t* mapping(int slaveIdentifier);
+
+    /**
+     * @brief Start serving requests that arrive on a descriptor (e.g. the master end of openPtyPair()).
+     * @return True on success.
+     */
+    bool start(int fileDescriptor, const ModbusSimulatorOptions& options = ModbusSimulatorOptions());
+
+    /**
+     * @brief Stop the server thread.
+     */
+    void stop();
+
+    /**
+     * @brief Requests answered, including broadcasts.
+     */
+    uint64_t requestCount() const;
+
+    /**
+     * @brief Frames dropped for a bad CRC, an unknown function code or an unknown slave.
+     */
+    uint64_t droppedCount() const;
+
+private:
+    void run();
+    void serve(const uint8_t* request, int length);
+
+    int                             fileDescriptor_;
+    modbus_t*                       context_;
+    ModbusSimulatorOptions          options_;
+    std::map<int, modbus_mapping_t*> slaves_;
+    std::thread                     thread_;
+    std::atomic<bool>               running_;
+    std::atomic<uint64_t>           requests_;
+    std::atomic<uint64_t>           dropped_;
+};
+
+} // namespace test_modbus_485
+
+#endif // MODBUS_SLAVE_SIMULATOR_H
@@ -0,0 +1,138 @@
+// include/modbus_tcp_gateway.h
+
+#ifndef MODBUS_TCP_GATEWAY_H
+#define MODBUS_TCP_GATEWAY_H
+
+#include "modbus_async_engine.h"
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace test_modbus_485 {
+
+/**
+ * @brief Limits and behaviour of a ModbusTcpGateway.
+ */
+struct ModbusGatewayOptions {
+    int  maximumClients = 1024;
+    int  maximumQueuedPerClient = 32;  ///< Further requests of that client get exception 6 (busy).
+    bool coalesceReads = true;         ///< Answer identical queued reads with one bus transaction.
+};
+
+/**
+ * @brief Counters of a ModbusTcpGateway.
+ */
+struct ModbusGatewayStatistics {
+    uint64_t clientsAccepted = 0;
+    uint64_t requests = 0;         ///< MBAP requests received.
+    uint64_t busTransactions = 0;  ///< RTU transactions issued.
+    uint64_t coalesced = 0;        ///< Requests answered by another client's transaction.
+    uint64_t rejected = 0;         ///< Requests refused because the client's queue was full.
+    uint64_t busErrors = 0;        ///< Transactions that ended without a reply.
+};
+
+/**
+ * @brief Modbus-TCP server forwarding MBAP requests to one RTU port of a ModbusAsyncEngine.
+ *
+ * Sockets are watched on the engine's epoll set, so an idle client costs a
+ * descriptor and a few bytes. Each client has its own FIFO; the bus takes
+ * one request at a time from the clients in round-robin order, so a client
+ * with a deep queue cannot starve the others. Before a read goes out, every
+ * identical read (same unit, same PDU) still queued by any client, and not
+ * behind a write of that client, is attached to it and answered from the
+ * same reply. Requests that get no
+ * reply are answered with exception 0x0B (target failed to respond) or
+ * 0x0A (path unavailable); unit 0 is broadcast and never answered.
+ * Everything runs on the engine thread.
+ */
+class ModbusTcpGateway {
+public:
+    /**
+     * @param[in] engine Initialised engine; must outlive the gateway.
+     * @param[in] portHandle Port returned by engine.addPort().
+     */
+    ModbusTcpGateway(ModbusAsyncEngine& engine,
+                     int portHandle,
+                     const ModbusGatewayOptions& options = ModbusGatewayOptions());
+
+    /**
+     * @brief Destructor closes the listener and all clients.
+     */
+    ~ModbusTcpGateway();
+
+    ModbusTcpGateway(const ModbusTcpGateway&) = delete;
+    ModbusTcpGateway& operator=(const ModbusTcpGateway&) = delete;
+
+    /**
+     * @brief Accept Modbus-TCP clients; call from the engine thread or before run().
+     * @param[in] address Local address to bind, e.g. "0.0.0.0" or "127.0.0.1".
+     * @param[in] port TCP port, 0 picks a free one (see localPort()).
+     * @return True on success.
+     */
+    bool listen(const std::string& address, int port = 502);
+
+    /**
+     * @brief Close the listener and every client connection.
+     */
+    void close();
+
+    /**
+     * @brief Port the listener is bound to, -1 if not listening.
+     */
+    int localPort() const;
+
+    /**
+     * @brief Connected clients.
+     */
+    size_t clientCount() const;
+
+    const ModbusGatewayStatistics& statistics() const;
+
+private:
+    struct Request {
+        uint64_t clientIdentifier;
+        uint16_t transactionIdentifier;
+        uint8_t  unitIdentifier;
+        uint8_t  pdu[253];
+        int      pduLength;
+    };
+
+    struct Client {
+        int                  fileDescriptor;
+        uint64_t             identifier;
+        std::vector<uint8_t> input;
+        std::vector<uint8_t> output;
+        std::deque<Request>  queue;
+        bool                 scheduled;           ///< In the round-robin list.
+        bool                 waitingForWritable;  ///< EPOLLOUT requested for pending output.
+    };
+
+    void onAccept();
+    void onClientEvent(uint64_t clientIdentifier, uint32_t events);
+    void parseFrames(Client& client);
+    void dispatch();
+    void onCompletion(const ModbusAsyncResult& result);
+    void respond(const Request& request, const uint8_t* pdu, int pduLength);
+    void respondException(const Request& request, int exceptionCode);
+    bool flushOutput(Client& client);
+    void dropClient(uint64_t clientIdentifier);
+
+    ModbusAsyncEngine&                                     engine_;
+    int                                                    portHandle_;
+    ModbusGatewayOptions                                   options_;
+    int                                                    listenFileDescriptor_;
+    int                                                    localPort_;
+    uint64_t                                               nextClientIdentifier_;
+    std::unordered_map<uint64_t, std::unique_ptr<Client>> clients_;
+    std::deque<uint64_t>                                   roundRobin_;
+    std::vector<Request>                                   inFlight_;
+    bool                                                   busy_;
+    ModbusGatewayStatistics                                statistics_;
+};
+
+} // namespace test_modbus_485
+
+#endif // MODBUS_TCP_GATEWAY_H
@@ -0,0 +1,41 @@
+// include/modbus_timing.h
+
+#ifndef MODBUS_TIMING_H
+#define MODBUS_TIMING_H
+
+#include <chrono>
+
+namespace test_modbus_485 {
+
+/**
+ * @brief Bits on the wire per character: start + data + parity + stop.
+ */
+int bitsPerCharacter(char parityMode, int dataBits, int stopBits);
+
+/**
+ * @brief Time one character occupies on the line.
+ */
+std::chrono::nanoseconds characterTime(int baudRate, int bitsPerCharacter);
+
+/**
+ * @brief t1.5 inter-character timeout; fixed at 750 us above 19200 baud.
+ */
+std::chrono::nanoseconds interCharacterTimeout(int baudRate, int bitsPerCharacter);
+
+/**
+ * @brief t3.5 inter-frame delay; fixed at 1750 us above 19200 baud.
+ */
+std::chrono::nanoseconds interFrameDelay(int baudRate, int bitsPerCharacter);
+
+/**
+ * @brief Request plus response RTU bytes of one transaction.
+ * @param[in] functionCode Modbus function code.
+ * @param[in] quantity Items transferred; for FC23 written plus read registers,
+ *            for FC17 the largest expected reply payload, for FC20/FC21 the records of one sub-request.
+ * @return Bytes on the wire, a conservative 2 * 256 for unknown function codes.
+ */
+int expectedFrameBytes(int functionCode, int quantity);
+
+} // namespace test_modbus_485
+
+#endif // MODBUS_TIMING_H
@@ -0,0 +1,141 @@
+// include/modbus_transport.h
+
+#ifndef MODBUS_TRANSPORT_H
+#define MODBUS_TRANSPORT_H
+
+#include <modbus.h>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace test_modbus_485 {
+
+/**
+ * @brief One Modbus request/response exchange per call, independent of the link.
+ *
+ * Backends move PDUs; addressing, framing and checksums are theirs. Errors
+ * follow libmodbus: -1 with errno set, exception replies as
+ * MODBUS_ENOBASE + exception code, so classifyModbusError() applies as-is.
+ * Attach one to ModbusUtils with attachTransport().
+ */
+class ModbusTransport {
+public:
+    virtual ~ModbusTransport() = default;
+
+    /**
+     * @brief Send a request PDU and wait for the matching response PDU.
+     * @param[in] slaveIdentifier Slave or unit identifier, 0 broadcasts.
+     * @param[in] request Request PDU (function code first).
+     * @param[in] requestLength Request PDU length.
+     * @param[out] response Buffer for the response PDU.
+     * @param[in] responseCapacity Size of that buffer.
+     * @return Response PDU length, 0 for a broadcast, -1 on error.
+     */
+    virtual int transact(int slaveIdentifier,
+                         const uint8_t* request,
+                         int requestLength,
+                         uint8_t* response,
+                         int responseCapacity) = 0;
+
+    /**
+     * @brief Response and byte timeouts for the following transactions.
+     */
+    virtual void setTimeouts(std::chrono::microseconds responseTimeout,
+                             std::chrono::microseconds byteTimeout) = 0;
+
+    /**
+     * @brief Drop whatever is left of a late or corrupt reply.
+     */
+    virtual void flush() = 0;
+
+    /**
+     * @brief Re-establish the link after an I/O error.
+     * @return True on success.
+     */
+    virtual bool reconnect() = 0;
+
+    /**
+     * @brief Line rate for timeout and wire-time computation, 0 if the link has no character timing.
+     */
+    virtual int baudRate() const = 0;
+
+    /**
+     * @brief Bits on the wire per character, see bitsPerCharacter().
+     */
+    virtual int bitsPerCharacter() const = 0;
+};
+
+/**
+ * @brief RTU-serial or Modbus-TCP transport on a libmodbus context.
+ *
+ * PDUs go out through modbus_send_raw_request() and come back through
+ * modbus_receive_confirmation(), so libmodbus does the framing and CRC.
+ * libmodbus cannot size FC20/FC21 replies: on RTU they are read with
+ * receiveRtuResponse() instead, on TCP these requests fail with ENOTSUP.
+ * The serial port is configured like ModbusUtils::openRtu().
+ */
+class ModbusLibmodbusTransport : public ModbusTransport {
+public:
+    ModbusLibmodbusTransport();
+
+    /**
+     * @brief Destructor closes the context.
+     */
+    ~ModbusLibmodbusTransport() override;
+
+    ModbusLibmodbusTransport(const ModbusLibmodbusTransport&) = delete;
+    ModbusLibmodbusTransport& operator=(const ModbusLibmodbusTransport&) = delete;
+
+    /**
+     * @brief Open an RTU serial port; parameters as for ModbusUtils::openRtu().
+     * @return True on success.
+     */
+    bool openRtu(const std::string& serialDevicePath,
+                 int baudRate = 115200,
+                 char parityMode = 'N',
+                 int dataBits = 8,
+                 int stopBits = 1);
+
+    /**
+     * @brief Connect to a Modbus-TCP server.
+     * @return True on success.
+     */
+    bool openTcp(const std::string& address, int port = MODBUS_TCP_DEFAULT_PORT);
+
+    /**
+     * @brief Close and free the context.
+     */
+    void close();
+
+    /**
+     * @brief Underlying context, nullptr when closed.
+     */
+    modbus_t* context() const;
+
+    int transact(int slaveIdentifier,
+                 const uint8_t* request,
+                 int requestLength,
+                 uint8_t* response,
+                 int responseCapacity) override;
+    void setTimeouts(std::chrono::microseconds responseTimeout,
+                     std::chrono::microseconds byteTimeout) override;
+    void flush() override;
+    bool reconnect() override;
+    int baudRate() const override;
+    int bitsPerCharacter() const override;
+
+private:
+    bool connect();
+    int receiveFileRecordResponse(int slaveIdentifier, uint8_t* adu, int capacity);
+
+    modbus_t* context_;
+    bool      rtu_;
+    int       baudRate_;
+    char      parityMode_;
+    int       dataBits_;
+    int       stopBits_;
+};
+
+} // namespace test_modbus_485
+
+#endif // MODBUS_TRANSPORT_H
@@ -3,15 +3,137 @@
 #ifndef MODBUS_UTILS_H
 #define MODBUS_UTILS_H
 
+#include "modbus_metrics.h"
+#include "modbus_timing.h"
+#include "modbus_transport.h"
 #include <modbus.h>
+#include <array>
+#include <chrono>
+#include <memory>
 #include <string>
 #include <vector>
 #include <mutex>
 
 namespace test_modbus_485 {
 
+class ModbusReadCache;
+class ModbusSharedImageWriter;
+
+/**
+ * @brief The four Modbus data tables.
+ */
+enum class ModbusTable {
+    Coils,
+    DiscreteInputs,
+    HoldingRegisters,
+    InputRegisters
+};
+
+/**
+ * @brief How ModbusUtils chooses the response and byte timeouts.
+ */
+enum class ModbusTimeoutMode {
+    Fixed,        ///< fixedTimeout for both, as before.
+    BaudDerived,  ///< Computed from the line parameters and the expected frame lengths.
+    Adaptive      ///< BaudDerived, tightened to the observed per-slave turnaround.
+};
+
+/**
+ * @brief Timeout configuration of a ModbusUtils instance.
+ */
+struct ModbusTimeoutPolicy {
+    ModbusTimeoutMode         mode = ModbusTimeoutMode::BaudDerived;
+    std::chrono::microseconds fixedTimeout{2000000};         ///< Fixed mode response and byte timeout.
+    std::chrono::microseconds turnaroundAllowance{20000};    ///< Slave processing time assumed when nothing was observed.
+    std::chrono::microseconds byteTimeoutSlack{5000};        ///< Added to t3.5 for the byte timeout (scheduler, USB latency).
+    std::chrono::microseconds minimumResponseTimeout{5000};
+    std::chrono::microseconds maximumResponseTimeout{2000000};
+    double                    adaptivePercentile = 0.99;     ///< Turnaround quantile the adaptive timeout follows.
+    std::chrono::microseconds adaptiveMargin{2000};          ///< Added on top of that quantile.
+    int                       adaptiveMinimumSamples = 32;   ///< Samples needed before the adaptive value is used.
+    std::chrono::microseconds broadcastTurnaround{100000};   ///< Silence after a broadcast write so every slave can apply it.
+};
+
+/**
+ * @brief How a failed transaction is handled, by errno.
+ */
+enum class ModbusErrorClass {
+    None,       ///< Not an error.
+    Exception,  ///< Exception response; the link is fine, returned as-is.
+    Request,    ///< Rejected locally (invalid argument, too many items); returned as-is.
+    Transient,  ///< Timeout, CRC or framing error; resynchronise and retry.
+    Link        ///< I/O error on the port; reopen it.
+};
+
+/**
+ * @brief Classify an errno value left by libmodbus.
+ */
+ModbusErrorClass classifyModbusError(int errorCode);
+
+/**
+ * @brief Put an open serial port in raw mode with the given line parameters.
+ *
+ * Rates without a Bxxx constant go through termios2; the applied rate must
+ * be within 2 % of the requested one.
+ * @return True on success.
+ */
+bool configureRtuLine(int fileDescriptor, int baudRate, char parityMode, int dataBits, int stopBits);
+
+/**
+ * @brief Read one RTU response ADU from a port, framed from its length fields.
+ *
+ * For replies modbus_receive_confirmation() cannot size, e.g. FC20/FC21.
+ * @param[in] responseTimeout Wait for the first byte.
+ * @param[in] byteTimeout Wait for each further byte.
+ * @return ADU length including CRC, -1 with errno set on timeout, bad CRC or a port error.
+ */
+int receiveRtuResponse(int fileDescriptor,
+                       uint8_t* adu,
+                       int capacity,
+                       std::chrono::microseconds responseTimeout,
+                       std::chrono::microseconds byteTimeout);
+
+
+/**
+ * @brief Recovery configuration of a ModbusUtils instance.
+ */
+struct ModbusRecoveryPolicy {
+    int                       maximumResyncRetries = 1;      ///< Retries after a transient error.
+    std::chrono::milliseconds initialReopenBackoff{100};     ///< Wait after the first failed reopen.
+    std::chrono::milliseconds maximumReopenBackoff{5000};    ///< Cap of the doubling reopen backoff.
+};
+
+/**
+ * @brief Outcome of the last range read or written, split into PDUs where it exceeded one.
+ */
+struct ModbusBlockTransfer {
+    int chunks = 0;               ///< PDUs sent.
+    int failedChunks = 0;         ///< PDUs that failed after recovery.
+    int transferred = 0;          ///< Items moved by the PDUs that succeeded.
+    int firstFailedAddress = -1;  ///< Start of the first failed PDU, -1 if none failed.
+    int errorCode = 0;            ///< errno of the first failed PDU.
+};
+
 /**
  * @brief Utility class for Modbus RTU communication using libmodbus.
+ *
+ * Failed transactions are recovered according to classifyModbusError():
+ * transient errors flush the line and retry up to maximumResyncRetries
+ * times, link errors reopen the port once per call. A failed reopen leaves
+ * the context null and further reopens wait for an exponential backoff;
+ * calls in between fail immediately with EBADF.
+ *
+ * Reads and multiple writes accept any range inside the 65536-item address
+ * space: ranges beyond one PDU (2000 bits read, 1968 written, 125 registers
+ * read, 123 written) go out as consecutive maximum-size PDUs, each moving
+ * its items straight to or from its slice of the caller's buffer. A PDU
+ * that fails after recovery does not stop the transfer unless the link is
+ * gone; the call then returns -1 with the errno of the first failure, the
+ * buffer holds every slice that succeeded, and lastBlockTransfer() tells
+ * where the first failure starts.
+ *
+ * An instance is not thread-safe; share one bus between threads through a
+ * ModbusBusOwner.
  */
 class ModbusUtils {
 public:
@@ -60,95 +182,505 @@ public:
      */
     bool reconnectRtu(modbus_t*& contextReference);
 
-    int readCoils(modbus_t* contextPointer,
+    /**
+     * @brief Address subsequent requests to another slave without reopening the port.
+     * @param[in] contextPointer Valid Modbus context.
+     * @param[in] slaveIdentifier Modbus slave identifier (0 = broadcast: writes go out without
+     *            waiting for a reply, and the next request waits broadcastTurnaround).
+     * @return True on success; reconnectRtu() keeps the new identifier.
+     */
+    bool setSlave(modbus_t* contextPointer, int slaveIdentifier);
+
+    /**
+     * @brief Select how response and byte timeouts are computed; applies from the next transaction.
+     */
+    void setTimeoutPolicy(const ModbusTimeoutPolicy& policy);
+
+    /**
+     * @brief Current timeout policy.
+     */
+    const ModbusTimeoutPolicy& timeoutPolicy() const;
+
+    /**
+     * @brief Byte timeout applied to the current line settings.
+     */
+    std::chrono::microseconds effectiveByteTimeout() const;
+
+    /**
+     * @brief Response timeout a transaction would get now.
+     * @param[in] slaveIdentifier Slave the request goes to (adaptive mode is per slave).
+     * @param[in] functionCode Modbus function code.
+     * @param[in] quantity Items transferred, see expectedFrameBytes().
+     */
+    std::chrono::microseconds effectiveResponseTimeout(int slaveIdentifier, int functionCode, int quantity) const;
+
+    /**
+     * @brief Response timeout applied to the most recent transaction.
+     */
+    std::chrono::microseconds lastResponseTimeout() const;
+
+    /**
+     * @brief Observed turnaround of a slave at the policy's percentile.
+     * @return Zero until adaptiveMinimumSamples replies have been seen.
+     */
+    std::chrono::microseconds observedTurnaround(int slaveIdentifier) const;
+
+    /**
+     * @brief Latency histograms and error counters of every transaction issued through this instance.
+     */
+    ModbusMetrics& metrics();
+    const ModbusMetrics& metrics() const;
+
+    /**
+     * @brief Configure retries and reopen backoff.
+     */
+    void setRecoveryPolicy(const ModbusRecoveryPolicy& policy);
+
+    /**
+     * @brief Current recovery policy.
+     */
+    const ModbusRecoveryPolicy& recoveryPolicy() const;
+
+    /**
+     * @brief Route all requests through a transport instead of the libmodbus context.
+     *
+     * While a transport is attached the context arguments are ignored and may
+     * be null; setSlave() selects the slave, and recovery flushes or
+     * reconnects the transport. Timeouts and metrics work as before.
+     * @param[in] transport Transport to use, not owned; nullptr detaches.
+     */
+    void attachTransport(ModbusTransport* transport);
+
+    /**
+     * @brief Attached transport, nullptr when requests go through the context.
+     */
+    ModbusTransport* transport() const;
+
+    /**
+     * @brief Serve reads through a short-TTL cache and invalidate it on writes.
+     *
+     * One cache may be shared by several instances on the same line, so that
+     * threads polling the same points collapse into one bus transaction.
+     * @param[in] cache Cache to use, not owned; nullptr detaches.
+     */
+    void attachReadCache(ModbusReadCache* cache);
+
+    /**
+     * @brief Attached read cache, nullptr when reads always go to the bus.
+     */
+    ModbusReadCache* readCache() const;
+
+    /**
+     * @brief Publish every successful read into a shared process image for local readers.
+     *
+     * Reads served from the read cache are not published again.
+     * @param[in] image Image to publish into, not owned; nullptr detaches.
+     */
+    void attachSharedImage(ModbusSharedImageWriter* image);
+
+    /**
+     * @brief Attached shared image, nullptr when reads are not published.
+     */
+    ModbusSharedImageWriter* sharedImage() const;
+
+    /**
+     * @brief Chunks and first failure of the last read or write of a range.
+     */
+    const ModbusBlockTransfer& lastBlockTransfer() const;
+
+    int readCoils(modbus_t*& contextReference,
                   int startAddress,
                   int numberOfCoils,
                   std::vector<uint8_t>& destination);
 
-    int readDiscreteInputs(modbus_t* contextPointer,
+    int readDiscreteInputs(modbus_t*& contextReference,
                            int startAddress,
                            int numberOfInputs,
                            std::vector<uint8_t>& destination);
 
-    int readHoldingRegisters(modbus_t* contextPointer,
+    int readHoldingRegisters(modbus_t*& contextReference,
                              int startAddress,
                              int numberOfRegisters,
                              std::vector<uint16_t>& destination);
 
-    int readInputRegisters(modbus_t* contextPointer,
+    int readInputRegisters(modbus_t*& contextReference,
                            int startAddress,
                            int numberOfRegisters,
                            std::vector<uint16_t>& destination);
 
-    bool writeSingleCoil(modbus_t* contextPointer,
+    bool writeSingleCoil(modbus_t*& contextReference,
                          int coilAddress,
                          bool coilStatus);
 
-    bool writeSingleRegister(modbus_t* contextPointer,
+    bool writeSingleRegister(modbus_t*& contextReference,
                              int registerAddress,
                              uint16_t registerValue);
 
-    int writeMultipleCoils(modbus_t* contextPointer,
+    int writeMultipleCoils(modbus_t*& contextReference,
                            int startAddress,
                            const std::vector<uint8_t>& source);
 
-    int writeMultipleRegisters(modbus_t* contextPointer,
+    int writeMultipleRegisters(modbus_t*& contextReference,
                                int startAddress,
                                const std::vector<uint16_t>& source);
 
-    bool maskWriteRegister(modbus_t* contextPointer,
+    bool maskWriteRegister(modbus_t*& contextReference,
                            int registerAddress,
                            uint16_t andMask,
                            uint16_t orMask);
 
-    int writeAndReadRegisters(modbus_t* contextPointer,
+    int writeAndReadRegisters(modbus_t*& contextReference,
                               int writeAddress,
                               const std::vector<uint16_t>& source,
                               int readAddress,
                               int numberOfRegisters,
                               std::vector<uint16_t>& destination);
 
-    int reportSlaveIdentifier(modbus_t* contextPointer,
+    int reportSlaveIdentifier(modbus_t*& contextReference,
                               int maximumBytes,
                               std::vector<uint8_t>& destination);
 
-    bool readSingleCoil(modbus_t* contextPointer,
+    bool readSingleCoil(modbus_t*& contextReference,
                         int coilAddress,
                         bool& coilStatus);
 
-    bool readSingleRegister(modbus_t* contextPointer,
+    bool readSingleRegister(modbus_t*& contextReference,
                              int registerAddress,
                              uint16_t& registerValue);
 
+    /**
+     * @brief Read consecutive records of a file (FC20, reference type 6), split like register reads.
+     * @param[in] fileNumber File, 1 to 65535.
+     * @param[in] recordNumber First record, 0 to 9999.
+     * @param[in] numberOfRecords Records to read; the range must end at record 9999 or before.
+     * @param[out] destination One register per record.
+     * @return Number of records read, -1 on error.
+     */
+    int readFileRecord(modbus_t*& contextReference,
+                       int fileNumber,
+                       int recordNumber,
+                       int numberOfRecords,
+                       std::vector<uint16_t>& destination);
+
+    /**
+     * @brief Write consecutive records of a file (FC21, reference type 6), split like register writes.
+     * @return Number of records written, -1 on error.
+     */
+    int writeFileRecord(modbus_t*& contextReference,
+                        int fileNumber,
+                        int recordNumber,
+                        const std::vector<uint16_t>& source);
+
+    /**
+     * @brief Caller-owned buffer variants; they never allocate.
+     *
+     * destination must hold the requested count (one byte per coil or input),
+     * source must hold count items. Return values match the vector variants.
+     */
+    int readCoils(modbus_t*& contextReference,
+                  int startAddress,
+                  int numberOfCoils,
+                  uint8_t* destination);
+
+    int readDiscreteInputs(modbus_t*& contextReference,
+                           int startAddress,
+                           int numberOfInputs,
+                           uint8_t* destination);
+
+    int readHoldingRegisters(modbus_t*& contextReference,
+                             int startAddress,
+                             int numberOfRegisters,
+                             uint16_t* destination);
+
+    int readInputRegisters(modbus_t*& contextReference,
+                           int startAddress,
+                           int numberOfRegisters,
+                           uint16_t* destination);
+
+    int writeMultipleCoils(modbus_t*& contextReference,
+                           int startAddress,
+                           const uint8_t* source,
+                           int count);
+
+    int writeMultipleRegisters(modbus_t*& contextReference,
+                               int startAddress,
+                               const uint16_t* source,
+                               int count);
+
+    int writeAndReadRegisters(modbus_t*& contextReference,
+                              int writeAddress,
+                              const uint16_t* source,
+                              int writeCount,
+                              int readAddress,
+                              int numberOfRegisters,
+                              uint16_t* destination);
+
+    int reportSlaveIdentifier(modbus_t*& contextReference,
+                              int maximumBytes,
+                              uint8_t* destination);
+
+    int readFileRecord(modbus_t*& contextReference,
+                       int fileNumber,
+                       int recordNumber,
+                       int numberOfRecords,
+                       uint16_t* destination);
+
+    int writeFileRecord(modbus_t*& contextReference,
+                        int fileNumber,
+                        int recordNumber,
+                        const uint16_t* source,
+                        int count);
+
+    /**
+     * @brief Fixed-size variants; the count is the array size.
+     */
+    template<size_t Count>
+    int readCoils(modbus_t*& contextReference, int startAddress, std::array<uint8_t, Count>& destination) {
+        return readCoils(contextReference, startAddress, static_cast<int>(Count), destination.data());
+    }
+
+    template<size_t Count>
+    int readDiscreteInputs(modbus_t*& contextReference, int startAddress, std::array<uint8_t, Count>& destination) {
+        return readDiscreteInputs(contextReference, startAddress, static_cast<int>(Count), destination.data());
+    }
+
+    template<size_t Count>
+    int readHoldingRegisters(modbus_t*& contextReference, int startAddress, std::array<uint16_t, Count>& destination) {
+        return readHoldingRegisters(contextReference, startAddress, static_cast<int>(Count), destination.data());
+    }
+
+    template<size_t Count>
+    int readInputRegisters(modbus_t*& contextReference, int startAddress, std::array<uint16_t, Count>& destination) {
+        return readInputRegisters(contextReference, startAddress, static_cast<int>(Count), destination.data());
+    }
+
+    template<size_t Count>
+    int writeMultipleCoils(modbus_t*& contextReference, int startAddress, const std::array<uint8_t, Count>& source) {
+        return writeMultipleCoils(contextReference, startAddress, source.data(), static_cast<int>(Count));
+    }
+
+    template<size_t Count>
+    int writeMultipleRegisters(modbus_t*& contextReference, int startAddress, const std::array<uint16_t, Count>& source) {
+        return writeMultipleRegisters(contextReference, startAddress, source.data(), static_cast<int>(Count));
+    }
+
+    template<size_t WriteCount, size_t ReadCount>
+    int writeAndReadRegisters(modbus_t*& contextReference,
+                              int writeAddress,
+                              const std::array<uint16_t, WriteCount>& source,
+                              int readAddress,
+                              std::array<uint16_t, ReadCount>& destination) {
+        return writeAndReadRegisters(contextReference, writeAddress, source.data(), static_cast<int>(WriteCount),
+                                     readAddress, static_cast<int>(ReadCount), destination.data());
+    }
+
 private:
+    /**
+     * @brief Recent reply turnarounds of one slave, for the adaptive timeout.
+     */
+    struct TurnaroundTracker {
+        std::array<uint32_t, 128> samplesMicroseconds{};
+        int                       count = 0;
+        int                       next = 0;
+        int                       sinceUpdate = 0;
+        uint32_t                  quantileMicroseconds = 0;
+    };
+
     bool ensureContext(modbus_t* contextPointer, const char* functionName);
 
+    bool openRtuUnlocked(modbus_t*& contextReference,
+                         const std::string& serialDevicePath,
+                         int baudRate,
+                         char parityMode,
+                         int dataBits,
+                         int stopBits,
+                         int slaveIdentifier);
+
+    /**
+     * @brief Drop whatever is left of a late or corrupt frame.
+     */
+    void resynchronize(modbus_t* contextPointer);
+
+    /**
+     * @brief Reopen the last port unless the reopen backoff is still running.
+     */
+    bool reopenForRecovery(modbus_t*& contextReference);
+
+    void finishRecovery(ModbusErrorClass recovering,
+                        std::chrono::steady_clock::time_point failedAt,
+                        bool recovered);
+
+    int currentSlave(modbus_t* contextPointer) const;
+
+    /**
+     * @brief True when requests go to unit 0 through the libmodbus context, which would wait for a reply.
+     */
+    bool broadcasting(modbus_t* contextPointer) const;
+
+    void beginTransaction(modbus_t* contextPointer, int functionCode, int quantity);
+    void endTransaction(modbus_t* contextPointer,
+                        int functionCode,
+                        int quantity,
+                        int result,
+                        std::chrono::steady_clock::time_point started);
+    std::chrono::nanoseconds wireTime(int functionCode, int quantity) const;
+
+    /**
+     * @brief Run one attempt callable per try under the recovery rules of the class.
+     */
+    template<typename Attempt>
+    int executeWithRecovery(modbus_t*& contextReference, int functionCode, int quantity, Attempt attempt);
+
     template<typename Function, typename... Arguments>
     int executeWithReconnect(modbus_t*& contextReference,
+                             int functionCode,
+                             int quantity,
                              Function functionPointer,
                              Arguments&&... args);
 
+    /**
+     * @brief Exchange one request PDU: through the transport, or as raw RTU frames on the context.
+     *
+     * libmodbus cannot frame replies to function codes it does not know
+     * (FC20/FC21), so the context path reads the reply from the port itself.
+     * @return Response PDU length, 0 for a broadcast, -1 on error.
+     */
+    int exchange(modbus_t* contextPointer, const uint8_t* request, int requestLength,
+                 uint8_t* response, int responseCapacity);
+
+    /**
+     * @brief Run a request PDU through exchange() under the recovery rules and decode the reply.
+     */
+    template<typename Decode>
+    int transportTransaction(modbus_t*& contextReference,
+                             int functionCode,
+                             int quantity,
+                             const uint8_t* request,
+                             int requestLength,
+                             Decode decode);
+    int transportReadBits(modbus_t*& contextReference, int functionCode, int startAddress, int count,
+                          uint8_t* destination);
+    int transportReadRegisters(modbus_t*& contextReference, int functionCode, int startAddress, int count,
+                               uint16_t* destination);
+    int transportWrite(modbus_t*& contextReference, int functionCode, int quantity,
+                       const uint8_t* request, int requestLength);
+
+    /**
+     * @brief Move a range as PDUs of at most chunkLimit items; see the class description.
+     * @param[in] addressLimit Size of the address space the range must fit in.
+     * @param[in] chunk Called as chunk(address, offset, count) per PDU; returns -1 on error.
+     */
+    template<typename Chunk>
+    int transferBlock(int startAddress, int count, int chunkLimit, int addressLimit, Chunk chunk);
+
+    /**
+     * @brief Read one PDU worth of a table through the read cache, if attached.
+     */
+    int readBits(modbus_t*& contextReference, ModbusTable table, int startAddress, int count,
+                 uint8_t* destination);
+    int readRegisters(modbus_t*& contextReference, ModbusTable table, int startAddress, int count,
+                      uint16_t* destination);
+
+    /**
+     * @brief Write one PDU worth of coils or holding registers and invalidate the read cache.
+     */
+    int storeBits(modbus_t*& contextReference, int startAddress, const uint8_t* source, int count);
+    int storeRegisters(modbus_t*& contextReference, int startAddress, const uint16_t* source, int count);
+
+    int fetchFileRecord(modbus_t*& contextReference, int fileNumber, int recordNumber, int count,
+                        uint16_t* destination);
+    int storeFileRecord(modbus_t*& contextReference, int fileNumber, int recordNumber, const uint16_t* source,
+                        int count);
+
+    /**
+     * @brief Read a table from the bus, bypassing the read cache.
+     */
+    int fetchBits(modbus_t*& contextReference, ModbusTable table, int startAddress, int count,
+                  uint8_t* destination);
+    int fetchRegisters(modbus_t*& contextReference, ModbusTable table, int startAddress, int count,
+                       uint16_t* destination);
+    void invalidateReadCache(modbus_t* contextPointer, ModbusTable table, int startAddress, int count);
+
     std::string lastSerialDevicePath_;
-    int         lastBaudRate_;
-    char        lastParityMode_;
-    int         lastDataBits_;
-    int         lastStopBits_;
-    int         lastSlaveIdentifier_;
+    int         lastBaudRate_ = 115200;
+    char        lastParityMode_ = 'N';
+    int         lastDataBits_ = 8;
+    int         lastStopBits_ = 1;
+    int         lastSlaveIdentifier_ = 1;
     std::mutex  contextMutex_;
+    ModbusTransport* transport_ = nullptr;
+    ModbusReadCache* readCache_ = nullptr;
+    ModbusSharedImageWriter* sharedImage_ = nullptr;
+    ModbusBlockTransfer lastBlockTransfer_;
+
+    ModbusTimeoutPolicy       timeoutPolicy_;
+    std::chrono::nanoseconds  characterTime_{0};
+    std::chrono::nanoseconds  interFrameDelay_{0};
+    std::chrono::microseconds lastResponseTimeout_{0};
+    std::chrono::microseconds appliedByteTimeout_{0};
+    std::chrono::steady_clock::time_point broadcastQuietUntil_;   ///< No request before this after a broadcast.
+    std::array<std::unique_ptr<TurnaroundTracker>, 248> turnarounds_;
+    ModbusMetrics             metrics_;
+
+    ModbusRecoveryPolicy                  recoveryPolicy_;
+    std::chrono::milliseconds             reopenBackoff_{0};
+    std::chrono::steady_clock::time_point nextReopenAttempt_;
 };
 
 template<typename Function, typename... Arguments>
 int ModbusUtils::executeWithReconnect(modbus_t*& contextReference,
+                                      int functionCode,
+                                      int quantity,
                                       Function functionPointer,
                                       Arguments&&... args) {
-    if (!ensureContext(contextReference, __func__)) {
+    // Captured by reference: a reopen replaces the context between attempts.
+    return executeWithRecovery(contextReference, functionCode, quantity, [&]() {
+        return functionPointer(contextReference, args...);
+    });
+}
+
+template<typename Attempt>
+int ModbusUtils::executeWithRecovery(modbus_t*& contextReference, int functionCode, int quantity, Attempt attempt) {
+    if (!transport_ && !contextReference && !reopenForRecovery(contextReference)) {
         return -1;
     }
-    int result = functionPointer(contextReference, std::forward<Arguments>(args)...);
-    if (result == -1 && reconnectRtu(contextReference)) {
-        result = functionPointer(contextReference, std::forward<Arguments>(args)...);
+
+    ModbusErrorClass recovering = ModbusErrorClass::None;
+    std::chrono::steady_clock::time_point failedAt;
+    int resyncRetries = 0;
+    for (;;) {
+        beginTransaction(contextReference, functionCode, quantity);
+        auto started = std::chrono::steady_clock::now();
+        int result = attempt();
+        endTransaction(contextReference, functionCode, quantity, result, started);
+        if (result != -1) {
+            finishRecovery(recovering, failedAt, true);
+            return result;
+        }
+
+        const int errorCode = errno;
+        const ModbusErrorClass errorClass = classifyModbusError(errorCode);
+        if (recovering == ModbusErrorClass::None) {
+            failedAt = started;
+        }
+        if (errorClass == ModbusErrorClass::Transient && resyncRetries < recoveryPolicy_.maximumResyncRetries) {
+            ++resyncRetries;
+            if (recovering == ModbusErrorClass::None) {
+                recovering = ModbusErrorClass::Transient;
+            }
+            resynchronize(contextReference);
+            continue;
+        }
+        if (errorClass == ModbusErrorClass::Link && recovering != ModbusErrorClass::Link) {
+            recovering = ModbusErrorClass::Link;
+            if (reopenForRecovery(contextReference)) {
+                continue;
+            }
+        }
+        finishRecovery(recovering, failedAt, false);
+        errno = errorCode;
+        return -1;
     }
-    return result;
 }
 
 } // namespace test_modbus_485
@@ -0,0 +1,114 @@
+// include/modbus_write_coalescer.h
+
+#ifndef MODBUS_WRITE_COALESCER_H
+#define MODBUS_WRITE_COALESCER_H
+
+#include "modbus_bus_owner.h"
+#include "modbus_metrics.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <tuple>
+#include <vector>
+
+namespace test_modbus_485 {
+
+/**
+ * @brief Counters of a ModbusWriteCoalescer.
+ */
+struct ModbusWriteCoalescerStatistics {
+    uint64_t                 posted = 0;      ///< Writes posted.
+    uint64_t                 merged = 0;      ///< Posted while the range was still queued; only the newest values go out.
+    uint64_t                 written = 0;     ///< Bus writes that succeeded, broadcasts included.
+    uint64_t                 failed = 0;      ///< Bus writes that failed.
+    uint64_t                 dropped = 0;     ///< Queued writes cancelled because the bus owner stopped.
+    uint64_t                 broadcasts = 0;  ///< Bus writes to unit 0, each reaching every slave in one frame.
+    LatencyHistogramSnapshot age;             ///< Post of the values written to the end of their write.
+
+    void print(std::ostream& stream) const;
+};
+
+/**
+ * @brief Last-writer-wins write path for setpoints and commands on top of a ModbusBusOwner.
+ *
+ * At most one write per (slave, table, start, count) is queued at a time.
+ * A write posted while the previous one for the same range is still queued
+ * replaces its values instead of queueing behind it, so when the bus falls
+ * behind only the newest setpoint goes out and its age stays bounded by one
+ * queue wait instead of growing with the backlog. Callers that were merged
+ * share the future of the write that carried their range. Slave 0
+ * broadcasts the write: every drive takes the command from one frame, and
+ * ModbusUtils keeps the line quiet for the policy's broadcastTurnaround
+ * afterwards. Thread-safe; the bus owner must outlive the coalescer.
+ */
+class ModbusWriteCoalescer {
+public:
+    /**
+     * @param[in] owner Bus owner the writes are queued on.
+     * @param[in] priority Class the writes are queued in.
+     */
+    explicit ModbusWriteCoalescer(ModbusBusOwner& owner,
+                                  ModbusRequestPriority priority = ModbusRequestPriority::Control);
+
+    ModbusWriteCoalescer(const ModbusWriteCoalescer&) = delete;
+    ModbusWriteCoalescer& operator=(const ModbusWriteCoalescer&) = delete;
+
+    /**
+     * @brief Write holding registers (FC6 for one, FC16 otherwise), replacing a queued write of the same range.
+     * @param[in] slaveIdentifier Slave, 0 to broadcast.
+     * @return Future of the write that carries these values or newer ones.
+     */
+    std::shared_future<ModbusBusResult> writeRegisters(int slaveIdentifier, int startAddress,
+                                                       std::vector<uint16_t> values);
+
+    /**
+     * @brief Write coils, one byte per coil (FC5 for one, FC15 otherwise), replacing a queued write of the same range.
+     */
+    std::shared_future<ModbusBusResult> writeCoils(int slaveIdentifier, int startAddress, std::vector<uint8_t> values);
+
+    /**
+     * @brief Ranges queued now.
+     */
+    size_t pending() const;
+
+    ModbusWriteCoalescerStatistics statistics() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+    using Key = std::tuple<int, int, int, int>;   ///< Slave, table, start, count.
+
+    struct Pending {
+        std::vector<uint16_t>                          registers;
+        std::vector<uint8_t>                           bits;
+        Clock::time_point                              posted;     ///< Of the newest values.
+        std::shared_ptr<std::promise<ModbusBusResult>> promise;
+        std::shared_future<ModbusBusResult>            future;
+    };
+
+    /**
+     * @brief Queue a range or merge into its queued write; registers or bits holds the values.
+     */
+    std::shared_future<ModbusBusResult> post(int slaveIdentifier, ModbusTable table, int startAddress, int count,
+                                             std::vector<uint16_t> registers, std::vector<uint8_t> bits);
+
+    /**
+     * @brief Run on the owner thread: take the newest values of a range and write them.
+     */
+    int flush(const Key& key, ModbusUtils& modbus, modbus_t*& contextReference);
+
+    ModbusBusOwner&                owner_;
+    ModbusRequestPriority          priority_;
+    mutable std::mutex             mutex_;
+    std::map<Key, Pending>         pending_;
+    ModbusWriteCoalescerStatistics counters_;
+    LatencyHistogram               age_;
+};
+
+} // namespace test_modbus_485
+
+#endif // MODBUS_WRITE_COALESCER_H
@@ -0,0 +1,474 @@
+// src/modbus_async_engine.cpp
+
+#include "modbus_async_engine.h"
+#include "modbus_rtu_codec.h"
+#include "modbus_timing.h"
+#include <modbus.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <termios.h>
+#include <unistd.h>
+
+test_modbus_485::ModbusAsyncEngine::ModbusAsyncEngine()
+    : epollFileDescriptor_(-1),
+      wakeFileDescriptor_(-1),
+      running_(false) {}
+
+test_modbus_485::ModbusAsyncEngine::~ModbusAsyncEngine() {
+    for (std::unique_ptr<Port>& port : ports_) {
+        if (port) {
+            ::close(port->timerFileDescriptor);
+        }
+    }
+    if (wakeFileDescriptor_ >= 0) {
+        ::close(wakeFileDescriptor_);
+    }
+    if (epollFileDescriptor_ >= 0) {
+        ::close(epollFileDescriptor_);
+    }
+}
+
+bool test_modbus_485::ModbusAsyncEngine::initialize() {
+    epollFileDescriptor_ = ::epoll_create1(EPOLL_CLOEXEC);
+    if (epollFileDescriptor_ < 0) {
+        perror("[initialize] epoll_create1");
+        return false;
+    }
+    wakeFileDescriptor_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wakeFileDescriptor_ < 0) {
+        perror("[initialize] eventfd");
+        return false;
+    }
+    return watch(wakeFileDescriptor_, EPOLLIN, [this](uint32_t) {
+        uint64_t counter;
+        while (::read(wakeFileDescriptor_, &counter, sizeof(counter)) > 0) {
+        }
+        drainSubmissions();
+    });
+}
+
+int test_modbus_485::ModbusAsyncEngine::addPort(int fileDescriptor, const ModbusAsyncPortOptions& options) {
+    if (fileDescriptor < 0 || options.baudRate <= 0) {
+        std::cerr << "[addPort] invalid descriptor or baud rate\n";
+        return -1;
+    }
+    int flags = ::fcntl(fileDescriptor, F_GETFL);
+    if (flags < 0 || ::fcntl(fileDescriptor, F_SETFL, flags | O_NONBLOCK) < 0) {
+        perror("[addPort] fcntl");
+        return -1;
+    }
+
+    std::unique_ptr<Port> port(new Port());
+    port->fileDescriptor = fileDescriptor;
+    port->timerFileDescriptor = ::timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (port->timerFileDescriptor < 0) {
+        perror("[addPort] timerfd_create");
+        return -1;
+    }
+    port->options = options;
+    port->characterTime = characterTime(options.baudRate, options.bitsPerCharacter);
+    port->frameGap = interFrameDelay(options.baudRate, options.bitsPerCharacter);
+    port->byteTimeout = options.byteTimeout.count() > 0
+                        ? std::chrono::nanoseconds(options.byteTimeout)
+                        : port->frameGap + std::chrono::nanoseconds(options.byteTimeoutSlack);
+    port->state = PortState::Idle;
+    port->transmitLength = 0;
+    port->transmitSent = 0;
+    port->receiveLength = 0;
+    port->expectedLength = -1;
+    port->failure = 0;
+    port->lastActivity = Clock::time_point{};
+
+    const int handle = static_cast<int>(ports_.size());
+    Port* raw = port.get();
+    ports_.push_back(std::move(port));
+    if (!watch(raw->fileDescriptor, EPOLLIN, [this, raw](uint32_t events) { onPortEvent(*raw, events); }) ||
+        !watch(raw->timerFileDescriptor, EPOLLIN, [this, raw](uint32_t) { onTimer(*raw); })) {
+        unwatch(raw->fileDescriptor);
+        ::close(raw->timerFileDescriptor);
+        ports_[handle].reset();
+        return -1;
+    }
+    return handle;
+}
+
+void test_modbus_485::ModbusAsyncEngine::removePort(int portHandle) {
+    if (portHandle < 0 || portHandle >= static_cast<int>(ports_.size()) || !ports_[portHandle]) {
+        return;
+    }
+    std::unique_ptr<Port> port = std::move(ports_[portHandle]);
+    unwatch(port->fileDescriptor);
+    unwatch(port->timerFileDescriptor);
+    ::close(port->timerFileDescriptor);
+
+    ModbusAsyncResult result{ECANCELED, {}, std::chrono::nanoseconds(0)};
+    if (port->state != PortState::Idle && port->current.completion) {
+        port->current.completion(result);
+    }
+    for (Transaction& transaction : port->queue) {
+        if (transaction.completion) {
+            transaction.completion(result);
+        }
+    }
+}
+
+bool test_modbus_485::ModbusAsyncEngine::submit(int portHandle,
+                                                int slaveIdentifier,
+                                                const uint8_t* pdu,
+                                                int pduLength,
+                                                Completion completion) {
+    if (pduLength < 1 || pduLength > MODBUS_MAX_PDU_LENGTH || slaveIdentifier < 0 || slaveIdentifier > 247) {
+        std::cerr << "[submit] invalid PDU length or slave\n";
+        return false;
+    }
+    Transaction transaction;
+    transaction.portHandle = portHandle;
+    transaction.slaveIdentifier = slaveIdentifier;
+    std::memcpy(transaction.pdu, pdu, static_cast<size_t>(pduLength));
+    transaction.pduLength = pduLength;
+    transaction.completion = std::move(completion);
+    transaction.submitted = Clock::now();
+    // Wake the loop under the lock: if that fails the request is still the
+    // last one queued and is withdrawn, so its completion never runs.
+    std::lock_guard<std::mutex> lock(submitMutex_);
+    submitted_.push_back(std::move(transaction));
+    uint64_t one = 1;
+    if (::write(wakeFileDescriptor_, &one, sizeof(one)) != sizeof(one) && errno != EAGAIN) {
+        perror("[submit] eventfd write");
+        submitted_.pop_back();
+        return false;
+    }
+    return true;
+}
+
+std::future<test_modbus_485::ModbusAsyncResult>
+test_modbus_485::ModbusAsyncEngine::submit(int portHandle, int slaveIdentifier, const uint8_t* pdu, int pduLength) {
+    auto promise = std::make_shared<std::promise<ModbusAsyncResult>>();
+    std::future<ModbusAsyncResult> future = promise->get_future();
+    if (!submit(portHandle, slaveIdentifier, pdu, pduLength,
+                [promise](const ModbusAsyncResult& result) { promise->set_value(result); })) {
+        promise->set_value(ModbusAsyncResult{EINVAL, {}, std::chrono::nanoseconds(0)});
+    }
+    return future;
+}
+
+std::future<test_modbus_485::ModbusAsyncResult>
+test_modbus_485::ModbusAsyncEngine::readHoldingRegisters(int portHandle, int slaveIdentifier,
+                                                         int startAddress, int numberOfRegisters) {
+    uint8_t pdu[MODBUS_MAX_PDU_LENGTH];
+    int length = encodeReadRequest(MODBUS_FC_READ_HOLDING_REGISTERS, startAddress, numberOfRegisters, pdu);
+    return submit(portHandle, slaveIdentifier, pdu, length);
+}
+
+std::future<test_modbus_485::ModbusAsyncResult>
+test_modbus_485::ModbusAsyncEngine::readCoils(int portHandle, int slaveIdentifier,
+                                              int startAddress, int numberOfCoils) {
+    uint8_t pdu[MODBUS_MAX_PDU_LENGTH];
+    int length = encodeReadRequest(MODBUS_FC_READ_COILS, startAddress, numberOfCoils, pdu);
+    return submit(portHandle, slaveIdentifier, pdu, length);
+}
+
+std::future<test_modbus_485::ModbusAsyncResult>
+test_modbus_485::ModbusAsyncEngine::writeMultipleRegisters(int portHandle, int slaveIdentifier,
+                                                           int startAddress, const uint16_t* source, int count) {
+    if (count < 1 || count > MODBUS_MAX_WRITE_REGISTERS) {
+        std::promise<ModbusAsyncResult> promise;
+        promise.set_value(ModbusAsyncResult{EMBMDATA, {}, std::chrono::nanoseconds(0)});
+        return promise.get_future();
+    }
+    uint8_t pdu[MODBUS_MAX_PDU_LENGTH];
+    int length = encodeWriteMultipleRegisters(startAddress, source, count, pdu);
+    return submit(portHandle, slaveIdentifier, pdu, length);
+}
+
+std::future<test_modbus_485::ModbusAsyncResult>
+test_modbus_485::ModbusAsyncEngine::writeMultipleCoils(int portHandle, int slaveIdentifier,
+                                                       int startAddress, const uint8_t* source, int count) {
+    if (count < 1 || count > MODBUS_MAX_WRITE_BITS) {
+        std::promise<ModbusAsyncResult> promise;
+        promise.set_value(ModbusAsyncResult{EMBMDATA, {}, std::chrono::nanoseconds(0)});
+        return promise.get_future();
+    }
+    uint8_t pdu[MODBUS_MAX_PDU_LENGTH];
+    int length = encodeWriteMultipleCoils(startAddress, source, count, pdu);
+    return submit(portHandle, slaveIdentifier, pdu, length);
+}
+
+bool test_modbus_485::ModbusAsyncEngine::watch(int fileDescriptor, uint32_t events, EventHandler handler) {
+    epoll_event event{};
+    event.events = events;
+    event.data.fd = fileDescriptor;
+    if (::epoll_ctl(epollFileDescriptor_, EPOLL_CTL_ADD, fileDescriptor, &event) != 0) {
+        perror("[watch] epoll_ctl");
+        return false;
+    }
+    handlers_[fileDescriptor] = std::make_shared<EventHandler>(std::move(handler));
+    return true;
+}
+
+bool test_modbus_485::ModbusAsyncEngine::modifyWatch(int fileDescriptor, uint32_t events) {
+    epoll_event event{};
+    event.events = events;
+    event.data.fd = fileDescriptor;
+    return ::epoll_ctl(epollFileDescriptor_, EPOLL_CTL_MOD, fileDescriptor, &event) == 0;
+}
+
+void test_modbus_485::ModbusAsyncEngine::unwatch(int fileDescriptor) {
+    ::epoll_ctl(epollFileDescriptor_, EPOLL_CTL_DEL, fileDescriptor, nullptr);
+    handlers_.erase(fileDescriptor);
+}
+
+int test_modbus_485::ModbusAsyncEngine::runOnce(int timeoutMilliseconds) {
+    epoll_event events[64];
+    int count = ::epoll_wait(epollFileDescriptor_, events, 64, timeoutMilliseconds);
+    if (count < 0) {
+        if (errno == EINTR) {
+            return 0;
+        }
+        perror("[runOnce] epoll_wait");
+        return -1;
+    }
+    for (int i = 0; i < count; ++i) {
+        auto found = handlers_.find(events[i].data.fd);
+        if (found == handlers_.end()) {
+            continue; // unwatched by an earlier handler of this batch
+        }
+        std::shared_ptr<EventHandler> handler = found->second;
+        (*handler)(events[i].events);
+    }
+    return count;
+}
+
+void test_modbus_485::ModbusAsyncEngine::run() {
+    running_.store(true);
+    while (running_.load() && runOnce(-1) >= 0) {
+    }
+}
+
+void test_modbus_485::ModbusAsyncEngine::stop() {
+    running_.store(false);
+    uint64_t one = 1;
+    if (::write(wakeFileDescriptor_, &one, sizeof(one)) < 0 && errno != EAGAIN) {
+        perror("[stop] write");
+    }
+}
+
+size_t test_modbus_485::ModbusAsyncEngine::pendingCount(int portHandle) const {
+    if (portHandle < 0 || portHandle >= static_cast<int>(ports_.size()) || !ports_[portHandle]) {
+        return 0;
+    }
+    const Port& port = *ports_[portHandle];
+    return port.queue.size() + (port.state == PortState::Idle ? 0 : 1);
+}
+
+void test_modbus_485::ModbusAsyncEngine::drainSubmissions() {
+    std::vector<Transaction> batch;
+    {
+        std::lock_guard<std::mutex> lock(submitMutex_);
+        batch.swap(submitted_);
+    }
+    for (Transaction& transaction : batch) {
+        int handle = transaction.portHandle;
+        if (handle < 0 || handle >= static_cast<int>(ports_.size()) || !ports_[handle]) {
+            if (transaction.completion) {
+                transaction.completion(ModbusAsyncResult{EBADF, {}, Clock::now() - transaction.submitted});
+            }
+            continue;
+        }
+        Port& port = *ports_[handle];
+        port.queue.push_back(std::move(transaction));
+        startNext(port);
+    }
+}
+
+void test_modbus_485::ModbusAsyncEngine::armTimer(Port& port, Clock::time_point when) {
+    auto sinceEpoch = std::chrono::duration_cast<std::chrono::nanoseconds>(when.time_since_epoch()).count();
+    itimerspec specification{};
+    specification.it_value.tv_sec = static_cast<time_t>(sinceEpoch / 1000000000LL);
+    specification.it_value.tv_nsec = static_cast<long>(sinceEpoch % 1000000000LL);
+    if (specification.it_value.tv_sec == 0 && specification.it_value.tv_nsec == 0) {
+        specification.it_value.tv_nsec = 1; // zero would disarm
+    }
+    ::timerfd_settime(port.timerFileDescriptor, TFD_TIMER_ABSTIME, &specification, nullptr);
+}
+
+void test_modbus_485::ModbusAsyncEngine::startNext(Port& port) {
+    if (port.state != PortState::Idle || port.queue.empty()) {
+        return;
+    }
+    port.current = std::move(port.queue.front());
+    port.queue.pop_front();
+    if (port.failure != 0) {
+        port.state = PortState::Sending;
+        finish(port, port.failure);
+        return;
+    }
+
+    port.transmit[0] = static_cast<uint8_t>(port.current.slaveIdentifier);
+    std::memcpy(port.transmit + 1, port.current.pdu, static_cast<size_t>(port.current.pduLength));
+    port.transmitLength = appendCrc(port.transmit, port.current.pduLength + 1);
+    port.transmitSent = 0;
+    port.receiveLength = 0;
+    port.expectedLength = expectedRtuResponseLength(port.transmit, port.transmitLength);
+
+    const Clock::time_point gapEnd = port.lastActivity + port.frameGap;
+    if (Clock::now() < gapEnd) {
+        port.state = PortState::Gap;
+        armTimer(port, gapEnd);
+        return;
+    }
+    sendFrame(port);
+}
+
+void test_modbus_485::ModbusAsyncEngine::sendFrame(Port& port) {
+    if (port.state != PortState::Sending) {
+        // Drop bytes of a late reply to an earlier request before talking again.
+        ::tcflush(port.fileDescriptor, TCIFLUSH);
+        port.state = PortState::Sending;
+    }
+    while (port.transmitSent < port.transmitLength) {
+        ssize_t written = ::write(port.fileDescriptor, port.transmit + port.transmitSent,
+                                  static_cast<size_t>(port.transmitLength - port.transmitSent));
+        if (written > 0) {
+            port.transmitSent += static_cast<int>(written);
+        } else if (written < 0 && (errno == EAGAIN || errno == EINTR)) {
+            modifyWatch(port.fileDescriptor, EPOLLIN | EPOLLOUT);
+            return;
+        } else {
+            port.failure = errno ? errno : EIO;
+            finish(port, port.failure);
+            return;
+        }
+    }
+    modifyWatch(port.fileDescriptor, EPOLLIN);
+
+    // The UART still has the frame in flight; time the reply from the end of transmission.
+    const Clock::time_point transmitted = Clock::now() + port.characterTime * port.transmitLength;
+    port.lastActivity = transmitted;
+    port.state = PortState::Awaiting;
+    if (port.expectedLength == 0) {
+        armTimer(port, transmitted + port.frameGap);
+    } else {
+        armTimer(port, transmitted + port.options.responseTimeout);
+    }
+}
+
+void test_modbus_485::ModbusAsyncEngine::onPortEvent(Port& port, uint32_t events) {
+    if ((events & EPOLLOUT) && port.state == PortState::Sending) {
+        sendFrame(port);
+    }
+    if (events & (EPOLLIN | EPOLLERR | EPOLLHUP)) {
+        uint8_t discard[256];
+        for (;;) {
+            const bool collecting = port.state == PortState::Awaiting && port.expectedLength != 0;
+            uint8_t* buffer = collecting ? port.receive + port.receiveLength : discard;
+            size_t room = collecting ? sizeof(port.receive) - static_cast<size_t>(port.receiveLength) : sizeof(discard);
+            if (room == 0) {
+                buffer = discard;
+                room = sizeof(discard);
+            }
+            ssize_t received = ::read(port.fileDescriptor, buffer, room);
+            if (received > 0) {
+                port.lastActivity = Clock::now();
+                if (collecting && buffer != discard) {
+                    port.receiveLength += static_cast<int>(received);
+                }
+                continue;
+            }
+            if (received < 0 && errno == EINTR) {
+                continue;
+            }
+            if (received == 0 || errno != EAGAIN) {
+                // Hung up or broken: stop polling the descriptor so the loop does not spin.
+                port.failure = received == 0 ? EIO : errno;
+                modifyWatch(port.fileDescriptor, 0);
+                if (port.state != PortState::Idle) {
+                    finish(port, port.failure);
+                }
+                return;
+            }
+            break;
+        }
+    }
+    if (port.state != PortState::Awaiting || port.receiveLength == 0) {
+        return;
+    }
+
+    if (port.receiveLength >= 2 && (port.receive[1] & 0x80)) {
+        port.expectedLength = 5;
+    }
+    if (port.expectedLength > 0 && port.receiveLength >= port.expectedLength) {
+        finish(port, 0);
+        return;
+    }
+    // Inside a reply the byte timeout applies, as in libmodbus.
+    armTimer(port, port.lastActivity + port.byteTimeout);
+}
+
+void test_modbus_485::ModbusAsyncEngine::onTimer(Port& port) {
+    uint64_t expirations;
+    bool expired = false;
+    while (::read(port.timerFileDescriptor, &expirations, sizeof(expirations)) > 0) {
+        expired = true;
+    }
+    if (!expired) {
+        return; // re-armed or disarmed after epoll reported it
+    }
+    switch (port.state) {
+        case PortState::Gap:
+            sendFrame(port);
+            break;
+        case PortState::Awaiting:
+            if (port.expectedLength == 0) {
+                finish(port, 0);
+            } else if (port.receiveLength == 0) {
+                finish(port, ETIMEDOUT);
+            } else if (port.expectedLength < 0) {
+                finish(port, 0); // unknown function code: the silence ends the frame
+            } else {
+                finish(port, EMBBADDATA);
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+void test_modbus_485::ModbusAsyncEngine::finish(Port& port, int errorCode) {
+    ModbusAsyncResult result{errorCode, {}, Clock::now() - port.current.submitted};
+    if (errorCode == 0 && port.expectedLength != 0) {
+        int length = port.expectedLength > 0 ? port.expectedLength : port.receiveLength;
+        const uint8_t functionCode = port.current.pdu[0];
+        if (length < 4 || !checkCrc(port.receive, length)) {
+            result.errorCode = EMBBADCRC;
+        } else if (port.receive[0] != port.current.slaveIdentifier) {
+            result.errorCode = EMBBADSLAVE;
+        } else if (port.receive[1] == (functionCode | 0x80)) {
+            result.errorCode = MODBUS_ENOBASE + port.receive[2];
+        } else if (port.receive[1] != functionCode) {
+            result.errorCode = EMBBADDATA;
+        } else {
+            result.response.assign(port.receive + 1, port.receive + length - 2);
+        }
+    }
+
+    itimerspec disarm{};
+    ::timerfd_settime(port.timerFileDescriptor, 0, &disarm, nullptr);
+    modifyWatch(port.fileDescriptor, port.failure == 0 ? static_cast<uint32_t>(EPOLLIN) : 0u);
+    port.state = PortState::Idle;
+    port.lastActivity = std::max(port.lastActivity, Clock::now());
+
+    Completion completion = std::move(port.current.completion);
+    port.current.completion = nullptr;
+    if (completion) {
+        completion(result);
+    }
+    startNext(port);
+}
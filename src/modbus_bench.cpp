@@ -0,0 +1,393 @@
+// src/modbus_bench.cpp
+//
+// Self-contained ModbusUtils benchmark: master and simulated slaves run in one
+// process over a pseudo-terminal pair, sweeping baud rate, function code,
+// payload size and slave count. Results go to stdout as CSV or JSON.
+// --transport=loopback skips the pty and the kernel: requests go through
+// ModbusLoopbackTransport, so with --no-wire-time the numbers are the pure
+// software cost per transaction (framing, CRC, copies, bookkeeping).
+// Counts beyond one PDU measure block transfers, which ModbusUtils splits
+// into maximum-size PDUs; FC20/FC21 move file records. Each case reports
+// items per second against the wire limit: the rate if the line carried
+// nothing but the request and response frames and the t3.5 after each request.
+//
+// usage: modbus_bench [--baud=9600,115200,...] [--fc=3,16,23,1,15,20,21]
+//                     [--count=1,16,64,125] [--slaves=1,4]
+//                     [--duration-ms=500] [--no-wire-time] [--format=csv|json]
+//                     [--transport=pty|loopback]
+
+#include "modbus_utils.h"
+#include "modbus_loopback_transport.h"
+#include "modbus_metrics.h"
+#include "modbus_pty.h"
+#include "modbus_rtu_codec.h"
+#include "modbus_slave_simulator.h"
+#include "modbus_timing.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+#include <termios.h>
+#include <unistd.h>
+
+using namespace std::chrono;
+
+namespace {
+
+// Table size of the simulated slaves, the longest block a case can move.
+constexpr int simulatedTableSize = 10000;
+
+struct BenchOptions {
+    std::vector<int> baudRates{9600, 115200, 921600};
+    std::vector<int> functionCodes{MODBUS_FC_READ_HOLDING_REGISTERS,
+                                   MODBUS_FC_WRITE_MULTIPLE_REGISTERS,
+                                   MODBUS_FC_WRITE_AND_READ_REGISTERS,
+                                   MODBUS_FC_READ_COILS,
+                                   MODBUS_FC_WRITE_MULTIPLE_COILS};
+    std::vector<int> counts{1, 16, 64, 125};
+    std::vector<int> slaveCounts{1, 4};
+    milliseconds     duration{500};
+    bool             emulateWireTime = true;
+    bool             json = false;
+    bool             loopback = false;
+};
+
+struct BenchResult {
+    const char*                    transport;
+    int                            baudRate;
+    int                            functionCode;
+    int                            count;
+    int                            slaveCount;
+    long long                      transactions;
+    long long                      errors;
+    double                         seconds;
+    double                         cpuMicrosecondsPerTransaction;
+    double                         wireLimitItemsPerSecond;
+    test_modbus_485::LatencySummary latency;
+};
+
+std::vector<int> parseList(const char* text) {
+    std::vector<int> values;
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        if (!item.empty()) {
+            values.push_back(std::atoi(item.c_str()));
+        }
+    }
+    return values;
+}
+
+bool parseArguments(int argc, char** argv, BenchOptions& options) {
+    for (int i = 1; i < argc; ++i) {
+        const char* argument = argv[i];
+        if (std::strncmp(argument, "--baud=", 7) == 0) {
+            options.baudRates = parseList(argument + 7);
+        } else if (std::strncmp(argument, "--fc=", 5) == 0) {
+            options.functionCodes = parseList(argument + 5);
+        } else if (std::strncmp(argument, "--count=", 8) == 0) {
+            options.counts = parseList(argument + 8);
+        } else if (std::strncmp(argument, "--slaves=", 9) == 0) {
+            options.slaveCounts = parseList(argument + 9);
+        } else if (std::strncmp(argument, "--duration-ms=", 14) == 0) {
+            options.duration = milliseconds(std::atoi(argument + 14));
+        } else if (std::strcmp(argument, "--no-wire-time") == 0) {
+            options.emulateWireTime = false;
+        } else if (std::strcmp(argument, "--format=json") == 0) {
+            options.json = true;
+        } else if (std::strcmp(argument, "--format=csv") == 0) {
+            options.json = false;
+        } else if (std::strcmp(argument, "--transport=loopback") == 0) {
+            options.loopback = true;
+        } else if (std::strcmp(argument, "--transport=pty") == 0) {
+            options.loopback = false;
+        } else {
+            std::cerr << "unknown argument: " << argument << "\n"
+                      << "usage: modbus_bench [--baud=LIST] [--fc=LIST] [--count=LIST] [--slaves=LIST]\n"
+                      << "                    [--duration-ms=N] [--no-wire-time] [--format=csv|json]\n"
+                      << "                    [--transport=pty|loopback]\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Items one PDU of a function code carries.
+ */
+int pduLimit(int functionCode) {
+    switch (functionCode) {
+        case MODBUS_FC_READ_COILS:                        return MODBUS_MAX_READ_BITS;
+        case MODBUS_FC_WRITE_MULTIPLE_COILS:              return MODBUS_MAX_WRITE_BITS;
+        case MODBUS_FC_READ_HOLDING_REGISTERS:            return MODBUS_MAX_READ_REGISTERS;
+        case MODBUS_FC_WRITE_MULTIPLE_REGISTERS:          return MODBUS_MAX_WRITE_REGISTERS;
+        case MODBUS_FC_WRITE_AND_READ_REGISTERS:          return MODBUS_MAX_WR_WRITE_REGISTERS;
+        case test_modbus_485::modbusFcReadFileRecord:     return test_modbus_485::modbusMaxReadFileRecords;
+        case test_modbus_485::modbusFcWriteFileRecord:    return test_modbus_485::modbusMaxWriteFileRecords;
+        default:                                          return 0;
+    }
+}
+
+/**
+ * @brief Largest count a case can use; FC23 is not split.
+ */
+int maximumCount(int functionCode) {
+    if (functionCode == MODBUS_FC_WRITE_AND_READ_REGISTERS) {
+        return pduLimit(functionCode);
+    }
+    return pduLimit(functionCode) ? simulatedTableSize : 0;
+}
+
+/**
+ * @brief Items per second if every PDU of the block took only its frames and one t3.5.
+ *
+ * The slave needs t3.5 of silence to see the request end; a master that
+ * frames replies by length, as libmodbus does, sends the next request right
+ * after the reply.
+ */
+double wireLimit(int baudRate, int functionCode, int count) {
+    const nanoseconds character = test_modbus_485::characterTime(baudRate, 10);
+    const nanoseconds gap = test_modbus_485::interFrameDelay(baudRate, 10);
+    nanoseconds block(0);
+    for (int offset = 0; offset < count; offset += pduLimit(functionCode)) {
+        const int items = std::min(pduLimit(functionCode), count - offset);
+        // FC23 moves its count both ways.
+        const int quantity = functionCode == MODBUS_FC_WRITE_AND_READ_REGISTERS ? 2 * items : items;
+        block += character * test_modbus_485::expectedFrameBytes(functionCode, quantity) + gap;
+    }
+    return block.count() > 0 ? count / duration<double>(block).count() : 0.0;
+}
+
+microseconds threadCpuTime() {
+    rusage usage;
+    getrusage(RUSAGE_THREAD, &usage);
+    return seconds(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec)
+           + microseconds(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec);
+}
+
+int transact(test_modbus_485::ModbusUtils& mb,
+             modbus_t*& ctx,
+             int functionCode,
+             int count,
+             uint16_t* registers,
+             uint8_t* bits) {
+    switch (functionCode) {
+        case MODBUS_FC_READ_HOLDING_REGISTERS:
+            return mb.readHoldingRegisters(ctx, 0, count, registers);
+        case MODBUS_FC_WRITE_MULTIPLE_REGISTERS:
+            return mb.writeMultipleRegisters(ctx, 0, registers, count);
+        case MODBUS_FC_WRITE_AND_READ_REGISTERS:
+            return mb.writeAndReadRegisters(ctx, 0, registers, count, 0, count, registers);
+        case MODBUS_FC_READ_COILS:
+            return mb.readCoils(ctx, 0, count, bits);
+        case MODBUS_FC_WRITE_MULTIPLE_COILS:
+            return mb.writeMultipleCoils(ctx, 0, bits, count);
+        case test_modbus_485::modbusFcReadFileRecord:
+            return mb.readFileRecord(ctx, 1, 0, count, registers);
+        case test_modbus_485::modbusFcWriteFileRecord:
+            return mb.writeFileRecord(ctx, 1, 0, registers, count);
+        default:
+            return -1;
+    }
+}
+
+bool runCase(int masterFileDescriptor,
+             const std::string& slaveDevicePath,
+             const BenchOptions& options,
+             int baudRate,
+             int functionCode,
+             int count,
+             int slaveCount,
+             BenchResult& result) {
+    test_modbus_485::ModbusUtils mb;
+    modbus_t* ctx = nullptr;
+    test_modbus_485::ModbusSlaveSimulator simulator;
+    std::vector<std::unique_ptr<test_modbus_485::ModbusDataModel>> models;
+    test_modbus_485::ModbusLoopbackOptions loopbackOptions;
+    loopbackOptions.baudRate = baudRate;
+    loopbackOptions.emulateWireTime = options.emulateWireTime;
+    test_modbus_485::ModbusLoopbackTransport loopback(loopbackOptions);
+
+    if (options.loopback) {
+        for (int slave = 1; slave <= slaveCount; ++slave) {
+            models.emplace_back(new test_modbus_485::ModbusDataModel());
+            if (!loopback.addSlave(slave, *models.back())) {
+                return false;
+            }
+        }
+        mb.attachTransport(&loopback);
+    } else {
+        for (int slave = 1; slave <= slaveCount; ++slave) {
+            if (!simulator.addSlave(slave)) {
+                return false;
+            }
+        }
+        test_modbus_485::ModbusSimulatorOptions simulatorOptions;
+        simulatorOptions.baudRate = baudRate;
+        simulatorOptions.emulateWireTime = options.emulateWireTime;
+        tcflush(masterFileDescriptor, TCIOFLUSH);
+        if (!simulator.start(masterFileDescriptor, simulatorOptions)) {
+            return false;
+        }
+        if (!mb.openRtu(ctx, slaveDevicePath, baudRate, 'N', 8, 1, 1)) {
+            return false;
+        }
+    }
+
+    std::vector<uint16_t> registers(simulatedTableSize, 0x1234);
+    std::vector<uint8_t> bits(simulatedTableSize, 1);
+    test_modbus_485::LatencyHistogram latency;
+    long long transactions = 0;
+    long long errors = 0;
+
+    // Warm-up: first contact, page faults, adaptive state.
+    for (int i = 0; i < 4; ++i) {
+        transact(mb, ctx, functionCode, count, registers.data(), bits.data());
+    }
+
+    const steady_clock::time_point started = steady_clock::now();
+    const steady_clock::time_point deadline = started + options.duration;
+    const microseconds cpuStarted = threadCpuTime();
+    steady_clock::time_point now = started;
+    while (now < deadline) {
+        if (slaveCount > 1) {
+            mb.setSlave(ctx, 1 + static_cast<int>(transactions % slaveCount));
+        }
+        int rc = transact(mb, ctx, functionCode, count, registers.data(), bits.data());
+        steady_clock::time_point finished = steady_clock::now();
+        latency.record(finished - now);
+        now = finished;
+        ++transactions;
+        if (rc == -1) {
+            ++errors;
+        }
+    }
+    const microseconds cpuUsed = threadCpuTime() - cpuStarted;
+
+    mb.attachTransport(nullptr);
+    mb.closeRtu(ctx);
+    simulator.stop();
+
+    result.transport = options.loopback ? "loopback" : "pty";
+    result.baudRate = baudRate;
+    result.functionCode = functionCode;
+    result.count = count;
+    result.slaveCount = slaveCount;
+    result.transactions = transactions;
+    result.errors = errors;
+    result.seconds = duration<double>(now - started).count();
+    result.cpuMicrosecondsPerTransaction = transactions ? double(cpuUsed.count()) / transactions : 0.0;
+    result.wireLimitItemsPerSecond = wireLimit(baudRate, functionCode, count);
+    result.latency = latency.snapshot().summary();
+    return true;
+}
+
+double itemsPerSecond(const BenchResult& r) {
+    return r.seconds > 0 ? double(r.transactions - r.errors) * r.count / r.seconds : 0.0;
+}
+
+double wireEfficiency(const BenchResult& r) {
+    return r.wireLimitItemsPerSecond > 0 ? itemsPerSecond(r) / r.wireLimitItemsPerSecond : 0.0;
+}
+
+void printCsvHeader() {
+    std::cout << "transport,baud,function_code,count,slaves,transactions,errors,seconds,transactions_per_second,"
+                 "p50_us,p90_us,p99_us,p999_us,max_us,cpu_us_per_transaction,"
+                 "items_per_second,wire_limit_items_per_second,wire_efficiency\n";
+}
+
+void printCsv(const BenchResult& r) {
+    std::cout << r.transport << ',' << r.baudRate << ',' << r.functionCode << ',' << r.count << ','
+              << r.slaveCount << ','
+              << r.transactions << ',' << r.errors << ',' << r.seconds << ','
+              << (r.seconds > 0 ? r.transactions / r.seconds : 0.0) << ','
+              << r.latency.p50 << ',' << r.latency.p90 << ',' << r.latency.p99 << ','
+              << r.latency.p999 << ',' << r.latency.max << ',' << r.cpuMicrosecondsPerTransaction << ','
+              << itemsPerSecond(r) << ',' << r.wireLimitItemsPerSecond << ',' << wireEfficiency(r) << "\n";
+}
+
+void printJson(const BenchResult& r, bool first) {
+    std::cout << (first ? "  " : ",\n  ")
+              << "{\"transport\": \"" << r.transport << "\""
+              << ", \"baud\": " << r.baudRate
+              << ", \"function_code\": " << r.functionCode
+              << ", \"count\": " << r.count
+              << ", \"slaves\": " << r.slaveCount
+              << ", \"transactions\": " << r.transactions
+              << ", \"errors\": " << r.errors
+              << ", \"seconds\": " << r.seconds
+              << ", \"transactions_per_second\": " << (r.seconds > 0 ? r.transactions / r.seconds : 0.0)
+              << ", \"latency_us\": {\"p50\": " << r.latency.p50
+              << ", \"p90\": " << r.latency.p90
+              << ", \"p99\": " << r.latency.p99
+              << ", \"p999\": " << r.latency.p999
+              << ", \"max\": " << r.latency.max << "}"
+              << ", \"cpu_us_per_transaction\": " << r.cpuMicrosecondsPerTransaction
+              << ", \"items_per_second\": " << itemsPerSecond(r)
+              << ", \"wire_limit_items_per_second\": " << r.wireLimitItemsPerSecond
+              << ", \"wire_efficiency\": " << wireEfficiency(r) << "}";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    BenchOptions options;
+    if (!parseArguments(argc, argv, options)) {
+        return 1;
+    }
+
+    int masterFileDescriptor = -1;
+    std::string slaveDevicePath;
+    if (!options.loopback && !test_modbus_485::openPtyPair(masterFileDescriptor, slaveDevicePath)) {
+        std::cerr << "ERROR: cannot open pty pair\n";
+        return 1;
+    }
+
+    if (options.json) {
+        std::cout << "[\n";
+    } else {
+        printCsvHeader();
+    }
+    bool first = true;
+    int failures = 0;
+    for (int baudRate : options.baudRates) {
+        for (int slaveCount : options.slaveCounts) {
+            for (int functionCode : options.functionCodes) {
+                for (int count : options.counts) {
+                    if (count < 1 || count > maximumCount(functionCode)) {
+                        continue;
+                    }
+                    BenchResult result{};
+                    if (!runCase(masterFileDescriptor, slaveDevicePath, options,
+                                 baudRate, functionCode, count, slaveCount, result)) {
+                        std::cerr << "[modbus_bench] case baud=" << baudRate << " fc=" << functionCode
+                                  << " count=" << count << " slaves=" << slaveCount << " failed to start\n";
+                        ++failures;
+                        continue;
+                    }
+                    if (options.json) {
+                        printJson(result, first);
+                    } else {
+                        printCsv(result);
+                    }
+                    first = false;
+                    std::cout.flush();
+                }
+            }
+        }
+    }
+    if (options.json) {
+        std::cout << "\n]\n";
+    }
+
+    if (masterFileDescriptor >= 0) {
+        close(masterFileDescriptor);
+    }
+    return failures ? 2 : 0;
+}
@@ -0,0 +1,335 @@
+// src/modbus_bus_owner.cpp
+
+#include "modbus_bus_owner.h"
+#include <cerrno>
+#include <iomanip>
+#include <utility>
+
+namespace {
+
+const char* priorityName(int index) {
+    return index == static_cast<int>(test_modbus_485::ModbusRequestPriority::Control) ? "control" : "telemetry";
+}
+
+} // namespace
+
+void test_modbus_485::ModbusBusOwnerStatistics::print(std::ostream& stream) const {
+    std::ios::fmtflags flags = stream.flags();
+    std::streamsize precision = stream.precision();
+
+    stream << "  " << std::left << std::setw(10) << "wait (us)" << std::right
+           << std::setw(10) << "count"
+           << std::setw(9) << "p50"
+           << std::setw(9) << "p90"
+           << std::setw(9) << "p99"
+           << std::setw(9) << "max"
+           << std::setw(8) << "failed"
+           << std::setw(7) << "depth"
+           << std::setw(7) << "peak" << "\n";
+    for (int i = 0; i < static_cast<int>(queues.size()); ++i) {
+        const ModbusBusQueueStatistics& queue = queues[i];
+        LatencySummary summary = queue.wait.summary();
+        stream << "  " << std::left << std::setw(10) << priorityName(i) << std::right
+               << std::setw(10) << queue.completed
+               << std::fixed << std::setprecision(0)
+               << std::setw(9) << summary.p50
+               << std::setw(9) << summary.p90
+               << std::setw(9) << summary.p99
+               << std::setw(9) << summary.max
+               << std::setw(8) << queue.failed
+               << std::setw(7) << queue.depth
+               << std::setw(7) << queue.maximumDepth << "\n";
+    }
+
+    stream.flags(flags);
+    stream.precision(precision);
+}
+
+test_modbus_485::ModbusBusOwner::RequestQueue::RequestQueue()
+    : back_(&stub_),
+      front_(&stub_) {}
+
+void test_modbus_485::ModbusBusOwner::RequestQueue::push(Request* request) {
+    request->next.store(nullptr, std::memory_order_relaxed);
+    Request* previous = back_.exchange(request, std::memory_order_acq_rel);
+    // Until this store the consumer sees the queue end at previous.
+    previous->next.store(request, std::memory_order_release);
+}
+
+test_modbus_485::ModbusBusOwner::Request* test_modbus_485::ModbusBusOwner::RequestQueue::pop() {
+    Request* front = front_;
+    Request* next = front->next.load(std::memory_order_acquire);
+    if (front == &stub_) {
+        if (!next) {
+            return nullptr;
+        }
+        front_ = next;
+        front = next;
+        next = next->next.load(std::memory_order_acquire);
+    }
+    if (next) {
+        front_ = next;
+        return front;
+    }
+    if (front != back_.load(std::memory_order_acquire)) {
+        return nullptr;
+    }
+    // front is the last request; put the stub behind it so it can be handed out.
+    push(&stub_);
+    next = front->next.load(std::memory_order_acquire);
+    if (next) {
+        front_ = next;
+        return front;
+    }
+    return nullptr;
+}
+
+test_modbus_485::ModbusBusOwner::ModbusBusOwner(ModbusUtils& modbus, modbus_t*& contextReference)
+    : modbus_(modbus),
+      context_(contextReference) {}
+
+test_modbus_485::ModbusBusOwner::~ModbusBusOwner() {
+    stop();
+}
+
+bool test_modbus_485::ModbusBusOwner::start() {
+    if (running_.exchange(true)) {
+        return false;
+    }
+    currentSlave_ = -1;
+    thread_ = std::thread(&ModbusBusOwner::run, this);
+    return true;
+}
+
+void test_modbus_485::ModbusBusOwner::stop() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex_);
+        wake_.notify_one();
+    }
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    // Submitters that saw the owner running finish their push before the last drain.
+    while (submitters_.load() > 0) {
+        std::this_thread::yield();
+    }
+    QueueCounters* counters = nullptr;
+    while (Request* request = dequeue(counters)) {
+        execute(request, *counters, true);
+    }
+}
+
+std::future<test_modbus_485::ModbusBusResult>
+test_modbus_485::ModbusBusOwner::submit(int slaveIdentifier, ModbusRequestPriority priority, Operation operation) {
+    Request* request = new Request();
+    request->slaveIdentifier = slaveIdentifier;
+    request->operation = std::move(operation);
+    request->hasPromise = true;
+    std::future<ModbusBusResult> future = request->promise.get_future();
+    enqueue(priority, request);
+    return future;
+}
+
+void test_modbus_485::ModbusBusOwner::submit(int slaveIdentifier,
+                                             ModbusRequestPriority priority,
+                                             Operation operation,
+                                             Completion completion) {
+    Request* request = new Request();
+    request->slaveIdentifier = slaveIdentifier;
+    request->operation = std::move(operation);
+    request->completion = std::move(completion);
+    enqueue(priority, request);
+}
+
+std::future<test_modbus_485::ModbusBusResult>
+test_modbus_485::ModbusBusOwner::readCoils(int slaveIdentifier,
+                                           int startAddress,
+                                           int count,
+                                           ModbusRequestPriority priority) {
+    return submit(slaveIdentifier, priority,
+                  [startAddress, count](ModbusUtils& modbus, modbus_t*& contextReference, ModbusBusResult& result) {
+                      return modbus.readCoils(contextReference, startAddress, count, result.bits);
+                  });
+}
+
+std::future<test_modbus_485::ModbusBusResult>
+test_modbus_485::ModbusBusOwner::readDiscreteInputs(int slaveIdentifier,
+                                                    int startAddress,
+                                                    int count,
+                                                    ModbusRequestPriority priority) {
+    return submit(slaveIdentifier, priority,
+                  [startAddress, count](ModbusUtils& modbus, modbus_t*& contextReference, ModbusBusResult& result) {
+                      return modbus.readDiscreteInputs(contextReference, startAddress, count, result.bits);
+                  });
+}
+
+std::future<test_modbus_485::ModbusBusResult>
+test_modbus_485::ModbusBusOwner::readHoldingRegisters(int slaveIdentifier,
+                                                      int startAddress,
+                                                      int count,
+                                                      ModbusRequestPriority priority) {
+    return submit(slaveIdentifier, priority,
+                  [startAddress, count](ModbusUtils& modbus, modbus_t*& contextReference, ModbusBusResult& result) {
+                      return modbus.readHoldingRegisters(contextReference, startAddress, count, result.registers);
+                  });
+}
+
+std::future<test_modbus_485::ModbusBusResult>
+test_modbus_485::ModbusBusOwner::readInputRegisters(int slaveIdentifier,
+                                                    int startAddress,
+                                                    int count,
+                                                    ModbusRequestPriority priority) {
+    return submit(slaveIdentifier, priority,
+                  [startAddress, count](ModbusUtils& modbus, modbus_t*& contextReference, ModbusBusResult& result) {
+                      return modbus.readInputRegisters(contextReference, startAddress, count, result.registers);
+                  });
+}
+
+std::future<test_modbus_485::ModbusBusResult>
+test_modbus_485::ModbusBusOwner::writeSingleCoil(int slaveIdentifier,
+                                                 int coilAddress,
+                                                 bool coilStatus,
+                                                 ModbusRequestPriority priority) {
+    return submit(slaveIdentifier, priority,
+                  [coilAddress, coilStatus](ModbusUtils& modbus, modbus_t*& contextReference, ModbusBusResult&) {
+                      return modbus.writeSingleCoil(contextReference, coilAddress, coilStatus) ? 1 : -1;
+                  });
+}
+
+std::future<test_modbus_485::ModbusBusResult>
+test_modbus_485::ModbusBusOwner::writeSingleRegister(int slaveIdentifier,
+                                                     int registerAddress,
+                                                     uint16_t registerValue,
+                                                     ModbusRequestPriority priority) {
+    return submit(slaveIdentifier, priority,
+                  [registerAddress, registerValue](ModbusUtils& modbus,
+                                                   modbus_t*& contextReference,
+                                                   ModbusBusResult&) {
+                      return modbus.writeSingleRegister(contextReference, registerAddress, registerValue) ? 1 : -1;
+                  });
+}
+
+std::future<test_modbus_485::ModbusBusResult>
+test_modbus_485::ModbusBusOwner::writeMultipleRegisters(int slaveIdentifier,
+                                                        int startAddress,
+                                                        std::vector<uint16_t> source,
+                                                        ModbusRequestPriority priority) {
+    return submit(slaveIdentifier, priority,
+                  [startAddress, source = std::move(source)](ModbusUtils& modbus,
+                                                             modbus_t*& contextReference,
+                                                             ModbusBusResult&) {
+                      return modbus.writeMultipleRegisters(contextReference, startAddress, source);
+                  });
+}
+
+test_modbus_485::ModbusBusOwnerStatistics test_modbus_485::ModbusBusOwner::statistics() const {
+    ModbusBusOwnerStatistics result;
+    for (size_t i = 0; i < queues_.size(); ++i) {
+        const QueueCounters& counters = queues_[i];
+        ModbusBusQueueStatistics& queue = result.queues[i];
+        queue.submitted = counters.submitted.load(std::memory_order_relaxed);
+        queue.completed = counters.completed.load(std::memory_order_relaxed);
+        queue.failed = counters.failed.load(std::memory_order_relaxed);
+        queue.depth = counters.depth.load(std::memory_order_relaxed);
+        queue.maximumDepth = counters.maximumDepth.load(std::memory_order_relaxed);
+        queue.wait = counters.wait.snapshot();
+    }
+    return result;
+}
+
+void test_modbus_485::ModbusBusOwner::resetStatistics() {
+    for (QueueCounters& counters : queues_) {
+        counters.submitted.store(0, std::memory_order_relaxed);
+        counters.completed.store(0, std::memory_order_relaxed);
+        counters.failed.store(0, std::memory_order_relaxed);
+        counters.maximumDepth.store(counters.depth.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        counters.wait.reset();
+    }
+}
+
+void test_modbus_485::ModbusBusOwner::enqueue(ModbusRequestPriority priority, Request* request) {
+    QueueCounters& counters = queues_[static_cast<size_t>(priority)];
+    request->submitted = Clock::now();
+    counters.submitted.fetch_add(1, std::memory_order_relaxed);
+
+    submitters_.fetch_add(1);
+    if (!running_.load()) {
+        submitters_.fetch_sub(1);
+        execute(request, counters, true);
+        return;
+    }
+    const uint64_t depth = counters.depth.fetch_add(1, std::memory_order_relaxed) + 1;
+    uint64_t deepest = counters.maximumDepth.load(std::memory_order_relaxed);
+    while (depth > deepest &&
+           !counters.maximumDepth.compare_exchange_weak(deepest, depth, std::memory_order_relaxed)) {
+    }
+    counters.queue.push(request);
+    queued_.fetch_add(1);
+    submitters_.fetch_sub(1);
+
+    // The owner publishes sleeping_ before re-checking queued_, so one side always sees the other.
+    if (sleeping_.load()) {
+        std::lock_guard<std::mutex> lock(wakeMutex_);
+        wake_.notify_one();
+    }
+}
+
+test_modbus_485::ModbusBusOwner::Request* test_modbus_485::ModbusBusOwner::dequeue(QueueCounters*& counters) {
+    for (QueueCounters& candidate : queues_) {
+        if (Request* request = candidate.queue.pop()) {
+            candidate.depth.fetch_sub(1, std::memory_order_relaxed);
+            queued_.fetch_sub(1);
+            counters = &candidate;
+            return request;
+        }
+    }
+    return nullptr;
+}
+
+void test_modbus_485::ModbusBusOwner::run() {
+    while (running_.load()) {
+        QueueCounters* counters = nullptr;
+        if (Request* request = dequeue(counters)) {
+            execute(request, *counters, false);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(wakeMutex_);
+        sleeping_.store(true);
+        // A push counted in queued_ may still be linking; the loop then spins for those few instructions.
+        wake_.wait(lock, [this] { return queued_.load() > 0 || !running_.load(); });
+        sleeping_.store(false);
+    }
+}
+
+void test_modbus_485::ModbusBusOwner::execute(Request* request, QueueCounters& counters, bool cancelled) {
+    ModbusBusResult result;
+    result.waited = Clock::now() - request->submitted;
+    if (cancelled) {
+        result.errorCode = ECANCELED;
+    } else {
+        counters.wait.record(result.waited);
+        if (request->slaveIdentifier != currentSlave_) {
+            if (modbus_.setSlave(context_, request->slaveIdentifier)) {
+                currentSlave_ = request->slaveIdentifier;
+            }
+        }
+        if (request->slaveIdentifier == currentSlave_) {
+            result.result = request->operation(modbus_, context_, result);
+        }
+        result.errorCode = result.result == -1 ? errno : 0;
+    }
+    counters.completed.fetch_add(1, std::memory_order_relaxed);
+    if (result.result == -1) {
+        counters.failed.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    if (request->hasPromise) {
+        request->promise.set_value(std::move(result));
+    } else if (request->completion) {
+        request->completion(result);
+    }
+    delete request;
+}
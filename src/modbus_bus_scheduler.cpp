@@ -0,0 +1,218 @@
+// src/modbus_bus_scheduler.cpp
+
+#include "modbus_bus_scheduler.h"
+#include <algorithm>
+#include <iostream>
+#include <thread>
+
+test_modbus_485::ModbusBusScheduler::ModbusBusScheduler()
+    : context_(nullptr),
+      currentSlave_(-1),
+      opened_(false),
+      initialBackoff_(std::chrono::milliseconds(100)),
+      maximumBackoff_(std::chrono::milliseconds(10000)),
+      statisticsStart_(Clock::now()) {}
+
+test_modbus_485::ModbusBusScheduler::~ModbusBusScheduler() {
+    close();
+}
+
+bool test_modbus_485::ModbusBusScheduler::open(const std::string& serialDevicePath,
+                                               int baudRate,
+                                               char parityMode,
+                                               int dataBits,
+                                               int stopBits) {
+    int firstSlave = groups_.empty() ? 1 : groups_.front().slaveIdentifier;
+    if (!modbusUtils_.openRtu(context_, serialDevicePath, baudRate, parityMode, dataBits, stopBits, firstSlave)) {
+        return false;
+    }
+    currentSlave_ = firstSlave;
+    opened_ = true;
+    return true;
+}
+
+void test_modbus_485::ModbusBusScheduler::close() {
+    modbusUtils_.closeRtu(context_);
+    currentSlave_ = -1;
+    opened_ = false;
+}
+
+void test_modbus_485::ModbusBusScheduler::attachTransport(ModbusTransport* transport) {
+    modbusUtils_.attachTransport(transport);
+    // The slave last set on the port is not the transport's.
+    currentSlave_ = -1;
+}
+
+int test_modbus_485::ModbusBusScheduler::addPollGroup(int slaveIdentifier,
+                                                      std::chrono::microseconds period,
+                                                      int priority,
+                                                      PollCallback callback) {
+    if (slaveIdentifier < 1 || slaveIdentifier > 247 || period.count() <= 0) {
+        std::cerr << "[addPollGroup] invalid slave " << slaveIdentifier
+                  << " or period " << period.count() << " us\n";
+        return -1;
+    }
+    PollGroup group;
+    group.slaveIdentifier = slaveIdentifier;
+    group.period = period;
+    group.priority = priority;
+    group.callback = std::move(callback);
+    group.reader.reset(new ModbusPointReader(modbusUtils_));
+    group.nextDue = Clock::now();
+    groups_.push_back(std::move(group));
+    slaves_[slaveIdentifier];
+    return static_cast<int>(groups_.size()) - 1;
+}
+
+int test_modbus_485::ModbusBusScheduler::addPoint(int groupHandle, ModbusTable table, int address) {
+    if (groupHandle < 0 || groupHandle >= static_cast<int>(groups_.size())) {
+        std::cerr << "[addPoint] invalid group " << groupHandle << "\n";
+        return -1;
+    }
+    return groups_[groupHandle].reader->addPoint(table, address);
+}
+
+test_modbus_485::ModbusPointReader& test_modbus_485::ModbusBusScheduler::group(int groupHandle) {
+    return *groups_.at(groupHandle).reader;
+}
+
+void test_modbus_485::ModbusBusScheduler::setBackoff(std::chrono::milliseconds initialBackoff,
+                                                     std::chrono::milliseconds maximumBackoff) {
+    initialBackoff_ = initialBackoff;
+    maximumBackoff_ = std::max(initialBackoff, maximumBackoff);
+}
+
+bool test_modbus_485::ModbusBusScheduler::pollOnce() {
+    const Clock::time_point now = Clock::now();
+    int chosen = -1;
+    for (int index = 0; index < static_cast<int>(groups_.size()); ++index) {
+        PollGroup& candidate = groups_[index];
+        if (candidate.nextDue > now) {
+            continue;
+        }
+        SlaveState& slave = slaves_[candidate.slaveIdentifier];
+        if (slave.backoffUntil > now) {
+            // Drop the due poll instead of queueing it behind the backoff.
+            ++slave.skippedForBackoff;
+            candidate.nextDue = std::max(candidate.nextDue + candidate.period, slave.backoffUntil);
+            continue;
+        }
+        if (chosen < 0 ||
+            candidate.priority > groups_[chosen].priority ||
+            (candidate.priority == groups_[chosen].priority && candidate.nextDue < groups_[chosen].nextDue)) {
+            chosen = index;
+        }
+    }
+    if (chosen < 0) {
+        return false;
+    }
+
+    PollGroup& group = groups_[chosen];
+    SlaveState& slave = slaves_[group.slaveIdentifier];
+    const Clock::time_point started = Clock::now();
+    bool success = false;
+    if (!context_ && opened_ && modbusUtils_.reconnectRtu(context_)) {
+        // The reopened context addresses the last slave set on it, not ours.
+        currentSlave_ = -1;
+    }
+    if ((context_ || modbusUtils_.transport()) &&
+        (currentSlave_ == group.slaveIdentifier || modbusUtils_.setSlave(context_, group.slaveIdentifier))) {
+        currentSlave_ = group.slaveIdentifier;
+        success = group.reader->read(context_);
+    } else {
+        // No usable context (a reopen failed): count it as a failed poll so
+        // the slave backs off and the group moves on instead of spinning.
+        currentSlave_ = -1;
+    }
+    const Clock::time_point finished = Clock::now();
+
+    slave.busTime += finished - started;
+    ++slave.polls;
+    if (success) {
+        ++slave.successes;
+        slave.consecutiveFailures = 0;
+        slave.backoffUntil = Clock::time_point{};
+    } else {
+        ++slave.failures;
+        ++slave.consecutiveFailures;
+        int doublings = std::min(slave.consecutiveFailures - 1, 16);
+        std::chrono::milliseconds backoff = std::min(initialBackoff_ * (1 << doublings), maximumBackoff_);
+        slave.backoffUntil = finished + backoff;
+    }
+
+    // A group that fell behind resumes from now rather than bursting to catch up.
+    group.nextDue = std::max(group.nextDue + group.period, finished);
+    if (group.callback) {
+        group.callback(chosen, success);
+    }
+    return true;
+}
+
+test_modbus_485::ModbusBusScheduler::Clock::time_point
+test_modbus_485::ModbusBusScheduler::nextDeadline() const {
+    Clock::time_point deadline = Clock::time_point::max();
+    for (const PollGroup& group : groups_) {
+        auto slave = slaves_.find(group.slaveIdentifier);
+        Clock::time_point due = group.nextDue;
+        if (slave != slaves_.end()) {
+            due = std::max(due, slave->second.backoffUntil);
+        }
+        deadline = std::min(deadline, due);
+    }
+    return deadline;
+}
+
+void test_modbus_485::ModbusBusScheduler::run(const std::atomic<bool>& running) {
+    constexpr std::chrono::milliseconds stopLatency(10);
+    while (running.load(std::memory_order_relaxed)) {
+        if (!pollOnce()) {
+            std::this_thread::sleep_until(std::min(nextDeadline(), Clock::now() + stopLatency));
+        }
+    }
+}
+
+std::vector<test_modbus_485::ModbusSlaveStatistics>
+test_modbus_485::ModbusBusScheduler::statistics() const {
+    const Clock::time_point now = Clock::now();
+    double elapsedSeconds = std::chrono::duration<double>(now - statisticsStart_).count();
+
+    std::vector<ModbusSlaveStatistics> result;
+    for (const auto& entry : slaves_) {
+        const SlaveState& slave = entry.second;
+        ModbusSlaveStatistics statistics{};
+        statistics.slaveIdentifier = entry.first;
+        for (const PollGroup& group : groups_) {
+            if (group.slaveIdentifier == entry.first) {
+                statistics.requestedRateHz += 1e6 / static_cast<double>(group.period.count());
+            }
+        }
+        statistics.achievedRateHz = elapsedSeconds > 0.0 ? slave.successes / elapsedSeconds : 0.0;
+        statistics.polls = slave.polls;
+        statistics.failures = slave.failures;
+        statistics.skippedForBackoff = slave.skippedForBackoff;
+        statistics.busTimeMs = std::chrono::duration<double, std::milli>(slave.busTime).count();
+        statistics.backingOff = slave.backoffUntil > now;
+        result.push_back(statistics);
+    }
+    return result;
+}
+
+void test_modbus_485::ModbusBusScheduler::resetStatistics() {
+    for (auto& entry : slaves_) {
+        SlaveState& slave = entry.second;
+        slave.polls = 0;
+        slave.successes = 0;
+        slave.failures = 0;
+        slave.skippedForBackoff = 0;
+        slave.busTime = std::chrono::nanoseconds(0);
+    }
+    statisticsStart_ = Clock::now();
+}
+
+test_modbus_485::ModbusUtils& test_modbus_485::ModbusBusScheduler::utils() {
+    return modbusUtils_;
+}
+
+modbus_t*& test_modbus_485::ModbusBusScheduler::context() {
+    return context_;
+}
@@ -0,0 +1,606 @@
+// src/modbus_capture.cpp
+
+#include "modbus_capture.h"
+#include "modbus_rtu_codec.h"
+#include "modbus_timing.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+namespace format = test_modbus_485::capture_format;
+
+size_t roundUp(size_t value, size_t multiple) {
+    return (value + multiple - 1) / multiple * multiple;
+}
+
+uint64_t clockNanoseconds(clockid_t clock) {
+    timespec now{};
+    clock_gettime(clock, &now);
+    return static_cast<uint64_t>(now.tv_sec) * 1000000000ull + static_cast<uint64_t>(now.tv_nsec);
+}
+
+void printRow(std::ostream& stream, const char* label, uint64_t requests, uint64_t responses, uint64_t exceptions,
+              const test_modbus_485::LatencyHistogramSnapshot& histogram) {
+    test_modbus_485::LatencySummary summary = histogram.summary();
+    stream << "  " << std::left << std::setw(8) << label << std::right
+           << std::setw(10) << requests
+           << std::setw(10) << responses
+           << std::setw(6) << exceptions
+           << std::fixed << std::setprecision(0)
+           << std::setw(9) << summary.p50
+           << std::setw(9) << summary.p90
+           << std::setw(9) << summary.p99
+           << std::setw(9) << summary.p999
+           << std::setw(9) << summary.max << "\n";
+}
+
+void printCsvRow(std::ostream& stream, const char* label, uint64_t requests, uint64_t responses,
+                 uint64_t exceptions, const test_modbus_485::LatencyHistogramSnapshot& histogram) {
+    test_modbus_485::LatencySummary summary = histogram.summary();
+    stream << label << ',' << requests << ',' << responses << ',' << exceptions << ','
+           << summary.count << ',' << summary.mean << ',' << summary.p50 << ',' << summary.p90 << ','
+           << summary.p99 << ',' << summary.p999 << ',' << summary.max << "\n";
+}
+
+} // namespace
+
+test_modbus_485::ModbusCaptureWriter::ModbusCaptureWriter()
+    : fileDescriptor_(-1),
+      header_(),
+      segment_(nullptr),
+      segmentHeader_(nullptr),
+      segmentsStarted_(0),
+      records_(0),
+      lastTimestamp_(0),
+      nextIndexOffset_(0) {}
+
+test_modbus_485::ModbusCaptureWriter::~ModbusCaptureWriter() {
+    close();
+}
+
+bool test_modbus_485::ModbusCaptureWriter::open(const std::string& path, const ModbusCaptureOptions& options) {
+    close();
+    fileDescriptor_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fileDescriptor_ == -1) {
+        perror("[ModbusCaptureWriter::open] open");
+        return false;
+    }
+
+    header_ = format::FileHeader();
+    std::memcpy(header_.magic, format::fileMagic, sizeof(header_.magic));
+    header_.version = format::fileVersion;
+    header_.headerBytes = format::pageBytes;
+    header_.segmentBytes = std::max(roundUp(options.segmentBytes, format::pageBytes), 2 * format::pageBytes);
+    header_.maximumSegments = options.maximumSegments;
+    header_.baudRate = options.baudRate;
+    header_.bitsPerCharacter = options.bitsPerCharacter;
+    // Spread the index entries over the record area so a segment never has more than fit in its header.
+    const size_t recordArea = header_.segmentBytes - format::pageBytes;
+    header_.indexInterval = static_cast<uint32_t>(roundUp((recordArea + format::indexCapacity - 1) /
+                                                          format::indexCapacity, 8));
+    header_.startRealtime = clockNanoseconds(CLOCK_REALTIME);
+    header_.startMonotonic = clockNanoseconds(CLOCK_MONOTONIC);
+
+    uint8_t page[format::pageBytes] = {};
+    std::memcpy(page, &header_, sizeof(header_));
+    if (pwrite(fileDescriptor_, page, sizeof(page), 0) != static_cast<ssize_t>(sizeof(page))) {
+        perror("[ModbusCaptureWriter::open] pwrite");
+        ::close(fileDescriptor_);
+        fileDescriptor_ = -1;
+        return false;
+    }
+    segmentsStarted_ = 0;
+    records_ = 0;
+    lastTimestamp_ = 0;
+    return true;
+}
+
+bool test_modbus_485::ModbusCaptureWriter::append(uint64_t timestamp,
+                                                  ModbusCaptureDirection direction,
+                                                  ModbusCaptureStatus status,
+                                                  const uint8_t* adu,
+                                                  int length) {
+    const size_t recordBytes = sizeof(format::RecordHeader) + roundUp(static_cast<size_t>(length), 8);
+    if (fileDescriptor_ == -1 || length < 0 || length > 65535 ||
+        recordBytes > header_.segmentBytes - format::pageBytes) {
+        return false;
+    }
+    // Keep time order, which seek() relies on, if the caller's clock estimate steps back.
+    timestamp = std::max(timestamp, lastTimestamp_);
+    if (!segment_ || segmentHeader_->usedBytes + recordBytes > header_.segmentBytes) {
+        if (!startSegment(timestamp)) {
+            return false;
+        }
+    }
+    format::SegmentHeader& segmentHeader = *segmentHeader_;
+
+    const uint32_t offset = segmentHeader.usedBytes;
+    format::RecordHeader recordHeader{timestamp, static_cast<uint16_t>(length),
+                                      static_cast<uint8_t>(direction), static_cast<uint8_t>(status), 0};
+    uint8_t* record = segment_ + offset;
+    std::memcpy(record, &recordHeader, sizeof(recordHeader));
+    std::memcpy(record + sizeof(recordHeader), adu, static_cast<size_t>(length));
+    std::memset(record + sizeof(recordHeader) + length, 0, recordBytes - sizeof(recordHeader) - length);
+
+    // Counters are updated after the record, so a killed recorder leaves a readable file.
+    if (offset >= nextIndexOffset_ && segmentHeader.indexCount < format::indexCapacity) {
+        segmentHeader.index[segmentHeader.indexCount] = format::IndexEntry{timestamp, offset, segmentHeader.recordCount};
+        ++segmentHeader.indexCount;
+        nextIndexOffset_ = static_cast<uint32_t>(format::pageBytes +
+                                                 ((offset - format::pageBytes) / header_.indexInterval + 1) *
+                                                     header_.indexInterval);
+    }
+    if (segmentHeader.recordCount == 0) {
+        segmentHeader.firstTimestamp = timestamp;
+    }
+    segmentHeader.lastTimestamp = timestamp;
+    ++segmentHeader.recordCount;
+    segmentHeader.usedBytes = static_cast<uint32_t>(offset + recordBytes);
+    ++records_;
+    lastTimestamp_ = timestamp;
+    return true;
+}
+
+bool test_modbus_485::ModbusCaptureWriter::startSegment(uint64_t timestamp) {
+    if (segment_) {
+        msync(segment_, segmentHeader_->usedBytes, MS_ASYNC);
+        munmap(segment_, header_.segmentBytes);
+        segment_ = nullptr;
+        segmentHeader_ = nullptr;
+    }
+
+    const uint64_t slot = header_.maximumSegments ? segmentsStarted_ % header_.maximumSegments : segmentsStarted_;
+    const off_t offset = static_cast<off_t>(header_.headerBytes + slot * header_.segmentBytes);
+    if (slot == segmentsStarted_) {
+        // Reserve the blocks up front so a full disk fails here, not as SIGBUS on a store.
+        const int error = posix_fallocate(fileDescriptor_, offset, static_cast<off_t>(header_.segmentBytes));
+        if (error != 0) {
+            std::cerr << "[ModbusCaptureWriter::startSegment] posix_fallocate: " << std::strerror(error) << "\n";
+            return false;
+        }
+    }
+    void* mapping = mmap(nullptr, header_.segmentBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fileDescriptor_, offset);
+    if (mapping == MAP_FAILED) {
+        perror("[ModbusCaptureWriter::startSegment] mmap");
+        return false;
+    }
+    madvise(mapping, header_.segmentBytes, MADV_SEQUENTIAL);
+    segment_ = static_cast<uint8_t*>(mapping);
+    segmentHeader_ = reinterpret_cast<format::SegmentHeader*>(segment_);
+
+    // A reused segment is marked unused while its counters are reset.
+    segmentHeader_->sequence = 0;
+    segmentHeader_->magic = format::segmentMagic;
+    segmentHeader_->indexCount = 0;
+    segmentHeader_->firstTimestamp = timestamp;
+    segmentHeader_->lastTimestamp = timestamp;
+    segmentHeader_->firstRecord = records_;
+    segmentHeader_->recordCount = 0;
+    segmentHeader_->usedBytes = format::pageBytes;
+    segmentHeader_->sequence = ++segmentsStarted_;
+    nextIndexOffset_ = format::pageBytes;
+    return true;
+}
+
+void test_modbus_485::ModbusCaptureWriter::close() {
+    if (segment_) {
+        msync(segment_, segmentHeader_->usedBytes, MS_ASYNC);
+        munmap(segment_, header_.segmentBytes);
+        segment_ = nullptr;
+        segmentHeader_ = nullptr;
+    }
+    if (fileDescriptor_ != -1) {
+        ::close(fileDescriptor_);
+        fileDescriptor_ = -1;
+    }
+}
+
+uint64_t test_modbus_485::ModbusCaptureWriter::recordCount() const {
+    return records_;
+}
+
+uint64_t test_modbus_485::ModbusCaptureWriter::now() {
+    return clockNanoseconds(CLOCK_MONOTONIC);
+}
+
+test_modbus_485::ModbusCaptureReader::ModbusCaptureReader()
+    : fileDescriptor_(-1),
+      data_(nullptr),
+      size_(0),
+      segmentPosition_(0),
+      recordOffset_(format::pageBytes) {}
+
+test_modbus_485::ModbusCaptureReader::~ModbusCaptureReader() {
+    close();
+}
+
+bool test_modbus_485::ModbusCaptureReader::open(const std::string& path) {
+    close();
+    fileDescriptor_ = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fileDescriptor_ == -1) {
+        perror("[ModbusCaptureReader::open] open");
+        return false;
+    }
+    struct stat status{};
+    if (fstat(fileDescriptor_, &status) == -1 || static_cast<size_t>(status.st_size) < format::pageBytes) {
+        std::cerr << "[ModbusCaptureReader::open] " << path << " is too short for a capture file\n";
+        close();
+        return false;
+    }
+    size_ = static_cast<size_t>(status.st_size);
+    void* mapping = mmap(nullptr, size_, PROT_READ, MAP_SHARED, fileDescriptor_, 0);
+    if (mapping == MAP_FAILED) {
+        perror("[ModbusCaptureReader::open] mmap");
+        size_ = 0;
+        close();
+        return false;
+    }
+    data_ = static_cast<const uint8_t*>(mapping);
+
+    const format::FileHeader& fileHeader = header();
+    if (std::memcmp(fileHeader.magic, format::fileMagic, sizeof(fileHeader.magic)) != 0 ||
+        fileHeader.version != format::fileVersion || fileHeader.segmentBytes < 2 * format::pageBytes ||
+        fileHeader.segmentBytes % format::pageBytes != 0 || fileHeader.headerBytes < format::pageBytes) {
+        std::cerr << "[ModbusCaptureReader::open] " << path << " is not a capture file\n";
+        close();
+        return false;
+    }
+
+    for (size_t offset = fileHeader.headerBytes; offset + fileHeader.segmentBytes <= size_;
+         offset += fileHeader.segmentBytes) {
+        const auto* segmentHeader = reinterpret_cast<const format::SegmentHeader*>(data_ + offset);
+        if (segmentHeader->magic == format::segmentMagic && segmentHeader->sequence != 0 &&
+            segmentHeader->recordCount > 0 && segmentHeader->usedBytes <= fileHeader.segmentBytes) {
+            segments_.push_back(offset);
+        }
+    }
+    std::sort(segments_.begin(), segments_.end(), [this](size_t left, size_t right) {
+        return reinterpret_cast<const format::SegmentHeader*>(data_ + left)->sequence <
+               reinterpret_cast<const format::SegmentHeader*>(data_ + right)->sequence;
+    });
+    rewind();
+    return true;
+}
+
+void test_modbus_485::ModbusCaptureReader::close() {
+    if (data_) {
+        munmap(const_cast<uint8_t*>(data_), size_);
+        data_ = nullptr;
+        size_ = 0;
+    }
+    if (fileDescriptor_ != -1) {
+        ::close(fileDescriptor_);
+        fileDescriptor_ = -1;
+    }
+    segments_.clear();
+    rewind();
+}
+
+const test_modbus_485::capture_format::FileHeader& test_modbus_485::ModbusCaptureReader::header() const {
+    return *reinterpret_cast<const format::FileHeader*>(data_);
+}
+
+uint64_t test_modbus_485::ModbusCaptureReader::recordCount() const {
+    uint64_t count = 0;
+    for (size_t position = 0; position < segments_.size(); ++position) {
+        count += segment(position)->recordCount;
+    }
+    return count;
+}
+
+uint64_t test_modbus_485::ModbusCaptureReader::firstTimestamp() const {
+    return segments_.empty() ? 0 : segment(0)->firstTimestamp;
+}
+
+uint64_t test_modbus_485::ModbusCaptureReader::lastTimestamp() const {
+    return segments_.empty() ? 0 : segment(segments_.size() - 1)->lastTimestamp;
+}
+
+void test_modbus_485::ModbusCaptureReader::seek(uint64_t timestamp) {
+    // First segment that ends at or after the time, then the index entry just before it.
+    size_t low = 0;
+    size_t high = segments_.size();
+    while (low < high) {
+        const size_t middle = low + (high - low) / 2;
+        if (segment(middle)->lastTimestamp < timestamp) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    segmentPosition_ = low;
+    recordOffset_ = format::pageBytes;
+    if (segmentPosition_ == segments_.size()) {
+        return;
+    }
+
+    const format::SegmentHeader* segmentHeader = segment(segmentPosition_);
+    const format::IndexEntry* begin = segmentHeader->index;
+    const format::IndexEntry* end = begin + std::min<size_t>(segmentHeader->indexCount, format::indexCapacity);
+    const format::IndexEntry* entry = std::lower_bound(begin, end, timestamp,
+                                                       [](const format::IndexEntry& candidate, uint64_t value) {
+                                                           return candidate.timestamp < value;
+                                                       });
+    if (entry != begin) {
+        recordOffset_ = std::prev(entry)->offset;
+    }
+
+    const uint8_t* base = data_ + segments_[segmentPosition_];
+    while (recordOffset_ < segmentHeader->usedBytes) {
+        format::RecordHeader recordHeader;
+        std::memcpy(&recordHeader, base + recordOffset_, sizeof(recordHeader));
+        if (recordHeader.timestamp >= timestamp) {
+            return;
+        }
+        recordOffset_ += static_cast<uint32_t>(sizeof(recordHeader) + roundUp(recordHeader.length, 8));
+    }
+}
+
+void test_modbus_485::ModbusCaptureReader::rewind() {
+    segmentPosition_ = 0;
+    recordOffset_ = format::pageBytes;
+}
+
+bool test_modbus_485::ModbusCaptureReader::next(ModbusCaptureRecord& record) {
+    while (segmentPosition_ < segments_.size()) {
+        const format::SegmentHeader* segmentHeader = segment(segmentPosition_);
+        if (recordOffset_ + sizeof(format::RecordHeader) <= segmentHeader->usedBytes) {
+            const uint8_t* base = data_ + segments_[segmentPosition_] + recordOffset_;
+            format::RecordHeader recordHeader;
+            std::memcpy(&recordHeader, base, sizeof(recordHeader));
+            if (recordOffset_ + sizeof(recordHeader) + recordHeader.length > segmentHeader->usedBytes) {
+                // Corrupt length; skip the rest of the segment.
+                ++segmentPosition_;
+                recordOffset_ = format::pageBytes;
+                continue;
+            }
+            record.timestamp = recordHeader.timestamp;
+            record.direction = static_cast<ModbusCaptureDirection>(recordHeader.direction);
+            record.status = static_cast<ModbusCaptureStatus>(recordHeader.status);
+            record.adu = base + sizeof(recordHeader);
+            record.length = recordHeader.length;
+            recordOffset_ += static_cast<uint32_t>(sizeof(recordHeader) + roundUp(recordHeader.length, 8));
+            return true;
+        }
+        ++segmentPosition_;
+        recordOffset_ = format::pageBytes;
+    }
+    return false;
+}
+
+const test_modbus_485::capture_format::SegmentHeader*
+test_modbus_485::ModbusCaptureReader::segment(size_t position) const {
+    return reinterpret_cast<const format::SegmentHeader*>(data_ + segments_[position]);
+}
+
+test_modbus_485::ModbusCaptureRecorder::ModbusCaptureRecorder(ModbusCaptureWriter& writer,
+                                                              int baudRate,
+                                                              int bitsPerCharacter)
+    : writer_(writer),
+      splitter_([this](const uint8_t* frame, int length) { onFrame(frame, length); },
+                [this](const uint8_t* bytes, int length) { onGarbage(bytes, length); }),
+      characterNanoseconds_(baudRate > 0
+                                ? static_cast<uint64_t>(characterTime(baudRate, bitsPerCharacter).count())
+                                : 0) {}
+
+void test_modbus_485::ModbusCaptureRecorder::push(const uint8_t* data, size_t length, uint64_t receivedAt) {
+    if (length == 0) {
+        return;
+    }
+    pushed_ += length;
+    chunks_.push_back(Chunk{pushed_, receivedAt});
+    splitter_.push(data, length);
+}
+
+void test_modbus_485::ModbusCaptureRecorder::gap() {
+    splitter_.gap();
+}
+
+uint64_t test_modbus_485::ModbusCaptureRecorder::frameCount() const {
+    return frames_;
+}
+
+uint64_t test_modbus_485::ModbusCaptureRecorder::garbageBytes() const {
+    return garbage_;
+}
+
+uint64_t test_modbus_485::ModbusCaptureRecorder::droppedRecords() const {
+    return dropped_;
+}
+
+void test_modbus_485::ModbusCaptureRecorder::onFrame(const uint8_t* frame, int length) {
+    const uint64_t timestamp = timestampOf(length);
+    ++frames_;
+    const uint8_t slave = frame[0];
+    const uint8_t functionCode = frame[1];
+    const bool answersPending = pending_ && slave == pendingSlave_ && (functionCode & 0x7F) == pendingFunction_;
+    const int requestLength = rtuRequestLength(frame, length);
+    const int responseLength = rtuResponseLength(frame, length);
+
+    if (functionCode & 0x80) {
+        pending_ = pending_ && !answersPending;
+        record(timestamp, ModbusCaptureDirection::Response,
+               answersPending ? ModbusCaptureStatus::Exception : ModbusCaptureStatus::Unmatched, frame, length);
+    } else if (answersPending && (responseLength == length || responseLength < 0)) {
+        pending_ = false;
+        record(timestamp, ModbusCaptureDirection::Response, ModbusCaptureStatus::Ok, frame, length);
+    } else if (requestLength == length || requestLength < 0) {
+        // Broadcasts get no response.
+        pending_ = slave != 0;
+        pendingSlave_ = slave;
+        pendingFunction_ = functionCode;
+        record(timestamp, ModbusCaptureDirection::Request, ModbusCaptureStatus::Ok, frame, length);
+    } else {
+        record(timestamp, ModbusCaptureDirection::Response, ModbusCaptureStatus::Unmatched, frame, length);
+    }
+}
+
+void test_modbus_485::ModbusCaptureRecorder::onGarbage(const uint8_t* bytes, int length) {
+    const uint64_t timestamp = timestampOf(length);
+    garbage_ += static_cast<uint64_t>(length);
+    record(timestamp, ModbusCaptureDirection::Unknown, ModbusCaptureStatus::Garbage, bytes, length);
+}
+
+uint64_t test_modbus_485::ModbusCaptureRecorder::timestampOf(int length) {
+    // The read that delivered the last byte of the frame returned one character
+    // time after each byte from the frame start to the end of that read.
+    const uint64_t last = consumed_ + static_cast<uint64_t>(length) - 1;
+    while (chunks_.size() > 1 && chunks_.front().end <= last) {
+        chunks_.pop_front();
+    }
+    const Chunk& chunk = chunks_.front();
+    const uint64_t elapsed = (chunk.end - consumed_) * characterNanoseconds_;
+    consumed_ += static_cast<uint64_t>(length);
+    return chunk.receivedAt > elapsed ? chunk.receivedAt - elapsed : 0;
+}
+
+void test_modbus_485::ModbusCaptureRecorder::record(uint64_t timestamp,
+                                                    ModbusCaptureDirection direction,
+                                                    ModbusCaptureStatus status,
+                                                    const uint8_t* adu,
+                                                    int length) {
+    if (!writer_.append(timestamp, direction, status, adu, length)) {
+        ++dropped_;
+    }
+}
+
+void test_modbus_485::ModbusCaptureStatistics::print(std::ostream& stream) const {
+    std::ios::fmtflags flags = stream.flags();
+    std::streamsize precision = stream.precision();
+
+    stream << std::fixed << std::setprecision(3)
+           << "  span " << static_cast<double>(lastTimestamp - firstTimestamp) / 1e9 << " s, "
+           << records << " records, " << wireBytes << " bytes, bus utilisation "
+           << std::setprecision(1) << busUtilisation * 100.0 << " %\n"
+           << "  requests " << requests << ", responses " << responses << ", exceptions " << exceptions
+           << ", unmatched " << unmatched << ", unanswered " << unanswered
+           << ", garbage " << garbageBytes << " bytes\n";
+    stream << "  " << std::left << std::setw(8) << "(us)" << std::right
+           << std::setw(10) << "requests"
+           << std::setw(10) << "responses"
+           << std::setw(6) << "exc"
+           << std::setw(9) << "p50"
+           << std::setw(9) << "p90"
+           << std::setw(9) << "p99"
+           << std::setw(9) << "p99.9"
+           << std::setw(9) << "max" << "\n";
+    for (const ModbusCaptureFunctionStatistics& function : functions) {
+        char label[16];
+        std::snprintf(label, sizeof(label), "FC%02X", function.functionCode);
+        printRow(stream, label, function.requests, function.responses, function.exceptions, function.responseTime);
+    }
+    printRow(stream, "total", requests, responses, exceptions, responseTime);
+
+    stream.flags(flags);
+    stream.precision(precision);
+}
+
+void test_modbus_485::ModbusCaptureStatistics::printCsv(std::ostream& stream) const {
+    stream << "function,requests,responses,exceptions,timed,mean_us,p50_us,p90_us,p99_us,p999_us,max_us\n";
+    for (const ModbusCaptureFunctionStatistics& function : functions) {
+        char label[16];
+        std::snprintf(label, sizeof(label), "%d", function.functionCode);
+        printCsvRow(stream, label, function.requests, function.responses, function.exceptions, function.responseTime);
+    }
+    printCsvRow(stream, "total", requests, responses, exceptions, responseTime);
+}
+
+test_modbus_485::ModbusCaptureStatistics test_modbus_485::collectCaptureStatistics(ModbusCaptureReader& reader,
+                                                                                  uint64_t from,
+                                                                                  uint64_t to) {
+    struct FunctionCounters {
+        uint64_t         requests = 0;
+        uint64_t         responses = 0;
+        uint64_t         exceptions = 0;
+        LatencyHistogram responseTime;
+    };
+    std::map<int, FunctionCounters> functions;
+    LatencyHistogram responseTime;
+    ModbusCaptureStatistics statistics;
+
+    bool pending = false;
+    uint8_t pendingSlave = 0;
+    uint8_t pendingFunction = 0;
+    uint64_t pendingTimestamp = 0;
+    uint64_t lastLength = 0;
+
+    reader.seek(from);
+    ModbusCaptureRecord record;
+    while (reader.next(record) && record.timestamp < to) {
+        if (statistics.records == 0) {
+            statistics.firstTimestamp = record.timestamp;
+        }
+        statistics.lastTimestamp = record.timestamp;
+        lastLength = static_cast<uint64_t>(record.length);
+        ++statistics.records;
+        statistics.wireBytes += static_cast<uint64_t>(record.length);
+        if (record.status == ModbusCaptureStatus::Garbage || record.length < 2) {
+            statistics.garbageBytes += static_cast<uint64_t>(record.length);
+            continue;
+        }
+
+        const uint8_t slave = record.adu[0];
+        const uint8_t functionCode = record.adu[1] & 0x7F;
+        FunctionCounters& counters = functions[functionCode];
+        if (record.direction == ModbusCaptureDirection::Request) {
+            ++statistics.requests;
+            ++counters.requests;
+            statistics.unanswered += pending ? 1 : 0;
+            pending = slave != 0;
+            pendingSlave = slave;
+            pendingFunction = functionCode;
+            pendingTimestamp = record.timestamp;
+            continue;
+        }
+
+        ++statistics.responses;
+        ++counters.responses;
+        if (record.status == ModbusCaptureStatus::Exception) {
+            ++statistics.exceptions;
+            ++counters.exceptions;
+        }
+        if (record.status == ModbusCaptureStatus::Unmatched) {
+            ++statistics.unmatched;
+        } else if (pending && slave == pendingSlave && functionCode == pendingFunction) {
+            const std::chrono::nanoseconds latency(record.timestamp - pendingTimestamp);
+            responseTime.record(latency);
+            counters.responseTime.record(latency);
+            pending = false;
+        }
+    }
+
+    const uint32_t baudRate = reader.recordCount() ? reader.header().baudRate : 0;
+    if (baudRate > 0 && statistics.records > 0) {
+        const double characterNanoseconds =
+            static_cast<double>(characterTime(static_cast<int>(baudRate),
+                                              static_cast<int>(reader.header().bitsPerCharacter)).count());
+        // The range ends when the last frame has gone out.
+        const double span = static_cast<double>(statistics.lastTimestamp - statistics.firstTimestamp) +
+                            static_cast<double>(lastLength) * characterNanoseconds;
+        statistics.busUtilisation =
+            std::min(1.0, static_cast<double>(statistics.wireBytes) * characterNanoseconds / span);
+    }
+    statistics.responseTime = responseTime.snapshot();
+    for (const auto& entry : functions) {
+        ModbusCaptureFunctionStatistics function;
+        function.functionCode = entry.first;
+        function.requests = entry.second.requests;
+        function.responses = entry.second.responses;
+        function.exceptions = entry.second.exceptions;
+        function.responseTime = entry.second.responseTime.snapshot();
+        statistics.functions.push_back(function);
+    }
+    return statistics;
+}
@@ -0,0 +1,139 @@
+// src/modbus_capture_tool.cpp
+//
+// Reader of capture files written by modbus_sniffer. Times are seconds from
+// the start of the capture; --from/--to seek through the file's time index
+// instead of scanning it, so a window of a multi-day capture opens at once.
+//
+// usage: modbus_capture info  <capture-file>
+//        modbus_capture stats <capture-file> [--from=s] [--to=s] [--csv]
+//        modbus_capture dump  <capture-file> [--from=s] [--to=s] [--limit=N]
+
+#include "modbus_capture.h"
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <limits>
+#include <string>
+
+namespace {
+
+const char* directionName(test_modbus_485::ModbusCaptureDirection direction) {
+    switch (direction) {
+    case test_modbus_485::ModbusCaptureDirection::Request:
+        return "req";
+    case test_modbus_485::ModbusCaptureDirection::Response:
+        return "rsp";
+    default:
+        return "???";
+    }
+}
+
+const char* statusName(test_modbus_485::ModbusCaptureStatus status) {
+    switch (status) {
+    case test_modbus_485::ModbusCaptureStatus::Ok:
+        return "ok";
+    case test_modbus_485::ModbusCaptureStatus::Exception:
+        return "exception";
+    case test_modbus_485::ModbusCaptureStatus::Unmatched:
+        return "unmatched";
+    default:
+        return "garbage";
+    }
+}
+
+/**
+ * @brief Seconds from the start of the capture to a capture timestamp.
+ */
+uint64_t toTimestamp(const test_modbus_485::ModbusCaptureReader& reader, double seconds) {
+    const int64_t offset = static_cast<int64_t>(seconds * 1e9);
+    const uint64_t start = reader.header().startMonotonic;
+    return offset < 0 && static_cast<uint64_t>(-offset) > start ? 0 : start + static_cast<uint64_t>(offset);
+}
+
+double toSeconds(const test_modbus_485::ModbusCaptureReader& reader, uint64_t timestamp) {
+    return static_cast<double>(static_cast<int64_t>(timestamp - reader.header().startMonotonic)) / 1e9;
+}
+
+void printInfo(const test_modbus_485::ModbusCaptureReader& reader) {
+    const test_modbus_485::capture_format::FileHeader& header = reader.header();
+    const time_t started = static_cast<time_t>(header.startRealtime / 1000000000);
+    char startedText[64];
+    std::strftime(startedText, sizeof(startedText), "%Y-%m-%d %H:%M:%S", std::localtime(&started));
+    std::cout << "started      " << startedText << "\n"
+              << "line         " << header.baudRate << " baud, " << header.bitsPerCharacter << " bits/char\n"
+              << "segments     " << (header.segmentBytes >> 10) << " KiB"
+              << (header.maximumSegments ? ", ring of " + std::to_string(header.maximumSegments) : ", unbounded")
+              << "\n"
+              << "records      " << reader.recordCount() << "\n";
+    if (reader.recordCount()) {
+        std::printf("time         %.6f .. %.6f s\n", toSeconds(reader, reader.firstTimestamp()),
+                    toSeconds(reader, reader.lastTimestamp()));
+    }
+}
+
+void dump(test_modbus_485::ModbusCaptureReader& reader, uint64_t from, uint64_t to, uint64_t limit) {
+    reader.seek(from);
+    test_modbus_485::ModbusCaptureRecord record;
+    for (uint64_t printed = 0; printed < limit && reader.next(record) && record.timestamp < to; ++printed) {
+        std::printf("%14.6f %s %-9s %3d", toSeconds(reader, record.timestamp), directionName(record.direction),
+                    statusName(record.status), record.length);
+        for (int i = 0; i < record.length; ++i) {
+            std::printf(" %02X", record.adu[i]);
+        }
+        std::printf("\n");
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        std::cerr << "usage: modbus_capture info|stats|dump <capture-file> [--from=s] [--to=s] [--limit=N] [--csv]\n";
+        return 1;
+    }
+    const std::string command = argv[1];
+    test_modbus_485::ModbusCaptureReader reader;
+    if (!reader.open(argv[2])) {
+        return 1;
+    }
+
+    uint64_t from = 0;
+    uint64_t to = std::numeric_limits<uint64_t>::max();
+    uint64_t limit = std::numeric_limits<uint64_t>::max();
+    bool csv = false;
+    for (int i = 3; i < argc; ++i) {
+        if (std::strncmp(argv[i], "--from=", 7) == 0) {
+            from = toTimestamp(reader, std::atof(argv[i] + 7));
+        } else if (std::strncmp(argv[i], "--to=", 5) == 0) {
+            to = toTimestamp(reader, std::atof(argv[i] + 5));
+        } else if (std::strncmp(argv[i], "--limit=", 8) == 0) {
+            limit = std::strtoull(argv[i] + 8, nullptr, 10);
+        } else if (std::strcmp(argv[i], "--csv") == 0) {
+            csv = true;
+        } else {
+            std::cerr << "unknown argument: " << argv[i] << "\n";
+            return 1;
+        }
+    }
+
+    if (command == "info") {
+        printInfo(reader);
+    } else if (command == "stats") {
+        const test_modbus_485::ModbusCaptureStatistics statistics =
+            test_modbus_485::collectCaptureStatistics(reader, from, to);
+        if (csv) {
+            statistics.printCsv(std::cout);
+        } else {
+            statistics.print(std::cout);
+        }
+    } else if (command == "dump") {
+        dump(reader, from, to, limit);
+    } else {
+        std::cerr << "unknown command: " << command << "\n";
+        return 1;
+    }
+    return 0;
+}
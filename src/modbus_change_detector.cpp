@@ -0,0 +1,218 @@
+// src/modbus_change_detector.cpp
+
+#include "modbus_change_detector.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace {
+
+constexpr int addressCount = 65536;
+
+// Values compared per step before looking at single values.
+constexpr int compareWidth = 32;
+
+bool isBitTable(test_modbus_485::ModbusTable table) {
+    return table == test_modbus_485::ModbusTable::Coils || table == test_modbus_485::ModbusTable::DiscreteInputs;
+}
+
+bool byAddress(const test_modbus_485::ModbusChange& change, int address) {
+    return change.address < address;
+}
+
+} // namespace
+
+void test_modbus_485::ModbusChangeDetectorStatistics::print(std::ostream& stream) const {
+    stream << "  blocks " << updates << ", values compared " << valuesCompared << ", changed " << valuesChanged
+           << ", within deadband " << suppressed << "\n"
+           << "  changes reported " << reported << " in " << callbacks << " subscriber calls\n";
+}
+
+void test_modbus_485::ModbusChangeDetector::addPoint(int slaveIdentifier,
+                                                     ModbusTable table,
+                                                     const ModbusPoint& point,
+                                                     double deadband) {
+    if (isBitTable(table) || point.address < 0 || point.end() > addressCount) {
+        std::cerr << "[addPoint] points apply to register tables within 0..65535\n";
+        return;
+    }
+    TableState& image = tables_[{slaveIdentifier, static_cast<int>(table)}];
+    image.points[point.address] = PointState{point, deadband, 0.0, false};
+}
+
+int test_modbus_485::ModbusChangeDetector::subscribe(int slaveIdentifier,
+                                                     ModbusTable table,
+                                                     int startAddress,
+                                                     int count,
+                                                     Subscriber subscriber) {
+    const int identifier = nextSubscription_++;
+    subscriptions_.push_back(
+        Subscription{identifier, slaveIdentifier, table, startAddress, startAddress + count, std::move(subscriber)});
+    return identifier;
+}
+
+void test_modbus_485::ModbusChangeDetector::unsubscribe(int subscription) {
+    subscriptions_.erase(std::remove_if(subscriptions_.begin(), subscriptions_.end(),
+                                        [subscription](const Subscription& entry) {
+                                            return entry.identifier == subscription;
+                                        }),
+                         subscriptions_.end());
+}
+
+size_t test_modbus_485::ModbusChangeDetector::updateRegisters(int slaveIdentifier,
+                                                              ModbusTable table,
+                                                              int startAddress,
+                                                              int count,
+                                                              const uint16_t* values,
+                                                              std::chrono::steady_clock::time_point polledAt) {
+    if (isBitTable(table)) {
+        return 0;
+    }
+    return update(slaveIdentifier, table, startAddress, count, values, polledAt);
+}
+
+size_t test_modbus_485::ModbusChangeDetector::updateBits(int slaveIdentifier,
+                                                         ModbusTable table,
+                                                         int startAddress,
+                                                         int count,
+                                                         const uint8_t* values,
+                                                         std::chrono::steady_clock::time_point polledAt) {
+    if (!isBitTable(table)) {
+        return 0;
+    }
+    return update(slaveIdentifier, table, startAddress, count, values, polledAt);
+}
+
+void test_modbus_485::ModbusChangeDetector::forget(int slaveIdentifier) {
+    for (auto& entry : tables_) {
+        if (slaveIdentifier != 0 && entry.first.first != slaveIdentifier) {
+            continue;
+        }
+        TableState& image = entry.second;
+        std::fill(image.known.begin(), image.known.end(), 0);
+        for (auto& point : image.points) {
+            point.second.hasReported = false;
+        }
+    }
+}
+
+test_modbus_485::ModbusChangeDetectorStatistics test_modbus_485::ModbusChangeDetector::statistics() const {
+    return counters_;
+}
+
+template<typename Value>
+size_t test_modbus_485::ModbusChangeDetector::update(int slaveIdentifier,
+                                                     ModbusTable table,
+                                                     int startAddress,
+                                                     int count,
+                                                     const Value* values,
+                                                     std::chrono::steady_clock::time_point polledAt) {
+    if (count <= 0 || startAddress < 0 || startAddress + count > addressCount) {
+        return 0;
+    }
+    TableState& image = tables_[{slaveIdentifier, static_cast<int>(table)}];
+    const size_t end = static_cast<size_t>(startAddress + count);
+    if (image.values.size() < end) {
+        image.values.resize(end, 0);
+        image.known.resize(end, 0);
+    }
+    ++counters_.updates;
+    counters_.valuesCompared += static_cast<uint64_t>(count);
+
+    // Pass 1: find what differs from the known image. Most polls change
+    // nothing, so whole steps of compareWidth values are tested at once.
+    changed_.clear();
+    const uint16_t* known = image.values.data() + startAddress;
+    const uint8_t* seen = image.known.data() + startAddress;
+    for (int i = 0; i < count;) {
+        if (i + compareWidth <= count) {
+            unsigned difference = 0;
+            for (int k = 0; k < compareWidth; ++k) {
+                difference |= static_cast<unsigned>(known[i + k] ^ values[i + k]) | (seen[i + k] ^ 1u);
+            }
+            if (difference == 0) {
+                i += compareWidth;
+                continue;
+            }
+        }
+        const int stop = std::min(count, i + compareWidth);
+        for (; i < stop; ++i) {
+            if (!seen[i] || known[i] != values[i]) {
+                changed_.push_back(ChangedValue{startAddress + i, known[i], !seen[i]});
+            }
+        }
+    }
+    if (changed_.empty()) {
+        return 0;
+    }
+    counters_.valuesChanged += changed_.size();
+
+    // Pass 2: take the block into the image, then turn changed values into
+    // point changes, so both words of a two-register point are current.
+    for (const ChangedValue& value : changed_) {
+        image.values[value.address] = static_cast<uint16_t>(values[value.address - startAddress]);
+        image.known[value.address] = 1;
+    }
+    changes_.clear();
+    int lastPoint = -1;
+    for (const ChangedValue& value : changed_) {
+        ModbusChange change{slaveIdentifier, table, value.address, static_cast<double>(value.previous),
+                            static_cast<double>(image.values[value.address]), value.initial, polledAt};
+        if (!image.points.empty()) {
+            auto point = image.points.upper_bound(value.address);
+            if (point != image.points.begin() && (--point)->second.point.end() > value.address) {
+                // Both words of a point may have changed; it is judged once.
+                if (point->first != lastPoint) {
+                    lastPoint = point->first;
+                    change.address = point->first;
+                    evaluate(point->second, image, change);
+                }
+                continue;
+            }
+        }
+        if (change.initial) {
+            change.previous = change.value;
+        }
+        changes_.push_back(change);
+    }
+    counters_.reported += changes_.size();
+    dispatch(slaveIdentifier, table);
+    return changes_.size();
+}
+
+void test_modbus_485::ModbusChangeDetector::evaluate(PointState& state, TableState& image, ModbusChange change) {
+    if (static_cast<size_t>(state.point.end()) > image.values.size()) {
+        image.values.resize(state.point.end(), 0);
+        image.known.resize(state.point.end(), 0);
+    }
+    const double value = decodePoint<double>(state.point, image.values.data() + state.point.address);
+    if (state.hasReported && (value == state.reported || std::fabs(value - state.reported) < state.deadband)) {
+        ++counters_.suppressed;
+        return;
+    }
+    change.initial = !state.hasReported;
+    change.previous = state.hasReported ? state.reported : value;
+    change.value = value;
+    state.reported = value;
+    state.hasReported = true;
+    changes_.push_back(change);
+}
+
+void test_modbus_485::ModbusChangeDetector::dispatch(int slaveIdentifier, ModbusTable table) {
+    if (changes_.empty()) {
+        return;
+    }
+    for (const Subscription& subscription : subscriptions_) {
+        if (subscription.table != table ||
+            (subscription.slaveIdentifier != 0 && subscription.slaveIdentifier != slaveIdentifier)) {
+            continue;
+        }
+        // Changes are in address order.
+        auto first = std::lower_bound(changes_.begin(), changes_.end(), subscription.startAddress, byAddress);
+        auto last = std::lower_bound(first, changes_.end(), subscription.endAddress, byAddress);
+        if (first != last) {
+            subscription.subscriber(&*first, static_cast<size_t>(last - first));
+            ++counters_.callbacks;
+        }
+    }
+}
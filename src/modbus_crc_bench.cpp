@@ -0,0 +1,279 @@
+// src/modbus_crc_bench.cpp
+//
+// CRC16/MODBUS and RTU framing microbenchmark. Before measuring, every
+// variant is checked against the bitwise reference, the incremental API
+// against one-shot CRCs, and the codec against frames libmodbus itself puts
+// on a pty; a mismatch exits with status 1. Then each variant is timed over
+// buffers of several sizes and the frame splitter over a captured-style
+// stream of mixed requests and responses.
+//
+// usage: modbus_crc_bench [--sizes=8,64,256,4096,1048576] [--duration-ms=200]
+
+#include "modbus_pty.h"
+#include "modbus_rtu_codec.h"
+#include "modbus_rtu_splitter.h"
+#include <modbus.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <poll.h>
+#include <unistd.h>
+
+using namespace std::chrono;
+
+namespace {
+
+using CrcFunction = uint16_t (*)(uint16_t, const uint8_t*, size_t);
+
+struct CrcVariant {
+    const char* name;
+    CrcFunction function;
+};
+
+const CrcVariant variants[] = {
+    {"bitwise", test_modbus_485::crc16UpdateBitwise},
+    {"table", test_modbus_485::crc16UpdateBytewise},
+    {"slicing-by-8", test_modbus_485::crc16Update},
+};
+
+std::vector<int> parseList(const char* text) {
+    std::vector<int> values;
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        if (!item.empty()) {
+            values.push_back(std::atoi(item.c_str()));
+        }
+    }
+    return values;
+}
+
+bool checkVariants(std::mt19937& random) {
+    const uint8_t checkString[] = {'1', '2', '3', '4', '5', '6', '7', '8', '9'};
+    for (const CrcVariant& variant : variants) {
+        if (variant.function(test_modbus_485::crc16Initial, checkString, sizeof(checkString)) != 0x4B37) {
+            std::cerr << "[checkVariants] " << variant.name << " fails the CRC-16/MODBUS check value\n";
+            return false;
+        }
+    }
+    std::vector<uint8_t> data(4096);
+    for (int round = 0; round < 2000; ++round) {
+        const size_t length = random() % data.size();
+        for (size_t i = 0; i < length; ++i) {
+            data[i] = static_cast<uint8_t>(random());
+        }
+        const uint16_t expected = test_modbus_485::crc16UpdateBitwise(test_modbus_485::crc16Initial, data.data(), length);
+        for (const CrcVariant& variant : variants) {
+            if (variant.function(test_modbus_485::crc16Initial, data.data(), length) != expected) {
+                std::cerr << "[checkVariants] " << variant.name << " differs at length " << length << "\n";
+                return false;
+            }
+        }
+        const size_t split = length ? random() % length : 0;
+        uint16_t incremental = test_modbus_485::crc16Update(test_modbus_485::crc16Initial, data.data(), split);
+        incremental = test_modbus_485::crc16Update(incremental, data.data() + split, length - split);
+        if (incremental != expected) {
+            std::cerr << "[checkVariants] incremental CRC differs at length " << length << " split " << split << "\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Have libmodbus frame random requests and compare its CRC bytes with appendCrc().
+ */
+bool checkAgainstLibmodbus(std::mt19937& random, std::vector<uint8_t>& capture) {
+    int masterFileDescriptor = -1;
+    std::string slaveDevicePath;
+    if (!test_modbus_485::openPtyPair(masterFileDescriptor, slaveDevicePath)) {
+        std::cerr << "[checkAgainstLibmodbus] cannot open pty pair\n";
+        return false;
+    }
+    modbus_t* context = modbus_new_rtu(slaveDevicePath.c_str(), 115200, 'N', 8, 1);
+    if (!context || modbus_connect(context) == -1) {
+        std::cerr << "[checkAgainstLibmodbus] cannot open " << slaveDevicePath << "\n";
+        if (context) {
+            modbus_free(context);
+        }
+        close(masterFileDescriptor);
+        return false;
+    }
+
+    bool matched = true;
+    int frames = 0;
+    for (int round = 0; round < 500 && matched; ++round) {
+        // FC16 with random payload, so every CRC input byte varies.
+        const int count = 1 + static_cast<int>(random() % MODBUS_MAX_WRITE_REGISTERS);
+        std::vector<uint16_t> values(count);
+        for (uint16_t& value : values) {
+            value = static_cast<uint16_t>(random());
+        }
+        uint8_t request[MODBUS_RTU_MAX_ADU_LENGTH];
+        request[0] = static_cast<uint8_t>(1 + random() % 247);
+        const int pduLength = test_modbus_485::encodeWriteMultipleRegisters(static_cast<int>(random() % 60000),
+                                                                           values.data(), count, request + 1);
+        if (modbus_send_raw_request(context, request, pduLength + 1) == -1) {
+            std::cerr << "[checkAgainstLibmodbus] send: " << modbus_strerror(errno) << "\n";
+            matched = false;
+            break;
+        }
+        const int expectedLength = test_modbus_485::appendCrc(request, pduLength + 1);
+
+        uint8_t sent[MODBUS_RTU_MAX_ADU_LENGTH];
+        int received = 0;
+        while (received < expectedLength) {
+            pollfd descriptor{masterFileDescriptor, POLLIN, 0};
+            if (poll(&descriptor, 1, 1000) <= 0) {
+                break;
+            }
+            ssize_t chunk = read(masterFileDescriptor, sent + received, sizeof(sent) - received);
+            if (chunk <= 0) {
+                break;
+            }
+            received += static_cast<int>(chunk);
+        }
+        if (received != expectedLength || std::memcmp(sent, request, expectedLength) != 0) {
+            std::cerr << "[checkAgainstLibmodbus] frame " << round << " differs from libmodbus ("
+                      << received << " bytes, expected " << expectedLength << ")\n";
+            matched = false;
+            break;
+        }
+        capture.insert(capture.end(), sent, sent + received);
+        ++frames;
+    }
+    modbus_close(context);
+    modbus_free(context);
+    close(masterFileDescriptor);
+    if (matched) {
+        std::cout << "libmodbus cross-check: " << frames << " frames identical\n";
+    }
+    return matched;
+}
+
+/**
+ * @brief Append a response to a request as a slave would, for the splitter stream.
+ */
+void appendResponse(const uint8_t* request, int length, std::vector<uint8_t>& stream, std::mt19937& random) {
+    uint8_t response[MODBUS_RTU_MAX_ADU_LENGTH];
+    int responseLength = 0;
+    response[0] = request[0];
+    response[1] = request[1];
+    if (request[1] == MODBUS_FC_READ_HOLDING_REGISTERS && length >= 8) {
+        const int count = (request[4] << 8) | request[5];
+        response[2] = static_cast<uint8_t>(2 * count);
+        for (int i = 0; i < 2 * count; ++i) {
+            response[3 + i] = static_cast<uint8_t>(random());
+        }
+        responseLength = 3 + 2 * count;
+    } else {
+        std::memcpy(response + 2, request + 2, 4);
+        responseLength = 6;
+    }
+    responseLength = test_modbus_485::appendCrc(response, responseLength);
+    stream.insert(stream.end(), response, response + responseLength);
+}
+
+double measureCrc(const CrcVariant& variant, const std::vector<uint8_t>& buffer, size_t size, milliseconds duration) {
+    uint64_t bytes = 0;
+    uint16_t sink = 0;
+    const auto started = steady_clock::now();
+    auto now = started;
+    while (now - started < duration) {
+        for (int i = 0; i < 64; ++i) {
+            sink = static_cast<uint16_t>(sink ^ variant.function(test_modbus_485::crc16Initial, buffer.data(), size));
+            bytes += size;
+        }
+        now = steady_clock::now();
+    }
+    volatile uint16_t keep = sink;
+    (void)keep;
+    return static_cast<double>(bytes) / static_cast<double>(duration_cast<nanoseconds>(now - started).count());
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::vector<int> sizes{8, 64, 256, 4096, 1 << 20};
+    milliseconds duration(200);
+    for (int i = 1; i < argc; ++i) {
+        if (std::strncmp(argv[i], "--sizes=", 8) == 0) {
+            sizes = parseList(argv[i] + 8);
+        } else if (std::strncmp(argv[i], "--duration-ms=", 14) == 0) {
+            duration = milliseconds(std::atoi(argv[i] + 14));
+        } else {
+            std::cerr << "unknown argument: " << argv[i] << "\n"
+                      << "usage: modbus_crc_bench [--sizes=LIST] [--duration-ms=N]\n";
+            return 1;
+        }
+    }
+
+    std::mt19937 random(12345);
+    std::vector<uint8_t> requests;
+    if (!checkVariants(random) || !checkAgainstLibmodbus(random, requests)) {
+        return 1;
+    }
+
+    std::cout << "\n" << std::left << std::setw(14) << "variant" << std::right << std::setw(10) << "bytes"
+              << std::setw(10) << "GB/s" << "\n";
+    size_t largest = 0;
+    for (int size : sizes) {
+        largest = std::max(largest, static_cast<size_t>(size > 0 ? size : 0));
+    }
+    std::vector<uint8_t> buffer(largest);
+    for (uint8_t& byte : buffer) {
+        byte = static_cast<uint8_t>(random());
+    }
+    for (const CrcVariant& variant : variants) {
+        for (int size : sizes) {
+            if (size <= 0) {
+                continue;
+            }
+            std::cout << std::left << std::setw(14) << variant.name << std::right << std::setw(10) << size
+                      << std::fixed << std::setprecision(3) << std::setw(10)
+                      << measureCrc(variant, buffer, static_cast<size_t>(size), duration) << "\n";
+        }
+    }
+
+    // Interleave the libmodbus requests with responses, then split the stream back up.
+    std::vector<uint8_t> stream;
+    int frameCount = 0;
+    for (size_t offset = 0; offset < requests.size();) {
+        const int length = test_modbus_485::rtuRequestLength(requests.data() + offset,
+                                                             static_cast<int>(requests.size() - offset));
+        stream.insert(stream.end(), requests.begin() + offset, requests.begin() + offset + length);
+        appendResponse(requests.data() + offset, length, stream, random);
+        offset += static_cast<size_t>(length);
+        frameCount += 2;
+    }
+    uint64_t split = 0;
+    const auto started = steady_clock::now();
+    auto now = started;
+    while (now - started < duration) {
+        test_modbus_485::ModbusRtuFrameSplitter splitter(nullptr);
+        // Feed in 64-byte pieces, as reads from a serial port would arrive.
+        for (size_t offset = 0; offset < stream.size(); offset += 64) {
+            splitter.push(stream.data() + offset, std::min<size_t>(64, stream.size() - offset));
+        }
+        splitter.gap();
+        if (splitter.frameCount() != static_cast<uint64_t>(frameCount) || splitter.discardedBytes() != 0) {
+            std::cerr << "[modbus_crc_bench] splitter found " << splitter.frameCount() << " frames, "
+                      << splitter.discardedBytes() << " discarded bytes; expected " << frameCount << "\n";
+            return 1;
+        }
+        split += stream.size();
+        now = steady_clock::now();
+    }
+    std::cout << std::left << std::setw(14) << "splitter" << std::right << std::setw(10) << stream.size()
+              << std::fixed << std::setprecision(3) << std::setw(10)
+              << static_cast<double>(split) / static_cast<double>(duration_cast<nanoseconds>(now - started).count())
+              << "  (" << frameCount << " frames)\n";
+    return 0;
+}
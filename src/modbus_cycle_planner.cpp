@@ -0,0 +1,404 @@
+// src/modbus_cycle_planner.cpp
+
+#include "modbus_cycle_planner.h"
+#include <algorithm>
+#include <iostream>
+
+test_modbus_485::ModbusCyclePlanner::ModbusCyclePlanner(ModbusUtils& modbusUtils)
+    : modbusUtils_(modbusUtils),
+      imageCoilAddress_(0),
+      imageRegisterAddress_(0),
+      imageCoilCount_(0),
+      writeAndReadEnabled_(true),
+      registerGapCost_(defaultGapCost(ModbusTable::HoldingRegisters)),
+      coilGapCost_(defaultGapCost(ModbusTable::Coils)),
+      failedFunctionCode_(0) {}
+
+int test_modbus_485::ModbusCyclePlanner::addOperation(OperationKind kind, int startAddress, int count) {
+    Operation operation;
+    operation.kind = kind;
+    operation.startAddress = startAddress;
+    operation.count = count;
+    operation.viaRegisterImage = false;
+    if (kind == OperationKind::RegisterWrite || kind == OperationKind::RegisterRead) {
+        operation.registers.assign(count > 0 ? count : 0, 0);
+    } else {
+        operation.coils.assign(count > 0 ? count : 0, 0);
+    }
+    operations_.push_back(std::move(operation));
+    transactions_.clear();
+    return static_cast<int>(operations_.size()) - 1;
+}
+
+int test_modbus_485::ModbusCyclePlanner::addRegisterWrite(int startAddress, int numberOfRegisters) {
+    return addOperation(OperationKind::RegisterWrite, startAddress, numberOfRegisters);
+}
+
+int test_modbus_485::ModbusCyclePlanner::addCoilWrite(int startAddress, int numberOfCoils) {
+    return addOperation(OperationKind::CoilWrite, startAddress, numberOfCoils);
+}
+
+int test_modbus_485::ModbusCyclePlanner::addRegisterRead(int startAddress, int numberOfRegisters) {
+    return addOperation(OperationKind::RegisterRead, startAddress, numberOfRegisters);
+}
+
+int test_modbus_485::ModbusCyclePlanner::addCoilRead(int startAddress, int numberOfCoils) {
+    return addOperation(OperationKind::CoilRead, startAddress, numberOfCoils);
+}
+
+void test_modbus_485::ModbusCyclePlanner::setCoilRegisterImage(int coilAddress,
+                                                                int registerAddress,
+                                                                int numberOfCoils) {
+    imageCoilAddress_ = coilAddress;
+    imageRegisterAddress_ = registerAddress;
+    imageCoilCount_ = numberOfCoils;
+    transactions_.clear();
+}
+
+void test_modbus_485::ModbusCyclePlanner::setWriteAndReadEnabled(bool enabled) {
+    writeAndReadEnabled_ = enabled;
+    transactions_.clear();
+}
+
+void test_modbus_485::ModbusCyclePlanner::setGapCost(ModbusTable table, int gapCost) {
+    if (table == ModbusTable::HoldingRegisters) {
+        registerGapCost_ = std::max(gapCost, 0);
+    } else if (table == ModbusTable::Coils) {
+        coilGapCost_ = std::max(gapCost, 0);
+    }
+    transactions_.clear();
+}
+
+uint16_t* test_modbus_485::ModbusCyclePlanner::registerBuffer(int handle) {
+    if (handle < 0 || handle >= static_cast<int>(operations_.size()) ||
+        operations_[handle].registers.empty()) {
+        return nullptr;
+    }
+    return operations_[handle].registers.data();
+}
+
+uint8_t* test_modbus_485::ModbusCyclePlanner::coilBuffer(int handle) {
+    if (handle < 0 || handle >= static_cast<int>(operations_.size()) ||
+        operations_[handle].coils.empty()) {
+        return nullptr;
+    }
+    return operations_[handle].coils.data();
+}
+
+bool test_modbus_485::ModbusCyclePlanner::coveredByRegisterImage(const Operation& operation,
+                                                                 bool requireWholeRegisters) const {
+    if (imageCoilCount_ <= 0 ||
+        operation.startAddress < imageCoilAddress_ ||
+        operation.startAddress + operation.count > imageCoilAddress_ + imageCoilCount_) {
+        return false;
+    }
+    // A misaligned read can span one register more than a PDU carries; it stays a coil read.
+    const int firstCoil = operation.startAddress - imageCoilAddress_;
+    const int registerSpan = (firstCoil + operation.count - 1) / 16 - firstCoil / 16 + 1;
+    if (registerSpan > (requireWholeRegisters ? MODBUS_MAX_WRITE_REGISTERS : MODBUS_MAX_READ_REGISTERS)) {
+        return false;
+    }
+    if (!requireWholeRegisters) {
+        return true;
+    }
+    // A partial register write would clobber the neighbouring coils held by the slave.
+    return (operation.startAddress - imageCoilAddress_) % 16 == 0 && operation.count % 16 == 0;
+}
+
+void test_modbus_485::ModbusCyclePlanner::operationSpan(const Operation& operation,
+                                                        int& startAddress,
+                                                        int& endAddress) const {
+    if (!operation.viaRegisterImage) {
+        startAddress = operation.startAddress;
+        endAddress = operation.startAddress + operation.count;
+        return;
+    }
+    int firstCoil = operation.startAddress - imageCoilAddress_;
+    int lastCoil = firstCoil + operation.count - 1;
+    startAddress = imageRegisterAddress_ + firstCoil / 16;
+    endAddress = imageRegisterAddress_ + lastCoil / 16 + 1;
+}
+
+std::vector<test_modbus_485::ModbusCyclePlanner::Block>
+test_modbus_485::ModbusCyclePlanner::mergeBlocks(std::vector<int> operations, int maximumSpan) const {
+    std::stable_sort(operations.begin(), operations.end(), [this](int left, int right) {
+        int leftStart, leftEnd, rightStart, rightEnd;
+        operationSpan(operations_[left], leftStart, leftEnd);
+        operationSpan(operations_[right], rightStart, rightEnd);
+        return leftStart < rightStart;
+    });
+
+    std::vector<Block> blocks;
+    for (int index : operations) {
+        int startAddress, endAddress;
+        operationSpan(operations_[index], startAddress, endAddress);
+        if (!blocks.empty() && startAddress <= blocks.back().endAddress &&
+            std::max(endAddress, blocks.back().endAddress) - blocks.back().startAddress <= maximumSpan) {
+            blocks.back().endAddress = std::max(endAddress, blocks.back().endAddress);
+            blocks.back().operations.push_back(index);
+        } else {
+            blocks.push_back(Block{startAddress, endAddress, {index}});
+        }
+    }
+    return blocks;
+}
+
+bool test_modbus_485::ModbusCyclePlanner::coalesceBlocks(const std::vector<int>& operations,
+                                                         int maximumSpan,
+                                                         int gapCost,
+                                                         std::vector<Block>& blocks) const {
+    std::vector<ModbusReadRange> ranges;
+    for (int index : operations) {
+        int startAddress, endAddress;
+        operationSpan(operations_[index], startAddress, endAddress);
+        ranges.push_back({startAddress, endAddress - startAddress});
+    }
+
+    blocks.clear();
+    for (const ModbusReadRange& range : coalesceReadRanges(ranges, maximumSpan, gapCost)) {
+        blocks.push_back(Block{range.startAddress, range.startAddress + range.count, {}});
+    }
+    for (int index : operations) {
+        int startAddress, endAddress;
+        operationSpan(operations_[index], startAddress, endAddress);
+        auto found = std::upper_bound(blocks.begin(), blocks.end(), startAddress,
+                                      [](int address, const Block& block) {
+                                          return address < block.startAddress;
+                                      });
+        // coalesceReadRanges() returns nothing for a range it cannot fit.
+        if (found == blocks.begin() || endAddress > (found - 1)->endAddress) {
+            std::cerr << "[plan] read operation " << index << " spans more than " << maximumSpan << " items\n";
+            blocks.clear();
+            return false;
+        }
+        (found - 1)->operations.push_back(index);
+    }
+    return true;
+}
+
+bool test_modbus_485::ModbusCyclePlanner::plan() {
+    transactions_.clear();
+
+    std::vector<int> registerWrites, registerReads, coilWrites, coilReads;
+    for (int index = 0; index < static_cast<int>(operations_.size()); ++index) {
+        Operation& operation = operations_[index];
+        int limit = 0;
+        switch (operation.kind) {
+            case OperationKind::RegisterWrite: limit = MODBUS_MAX_WRITE_REGISTERS; break;
+            case OperationKind::RegisterRead:  limit = MODBUS_MAX_READ_REGISTERS;  break;
+            case OperationKind::CoilWrite:     limit = MODBUS_MAX_WRITE_BITS;      break;
+            case OperationKind::CoilRead:      limit = MODBUS_MAX_READ_BITS;       break;
+        }
+        if (operation.count <= 0 || operation.count > limit || operation.startAddress < 0 ||
+            operation.startAddress + operation.count > 0x10000) {
+            std::cerr << "[plan] operation " << index << " exceeds Modbus limits\n";
+            return false;
+        }
+
+        switch (operation.kind) {
+            case OperationKind::RegisterWrite:
+                registerWrites.push_back(index);
+                break;
+            case OperationKind::RegisterRead:
+                registerReads.push_back(index);
+                break;
+            case OperationKind::CoilWrite:
+                operation.viaRegisterImage = coveredByRegisterImage(operation, true);
+                (operation.viaRegisterImage ? registerWrites : coilWrites).push_back(index);
+                break;
+            case OperationKind::CoilRead:
+                operation.viaRegisterImage = coveredByRegisterImage(operation, false);
+                (operation.viaRegisterImage ? registerReads : coilReads).push_back(index);
+                break;
+        }
+    }
+
+    std::vector<Block> registerWriteBlocks = mergeBlocks(registerWrites, MODBUS_MAX_WRITE_REGISTERS);
+    std::vector<Block> coilWriteBlocks     = mergeBlocks(coilWrites,     MODBUS_MAX_WRITE_BITS);
+    std::vector<Block> registerReadBlocks;
+    std::vector<Block> coilReadBlocks;
+    if (!coalesceBlocks(registerReads, MODBUS_MAX_READ_REGISTERS, registerGapCost_, registerReadBlocks) ||
+        !coalesceBlocks(coilReads, MODBUS_MAX_READ_BITS, coilGapCost_, coilReadBlocks)) {
+        return false;
+    }
+
+    auto makeTransaction = [](int functionCode, const Block* writeBlock, const Block* readBlock) {
+        Transaction transaction{};
+        transaction.functionCode = functionCode;
+        if (writeBlock) {
+            transaction.writeAddress = writeBlock->startAddress;
+            transaction.writeCount = writeBlock->endAddress - writeBlock->startAddress;
+            transaction.writeOperations = writeBlock->operations;
+            // Later registrations win where writes overlap.
+            std::sort(transaction.writeOperations.begin(), transaction.writeOperations.end());
+        }
+        if (readBlock) {
+            transaction.readAddress = readBlock->startAddress;
+            transaction.readCount = readBlock->endAddress - readBlock->startAddress;
+            transaction.readOperations = readBlock->operations;
+        }
+        return transaction;
+    };
+
+    // Coil writes go first so that every read, including the one folded into FC23,
+    // observes all of this cycle's writes.
+    for (const Block& block : coilWriteBlocks) {
+        Transaction transaction = makeTransaction(MODBUS_FC_WRITE_MULTIPLE_COILS, &block, nullptr);
+        transaction.coilWriteBlock.assign(transaction.writeCount, 0);
+        transactions_.push_back(std::move(transaction));
+    }
+
+    // A read may ride along with a write block as FC23 only if no later write block
+    // touches it; otherwise it would miss a write sent after it.
+    std::vector<bool> readFolded(registerReadBlocks.size(), false);
+    for (size_t writeIndex = 0; writeIndex < registerWriteBlocks.size(); ++writeIndex) {
+        const Block& block = registerWriteBlocks[writeIndex];
+        int foldedRead = -1;
+        if (writeAndReadEnabled_ && block.endAddress - block.startAddress <= MODBUS_MAX_WR_WRITE_REGISTERS) {
+            for (size_t readIndex = 0; readIndex < registerReadBlocks.size() && foldedRead < 0; ++readIndex) {
+                const Block& read = registerReadBlocks[readIndex];
+                bool overlapsLaterWrite = false;
+                for (size_t later = writeIndex + 1; later < registerWriteBlocks.size(); ++later) {
+                    overlapsLaterWrite |= read.startAddress < registerWriteBlocks[later].endAddress &&
+                                          registerWriteBlocks[later].startAddress < read.endAddress;
+                }
+                if (!readFolded[readIndex] && !overlapsLaterWrite) {
+                    foldedRead = static_cast<int>(readIndex);
+                }
+            }
+        }
+        Transaction transaction = foldedRead >= 0
+            ? makeTransaction(MODBUS_FC_WRITE_AND_READ_REGISTERS, &block, &registerReadBlocks[foldedRead])
+            : makeTransaction(MODBUS_FC_WRITE_MULTIPLE_REGISTERS, &block, nullptr);
+        if (foldedRead >= 0) {
+            readFolded[foldedRead] = true;
+        }
+        transaction.registerWriteBlock.assign(transaction.writeCount, 0);
+        transaction.registerReadBlock.assign(transaction.readCount, 0);
+        transactions_.push_back(std::move(transaction));
+    }
+    for (size_t readIndex = 0; readIndex < registerReadBlocks.size(); ++readIndex) {
+        if (readFolded[readIndex]) {
+            continue;
+        }
+        Transaction transaction = makeTransaction(MODBUS_FC_READ_HOLDING_REGISTERS, nullptr, &registerReadBlocks[readIndex]);
+        transaction.registerReadBlock.assign(transaction.readCount, 0);
+        transactions_.push_back(std::move(transaction));
+    }
+    for (const Block& block : coilReadBlocks) {
+        Transaction transaction = makeTransaction(MODBUS_FC_READ_COILS, nullptr, &block);
+        transaction.coilReadBlock.assign(transaction.readCount, 0);
+        transactions_.push_back(std::move(transaction));
+    }
+    return true;
+}
+
+void test_modbus_485::ModbusCyclePlanner::gatherWrites(Transaction& transaction) {
+    for (int index : transaction.writeOperations) {
+        const Operation& operation = operations_[index];
+        if (transaction.functionCode == MODBUS_FC_WRITE_MULTIPLE_COILS) {
+            std::copy(operation.coils.begin(), operation.coils.end(),
+                      transaction.coilWriteBlock.begin() + (operation.startAddress - transaction.writeAddress));
+        } else if (!operation.viaRegisterImage) {
+            std::copy(operation.registers.begin(), operation.registers.end(),
+                      transaction.registerWriteBlock.begin() + (operation.startAddress - transaction.writeAddress));
+        } else {
+            for (int i = 0; i < operation.count; ++i) {
+                int coil = operation.startAddress + i - imageCoilAddress_;
+                uint16_t& word = transaction.registerWriteBlock[imageRegisterAddress_ + coil / 16 - transaction.writeAddress];
+                uint16_t mask = static_cast<uint16_t>(1u << (coil % 16));
+                word = operation.coils[i] ? (word | mask) : (word & ~mask);
+            }
+        }
+    }
+}
+
+void test_modbus_485::ModbusCyclePlanner::scatterReads(Transaction& transaction) {
+    for (int index : transaction.readOperations) {
+        Operation& operation = operations_[index];
+        if (transaction.functionCode == MODBUS_FC_READ_COILS) {
+            auto first = transaction.coilReadBlock.begin() + (operation.startAddress - transaction.readAddress);
+            std::copy(first, first + operation.count, operation.coils.begin());
+        } else if (!operation.viaRegisterImage) {
+            auto first = transaction.registerReadBlock.begin() + (operation.startAddress - transaction.readAddress);
+            std::copy(first, first + operation.count, operation.registers.begin());
+        } else {
+            for (int i = 0; i < operation.count; ++i) {
+                int coil = operation.startAddress + i - imageCoilAddress_;
+                uint16_t word = transaction.registerReadBlock[imageRegisterAddress_ + coil / 16 - transaction.readAddress];
+                operation.coils[i] = static_cast<uint8_t>((word >> (coil % 16)) & 1u);
+            }
+        }
+    }
+}
+
+bool test_modbus_485::ModbusCyclePlanner::execute(modbus_t*& contextReference) {
+    failedFunctionCode_ = 0;
+    if (transactions_.empty() && !operations_.empty() && !plan()) {
+        return false;
+    }
+
+    for (Transaction& transaction : transactions_) {
+        gatherWrites(transaction);
+        int result = -1;
+        int expected = 0;
+        switch (transaction.functionCode) {
+            case MODBUS_FC_WRITE_MULTIPLE_COILS:
+                result = modbusUtils_.writeMultipleCoils(contextReference, transaction.writeAddress,
+                                                         transaction.coilWriteBlock.data(),
+                                                         transaction.writeCount);
+                expected = transaction.writeCount;
+                break;
+            case MODBUS_FC_WRITE_MULTIPLE_REGISTERS:
+                result = modbusUtils_.writeMultipleRegisters(contextReference, transaction.writeAddress,
+                                                             transaction.registerWriteBlock.data(),
+                                                             transaction.writeCount);
+                expected = transaction.writeCount;
+                break;
+            case MODBUS_FC_WRITE_AND_READ_REGISTERS:
+                result = modbusUtils_.writeAndReadRegisters(contextReference,
+                                                            transaction.writeAddress,
+                                                            transaction.registerWriteBlock.data(),
+                                                            transaction.writeCount,
+                                                            transaction.readAddress,
+                                                            transaction.readCount,
+                                                            transaction.registerReadBlock.data());
+                expected = transaction.readCount;
+                break;
+            case MODBUS_FC_READ_HOLDING_REGISTERS:
+                result = modbusUtils_.readHoldingRegisters(contextReference, transaction.readAddress,
+                                                           transaction.readCount,
+                                                           transaction.registerReadBlock.data());
+                expected = transaction.readCount;
+                break;
+            case MODBUS_FC_READ_COILS:
+                result = modbusUtils_.readCoils(contextReference, transaction.readAddress,
+                                                transaction.readCount,
+                                                transaction.coilReadBlock.data());
+                expected = transaction.readCount;
+                break;
+        }
+        if (result != expected) {
+            failedFunctionCode_ = transaction.functionCode;
+            return false;
+        }
+        scatterReads(transaction);
+    }
+    return true;
+}
+
+int test_modbus_485::ModbusCyclePlanner::failedFunctionCode() const {
+    return failedFunctionCode_;
+}
+
+int test_modbus_485::ModbusCyclePlanner::naiveTransactionCount() const {
+    return static_cast<int>(operations_.size());
+}
+
+int test_modbus_485::ModbusCyclePlanner::plannedTransactionCount() const {
+    return static_cast<int>(transactions_.size());
+}
+
+int test_modbus_485::ModbusCyclePlanner::roundTripsSaved() const {
+    return naiveTransactionCount() - plannedTransactionCount();
+}
@@ -0,0 +1,179 @@
+// src/modbus_cyclic_executor.cpp
+
+#include "modbus_cyclic_executor.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+
+namespace {
+
+constexpr int64_t nanosecondsPerSecond = 1000000000;
+
+int64_t monotonicNow() {
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<int64_t>(now.tv_sec) * nanosecondsPerSecond + now.tv_nsec;
+}
+
+void sleepUntil(int64_t deadline) {
+    timespec request;
+    request.tv_sec = static_cast<time_t>(deadline / nanosecondsPerSecond);
+    request.tv_nsec = static_cast<long>(deadline % nanosecondsPerSecond);
+    // clock_nanosleep returns the error instead of setting errno.
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &request, nullptr) == EINTR) {
+    }
+}
+
+void printRow(std::ostream& stream, const char* label, const test_modbus_485::LatencyHistogramSnapshot& histogram) {
+    test_modbus_485::LatencySummary summary = histogram.summary();
+    stream << "  " << std::left << std::setw(14) << label << std::right
+           << std::setw(10) << summary.count
+           << std::fixed << std::setprecision(0)
+           << std::setw(9) << summary.p50
+           << std::setw(9) << summary.p90
+           << std::setw(9) << summary.p99
+           << std::setw(9) << summary.p999
+           << std::setw(9) << summary.max << "\n";
+}
+
+} // namespace
+
+void test_modbus_485::ModbusCyclicStatistics::print(std::ostream& stream) const {
+    std::ios::fmtflags flags = stream.flags();
+    std::streamsize precision = stream.precision();
+
+    stream << "  cycles " << cycles << ", overruns " << overruns << ", skipped " << skippedCycles << "\n";
+    stream << "  " << std::left << std::setw(14) << "(us)" << std::right
+           << std::setw(10) << "count"
+           << std::setw(9) << "p50"
+           << std::setw(9) << "p90"
+           << std::setw(9) << "p99"
+           << std::setw(9) << "p99.9"
+           << std::setw(9) << "max" << "\n";
+    printRow(stream, "wake latency", wakeLatency);
+    printRow(stream, "period jitter", periodJitter);
+    printRow(stream, "execution", execution);
+    printRow(stream, "deadline miss", deadlineMiss);
+
+    stream.flags(flags);
+    stream.precision(precision);
+}
+
+test_modbus_485::ModbusCyclicExecutor::ModbusCyclicExecutor(const ModbusCyclicOptions& options)
+    : options_(options) {}
+
+bool test_modbus_485::ModbusCyclicExecutor::configureThread() {
+    bool applied = true;
+    if (options_.lockMemory && mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+        perror("[configureThread] mlockall");
+        applied = false;
+    }
+    if (options_.cpu >= 0) {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(options_.cpu, &cpus);
+        int error = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+        if (error != 0) {
+            std::cerr << "[configureThread] cpu " << options_.cpu << ": " << std::strerror(error) << "\n";
+            applied = false;
+        }
+    }
+    if (options_.realtimePriority > 0) {
+        sched_param parameters{};
+        parameters.sched_priority = options_.realtimePriority;
+        int error = pthread_setschedparam(pthread_self(), SCHED_FIFO, &parameters);
+        if (error != 0) {
+            std::cerr << "[configureThread] SCHED_FIFO " << options_.realtimePriority << ": "
+                      << std::strerror(error) << "\n";
+            applied = false;
+        }
+    }
+    return applied;
+}
+
+uint64_t test_modbus_485::ModbusCyclicExecutor::run(const Cycle& cycle, uint64_t cycles) {
+    const int64_t period = options_.period.count();
+    if (period <= 0 || !cycle) {
+        std::cerr << "[run] invalid period or cycle\n";
+        return 0;
+    }
+    stopRequested_.store(false);
+
+    uint64_t ran = 0;
+    uint64_t index = 0;
+    uint64_t previousIndex = 0;
+    int64_t previousStart = -1;
+    int64_t release = monotonicNow();
+    while (!stopRequested_.load(std::memory_order_relaxed) && (cycles == 0 || index < cycles)) {
+        sleepUntil(release);
+        const int64_t started = monotonicNow();
+        wakeLatency_.record(std::chrono::nanoseconds(started - release));
+        if (previousStart >= 0) {
+            const int64_t expected = static_cast<int64_t>(index - previousIndex) * period;
+            const int64_t error = started - previousStart - expected;
+            periodJitter_.record(std::chrono::nanoseconds(error < 0 ? -error : error));
+        }
+        previousStart = started;
+        previousIndex = index;
+
+        const bool keepRunning = cycle(index);
+        const int64_t finished = monotonicNow();
+        execution_.record(std::chrono::nanoseconds(finished - started));
+        cycles_.fetch_add(1, std::memory_order_relaxed);
+        ++ran;
+        if (!keepRunning) {
+            break;
+        }
+
+        release += period;
+        ++index;
+        if (finished > release) {
+            overruns_.fetch_add(1, std::memory_order_relaxed);
+            deadlineMiss_.record(std::chrono::nanoseconds(finished - release));
+            if (options_.overrunPolicy == ModbusOverrunPolicy::SkipMissed) {
+                // Stay on the original grid: next release is the first one still ahead.
+                const int64_t missed = (finished - release) / period + 1;
+                release += missed * period;
+                index += static_cast<uint64_t>(missed);
+                skippedCycles_.fetch_add(static_cast<uint64_t>(missed), std::memory_order_relaxed);
+            }
+        }
+    }
+    return ran;
+}
+
+void test_modbus_485::ModbusCyclicExecutor::stop() {
+    stopRequested_.store(true);
+}
+
+const test_modbus_485::ModbusCyclicOptions& test_modbus_485::ModbusCyclicExecutor::options() const {
+    return options_;
+}
+
+test_modbus_485::ModbusCyclicStatistics test_modbus_485::ModbusCyclicExecutor::statistics() const {
+    ModbusCyclicStatistics result;
+    result.cycles = cycles_.load(std::memory_order_relaxed);
+    result.overruns = overruns_.load(std::memory_order_relaxed);
+    result.skippedCycles = skippedCycles_.load(std::memory_order_relaxed);
+    result.wakeLatency = wakeLatency_.snapshot();
+    result.periodJitter = periodJitter_.snapshot();
+    result.execution = execution_.snapshot();
+    result.deadlineMiss = deadlineMiss_.snapshot();
+    return result;
+}
+
+void test_modbus_485::ModbusCyclicExecutor::resetStatistics() {
+    cycles_.store(0, std::memory_order_relaxed);
+    overruns_.store(0, std::memory_order_relaxed);
+    skippedCycles_.store(0, std::memory_order_relaxed);
+    wakeLatency_.reset();
+    periodJitter_.reset();
+    execution_.reset();
+    deadlineMiss_.reset();
+}
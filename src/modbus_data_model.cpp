@@ -0,0 +1,316 @@
+// src/modbus_data_model.cpp
+
+#include "modbus_data_model.h"
+#include "modbus_rtu_codec.h"
+#include <modbus.h>
+
+namespace {
+
+void putUint16(uint8_t* destination, int value) {
+    destination[0] = static_cast<uint8_t>((value >> 8) & 0xFF);
+    destination[1] = static_cast<uint8_t>(value & 0xFF);
+}
+
+int getUint16(const uint8_t* source) {
+    return (source[0] << 8) | source[1];
+}
+
+int exceptionResponse(uint8_t functionCode, int exceptionCode, uint8_t* response) {
+    response[0] = static_cast<uint8_t>(functionCode | 0x80);
+    response[1] = static_cast<uint8_t>(exceptionCode);
+    return 2;
+}
+
+bool inRange(int address, int count, size_t tableSize) {
+    return address + count <= static_cast<int>(tableSize);
+}
+
+} // namespace
+
+int test_modbus_485::processFileRecordRequest(const uint8_t* request,
+                                              int length,
+                                              uint16_t* registers,
+                                              int numberOfRegisters,
+                                              uint8_t* response) {
+    const uint8_t functionCode = request[0];
+    if (length < 2 || length < 2 + request[1] || request[1] < 7) {
+        return exceptionResponse(functionCode, MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE, response);
+    }
+    const int end = 2 + request[1];
+
+    // Validate every sub-request before a write touches the table.
+    int responseLength = 2;
+    int offset = 2;
+    while (offset < end) {
+        if (end - offset < 7 || request[offset] != 6) {
+            return exceptionResponse(functionCode, MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE, response);
+        }
+        const int fileNumber = getUint16(request + offset + 1);
+        const int recordNumber = getUint16(request + offset + 3);
+        const int count = getUint16(request + offset + 5);
+        const int dataLength = functionCode == modbusFcWriteFileRecord ? 2 * count : 0;
+        if (count < 1 || end - offset < 7 + dataLength) {
+            return exceptionResponse(functionCode, MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE, response);
+        }
+        if (fileNumber < 1 || recordNumber + count > modbusFileRecordCount ||
+            (fileNumber - 1) * modbusFileRecordCount + recordNumber + count > numberOfRegisters) {
+            return exceptionResponse(functionCode, MODBUS_EXCEPTION_ILLEGAL_DATA_ADDRESS, response);
+        }
+        responseLength += 2 + 2 * count;
+        offset += 7 + dataLength;
+    }
+    if (functionCode == modbusFcReadFileRecord && responseLength - 2 > 0xF5) {
+        return exceptionResponse(functionCode, MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE, response);
+    }
+
+    if (functionCode == modbusFcWriteFileRecord) {
+        for (offset = 2; offset < end; offset += 7 + 2 * getUint16(request + offset + 5)) {
+            uint16_t* record = registers + (getUint16(request + offset + 1) - 1) * modbusFileRecordCount
+                               + getUint16(request + offset + 3);
+            const int count = getUint16(request + offset + 5);
+            for (int i = 0; i < count; ++i) {
+                record[i] = static_cast<uint16_t>(getUint16(request + offset + 7 + 2 * i));
+            }
+        }
+        for (int i = 0; i < end; ++i) {
+            response[i] = request[i];
+        }
+        return end;
+    }
+
+    response[0] = functionCode;
+    response[1] = static_cast<uint8_t>(responseLength - 2);
+    int position = 2;
+    for (offset = 2; offset < end; offset += 7) {
+        const uint16_t* record = registers + (getUint16(request + offset + 1) - 1) * modbusFileRecordCount
+                                 + getUint16(request + offset + 3);
+        const int count = getUint16(request + offset + 5);
+        response[position] = static_cast<uint8_t>(1 + 2 * count);
+        response[position + 1] = 6;
+        for (int i = 0; i < count; ++i) {
+            putUint16(response + position + 2 + 2 * i, record[i]);
+        }
+        position += 2 + 2 * count;
+    }
+    return position;
+}
+
+test_modbus_485::ModbusDataModel::ModbusDataModel(int numberOfBits, int numberOfRegisters)
+    : coils_(numberOfBits, 0),
+      discreteInputs_(numberOfBits, 0),
+      holdingRegisters_(numberOfRegisters, 0),
+      inputRegisters_(numberOfRegisters, 0) {}
+
+int test_modbus_485::ModbusDataModel::process(const uint8_t* request, int length, uint8_t* response) {
+    if (length < 1) {
+        return 0;
+    }
+    const uint8_t functionCode = request[0];
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    switch (functionCode) {
+        case MODBUS_FC_READ_COILS:
+        case MODBUS_FC_READ_DISCRETE_INPUTS: {
+            if (length < 5) {
+                return exceptionResponse(functionCode, MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE, response);
+            }
+            const int address = getUint16(request + 1);
+            const int count = getUint16(request + 3);
+            const std::vector<uint8_t>& table = functionCode == MODBUS_FC_READ_COILS ? coils_ : discreteInputs_;
+            if (count < 1 || count > MODBUS_MAX_READ_BITS) {
+                return exceptionResponse(functionCode, MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE, response);
+            }
+            if (!inRange(address, count, table.size())) {
+                return exceptionResponse(functionCode, MODBUS_EXCEPTION_ILLEGAL_DATA_ADDRESS, response);
+            }
+            const int byteCount = (count + 7) / 8;
+            response[0] = functionCode;
+            response[1] = static_cast<uint8_t>(byteCount);
+            for (int i = 0; i < byteCount; ++i) {
+                response[2 + i] = 0;
+            }
+            for (int i = 0; i < count; ++i) {
+                if (table[address + i]) {
+                    response[2 + i / 8] |= static_cast<uint8_t>(1u << (i % 8));
+                }
+            }
+            return 2 + byteCount;
+        }
+
+        case MODBUS_FC_READ_HOLDING_REGISTERS:
+        case MODBUS_FC_READ_INPUT_REGISTERS: {
+            if (length < 5) {
+                return exceptionResponse(functionCode, MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE, response);
+            }
+            const int address = getUint16(request + 1);
+            const int count = getUint16(request + 3);
+            const std::vector<uint16_t>& table =
+                functionCode == MODBUS_FC_READ_HOLDING_REGISTERS ? holdingRegisters_ : inputRegisters_;
+            if (count < 1 || count > MODBUS_MAX_READ_REGISTERS) {
+                return exceptionResponse(functionCode, MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE, response);
+            }
+            if (!inRange(address, count, table.size())) {
+                return exceptionResponse(functionCode, MODBUS_EXCEPTION_ILLEGAL_DATA_ADDRESS, response);
+            }
+            response[0] = functionCode;
+            response[1] = static_cast<uint8_t>(count * 2);
+            for (int i = 0; i < count; ++i) {
+                putUint16(response + 2 + 2 * i, table[address + i]);
+            }
+            return 2 + 2 * count;
+        }
+
+        case MODBUS_FC_WRITE_SINGLE_COIL: {
+            if (length < 5) {
+                return exceptionResponse(functionCode, MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE, response);
+            }
+            const int address = getUint16(request + 1);
+            const int value = getUint16(request + 3);
+            if (value != 0xFF00 && value != 0x0000) {
+                return exceptionResponse(functionCode, MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE, response);
+            }
+            if (!inRange(address, 1, coils_.size())) {
+                return exceptionResponse(functionCode, MODBUS_EXCEPTION_ILLEGAL_DATA_ADDRESS, response);
+            }
+            coils_[address] = value ? 1 : 0;
+            for (int i = 0; i < 5; ++i) {
+                response[i] = request[i];
+            }
+            return 5;
+        }
+
+        case MODBUS_FC_WRITE_SINGLE_REGISTER: {
+            if (length < 5) {
+                return exceptionResponse(functionCode, MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE, response);
+            }
+            const int address = getUint16(request + 1);
+            if (!inRange(address, 1, holdingRegisters_.size())) {
+                return exceptionResponse(functionCode, MODBUS_EXCEPTION_ILLEGAL_DATA_ADDRESS, response);
+            }
+            holdingRegisters_[address] = static_cast<uint16_t>(getUint16(request + 3));
+            for (int i = 0; i < 5; ++i) {
+                response[i] = request[i];
+            }
+            return 5;
+        }
+
+        case MODBUS_FC_WRITE_MULTIPLE_COILS: {
+            if (length < 6) {
+                return exceptionResponse(functionCode, MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE, response);
+            }
+            const int address = getUint16(request + 1);
+            const int count = getUint16(request + 3);
+            if (count < 1 || count > MODBUS_MAX_WRITE_BITS || request[5] != (count + 7) / 8 ||
+                length < 6 + request[5]) {
+                return exceptionResponse(functionCode, MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE, response);
+            }
+            if (!inRange(address, count, coils_.size())) {
+                return exceptionResponse(functionCode, MODBUS_EXCEPTION_ILLEGAL_DATA_ADDRESS, response);
+            }
+            for (int i = 0; i < count; ++i) {
+                coils_[address + i] = static_cast<uint8_t>((request[6 + i / 8] >> (i % 8)) & 1u);
+            }
+            for (int i = 0; i < 5; ++i) {
+                response[i] = request[i];
+            }
+            return 5;
+        }
+
+        case MODBUS_FC_WRITE_MULTIPLE_REGISTERS: {
+            if (length < 6) {
+                return exceptionResponse(functionCode, MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE, response);
+            }
+            const int address = getUint16(request + 1);
+            const int count = getUint16(request + 3);
+            if (count < 1 || count > MODBUS_MAX_WRITE_REGISTERS || request[5] != count * 2 ||
+                length < 6 + count * 2) {
+                return exceptionResponse(functionCode, MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE, response);
+            }
+            if (!inRange(address, count, holdingRegisters_.size())) {
+                return exceptionResponse(functionCode, MODBUS_EXCEPTION_ILLEGAL_DATA_ADDRESS, response);
+            }
+            for (int i = 0; i < count; ++i) {
+                holdingRegisters_[address + i] = static_cast<uint16_t>(getUint16(request + 6 + 2 * i));
+            }
+            for (int i = 0; i < 5; ++i) {
+                response[i] = request[i];
+            }
+            return 5;
+        }
+
+        case MODBUS_FC_MASK_WRITE_REGISTER: {
+            if (length < 7) {
+                return exceptionResponse(functionCode, MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE, response);
+            }
+            const int address = getUint16(request + 1);
+            if (!inRange(address, 1, holdingRegisters_.size())) {
+                return exceptionResponse(functionCode, MODBUS_EXCEPTION_ILLEGAL_DATA_ADDRESS, response);
+            }
+            const int andMask = getUint16(request + 3);
+            const int orMask = getUint16(request + 5);
+            holdingRegisters_[address] =
+                static_cast<uint16_t>((holdingRegisters_[address] & andMask) | (orMask & ~andMask));
+            for (int i = 0; i < 7; ++i) {
+                response[i] = request[i];
+            }
+            return 7;
+        }
+
+        case MODBUS_FC_WRITE_AND_READ_REGISTERS: {
+            if (length < 10) {
+                return exceptionResponse(functionCode, MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE, response);
+            }
+            const int readAddress = getUint16(request + 1);
+            const int readCount = getUint16(request + 3);
+            const int writeAddress = getUint16(request + 5);
+            const int writeCount = getUint16(request + 7);
+            if (readCount < 1 || readCount > MODBUS_MAX_WR_READ_REGISTERS ||
+                writeCount < 1 || writeCount > MODBUS_MAX_WR_WRITE_REGISTERS ||
+                request[9] != writeCount * 2 || length < 10 + writeCount * 2) {
+                return exceptionResponse(functionCode, MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE, response);
+            }
+            if (!inRange(readAddress, readCount, holdingRegisters_.size()) ||
+                !inRange(writeAddress, writeCount, holdingRegisters_.size())) {
+                return exceptionResponse(functionCode, MODBUS_EXCEPTION_ILLEGAL_DATA_ADDRESS, response);
+            }
+            // The write happens before the read.
+            for (int i = 0; i < writeCount; ++i) {
+                holdingRegisters_[writeAddress + i] = static_cast<uint16_t>(getUint16(request + 10 + 2 * i));
+            }
+            response[0] = functionCode;
+            response[1] = static_cast<uint8_t>(readCount * 2);
+            for (int i = 0; i < readCount; ++i) {
+                putUint16(response + 2 + 2 * i, holdingRegisters_[readAddress + i]);
+            }
+            return 2 + 2 * readCount;
+        }
+
+        case modbusFcReadFileRecord:
+        case modbusFcWriteFileRecord:
+            return processFileRecordRequest(request, length, holdingRegisters_.data(),
+                                            static_cast<int>(holdingRegisters_.size()), response);
+
+        default:
+            return exceptionResponse(functionCode, MODBUS_EXCEPTION_ILLEGAL_FUNCTION, response);
+    }
+}
+
+std::vector<uint8_t>& test_modbus_485::ModbusDataModel::coils() {
+    return coils_;
+}
+
+std::vector<uint8_t>& test_modbus_485::ModbusDataModel::discreteInputs() {
+    return discreteInputs_;
+}
+
+std::vector<uint16_t>& test_modbus_485::ModbusDataModel::holdingRegisters() {
+    return holdingRegisters_;
+}
+
+std::vector<uint16_t>& test_modbus_485::ModbusDataModel::inputRegisters() {
+    return inputRegisters_;
+}
+
+std::mutex& test_modbus_485::ModbusDataModel::mutex() {
+    return mutex_;
+}
@@ -0,0 +1,328 @@
+// src/modbus_fault_bench.cpp
+//
+// Recovery benchmark: a ModbusUtils master polls a simulated slave every
+// --period-ms through ModbusFaultProxy, which injects each selected line
+// fault --repeat times. Per fault type it reports the cycles lost (failed
+// transactions plus releases missed while a call was still recovering),
+// the time from the fault clearing to the first good transaction, and the
+// whole outage from injection. The exit status is 1 if a fault was not
+// recovered from, or took longer than --max-recovery-ms, so the numbers
+// can gate a regression run.
+//
+// usage: modbus_fault_bench [--faults=crc,drop,dup,truncate,gap,stall,port] [--repeat=N]
+//                           [--baud=N] [--period-ms=N] [--gap-ms=N] [--stall-ms=N]
+//                           [--port-loss-ms=N] [--max-recovery-ms=N] [--link=PATH] [--csv]
+
+#include "modbus_fault_proxy.h"
+#include "modbus_pty.h"
+#include "modbus_slave_simulator.h"
+#include "modbus_utils.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace std::chrono;
+
+namespace {
+
+struct FaultBenchOptions {
+    std::vector<test_modbus_485::ModbusFault> faults;
+    int                                       repeat = 5;
+    int                                       baudRate = 115200;
+    milliseconds                              period{20};
+    test_modbus_485::ModbusFaultOptions       fault;
+    milliseconds                              maximumRecovery{0};   ///< 0: report only.
+    std::string                               linkPath;
+    bool                                      csv = false;
+};
+
+struct FaultResult {
+    test_modbus_485::ModbusFault fault;
+    int                          injections = 0;
+    int                          recovered = 0;
+    std::vector<long long>       lostCycles;
+    std::vector<double>          recoveryMilliseconds;   ///< Fault cleared to first good transaction.
+    std::vector<double>          outageMilliseconds;     ///< Injection to first good transaction.
+};
+
+constexpr int registerCount = 10;
+constexpr int warmupCycles = 10;
+constexpr seconds recoveryLimit{15};
+
+/**
+ * @brief Fixed-rate polling cycle; releases missed by a long call are counted, not caught up.
+ */
+class PollingCycle {
+public:
+    PollingCycle(test_modbus_485::ModbusUtils& modbus, modbus_t*& contextReference, milliseconds period)
+        : modbus_(modbus),
+          context_(contextReference),
+          period_(period),
+          next_(steady_clock::now()) {}
+
+    /**
+     * @brief Wait for the next release and poll once.
+     * @param[out] missed Releases that passed during the call.
+     * @return True if the poll succeeded.
+     */
+    bool run(long long& missed) {
+        std::this_thread::sleep_until(next_);
+        const bool good = modbus_.readHoldingRegisters(context_, 0, registerCount, registers_) == registerCount;
+        next_ += period_;
+        missed = 0;
+        const steady_clock::time_point now = steady_clock::now();
+        if (now >= next_) {
+            missed = (now - next_) / period_ + 1;
+            next_ += missed * period_;
+        }
+        return good;
+    }
+
+private:
+    test_modbus_485::ModbusUtils& modbus_;
+    modbus_t*&                    context_;
+    milliseconds                  period_;
+    steady_clock::time_point      next_;
+    uint16_t                      registers_[registerCount];
+};
+
+std::vector<std::string> splitList(const char* text) {
+    std::vector<std::string> items;
+    std::string item;
+    for (const char* p = text;; ++p) {
+        if (*p == ',' || *p == '\0') {
+            if (!item.empty()) {
+                items.push_back(item);
+            }
+            item.clear();
+            if (*p == '\0') {
+                break;
+            }
+        } else {
+            item += *p;
+        }
+    }
+    return items;
+}
+
+bool parseArguments(int argc, char** argv, FaultBenchOptions& options) {
+    for (int i = 1; i < argc; ++i) {
+        const char* argument = argv[i];
+        if (std::strncmp(argument, "--faults=", 9) == 0) {
+            options.faults.clear();
+            for (const std::string& name : splitList(argument + 9)) {
+                test_modbus_485::ModbusFault fault;
+                if (!test_modbus_485::parseModbusFault(name, fault)) {
+                    std::cerr << "unknown fault " << name << "\n";
+                    return false;
+                }
+                options.faults.push_back(fault);
+            }
+        } else if (std::strncmp(argument, "--repeat=", 9) == 0) {
+            options.repeat = std::max(1, std::atoi(argument + 9));
+        } else if (std::strncmp(argument, "--baud=", 7) == 0) {
+            options.baudRate = std::atoi(argument + 7);
+        } else if (std::strncmp(argument, "--period-ms=", 12) == 0) {
+            options.period = milliseconds(std::max(1, std::atoi(argument + 12)));
+        } else if (std::strncmp(argument, "--gap-ms=", 9) == 0) {
+            options.fault.stretchedGap = milliseconds(std::atoi(argument + 9));
+        } else if (std::strncmp(argument, "--stall-ms=", 11) == 0) {
+            options.fault.stallDuration = milliseconds(std::atoi(argument + 11));
+        } else if (std::strncmp(argument, "--port-loss-ms=", 15) == 0) {
+            options.fault.portLossDuration = milliseconds(std::atoi(argument + 15));
+        } else if (std::strncmp(argument, "--max-recovery-ms=", 18) == 0) {
+            options.maximumRecovery = milliseconds(std::atoi(argument + 18));
+        } else if (std::strncmp(argument, "--link=", 7) == 0) {
+            options.linkPath = argument + 7;
+        } else if (std::strcmp(argument, "--csv") == 0) {
+            options.csv = true;
+        } else {
+            std::cerr << "usage: modbus_fault_bench [--faults=crc,drop,dup,truncate,gap,stall,port] [--repeat=N]\n"
+                         "                          [--baud=N] [--period-ms=N] [--gap-ms=N] [--stall-ms=N]\n"
+                         "                          [--port-loss-ms=N] [--max-recovery-ms=N] [--link=PATH] [--csv]\n";
+            return false;
+        }
+    }
+    if (options.faults.empty()) {
+        for (int i = 0; i < test_modbus_485::modbusFaultCount; ++i) {
+            options.faults.push_back(static_cast<test_modbus_485::ModbusFault>(i));
+        }
+    }
+    if (options.linkPath.empty()) {
+        options.linkPath = "/tmp/modbus_fault_bench." + std::to_string(getpid());
+    }
+    return true;
+}
+
+double mean(const std::vector<double>& values) {
+    double sum = 0.0;
+    for (double value : values) {
+        sum += value;
+    }
+    return values.empty() ? 0.0 : sum / static_cast<double>(values.size());
+}
+
+double maximum(const std::vector<double>& values) {
+    return values.empty() ? 0.0 : *std::max_element(values.begin(), values.end());
+}
+
+double toMilliseconds(steady_clock::duration duration) {
+    return duration_cast<microseconds>(duration).count() / 1000.0;
+}
+
+/**
+ * @brief Inject one fault and poll until the first good transaction after it cleared.
+ * @return False if polling did not settle before the injection, or the master
+ *         did not recover, within recoveryLimit.
+ */
+bool measure(test_modbus_485::ModbusFaultProxy& proxy, PollingCycle& cycle, FaultResult& result) {
+    const char* faultName = test_modbus_485::modbusFaultName(result.fault);
+    long long missed = 0;
+    const steady_clock::time_point settleDeadline = steady_clock::now() + recoveryLimit;
+    for (int good = 0; good < warmupCycles;) {
+        good = cycle.run(missed) && missed == 0 ? good + 1 : 0;
+        if (good < warmupCycles && steady_clock::now() > settleDeadline) {
+            std::cerr << "no " << warmupCycles << " clean cycles before " << faultName << " within "
+                      << recoveryLimit.count() << " s\n";
+            return false;
+        }
+    }
+    ++result.injections;
+    proxy.inject(result.fault);
+
+    long long lost = 0;
+    for (;;) {
+        const bool good = cycle.run(missed);
+        const steady_clock::time_point finished = steady_clock::now();
+        lost += missed + (good ? 0 : 1);
+        const test_modbus_485::ModbusFaultEvent event = proxy.lastFault();
+        if (good && !event.active) {
+            ++result.recovered;
+            result.lostCycles.push_back(lost);
+            result.recoveryMilliseconds.push_back(toMilliseconds(finished - std::max(event.cleared, event.injected)));
+            result.outageMilliseconds.push_back(toMilliseconds(finished - event.injected));
+            return true;
+        }
+        if (finished - event.injected > recoveryLimit) {
+            std::cerr << "no recovery from " << faultName << " within " << recoveryLimit.count() << " s\n";
+            result.lostCycles.push_back(lost);
+            return false;
+        }
+    }
+}
+
+void printResults(const std::vector<FaultResult>& results, bool csv) {
+    if (csv) {
+        std::cout << "fault,injections,recovered,lost_cycles_mean,lost_cycles_max,"
+                     "recovery_ms_mean,recovery_ms_max,outage_ms_mean,outage_ms_max\n";
+    } else {
+        std::cout << std::left << std::setw(10) << "fault" << std::right
+                  << std::setw(6) << "runs" << std::setw(6) << "ok"
+                  << std::setw(18) << "lost cycles"
+                  << std::setw(26) << "recovery ms (mean/max)"
+                  << std::setw(24) << "outage ms (mean/max)" << "\n";
+    }
+    for (const FaultResult& result : results) {
+        std::vector<double> lost(result.lostCycles.begin(), result.lostCycles.end());
+        if (csv) {
+            std::cout << test_modbus_485::modbusFaultName(result.fault) << "," << result.injections << ","
+                      << result.recovered << "," << mean(lost) << "," << maximum(lost) << ","
+                      << mean(result.recoveryMilliseconds) << "," << maximum(result.recoveryMilliseconds) << ","
+                      << mean(result.outageMilliseconds) << "," << maximum(result.outageMilliseconds) << "\n";
+            continue;
+        }
+        std::ostringstream lostText, recoveryText, outageText;
+        lostText << std::fixed << std::setprecision(1) << mean(lost) << "/" << std::setprecision(0) << maximum(lost);
+        recoveryText << std::fixed << std::setprecision(1) << mean(result.recoveryMilliseconds) << "/"
+                     << maximum(result.recoveryMilliseconds);
+        outageText << std::fixed << std::setprecision(1) << mean(result.outageMilliseconds) << "/"
+                   << maximum(result.outageMilliseconds);
+        std::cout << std::left << std::setw(10) << test_modbus_485::modbusFaultName(result.fault) << std::right
+                  << std::setw(6) << result.injections << std::setw(6) << result.recovered
+                  << std::setw(18) << lostText.str()
+                  << std::setw(26) << recoveryText.str()
+                  << std::setw(24) << outageText.str() << "\n";
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    FaultBenchOptions options;
+    if (!parseArguments(argc, argv, options)) {
+        return 1;
+    }
+
+    // Slave side: simulator on one pty pair, the proxy on its other end.
+    int simulatorFileDescriptor = -1;
+    std::string simulatorPath;
+    if (!test_modbus_485::openPtyPair(simulatorFileDescriptor, simulatorPath)) {
+        return 1;
+    }
+    test_modbus_485::ModbusSlaveSimulator simulator;
+    test_modbus_485::ModbusSimulatorOptions simulatorOptions;
+    simulatorOptions.baudRate = options.baudRate;
+    simulator.addSlave(1, 16, 16);
+    const int proxyFileDescriptor = ::open(simulatorPath.c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (proxyFileDescriptor < 0 || !test_modbus_485::configureRtuLine(proxyFileDescriptor, options.baudRate, 'N', 8, 1) ||
+        !simulator.start(simulatorFileDescriptor, simulatorOptions)) {
+        std::cerr << "cannot set up the simulated slave\n";
+        return 1;
+    }
+    test_modbus_485::ModbusFaultProxy proxy;
+    if (!proxy.start(options.linkPath, proxyFileDescriptor, options.baudRate, options.fault)) {
+        return 1;
+    }
+
+    test_modbus_485::ModbusUtils modbus;
+    modbus_t* context = nullptr;
+    if (!modbus.openRtu(context, options.linkPath, options.baudRate, 'N', 8, 1, 1)) {
+        std::cerr << "cannot open " << options.linkPath << "\n";
+        return 1;
+    }
+    PollingCycle cycle(modbus, context, options.period);
+
+    std::vector<FaultResult> results;
+    bool passed = true;
+    for (test_modbus_485::ModbusFault fault : options.faults) {
+        FaultResult result;
+        result.fault = fault;
+        for (int i = 0; i < options.repeat; ++i) {
+            if (!measure(proxy, cycle, result)) {
+                passed = false;
+                break;
+            }
+        }
+        if (options.maximumRecovery.count() > 0 &&
+            maximum(result.recoveryMilliseconds) > static_cast<double>(options.maximumRecovery.count())) {
+            passed = false;
+        }
+        results.push_back(result);
+    }
+
+    if (!options.csv) {
+        std::cout << "period " << options.period.count() << " ms, " << options.baudRate << " baud, "
+                  << options.repeat << " injections per fault\n";
+    }
+    printResults(results, options.csv);
+    if (!options.csv) {
+        std::cout << "Transactions:\n";
+        modbus.metrics().snapshot().print(std::cout);
+    }
+
+    modbus.closeRtu(context);
+    proxy.stop();
+    simulator.stop();
+    ::close(proxyFileDescriptor);
+    ::close(simulatorFileDescriptor);
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,308 @@
+// src/modbus_fault_proxy.cpp
+
+#include "modbus_fault_proxy.h"
+#include "modbus_pty.h"
+#include "modbus_rtu_codec.h"
+#include "modbus_timing.h"
+#include <modbus.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <poll.h>
+#include <unistd.h>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+const char* const faultNames[test_modbus_485::modbusFaultCount] = {
+    "crc", "drop", "dup", "truncate", "gap", "stall", "port"};
+
+bool isFrameFault(test_modbus_485::ModbusFault fault) {
+    return fault != test_modbus_485::ModbusFault::SlaveStall && fault != test_modbus_485::ModbusFault::PortLoss;
+}
+
+/**
+ * @brief Write everything to a non-blocking descriptor; false if its peer is gone.
+ */
+bool writeAll(int fileDescriptor, const uint8_t* data, int length) {
+    while (length > 0) {
+        ssize_t written = ::write(fileDescriptor, data, static_cast<size_t>(length));
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN) {
+                pollfd descriptor{fileDescriptor, POLLOUT, 0};
+                ::poll(&descriptor, 1, 10);
+                continue;
+            }
+            return false;
+        }
+        data += written;
+        length -= static_cast<int>(written);
+    }
+    return true;
+}
+
+} // namespace
+
+const char* test_modbus_485::modbusFaultName(ModbusFault fault) {
+    return faultNames[static_cast<int>(fault)];
+}
+
+bool test_modbus_485::parseModbusFault(const std::string& name, ModbusFault& fault) {
+    for (int i = 0; i < modbusFaultCount; ++i) {
+        if (name == faultNames[i]) {
+            fault = static_cast<ModbusFault>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+test_modbus_485::ModbusFaultProxy::ModbusFaultProxy()
+    : masterFileDescriptor_(-1),
+      slaveFileDescriptor_(-1) {}
+
+test_modbus_485::ModbusFaultProxy::~ModbusFaultProxy() {
+    stop();
+}
+
+bool test_modbus_485::ModbusFaultProxy::start(const std::string& linkPath,
+                                              int slaveFileDescriptor,
+                                              int baudRate,
+                                              const ModbusFaultOptions& options) {
+    if (running_.load()) {
+        return false;
+    }
+    linkPath_ = linkPath;
+    slaveFileDescriptor_ = slaveFileDescriptor;
+    frameGap_ = interFrameDelay(baudRate, 10);
+    options_ = options;
+    fault_ = ModbusFaultEvent();
+    armed_ = false;
+    if (!openMasterPort()) {
+        return false;
+    }
+    running_.store(true);
+    thread_ = std::thread(&ModbusFaultProxy::run, this);
+    return true;
+}
+
+void test_modbus_485::ModbusFaultProxy::stop() {
+    if (running_.exchange(false) && thread_.joinable()) {
+        thread_.join();
+    }
+    closeMasterPort();
+}
+
+bool test_modbus_485::ModbusFaultProxy::inject(ModbusFault fault) {
+    std::lock_guard<std::mutex> lock(faultMutex_);
+    if (fault_.active) {
+        return false;
+    }
+    fault_.fault = fault;
+    fault_.injected = Clock::now();
+    fault_.active = true;
+    if (fault == ModbusFault::SlaveStall) {
+        stallUntil_ = fault_.injected + options_.stallDuration;
+        ++faultCounts_[static_cast<int>(fault)];
+    } else {
+        // Frame faults wait for a response; the port is closed by the forwarding thread.
+        armed_ = true;
+    }
+    return true;
+}
+
+test_modbus_485::ModbusFaultEvent test_modbus_485::ModbusFaultProxy::lastFault() const {
+    std::lock_guard<std::mutex> lock(faultMutex_);
+    return fault_;
+}
+
+const std::string& test_modbus_485::ModbusFaultProxy::linkPath() const {
+    return linkPath_;
+}
+
+uint64_t test_modbus_485::ModbusFaultProxy::responseCount() const {
+    return responses_.load(std::memory_order_relaxed);
+}
+
+std::array<uint64_t, test_modbus_485::modbusFaultCount> test_modbus_485::ModbusFaultProxy::faultCounts() const {
+    std::lock_guard<std::mutex> lock(faultMutex_);
+    return faultCounts_;
+}
+
+bool test_modbus_485::ModbusFaultProxy::openMasterPort() {
+    std::string devicePath;
+    if (!openPtyPair(masterFileDescriptor_, devicePath)) {
+        return false;
+    }
+    ::unlink(linkPath_.c_str());
+    if (::symlink(devicePath.c_str(), linkPath_.c_str()) != 0) {
+        perror("[ModbusFaultProxy] symlink");
+        ::close(masterFileDescriptor_);
+        masterFileDescriptor_ = -1;
+        return false;
+    }
+    return true;
+}
+
+void test_modbus_485::ModbusFaultProxy::closeMasterPort() {
+    if (masterFileDescriptor_ == -1) {
+        return;
+    }
+    ::unlink(linkPath_.c_str());
+    ::close(masterFileDescriptor_);
+    masterFileDescriptor_ = -1;
+}
+
+void test_modbus_485::ModbusFaultProxy::run() {
+    uint8_t request[MODBUS_RTU_MAX_ADU_LENGTH];
+    uint8_t response[2 * MODBUS_RTU_MAX_ADU_LENGTH];
+    int responseLength = 0;
+    Clock::time_point lastResponseByte;
+
+    while (running_.load()) {
+        bool stalled = false;
+        {
+            std::lock_guard<std::mutex> lock(faultMutex_);
+            const Clock::time_point now = Clock::now();
+            if (fault_.active && fault_.fault == ModbusFault::PortLoss) {
+                if (armed_) {
+                    armed_ = false;
+                    closeMasterPort();
+                    fault_.injected = now;
+                    portBackAt_ = now + options_.portLossDuration;
+                    ++faultCounts_[static_cast<int>(ModbusFault::PortLoss)];
+                } else if (masterFileDescriptor_ == -1 && now >= portBackAt_) {
+                    if (openMasterPort()) {
+                        clearFault();
+                    } else {
+                        portBackAt_ = now + std::chrono::milliseconds(100);
+                    }
+                }
+            }
+            if (fault_.active && fault_.fault == ModbusFault::SlaveStall) {
+                stalled = now < stallUntil_;
+                if (!stalled) {
+                    clearFault();
+                }
+            }
+        }
+
+        pollfd descriptors[2] = {{masterFileDescriptor_, POLLIN, 0}, {slaveFileDescriptor_, POLLIN, 0}};
+        int ready = ::poll(descriptors, 2, responseLength > 0 ? 1 : 5);
+        if (ready < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("[ModbusFaultProxy] poll");
+            break;
+        }
+
+        if (descriptors[0].revents & POLLIN) {
+            ssize_t received = ::read(masterFileDescriptor_, request, sizeof(request));
+            if (received > 0 && !stalled) {
+                writeAll(slaveFileDescriptor_, request, static_cast<int>(received));
+            } else if (received < 0 && errno == EIO) {
+                ::usleep(1000);
+            }
+        } else if (descriptors[0].revents & (POLLHUP | POLLERR)) {
+            // No master has the port open, e.g. while it reconnects.
+            ::usleep(1000);
+        }
+
+        if (descriptors[1].revents & POLLIN) {
+            ssize_t received = ::read(slaveFileDescriptor_, response + responseLength,
+                                      sizeof(response) - static_cast<size_t>(responseLength));
+            if (received > 0) {
+                responseLength += static_cast<int>(received);
+                lastResponseByte = Clock::now();
+            }
+        }
+        while (responseLength > 0) {
+            const int frameLength = rtuResponseLength(response, responseLength);
+            if (frameLength < 0 || frameLength > MODBUS_RTU_MAX_ADU_LENGTH) {
+                // Not a response we can frame: pass it through untouched.
+                writeMaster(response, responseLength);
+                responseLength = 0;
+                break;
+            }
+            if (frameLength == 0 || responseLength < frameLength) {
+                break;
+            }
+            forwardResponse(response, frameLength);
+            responseLength -= frameLength;
+            std::memmove(response, response + frameLength, static_cast<size_t>(responseLength));
+        }
+        // A partial response followed by t3.5 of silence goes out as it is.
+        if (responseLength > 0 && Clock::now() - lastResponseByte > frameGap_) {
+            writeMaster(response, responseLength);
+            responseLength = 0;
+        }
+    }
+}
+
+void test_modbus_485::ModbusFaultProxy::forwardResponse(const uint8_t* frame, int length) {
+    responses_.fetch_add(1, std::memory_order_relaxed);
+    ModbusFault fault;
+    {
+        std::lock_guard<std::mutex> lock(faultMutex_);
+        if (!armed_ || !isFrameFault(fault_.fault)) {
+            fault = ModbusFault::SlaveStall;
+        } else {
+            fault = fault_.fault;
+            armed_ = false;
+            // The fault starts with this frame, not when it was armed.
+            fault_.injected = Clock::now();
+        }
+    }
+    if (!isFrameFault(fault)) {
+        writeMaster(frame, length);
+        return;
+    }
+
+    uint8_t faulty[MODBUS_RTU_MAX_ADU_LENGTH + 1];
+    const int middle = length / 2;
+    switch (fault) {
+        case ModbusFault::CorruptCrc:
+            std::memcpy(faulty, frame, static_cast<size_t>(length));
+            faulty[length - 1] ^= 0x01;
+            writeMaster(faulty, length);
+            break;
+        case ModbusFault::DropByte:
+            std::memcpy(faulty, frame, static_cast<size_t>(middle));
+            std::memcpy(faulty + middle, frame + middle + 1, static_cast<size_t>(length - middle - 1));
+            writeMaster(faulty, length - 1);
+            break;
+        case ModbusFault::DuplicateByte:
+            std::memcpy(faulty, frame, static_cast<size_t>(middle + 1));
+            std::memcpy(faulty + middle + 1, frame + middle, static_cast<size_t>(length - middle));
+            writeMaster(faulty, length + 1);
+            break;
+        case ModbusFault::Truncate:
+            writeMaster(frame, middle);
+            break;
+        case ModbusFault::StretchGap:
+            writeMaster(frame, middle);
+            std::this_thread::sleep_for(options_.stretchedGap);
+            writeMaster(frame + middle, length - middle);
+            break;
+        default:
+            break;
+    }
+    std::lock_guard<std::mutex> lock(faultMutex_);
+    ++faultCounts_[static_cast<int>(fault)];
+    clearFault();
+}
+
+bool test_modbus_485::ModbusFaultProxy::writeMaster(const uint8_t* data, int length) {
+    // Without a master on the port the bytes are lost, as on a dead line.
+    return masterFileDescriptor_ != -1 && writeAll(masterFileDescriptor_, data, length);
+}
+
+void test_modbus_485::ModbusFaultProxy::clearFault() {
+    fault_.cleared = Clock::now();
+    fault_.active = false;
+}
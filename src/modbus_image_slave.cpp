@@ -0,0 +1,136 @@
+// src/modbus_image_slave.cpp
+
+#include "modbus_image_slave.h"
+#include "modbus_rtu_codec.h"
+#include "modbus_timing.h"
+#include <modbus.h>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <poll.h>
+#include <unistd.h>
+
+test_modbus_485::ModbusImageSlave::ModbusImageSlave(ModbusRegisterImage& image, int slaveIdentifier)
+    : image_(image),
+      slaveIdentifier_(slaveIdentifier),
+      fileDescriptor_(-1),
+      frameSilence_(0),
+      running_(false),
+      requests_(0),
+      dropped_(0) {}
+
+test_modbus_485::ModbusImageSlave::~ModbusImageSlave() {
+    stop();
+}
+
+bool test_modbus_485::ModbusImageSlave::start(int fileDescriptor, int baudRate, int bitsPerCharacter) {
+    if (running_.load()) {
+        std::cerr << "[start] already running\n";
+        return false;
+    }
+    if (slaveIdentifier_ < 1 || slaveIdentifier_ > 247) {
+        std::cerr << "[start] invalid slave " << slaveIdentifier_ << "\n";
+        return false;
+    }
+    fileDescriptor_ = fileDescriptor;
+    frameSilence_ = interFrameDelay(baudRate, bitsPerCharacter);
+    running_.store(true);
+    thread_ = std::thread(&ModbusImageSlave::run, this);
+    return true;
+}
+
+void test_modbus_485::ModbusImageSlave::stop() {
+    running_.store(false);
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+test_modbus_485::ModbusImageSlaveStatistics test_modbus_485::ModbusImageSlave::statistics() const {
+    ModbusImageSlaveStatistics statistics;
+    statistics.requests = requests_.load(std::memory_order_relaxed);
+    statistics.dropped = dropped_.load(std::memory_order_relaxed);
+    statistics.turnaround = turnaround_.snapshot();
+    return statistics;
+}
+
+void test_modbus_485::ModbusImageSlave::run() {
+    uint8_t buffer[2 * MODBUS_RTU_MAX_ADU_LENGTH];
+    uint8_t response[MODBUS_RTU_MAX_ADU_LENGTH];
+    int length = 0;
+    // t3.5 of silence ends a partial frame; poll() counts whole milliseconds, so round up.
+    const int frameSilenceMilliseconds =
+        static_cast<int>(std::chrono::ceil<std::chrono::milliseconds>(frameSilence_).count());
+
+    while (running_.load(std::memory_order_relaxed)) {
+        pollfd descriptor{fileDescriptor_, POLLIN, 0};
+        int ready = ::poll(&descriptor, 1, length > 0 ? frameSilenceMilliseconds : 50);
+        if (ready < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("[ModbusImageSlave] poll");
+            break;
+        }
+        if (ready == 0) {
+            if (length > 0) {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                length = 0;
+            }
+            continue;
+        }
+
+        ssize_t received = ::read(fileDescriptor_, buffer + length, sizeof(buffer) - length);
+        if (received < 0) {
+            if (errno == EAGAIN || errno == EINTR) {
+                continue;
+            }
+            if (errno == EIO) {
+                // pty master with no slave end open: wait for the master to connect.
+                ::usleep(10000);
+                continue;
+            }
+            perror("[ModbusImageSlave] read");
+            break;
+        }
+        const auto arrived = std::chrono::steady_clock::now();
+        length += static_cast<int>(received);
+
+        while (length > 0) {
+            const int frameLength = rtuRequestLength(buffer, length);
+            if (frameLength < 0 || frameLength > MODBUS_RTU_MAX_ADU_LENGTH) {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                length = 0;
+                break;
+            }
+            if (frameLength == 0 || length < frameLength) {
+                break;
+            }
+            const int target = buffer[0];
+            if (!checkCrc(buffer, frameLength) || (target != slaveIdentifier_ && target != MODBUS_BROADCAST_ADDRESS)) {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+            } else {
+                const int pduLength = image_.process(buffer + 1, frameLength - 3, response + 1);
+                // Broadcasts are applied but never answered.
+                if (target != MODBUS_BROADCAST_ADDRESS && pduLength > 0) {
+                    response[0] = static_cast<uint8_t>(slaveIdentifier_);
+                    const int responseLength = appendCrc(response, pduLength + 1);
+                    for (int written = 0; written < responseLength;) {
+                        const ssize_t chunk = ::write(fileDescriptor_, response + written, responseLength - written);
+                        if (chunk < 0 && errno != EAGAIN && errno != EINTR) {
+                            perror("[ModbusImageSlave] write");
+                            break;
+                        }
+                        written += chunk > 0 ? static_cast<int>(chunk) : 0;
+                    }
+                    turnaround_.record(std::chrono::steady_clock::now() - arrived);
+                }
+                requests_.fetch_add(1, std::memory_order_relaxed);
+            }
+            std::memmove(buffer, buffer + frameLength, length - frameLength);
+            length -= frameLength;
+        }
+    }
+}
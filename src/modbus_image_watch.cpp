@@ -0,0 +1,160 @@
+// src/modbus_image_watch.cpp
+//
+// Reads the shared process image a poller publishes (e.g. serial_modbus_master
+// with a shm name) without touching the bus. Prints every block with its
+// generation and age, once or every --interval ms; --bench times reads of
+// the first register block instead.
+//
+// usage: modbus_image_watch <shm-name> [--interval=ms] [--bench]
+
+#include "modbus_shared_image.h"
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+volatile std::sig_atomic_t stopRequested = 0;
+
+void onSignal(int) {
+    stopRequested = 1;
+}
+
+const char* tableName(int table) {
+    switch (static_cast<test_modbus_485::ModbusTable>(table)) {
+        case test_modbus_485::ModbusTable::Coils: return "coils";
+        case test_modbus_485::ModbusTable::DiscreteInputs: return "inputs";
+        case test_modbus_485::ModbusTable::HoldingRegisters: return "holding";
+        case test_modbus_485::ModbusTable::InputRegisters: return "input-regs";
+    }
+    return "?";
+}
+
+bool isBitTable(int table) {
+    return static_cast<test_modbus_485::ModbusTable>(table) == test_modbus_485::ModbusTable::Coils ||
+           static_cast<test_modbus_485::ModbusTable>(table) == test_modbus_485::ModbusTable::DiscreteInputs;
+}
+
+void printImage(const test_modbus_485::ModbusSharedImageReader& reader) {
+    std::vector<uint16_t> registers;
+    std::vector<uint8_t> bits;
+    const uint64_t now = test_modbus_485::ModbusSharedImageWriter::now();
+    const int blocks = reader.blockCount();
+    for (int i = 0; i < blocks; ++i) {
+        const test_modbus_485::shared_image_format::BlockHeader& header = reader.blockHeader(i);
+        const int start = static_cast<int>(header.startAddress);
+        const int count = static_cast<int>(header.count);
+        test_modbus_485::ModbusSharedStamp stamp{};
+        std::cout << "slave " << std::setw(3) << int(header.slaveIdentifier) << " " << std::setw(10)
+                  << tableName(header.table) << " @" << std::setw(5) << start << " x" << std::setw(3) << count;
+        if (isBitTable(header.table)) {
+            bits.resize(header.count);
+            reader.readBits(i, start, count, bits.data(), &stamp);
+        } else {
+            registers.resize(header.count);
+            reader.readRegisters(i, start, count, registers.data(), &stamp);
+        }
+        std::cout << "  gen " << std::setw(8) << stamp.generation << "  age ";
+        if (stamp.generation == 0) {
+            std::cout << "     -";
+        } else {
+            std::cout << std::setw(6) << (now > stamp.timestamp ? (now - stamp.timestamp) / 1000000 : 0) << " ms";
+        }
+        std::cout << "  [";
+        const int shown = count < 16 ? count : 16;
+        for (int k = 0; k < shown; ++k) {
+            std::cout << (k ? " " : "") << (isBitTable(header.table) ? int(bits[k]) : int(registers[k]));
+        }
+        std::cout << (shown < count ? " ...]\n" : "]\n");
+    }
+    if (reader.writerClosed()) {
+        std::cout << "(writer closed)\n";
+    }
+}
+
+int bench(const test_modbus_485::ModbusSharedImageReader& reader) {
+    int block = -1;
+    for (int i = 0; i < reader.blockCount() && block < 0; ++i) {
+        if (!isBitTable(reader.blockHeader(i).table)) {
+            block = i;
+        }
+    }
+    if (block < 0) {
+        std::cerr << "no register block published yet\n";
+        return 1;
+    }
+    const test_modbus_485::shared_image_format::BlockHeader& header = reader.blockHeader(block);
+    const int start = static_cast<int>(header.startAddress);
+    const int count = static_cast<int>(header.count);
+    std::vector<uint16_t> registers(header.count);
+    constexpr int reads = 10000000;
+    uint64_t checksum = 0;
+
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < reads; ++i) {
+        reader.readRegisters(block, start, 1, registers.data());
+        checksum += registers[0];
+    }
+    const double single = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count();
+    begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < reads; ++i) {
+        reader.readRegisters(block, start, count, registers.data());
+        checksum += registers[count - 1];
+    }
+    const double whole = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count();
+
+    std::cout << "block slave " << int(header.slaveIdentifier) << " " << tableName(header.table) << " @" << start
+              << " x" << count << "\n"
+              << std::fixed << std::setprecision(1)
+              << "  one register:  " << single / reads << " ns/read\n"
+              << "  whole block:   " << whole / reads << " ns/read\n"
+              << "  (checksum " << checksum << ")\n";
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "usage: modbus_image_watch <shm-name> [--interval=ms] [--bench]\n";
+        return 1;
+    }
+    int interval = 0;
+    bool benchmark = false;
+    for (int i = 2; i < argc; ++i) {
+        const std::string argument = argv[i];
+        if (argument.rfind("--interval=", 0) == 0) {
+            interval = std::atoi(argument.c_str() + std::strlen("--interval="));
+        } else if (argument == "--bench") {
+            benchmark = true;
+        } else {
+            std::cerr << "unknown option " << argument << "\n";
+            return 1;
+        }
+    }
+
+    test_modbus_485::ModbusSharedImageReader reader;
+    if (!reader.open(argv[1])) {
+        return 1;
+    }
+    if (benchmark) {
+        return bench(reader);
+    }
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+    do {
+        printImage(reader);
+        if (interval > 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(interval));
+            std::cout << "\n";
+        }
+    } while (interval > 0 && !stopRequested && !reader.writerClosed());
+    return 0;
+}
@@ -0,0 +1,125 @@
+// src/modbus_loopback_transport.cpp
+
+#include "modbus_loopback_transport.h"
+#include "modbus_rtu_codec.h"
+#include "modbus_timing.h"
+#include <modbus.h>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+test_modbus_485::ModbusLoopbackTransport::ModbusLoopbackTransport(const ModbusLoopbackOptions& options)
+    : options_(options) {}
+
+bool test_modbus_485::ModbusLoopbackTransport::addSlave(int slaveIdentifier, ModbusDataModel& model) {
+    if (slaveIdentifier < 1 || slaveIdentifier > 247 || slaves_[slaveIdentifier]) {
+        std::cerr << "[addSlave] invalid or duplicate slave " << slaveIdentifier << "\n";
+        return false;
+    }
+    slaves_[slaveIdentifier] = &model;
+    return true;
+}
+
+uint64_t test_modbus_485::ModbusLoopbackTransport::bytesTransferred() const {
+    return bytes_.load(std::memory_order_relaxed);
+}
+
+void test_modbus_485::ModbusLoopbackTransport::holdLine(std::chrono::steady_clock::time_point& clock,
+                                                         std::chrono::nanoseconds duration) const {
+    clock += duration;
+    std::this_thread::sleep_until(clock);
+}
+
+int test_modbus_485::ModbusLoopbackTransport::transact(int slaveIdentifier,
+                                                       const uint8_t* request,
+                                                       int requestLength,
+                                                       uint8_t* response,
+                                                       int responseCapacity) {
+    if (requestLength < 1 || requestLength > MODBUS_MAX_PDU_LENGTH ||
+        slaveIdentifier < 0 || slaveIdentifier > 247) {
+        errno = EINVAL;
+        return -1;
+    }
+    std::chrono::steady_clock::time_point clock = std::chrono::steady_clock::now();
+    const std::chrono::nanoseconds character = characterTime(options_.baudRate, options_.bitsPerCharacter);
+
+    // Master: frame the request.
+    uint8_t requestAdu[MODBUS_RTU_MAX_ADU_LENGTH];
+    requestAdu[0] = static_cast<uint8_t>(slaveIdentifier);
+    std::memcpy(requestAdu + 1, request, requestLength);
+    const int requestAduLength = appendCrc(requestAdu, requestLength + 1);
+    bytes_.fetch_add(requestAduLength, std::memory_order_relaxed);
+    if (options_.emulateWireTime) {
+        holdLine(clock, character * requestAduLength
+                        + interFrameDelay(options_.baudRate, options_.bitsPerCharacter));
+    }
+
+    // Slave: frame, check and answer it like the simulator does.
+    uint8_t responseAdu[MODBUS_RTU_MAX_ADU_LENGTH];
+    ModbusDataModel* model = slaves_[slaveIdentifier];
+    if (rtuRequestLength(requestAdu, requestAduLength) != requestAduLength ||
+        !checkCrc(requestAdu, requestAduLength) ||
+        (slaveIdentifier != MODBUS_BROADCAST_ADDRESS && !model)) {
+        // Nobody answers; the master waits out its response timeout.
+        if (options_.emulateWireTime) {
+            holdLine(clock, responseTimeout_);
+        }
+        errno = ETIMEDOUT;
+        return -1;
+    }
+    if (slaveIdentifier == MODBUS_BROADCAST_ADDRESS) {
+        for (ModbusDataModel* slave : slaves_) {
+            if (slave) {
+                slave->process(requestAdu + 1, requestAduLength - 3, responseAdu + 1);
+            }
+        }
+        return 0;
+    }
+    responseAdu[0] = requestAdu[0];
+    const int pduLength = model->process(requestAdu + 1, requestAduLength - 3, responseAdu + 1);
+    const int responseAduLength = appendCrc(responseAdu, pduLength + 1);
+    bytes_.fetch_add(responseAduLength, std::memory_order_relaxed);
+    std::chrono::nanoseconds replyTime = options_.turnaround;
+    if (options_.emulateWireTime) {
+        replyTime += character * responseAduLength;
+    }
+    if (replyTime.count() > 0) {
+        holdLine(clock, replyTime);
+    }
+
+    // Master: check and unpack the reply.
+    if (!checkCrc(responseAdu, responseAduLength)) {
+        errno = EMBBADCRC;
+        return -1;
+    }
+    if (responseAdu[1] & 0x80) {
+        errno = MODBUS_ENOBASE + responseAdu[2];
+        return -1;
+    }
+    if (pduLength > responseCapacity) {
+        errno = EMBBADDATA;
+        return -1;
+    }
+    std::memcpy(response, responseAdu + 1, pduLength);
+    return pduLength;
+}
+
+void test_modbus_485::ModbusLoopbackTransport::setTimeouts(std::chrono::microseconds responseTimeout,
+                                                           std::chrono::microseconds /*byteTimeout*/) {
+    responseTimeout_ = responseTimeout;
+}
+
+void test_modbus_485::ModbusLoopbackTransport::flush() {}
+
+bool test_modbus_485::ModbusLoopbackTransport::reconnect() {
+    return true;
+}
+
+int test_modbus_485::ModbusLoopbackTransport::baudRate() const {
+    return options_.emulateWireTime ? options_.baudRate : 0;
+}
+
+int test_modbus_485::ModbusLoopbackTransport::bitsPerCharacter() const {
+    return options_.bitsPerCharacter;
+}
@@ -0,0 +1,317 @@
+// src/modbus_metrics.cpp
+
+#include "modbus_metrics.h"
+#include <modbus.h>
+#include <cerrno>
+#include <cstdio>
+#include <iomanip>
+
+namespace {
+
+constexpr int subBucketBits = 3;
+constexpr int subBucketCount = 1 << subBucketBits;
+
+void printEntry(std::ostream& stream, const char* label, const test_modbus_485::ModbusMetricsEntry& entry) {
+    test_modbus_485::LatencySummary summary = entry.latency.summary();
+    stream << "  " << std::left << std::setw(10) << label << std::right
+           << std::setw(10) << summary.count
+           << std::fixed << std::setprecision(0)
+           << std::setw(9) << summary.p50
+           << std::setw(9) << summary.p90
+           << std::setw(9) << summary.p99
+           << std::setw(9) << summary.p999
+           << std::setw(9) << summary.max
+           << std::setw(9) << entry.timeouts
+           << std::setw(6) << entry.crcErrors
+           << std::setw(6) << entry.exceptions
+           << std::setw(6) << entry.otherErrors << "\n";
+}
+
+} // namespace
+
+int test_modbus_485::LatencyHistogram::bucketIndex(uint64_t microseconds) {
+    if (microseconds < static_cast<uint64_t>(subBucketCount)) {
+        return static_cast<int>(microseconds);
+    }
+    if (microseconds > 0xFFFFFFFFull) {
+        microseconds = 0xFFFFFFFFull;
+    }
+    int exponent = 63 - __builtin_clzll(microseconds);
+    int subBucket = static_cast<int>((microseconds >> (exponent - subBucketBits)) & (subBucketCount - 1));
+    return (exponent - subBucketBits + 1) * subBucketCount + subBucket;
+}
+
+uint64_t test_modbus_485::LatencyHistogram::bucketLowerBound(int index) {
+    if (index < subBucketCount) {
+        return static_cast<uint64_t>(index);
+    }
+    int exponent = index / subBucketCount + subBucketBits - 1;
+    uint64_t subBucket = static_cast<uint64_t>(index % subBucketCount);
+    return (subBucketCount + subBucket) << (exponent - subBucketBits);
+}
+
+test_modbus_485::LatencyHistogram::LatencyHistogram() {
+    reset();
+}
+
+void test_modbus_485::LatencyHistogram::record(std::chrono::nanoseconds latency) {
+    uint64_t microseconds = latency.count() > 0 ? static_cast<uint64_t>(latency.count()) / 1000 : 0;
+    buckets_[bucketIndex(microseconds)].fetch_add(1, std::memory_order_relaxed);
+    sumMicroseconds_.fetch_add(microseconds, std::memory_order_relaxed);
+    uint64_t previous = maxMicroseconds_.load(std::memory_order_relaxed);
+    while (microseconds > previous &&
+           !maxMicroseconds_.compare_exchange_weak(previous, microseconds, std::memory_order_relaxed)) {
+    }
+}
+
+void test_modbus_485::LatencyHistogram::reset() {
+    for (std::atomic<uint64_t>& bucket : buckets_) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    sumMicroseconds_.store(0, std::memory_order_relaxed);
+    maxMicroseconds_.store(0, std::memory_order_relaxed);
+}
+
+test_modbus_485::LatencyHistogramSnapshot test_modbus_485::LatencyHistogram::snapshot() const {
+    LatencyHistogramSnapshot result;
+    // The count is taken from the buckets so percentiles stay consistent under concurrent record().
+    for (int i = 0; i < LatencyHistogramSnapshot::bucketCount; ++i) {
+        result.buckets[i] = buckets_[i].load(std::memory_order_relaxed);
+        result.count += result.buckets[i];
+    }
+    result.sumMicroseconds = sumMicroseconds_.load(std::memory_order_relaxed);
+    result.maxMicroseconds = maxMicroseconds_.load(std::memory_order_relaxed);
+    return result;
+}
+
+double test_modbus_485::LatencyHistogramSnapshot::percentile(double quantile) const {
+    if (count == 0) {
+        return 0.0;
+    }
+    uint64_t rank = static_cast<uint64_t>(quantile * static_cast<double>(count) + 0.5);
+    rank = rank < 1 ? 1 : (rank > count ? count : rank);
+    uint64_t seen = 0;
+    for (int i = 0; i < bucketCount; ++i) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            uint64_t lower = LatencyHistogram::bucketLowerBound(i);
+            uint64_t upper = i + 1 < bucketCount ? LatencyHistogram::bucketLowerBound(i + 1) : lower + 1;
+            double middle = (static_cast<double>(lower) + static_cast<double>(upper - 1)) / 2.0;
+            return middle < static_cast<double>(maxMicroseconds) ? middle : static_cast<double>(maxMicroseconds);
+        }
+    }
+    return static_cast<double>(maxMicroseconds);
+}
+
+test_modbus_485::LatencySummary test_modbus_485::LatencyHistogramSnapshot::summary() const {
+    LatencySummary result{};
+    result.count = count;
+    result.mean = count ? static_cast<double>(sumMicroseconds) / static_cast<double>(count) : 0.0;
+    result.p50 = percentile(0.50);
+    result.p90 = percentile(0.90);
+    result.p99 = percentile(0.99);
+    result.p999 = percentile(0.999);
+    result.max = static_cast<double>(maxMicroseconds);
+    return result;
+}
+
+void test_modbus_485::ModbusMetricsSnapshot::print(std::ostream& stream) const {
+    std::ios::fmtflags flags = stream.flags();
+    std::streamsize precision = stream.precision();
+
+    stream << "  " << std::left << std::setw(10) << "(us)" << std::right
+           << std::setw(10) << "count"
+           << std::setw(9) << "p50"
+           << std::setw(9) << "p90"
+           << std::setw(9) << "p99"
+           << std::setw(9) << "p99.9"
+           << std::setw(9) << "max"
+           << std::setw(9) << "timeout"
+           << std::setw(6) << "crc"
+           << std::setw(6) << "exc"
+           << std::setw(6) << "other" << "\n";
+    for (const ModbusMetricsEntry& entry : functions) {
+        char label[16];
+        std::snprintf(label, sizeof(label), "FC%02X", entry.key);
+        printEntry(stream, label, entry);
+    }
+    for (const ModbusMetricsEntry& entry : slaves) {
+        char label[16];
+        std::snprintf(label, sizeof(label), "slave %d", entry.key);
+        printEntry(stream, label, entry);
+    }
+    printEntry(stream, "total", total);
+    const ModbusRecoveryEntry* recoveries[] = {&resync, &reopen};
+    const char* recoveryNames[] = {"resync", "reopen"};
+    for (int i = 0; i < 2; ++i) {
+        LatencySummary summary = recoveries[i]->duration.summary();
+        stream << "  " << std::left << std::setw(10) << recoveryNames[i] << std::right
+               << std::setw(10) << summary.count
+               << std::fixed << std::setprecision(0)
+               << std::setw(9) << summary.p50
+               << std::setw(9) << summary.p90
+               << std::setw(9) << summary.p99
+               << std::setw(9) << summary.p999
+               << std::setw(9) << summary.max
+               << "  recovered " << recoveries[i]->recovered
+               << ", failed " << recoveries[i]->failed << "\n";
+    }
+    stream << "  reconnects: " << reconnects << " (" << reconnectFailures << " failed)\n";
+
+    stream.flags(flags);
+    stream.precision(precision);
+}
+
+test_modbus_485::ModbusMetrics::ModbusMetrics()
+    : reconnects_(0),
+      reconnectFailures_(0) {
+    for (std::atomic<Counters*>& entry : functions_) {
+        entry.store(nullptr, std::memory_order_relaxed);
+    }
+    for (std::atomic<Counters*>& entry : slaves_) {
+        entry.store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+test_modbus_485::ModbusMetrics::~ModbusMetrics() {
+    for (std::atomic<Counters*>& entry : functions_) {
+        delete entry.load(std::memory_order_relaxed);
+    }
+    for (std::atomic<Counters*>& entry : slaves_) {
+        delete entry.load(std::memory_order_relaxed);
+    }
+}
+
+test_modbus_485::ModbusMetrics::Counters* test_modbus_485::ModbusMetrics::slot(std::atomic<Counters*>& entry) {
+    Counters* counters = entry.load(std::memory_order_acquire);
+    if (counters) {
+        return counters;
+    }
+    Counters* created = new Counters();
+    if (entry.compare_exchange_strong(counters, created, std::memory_order_acq_rel)) {
+        return created;
+    }
+    // Another thread installed its copy first.
+    delete created;
+    return counters;
+}
+
+void test_modbus_485::ModbusMetrics::record(Counters& counters, std::chrono::nanoseconds latency, int errorCode) {
+    counters.latency.record(latency);
+    if (errorCode == 0) {
+        return;
+    }
+    if (errorCode == ETIMEDOUT) {
+        counters.timeouts.fetch_add(1, std::memory_order_relaxed);
+    } else if (errorCode == EMBBADCRC) {
+        counters.crcErrors.fetch_add(1, std::memory_order_relaxed);
+    } else if (errorCode >= EMBXILFUN && errorCode <= EMBXGTAR) {
+        counters.exceptions.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        counters.otherErrors.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void test_modbus_485::ModbusMetrics::recordTransaction(int slaveIdentifier,
+                                                       int functionCode,
+                                                       std::chrono::nanoseconds latency,
+                                                       int errorCode) {
+    record(total_, latency, errorCode);
+    if (functionCode >= 0 && functionCode < static_cast<int>(functions_.size())) {
+        record(*slot(functions_[functionCode]), latency, errorCode);
+    }
+    if (slaveIdentifier >= 0 && slaveIdentifier < static_cast<int>(slaves_.size())) {
+        record(*slot(slaves_[slaveIdentifier]), latency, errorCode);
+    }
+}
+
+void test_modbus_485::ModbusMetrics::recordReconnect(bool success) {
+    reconnects_.fetch_add(1, std::memory_order_relaxed);
+    if (!success) {
+        reconnectFailures_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void test_modbus_485::ModbusMetrics::recordRecovery(ModbusRecoveryKind kind,
+                                                    std::chrono::nanoseconds duration,
+                                                    bool recovered) {
+    Recovery& recovery = kind == ModbusRecoveryKind::Resync ? resync_ : reopen_;
+    recovery.duration.record(duration);
+    (recovered ? recovery.recovered : recovery.failed).fetch_add(1, std::memory_order_relaxed);
+}
+
+test_modbus_485::ModbusMetricsEntry test_modbus_485::ModbusMetrics::read(const Counters& counters, int key) {
+    ModbusMetricsEntry entry;
+    entry.key = key;
+    entry.latency = counters.latency.snapshot();
+    entry.timeouts = counters.timeouts.load(std::memory_order_relaxed);
+    entry.crcErrors = counters.crcErrors.load(std::memory_order_relaxed);
+    entry.exceptions = counters.exceptions.load(std::memory_order_relaxed);
+    entry.otherErrors = counters.otherErrors.load(std::memory_order_relaxed);
+    return entry;
+}
+
+void test_modbus_485::ModbusMetrics::clear(Counters& counters) {
+    counters.latency.reset();
+    counters.timeouts.store(0, std::memory_order_relaxed);
+    counters.crcErrors.store(0, std::memory_order_relaxed);
+    counters.exceptions.store(0, std::memory_order_relaxed);
+    counters.otherErrors.store(0, std::memory_order_relaxed);
+}
+
+test_modbus_485::ModbusRecoveryEntry test_modbus_485::ModbusMetrics::read(const Recovery& recovery) {
+    ModbusRecoveryEntry entry;
+    entry.duration = recovery.duration.snapshot();
+    entry.recovered = recovery.recovered.load(std::memory_order_relaxed);
+    entry.failed = recovery.failed.load(std::memory_order_relaxed);
+    return entry;
+}
+
+void test_modbus_485::ModbusMetrics::clear(Recovery& recovery) {
+    recovery.duration.reset();
+    recovery.recovered.store(0, std::memory_order_relaxed);
+    recovery.failed.store(0, std::memory_order_relaxed);
+}
+
+test_modbus_485::ModbusMetricsSnapshot test_modbus_485::ModbusMetrics::snapshot() const {
+    ModbusMetricsSnapshot result;
+    result.total = read(total_, -1);
+    for (int functionCode = 0; functionCode < static_cast<int>(functions_.size()); ++functionCode) {
+        const Counters* counters = functions_[functionCode].load(std::memory_order_acquire);
+        if (counters) {
+            result.functions.push_back(read(*counters, functionCode));
+        }
+    }
+    for (int slaveIdentifier = 0; slaveIdentifier < static_cast<int>(slaves_.size()); ++slaveIdentifier) {
+        const Counters* counters = slaves_[slaveIdentifier].load(std::memory_order_acquire);
+        if (counters) {
+            result.slaves.push_back(read(*counters, slaveIdentifier));
+        }
+    }
+    result.resync = read(resync_);
+    result.reopen = read(reopen_);
+    result.reconnects = reconnects_.load(std::memory_order_relaxed);
+    result.reconnectFailures = reconnectFailures_.load(std::memory_order_relaxed);
+    return result;
+}
+
+void test_modbus_485::ModbusMetrics::reset() {
+    // Entries are zeroed, never freed, so concurrent recorders keep valid pointers.
+    clear(total_);
+    for (std::atomic<Counters*>& entry : functions_) {
+        Counters* counters = entry.load(std::memory_order_acquire);
+        if (counters) {
+            clear(*counters);
+        }
+    }
+    for (std::atomic<Counters*>& entry : slaves_) {
+        Counters* counters = entry.load(std::memory_order_acquire);
+        if (counters) {
+            clear(*counters);
+        }
+    }
+    clear(resync_);
+    clear(reopen_);
+    reconnects_.store(0, std::memory_order_relaxed);
+    reconnectFailures_.store(0, std::memory_order_relaxed);
+}
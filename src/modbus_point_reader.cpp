@@ -0,0 +1,204 @@
+// src/modbus_point_reader.cpp
+
+#include "modbus_point_reader.h"
+#include <algorithm>
+#include <iostream>
+#include <limits>
+
+int test_modbus_485::maximumReadCount(ModbusTable table) {
+    return (table == ModbusTable::Coils || table == ModbusTable::DiscreteInputs)
+           ? MODBUS_MAX_READ_BITS
+           : MODBUS_MAX_READ_REGISTERS;
+}
+
+int test_modbus_485::defaultGapCost(ModbusTable table) {
+    return (table == ModbusTable::Coils || table == ModbusTable::DiscreteInputs) ? 256 : 16;
+}
+
+std::vector<test_modbus_485::ModbusReadRange>
+test_modbus_485::coalesceReadRanges(std::vector<ModbusReadRange> ranges,
+                                    int maximumCount,
+                                    int gapCost) {
+    std::sort(ranges.begin(), ranges.end(), [](const ModbusReadRange& left, const ModbusReadRange& right) {
+        return left.startAddress < right.startAddress;
+    });
+
+    // Ranges that touch must be read together; fold them into disjoint intervals first.
+    std::vector<ModbusReadRange> intervals;
+    for (const ModbusReadRange& range : ranges) {
+        if (range.count <= 0 || range.count > maximumCount) {
+            std::cerr << "[coalesceReadRanges] range @" << range.startAddress
+                      << " cnt=" << range.count << " exceeds PDU limit\n";
+            return {};
+        }
+        int endAddress = range.startAddress + range.count;
+        if (!intervals.empty() &&
+            range.startAddress <= intervals.back().startAddress + intervals.back().count &&
+            std::max(endAddress, intervals.back().startAddress + intervals.back().count)
+                - intervals.back().startAddress <= maximumCount) {
+            intervals.back().count = std::max(endAddress, intervals.back().startAddress + intervals.back().count)
+                                     - intervals.back().startAddress;
+        } else {
+            intervals.push_back(range);
+        }
+    }
+
+    // best[k]: cheapest cover of intervals [0, k); first[k]: first interval of the last request.
+    const size_t intervalCount = intervals.size();
+    std::vector<long long> best(intervalCount + 1, std::numeric_limits<long long>::max());
+    std::vector<size_t> first(intervalCount + 1, 0);
+    best[0] = 0;
+    for (size_t last = 0; last < intervalCount; ++last) {
+        int endAddress = intervals[last].startAddress + intervals[last].count;
+        for (size_t start = last + 1; start-- > 0;) {
+            int span = endAddress - intervals[start].startAddress;
+            if (span > maximumCount) {
+                break;
+            }
+            long long cost = best[start] + gapCost + span;
+            if (cost < best[last + 1]) {
+                best[last + 1] = cost;
+                first[last + 1] = start;
+            }
+        }
+    }
+
+    std::vector<ModbusReadRange> requests;
+    for (size_t end = intervalCount; end > 0; end = first[end]) {
+        const ModbusReadRange& head = intervals[first[end]];
+        const ModbusReadRange& tail = intervals[end - 1];
+        requests.push_back({head.startAddress, tail.startAddress + tail.count - head.startAddress});
+    }
+    std::reverse(requests.begin(), requests.end());
+    return requests;
+}
+
+test_modbus_485::ModbusPointReader::ModbusPointReader(ModbusUtils& modbusUtils)
+    : modbusUtils_(modbusUtils) {
+    for (ModbusTable table : {ModbusTable::Coils, ModbusTable::DiscreteInputs,
+                              ModbusTable::HoldingRegisters, ModbusTable::InputRegisters}) {
+        gapCosts_[static_cast<int>(table)] = defaultGapCost(table);
+    }
+}
+
+int test_modbus_485::ModbusPointReader::addPoint(ModbusTable table, int address) {
+    if (address < 0 || address > 0xFFFF) {
+        std::cerr << "[addPoint] invalid address " << address << "\n";
+        return -1;
+    }
+    points_.push_back({table, address, -1, 0});
+    requests_.clear();
+    return static_cast<int>(points_.size()) - 1;
+}
+
+void test_modbus_485::ModbusPointReader::setGapCost(ModbusTable table, int gapCost) {
+    gapCosts_[static_cast<int>(table)] = std::max(gapCost, 0);
+    requests_.clear();
+}
+
+bool test_modbus_485::ModbusPointReader::plan() {
+    requests_.clear();
+    for (ModbusTable table : {ModbusTable::Coils, ModbusTable::DiscreteInputs,
+                              ModbusTable::HoldingRegisters, ModbusTable::InputRegisters}) {
+        std::vector<ModbusReadRange> ranges;
+        for (const Point& point : points_) {
+            if (point.table == table) {
+                ranges.push_back({point.address, 1});
+            }
+        }
+        if (ranges.empty()) {
+            continue;
+        }
+        std::vector<ModbusReadRange> planned =
+            coalesceReadRanges(ranges, maximumReadCount(table), gapCosts_[static_cast<int>(table)]);
+        if (planned.empty()) {
+            return false;
+        }
+
+        const int firstRequest = static_cast<int>(requests_.size());
+        for (const ModbusReadRange& range : planned) {
+            Request request{table, range, {}, {}, false};
+            if (table == ModbusTable::Coils || table == ModbusTable::DiscreteInputs) {
+                request.bits.assign(range.count, 0);
+            } else {
+                request.registers.assign(range.count, 0);
+            }
+            requests_.push_back(std::move(request));
+        }
+        for (Point& point : points_) {
+            if (point.table != table) {
+                continue;
+            }
+            auto found = std::upper_bound(planned.begin(), planned.end(), point.address,
+                                          [](int address, const ModbusReadRange& range) {
+                                              return address < range.startAddress;
+                                          });
+            point.request = firstRequest + static_cast<int>(found - planned.begin()) - 1;
+            point.offset = point.address - requests_[point.request].range.startAddress;
+        }
+    }
+    return true;
+}
+
+bool test_modbus_485::ModbusPointReader::read(modbus_t*& contextReference) {
+    if (requests_.empty() && !points_.empty() && !plan()) {
+        return false;
+    }
+
+    bool allSucceeded = true;
+    for (Request& request : requests_) {
+        int result = -1;
+        switch (request.table) {
+            case ModbusTable::Coils:
+                result = modbusUtils_.readCoils(contextReference, request.range.startAddress,
+                                                request.range.count, request.bits.data());
+                break;
+            case ModbusTable::DiscreteInputs:
+                result = modbusUtils_.readDiscreteInputs(contextReference, request.range.startAddress,
+                                                         request.range.count, request.bits.data());
+                break;
+            case ModbusTable::HoldingRegisters:
+                result = modbusUtils_.readHoldingRegisters(contextReference, request.range.startAddress,
+                                                           request.range.count, request.registers.data());
+                break;
+            case ModbusTable::InputRegisters:
+                result = modbusUtils_.readInputRegisters(contextReference, request.range.startAddress,
+                                                         request.range.count, request.registers.data());
+                break;
+        }
+        request.valid = (result == request.range.count);
+        allSucceeded = allSucceeded && request.valid;
+    }
+    return allSucceeded;
+}
+
+uint16_t test_modbus_485::ModbusPointReader::value(int handle) const {
+    if (handle < 0 || handle >= static_cast<int>(points_.size()) || points_[handle].request < 0) {
+        return 0;
+    }
+    const Point& point = points_[handle];
+    const Request& request = requests_[point.request];
+    return request.registers.empty() ? request.bits[point.offset] : request.registers[point.offset];
+}
+
+bool test_modbus_485::ModbusPointReader::isValid(int handle) const {
+    if (handle < 0 || handle >= static_cast<int>(points_.size()) || points_[handle].request < 0) {
+        return false;
+    }
+    return requests_[points_[handle].request].valid;
+}
+
+int test_modbus_485::ModbusPointReader::requestCount() const {
+    return static_cast<int>(requests_.size());
+}
+
+std::vector<test_modbus_485::ModbusReadRange>
+test_modbus_485::ModbusPointReader::requests(ModbusTable table) const {
+    std::vector<ModbusReadRange> ranges;
+    for (const Request& request : requests_) {
+        if (request.table == table) {
+            ranges.push_back(request.range);
+        }
+    }
+    return ranges;
+}
@@ -0,0 +1,38 @@
+// src/modbus_pty.cpp
+
+#include "modbus_pty.h"
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+
+bool test_modbus_485::openPtyPair(int& masterFileDescriptor, std::string& slaveDevicePath) {
+    masterFileDescriptor = ::posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (masterFileDescriptor < 0) {
+        perror("[openPtyPair] posix_openpt");
+        return false;
+    }
+    if (::grantpt(masterFileDescriptor) != 0 || ::unlockpt(masterFileDescriptor) != 0) {
+        perror("[openPtyPair] grantpt/unlockpt");
+        ::close(masterFileDescriptor);
+        masterFileDescriptor = -1;
+        return false;
+    }
+
+    termios terminalSettings;
+    if (tcgetattr(masterFileDescriptor, &terminalSettings) == 0) {
+        cfmakeraw(&terminalSettings);
+        tcsetattr(masterFileDescriptor, TCSANOW, &terminalSettings);
+    }
+
+    const char* name = ::ptsname(masterFileDescriptor);
+    if (!name) {
+        perror("[openPtyPair] ptsname");
+        ::close(masterFileDescriptor);
+        masterFileDescriptor = -1;
+        return false;
+    }
+    slaveDevicePath = name;
+    return true;
+}
@@ -0,0 +1,123 @@
+// src/modbus_read_cache.cpp
+
+#include "modbus_read_cache.h"
+#include <algorithm>
+
+bool test_modbus_485::ModbusReadCache::Range::covers(const Range& other) const {
+    return slaveIdentifier == other.slaveIdentifier && table == other.table &&
+           startAddress <= other.startAddress && other.startAddress + other.count <= startAddress + count;
+}
+
+bool test_modbus_485::ModbusReadCache::Range::overlaps(const Range& other) const {
+    // Slave 0 stands for every slave (broadcast writes, wildcard TTLs).
+    return (slaveIdentifier == other.slaveIdentifier || slaveIdentifier == 0 || other.slaveIdentifier == 0) &&
+           table == other.table &&
+           startAddress < other.startAddress + other.count && other.startAddress < startAddress + count;
+}
+
+test_modbus_485::ModbusReadCache::ModbusReadCache(std::chrono::microseconds defaultTimeToLive)
+    : defaultTimeToLive_(defaultTimeToLive) {}
+
+void test_modbus_485::ModbusReadCache::setTimeToLive(int slaveIdentifier,
+                                                    ModbusTable table,
+                                                    int startAddress,
+                                                    int count,
+                                                    std::chrono::microseconds timeToLive) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    timesToLive_.push_back(TimeToLive{Range{slaveIdentifier, table, startAddress, count}, timeToLive});
+}
+
+void test_modbus_485::ModbusReadCache::invalidate(int slaveIdentifier, ModbusTable table, int startAddress, int count) {
+    const Range written{slaveIdentifier, table, startAddress, count};
+    std::lock_guard<std::mutex> lock(mutex_);
+    bool dropped = false;
+    auto end = std::remove_if(entries_.begin(), entries_.end(),
+                              [&written](const Entry& entry) { return entry.range.overlaps(written); });
+    if (end != entries_.end()) {
+        entries_.erase(end, entries_.end());
+        dropped = true;
+    }
+    for (const std::shared_ptr<Flight>& flight : flights_) {
+        if (flight->range.overlaps(written)) {
+            flight->stale = true;
+            dropped = true;
+        }
+    }
+    if (dropped) {
+        ++statistics_.invalidations;
+    }
+}
+
+void test_modbus_485::ModbusReadCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.clear();
+    for (const std::shared_ptr<Flight>& flight : flights_) {
+        flight->stale = true;
+    }
+}
+
+test_modbus_485::ModbusReadCacheStatistics test_modbus_485::ModbusReadCache::statistics() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return statistics_;
+}
+
+void test_modbus_485::ModbusReadCache::resetStatistics() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    statistics_ = ModbusReadCacheStatistics();
+}
+
+std::chrono::microseconds test_modbus_485::ModbusReadCache::timeToLiveLocked(const Range& range) const {
+    for (auto configured = timesToLive_.rbegin(); configured != timesToLive_.rend(); ++configured) {
+        const Range& limit = configured->range;
+        if ((limit.slaveIdentifier == 0 || limit.slaveIdentifier == range.slaveIdentifier) &&
+            limit.table == range.table && limit.startAddress <= range.startAddress &&
+            range.startAddress + range.count <= limit.startAddress + limit.count) {
+            return configured->value;
+        }
+    }
+    return defaultTimeToLive_;
+}
+
+const test_modbus_485::ModbusReadCache::Entry*
+test_modbus_485::ModbusReadCache::findFreshLocked(const Range& range, Clock::time_point now) const {
+    for (const Entry& entry : entries_) {
+        if (entry.expires > now && entry.range.covers(range)) {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+std::shared_ptr<test_modbus_485::ModbusReadCache::Flight>
+test_modbus_485::ModbusReadCache::findFlightLocked(const Range& range) const {
+    for (const std::shared_ptr<Flight>& flight : flights_) {
+        if (flight->range.overlaps(range)) {
+            return flight;
+        }
+    }
+    return nullptr;
+}
+
+void test_modbus_485::ModbusReadCache::storeLocked(const Range& range,
+                                                  std::vector<uint16_t>& values,
+                                                  std::chrono::microseconds timeToLive,
+                                                  std::chrono::nanoseconds latency) {
+    const Clock::time_point now = Clock::now();
+    // Expired entries and ones the new range supersedes make room for it.
+    entries_.erase(std::remove_if(entries_.begin(), entries_.end(),
+                                  [&](const Entry& entry) {
+                                      return entry.expires <= now || range.covers(entry.range);
+                                  }),
+                   entries_.end());
+    Entry entry;
+    entry.range = range;
+    entry.values.swap(values);
+    entry.expires = now + timeToLive;
+    entry.latency = latency;
+    entries_.push_back(std::move(entry));
+}
+
+void test_modbus_485::ModbusReadCache::finishFlightLocked(const std::shared_ptr<Flight>& flight) {
+    flight->done = true;
+    flights_.erase(std::remove(flights_.begin(), flights_.end(), flight), flights_.end());
+}
@@ -0,0 +1,383 @@
+// src/modbus_register_image.cpp
+
+#include "modbus_register_image.h"
+#include <modbus.h>
+#include <algorithm>
+#include <thread>
+
+namespace {
+
+void putUint16(uint8_t* destination, int value) {
+    destination[0] = static_cast<uint8_t>((value >> 8) & 0xFF);
+    destination[1] = static_cast<uint8_t>(value & 0xFF);
+}
+
+int getUint16(const uint8_t* source) {
+    return (source[0] << 8) | source[1];
+}
+
+int exceptionResponse(uint8_t functionCode, int exceptionCode, uint8_t* response) {
+    response[0] = static_cast<uint8_t>(functionCode | 0x80);
+    response[1] = static_cast<uint8_t>(exceptionCode);
+    return 2;
+}
+
+bool inRange(int address, int count) {
+    return address >= 0 && count >= 0 && address + count <= test_modbus_485::ModbusRegisterImage::addressCount;
+}
+
+bool isBitTable(test_modbus_485::ModbusTable table) {
+    return table == test_modbus_485::ModbusTable::Coils || table == test_modbus_485::ModbusTable::DiscreteInputs;
+}
+
+} // namespace
+
+test_modbus_485::ModbusRegisterImage::Update::Update(ModbusRegisterImage& image)
+    : image_(image),
+      lock_(image.writeMutex_) {
+    image_.beginWrite();
+}
+
+test_modbus_485::ModbusRegisterImage::Update::~Update() {
+    image_.endWrite();
+}
+
+void test_modbus_485::ModbusRegisterImage::Update::setRegisters(ModbusTable table,
+                                                                int startAddress,
+                                                                const uint16_t* source,
+                                                                int count) {
+    if (isBitTable(table) || !inRange(startAddress, count)) {
+        return;
+    }
+    for (int i = 0; i < count; ++i) {
+        image_.store(table, startAddress + i, source[i]);
+    }
+}
+
+void test_modbus_485::ModbusRegisterImage::Update::setBits(ModbusTable table,
+                                                           int startAddress,
+                                                           const uint8_t* source,
+                                                           int count) {
+    if (!isBitTable(table) || !inRange(startAddress, count)) {
+        return;
+    }
+    for (int i = 0; i < count; ++i) {
+        image_.store(table, startAddress + i, source[i] ? 1 : 0);
+    }
+}
+
+test_modbus_485::ModbusRegisterImage::ModbusRegisterImage()
+    : sequence_(0),
+      pageCount_(0),
+      readRetries_(0) {
+    for (auto& table : pages_) {
+        for (std::atomic<Page*>& entry : table) {
+            entry.store(nullptr, std::memory_order_relaxed);
+        }
+    }
+}
+
+test_modbus_485::ModbusRegisterImage::~ModbusRegisterImage() {
+    for (auto& table : pages_) {
+        for (std::atomic<Page*>& entry : table) {
+            delete entry.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+bool test_modbus_485::ModbusRegisterImage::readRegisters(ModbusTable table,
+                                                         int startAddress,
+                                                         int count,
+                                                         uint16_t* destination) const {
+    if (isBitTable(table) || !inRange(startAddress, count)) {
+        return false;
+    }
+    load(table, startAddress, count, destination);
+    return true;
+}
+
+bool test_modbus_485::ModbusRegisterImage::readBits(ModbusTable table,
+                                                    int startAddress,
+                                                    int count,
+                                                    uint8_t* destination) const {
+    if (!isBitTable(table) || !inRange(startAddress, count)) {
+        return false;
+    }
+    load(table, startAddress, count, destination);
+    return true;
+}
+
+int test_modbus_485::ModbusRegisterImage::process(const uint8_t* request, int length, uint8_t* response) {
+    if (length < 1) {
+        return 0;
+    }
+    const uint8_t functionCode = request[0];
+
+    switch (functionCode) {
+        case MODBUS_FC_READ_COILS:
+        case MODBUS_FC_READ_DISCRETE_INPUTS: {
+            if (length < 5) {
+                return exceptionResponse(functionCode, MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE, response);
+            }
+            const int address = getUint16(request + 1);
+            const int count = getUint16(request + 3);
+            if (count < 1 || count > MODBUS_MAX_READ_BITS) {
+                return exceptionResponse(functionCode, MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE, response);
+            }
+            if (!inRange(address, count)) {
+                return exceptionResponse(functionCode, MODBUS_EXCEPTION_ILLEGAL_DATA_ADDRESS, response);
+            }
+            uint8_t bits[MODBUS_MAX_READ_BITS];
+            load(functionCode == MODBUS_FC_READ_COILS ? ModbusTable::Coils : ModbusTable::DiscreteInputs,
+                 address, count, bits);
+            const int byteCount = (count + 7) / 8;
+            response[0] = functionCode;
+            response[1] = static_cast<uint8_t>(byteCount);
+            for (int i = 0; i < byteCount; ++i) {
+                response[2 + i] = 0;
+            }
+            for (int i = 0; i < count; ++i) {
+                if (bits[i]) {
+                    response[2 + i / 8] |= static_cast<uint8_t>(1u << (i % 8));
+                }
+            }
+            return 2 + byteCount;
+        }
+
+        case MODBUS_FC_READ_HOLDING_REGISTERS:
+        case MODBUS_FC_READ_INPUT_REGISTERS: {
+            if (length < 5) {
+                return exceptionResponse(functionCode, MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE, response);
+            }
+            const int address = getUint16(request + 1);
+            const int count = getUint16(request + 3);
+            if (count < 1 || count > MODBUS_MAX_READ_REGISTERS) {
+                return exceptionResponse(functionCode, MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE, response);
+            }
+            if (!inRange(address, count)) {
+                return exceptionResponse(functionCode, MODBUS_EXCEPTION_ILLEGAL_DATA_ADDRESS, response);
+            }
+            uint16_t registers[MODBUS_MAX_READ_REGISTERS];
+            load(functionCode == MODBUS_FC_READ_HOLDING_REGISTERS ? ModbusTable::HoldingRegisters
+                                                                  : ModbusTable::InputRegisters,
+                 address, count, registers);
+            response[0] = functionCode;
+            response[1] = static_cast<uint8_t>(count * 2);
+            for (int i = 0; i < count; ++i) {
+                putUint16(response + 2 + 2 * i, registers[i]);
+            }
+            return 2 + 2 * count;
+        }
+
+        case MODBUS_FC_WRITE_SINGLE_COIL: {
+            if (length < 5) {
+                return exceptionResponse(functionCode, MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE, response);
+            }
+            const int address = getUint16(request + 1);
+            const int value = getUint16(request + 3);
+            if (value != 0xFF00 && value != 0x0000) {
+                return exceptionResponse(functionCode, MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE, response);
+            }
+            {
+                Update update(*this);
+                store(ModbusTable::Coils, address, value ? 1 : 0);
+            }
+            for (int i = 0; i < 5; ++i) {
+                response[i] = request[i];
+            }
+            return 5;
+        }
+
+        case MODBUS_FC_WRITE_SINGLE_REGISTER: {
+            if (length < 5) {
+                return exceptionResponse(functionCode, MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE, response);
+            }
+            const int address = getUint16(request + 1);
+            {
+                Update update(*this);
+                store(ModbusTable::HoldingRegisters, address, static_cast<uint16_t>(getUint16(request + 3)));
+            }
+            for (int i = 0; i < 5; ++i) {
+                response[i] = request[i];
+            }
+            return 5;
+        }
+
+        case MODBUS_FC_WRITE_MULTIPLE_COILS: {
+            if (length < 6) {
+                return exceptionResponse(functionCode, MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE, response);
+            }
+            const int address = getUint16(request + 1);
+            const int count = getUint16(request + 3);
+            if (count < 1 || count > MODBUS_MAX_WRITE_BITS || request[5] != (count + 7) / 8 ||
+                length < 6 + request[5]) {
+                return exceptionResponse(functionCode, MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE, response);
+            }
+            if (!inRange(address, count)) {
+                return exceptionResponse(functionCode, MODBUS_EXCEPTION_ILLEGAL_DATA_ADDRESS, response);
+            }
+            {
+                Update update(*this);
+                for (int i = 0; i < count; ++i) {
+                    store(ModbusTable::Coils, address + i, (request[6 + i / 8] >> (i % 8)) & 1u);
+                }
+            }
+            for (int i = 0; i < 5; ++i) {
+                response[i] = request[i];
+            }
+            return 5;
+        }
+
+        case MODBUS_FC_WRITE_MULTIPLE_REGISTERS: {
+            if (length < 6) {
+                return exceptionResponse(functionCode, MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE, response);
+            }
+            const int address = getUint16(request + 1);
+            const int count = getUint16(request + 3);
+            if (count < 1 || count > MODBUS_MAX_WRITE_REGISTERS || request[5] != count * 2 ||
+                length < 6 + count * 2) {
+                return exceptionResponse(functionCode, MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE, response);
+            }
+            if (!inRange(address, count)) {
+                return exceptionResponse(functionCode, MODBUS_EXCEPTION_ILLEGAL_DATA_ADDRESS, response);
+            }
+            {
+                Update update(*this);
+                for (int i = 0; i < count; ++i) {
+                    store(ModbusTable::HoldingRegisters, address + i,
+                          static_cast<uint16_t>(getUint16(request + 6 + 2 * i)));
+                }
+            }
+            for (int i = 0; i < 5; ++i) {
+                response[i] = request[i];
+            }
+            return 5;
+        }
+
+        case MODBUS_FC_MASK_WRITE_REGISTER: {
+            if (length < 7) {
+                return exceptionResponse(functionCode, MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE, response);
+            }
+            const int address = getUint16(request + 1);
+            const int andMask = getUint16(request + 3);
+            const int orMask = getUint16(request + 5);
+            {
+                Update update(*this);
+                const int current = storedValue(ModbusTable::HoldingRegisters, address);
+                store(ModbusTable::HoldingRegisters, address,
+                      static_cast<uint16_t>((current & andMask) | (orMask & ~andMask)));
+            }
+            for (int i = 0; i < 7; ++i) {
+                response[i] = request[i];
+            }
+            return 7;
+        }
+
+        case MODBUS_FC_WRITE_AND_READ_REGISTERS: {
+            if (length < 10) {
+                return exceptionResponse(functionCode, MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE, response);
+            }
+            const int readAddress = getUint16(request + 1);
+            const int readCount = getUint16(request + 3);
+            const int writeAddress = getUint16(request + 5);
+            const int writeCount = getUint16(request + 7);
+            if (readCount < 1 || readCount > MODBUS_MAX_WR_READ_REGISTERS ||
+                writeCount < 1 || writeCount > MODBUS_MAX_WR_WRITE_REGISTERS ||
+                request[9] != writeCount * 2 || length < 10 + writeCount * 2) {
+                return exceptionResponse(functionCode, MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE, response);
+            }
+            if (!inRange(readAddress, readCount) || !inRange(writeAddress, writeCount)) {
+                return exceptionResponse(functionCode, MODBUS_EXCEPTION_ILLEGAL_DATA_ADDRESS, response);
+            }
+            // The write happens before the read, in one update so nothing comes between them.
+            Update update(*this);
+            for (int i = 0; i < writeCount; ++i) {
+                store(ModbusTable::HoldingRegisters, writeAddress + i,
+                      static_cast<uint16_t>(getUint16(request + 10 + 2 * i)));
+            }
+            response[0] = functionCode;
+            response[1] = static_cast<uint8_t>(readCount * 2);
+            for (int i = 0; i < readCount; ++i) {
+                putUint16(response + 2 + 2 * i, storedValue(ModbusTable::HoldingRegisters, readAddress + i));
+            }
+            return 2 + 2 * readCount;
+        }
+
+        default:
+            return exceptionResponse(functionCode, MODBUS_EXCEPTION_ILLEGAL_FUNCTION, response);
+    }
+}
+
+size_t test_modbus_485::ModbusRegisterImage::pageCount() const {
+    return pageCount_.load(std::memory_order_relaxed);
+}
+
+uint64_t test_modbus_485::ModbusRegisterImage::readRetries() const {
+    return readRetries_.load(std::memory_order_relaxed);
+}
+
+template<typename Value>
+void test_modbus_485::ModbusRegisterImage::load(ModbusTable table,
+                                                int startAddress,
+                                                int count,
+                                                Value* destination) const {
+    const auto& pages = pages_[static_cast<int>(table)];
+    for (int attempt = 0;; ++attempt) {
+        const uint32_t before = sequence_.load(std::memory_order_acquire);
+        if ((before & 1u) == 0) {
+            for (int i = 0; i < count;) {
+                const int address = startAddress + i;
+                const int inPage = std::min(count - i, pageSize - address % pageSize);
+                const Page* page = pages[address / pageSize].load(std::memory_order_acquire);
+                for (int j = 0; j < inPage; ++j) {
+                    destination[i + j] = page ? static_cast<Value>(
+                                                    page->values[address % pageSize + j].load(std::memory_order_relaxed))
+                                              : 0;
+                }
+                i += inPage;
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (sequence_.load(std::memory_order_relaxed) == before) {
+                return;
+            }
+        }
+        readRetries_.fetch_add(1, std::memory_order_relaxed);
+        // An update is a few stores; give the writer the core only if it was preempted mid-way.
+        if (attempt >= 64) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void test_modbus_485::ModbusRegisterImage::store(ModbusTable table, int address, uint16_t value) {
+    std::atomic<Page*>& entry = pages_[static_cast<int>(table)][address / pageSize];
+    Page* page = entry.load(std::memory_order_relaxed);
+    if (!page) {
+        if (value == 0) {
+            // Pages never written already read as 0.
+            return;
+        }
+        page = new Page();
+        for (std::atomic<uint16_t>& slot : page->values) {
+            slot.store(0, std::memory_order_relaxed);
+        }
+        entry.store(page, std::memory_order_release);
+        pageCount_.fetch_add(1, std::memory_order_relaxed);
+    }
+    page->values[address % pageSize].store(value, std::memory_order_relaxed);
+}
+
+uint16_t test_modbus_485::ModbusRegisterImage::storedValue(ModbusTable table, int address) const {
+    const Page* page = pages_[static_cast<int>(table)][address / pageSize].load(std::memory_order_relaxed);
+    return page ? page->values[address % pageSize].load(std::memory_order_relaxed) : 0;
+}
+
+void test_modbus_485::ModbusRegisterImage::beginWrite() {
+    // Odd while stores are in progress; the fence keeps them from moving above the increment.
+    sequence_.store(sequence_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+}
+
+void test_modbus_485::ModbusRegisterImage::endWrite() {
+    sequence_.store(sequence_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
@@ -0,0 +1,592 @@
+// src/modbus_replay.cpp
+
+#include "modbus_replay.h"
+#include "modbus_rtu_codec.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <poll.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr int64_t nanosecondsPerSecond = 1000000000;
+
+// Mismatches reported on stderr per run; the rest are only counted.
+constexpr uint64_t reportedMismatches = 10;
+
+int64_t monotonicNow() {
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<int64_t>(now.tv_sec) * nanosecondsPerSecond + now.tv_nsec;
+}
+
+void sleepUntil(int64_t deadline) {
+    timespec request;
+    request.tv_sec = static_cast<time_t>(deadline / nanosecondsPerSecond);
+    request.tv_nsec = static_cast<long>(deadline % nanosecondsPerSecond);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &request, nullptr) == EINTR) {
+    }
+}
+
+int readWord(const uint8_t* bytes) {
+    return (bytes[0] << 8) | bytes[1];
+}
+
+/**
+ * @brief Recorded time from a request to its response, divided by the replay speed.
+ */
+std::chrono::nanoseconds scaledResponseTime(const test_modbus_485::ModbusReplayTransaction& transaction,
+                                            double speed) {
+    if (speed <= 0.0) {
+        return std::chrono::nanoseconds(0);
+    }
+    return std::chrono::nanoseconds(
+        static_cast<int64_t>(static_cast<double>(transaction.responseTimestamp - transaction.timestamp) / speed));
+}
+
+void printRow(std::ostream& stream, const std::string& label, const test_modbus_485::LatencyHistogramSnapshot& histogram) {
+    test_modbus_485::LatencySummary summary = histogram.summary();
+    stream << "  " << std::left << std::setw(16) << label << std::right
+           << std::setw(10) << summary.count
+           << std::fixed << std::setprecision(0)
+           << std::setw(9) << summary.p50
+           << std::setw(9) << summary.p90
+           << std::setw(9) << summary.p99
+           << std::setw(9) << summary.p999
+           << std::setw(9) << summary.max << "\n";
+}
+
+void printCsvRow(std::ostream& stream, const std::string& function, const char* distribution, uint64_t transactions,
+                 uint64_t mismatches, const test_modbus_485::LatencyHistogramSnapshot& histogram) {
+    test_modbus_485::LatencySummary summary = histogram.summary();
+    stream << function << ',' << distribution << ',' << transactions << ',' << mismatches << ','
+           << summary.count << ',' << summary.mean << ',' << summary.p50 << ',' << summary.p90 << ','
+           << summary.p99 << ',' << summary.p999 << ',' << summary.max << "\n";
+}
+
+} // namespace
+
+test_modbus_485::ModbusReplaySource::ModbusReplaySource(ModbusCaptureReader& reader, uint64_t from, uint64_t to)
+    : reader_(reader),
+      to_(to),
+      lookahead_(),
+      haveLookahead_(false) {
+    reader_.seek(from);
+}
+
+bool test_modbus_485::ModbusReplaySource::read(ModbusCaptureRecord& record) {
+    if (haveLookahead_) {
+        record = lookahead_;
+        haveLookahead_ = false;
+        return true;
+    }
+    return reader_.next(record) && record.timestamp < to_;
+}
+
+bool test_modbus_485::ModbusReplaySource::next(ModbusReplayTransaction& transaction) {
+    ModbusCaptureRecord record;
+    do {
+        if (!read(record)) {
+            return false;
+        }
+    } while (record.direction != ModbusCaptureDirection::Request || record.status == ModbusCaptureStatus::Garbage ||
+             record.length < 4);
+
+    transaction = ModbusReplayTransaction{record.timestamp, record.timestamp, record.adu, record.length, nullptr, 0};
+    ModbusCaptureRecord following;
+    if (!read(following)) {
+        return true;
+    }
+    if (following.direction == ModbusCaptureDirection::Response && following.length >= 4 &&
+        (following.status == ModbusCaptureStatus::Ok || following.status == ModbusCaptureStatus::Exception) &&
+        following.adu[0] == record.adu[0] && (following.adu[1] & 0x7F) == record.adu[1]) {
+        transaction.response = following.adu;
+        transaction.responseLength = following.length;
+        transaction.responseTimestamp = following.timestamp;
+    } else {
+        lookahead_ = following;
+        haveLookahead_ = true;
+    }
+    return true;
+}
+
+void test_modbus_485::ModbusReplayStatistics::print(std::ostream& stream) const {
+    std::ios::fmtflags flags = stream.flags();
+    std::streamsize precision = stream.precision();
+
+    const double recordedSeconds = static_cast<double>(recordedSpan.count()) / 1e9;
+    const double replaySeconds = static_cast<double>(replayDuration.count()) / 1e9;
+    stream << "  transactions " << transactions << ", matched " << matched << ", mismatched " << mismatches
+           << ", unsupported " << unsupported << "\n"
+           << std::fixed << std::setprecision(3)
+           << "  recorded " << recordedSeconds << " s, replayed in " << replaySeconds << " s ("
+           << std::setprecision(1) << (replaySeconds > 0.0 ? recordedSeconds / replaySeconds : 0.0)
+           << "x), max lag " << std::setprecision(3) << static_cast<double>(maximumLag.count()) / 1e6 << " ms\n";
+    stream << "  " << std::left << std::setw(16) << "(us)" << std::right
+           << std::setw(10) << "count"
+           << std::setw(9) << "p50"
+           << std::setw(9) << "p90"
+           << std::setw(9) << "p99"
+           << std::setw(9) << "p99.9"
+           << std::setw(9) << "max" << "\n";
+    for (const ModbusReplayFunctionStatistics& function : functions) {
+        char label[16];
+        std::snprintf(label, sizeof(label), "FC%02X", function.functionCode);
+        printRow(stream, std::string(label) + " recorded", function.recorded);
+        printRow(stream, std::string(label) + " replayed", function.replayed);
+    }
+    printRow(stream, "total recorded", recorded);
+    printRow(stream, "total replayed", replayed);
+
+    stream.flags(flags);
+    stream.precision(precision);
+}
+
+void test_modbus_485::ModbusReplayStatistics::printCsv(std::ostream& stream) const {
+    stream << "function,distribution,transactions,mismatches,timed,mean_us,p50_us,p90_us,p99_us,p999_us,max_us\n";
+    for (const ModbusReplayFunctionStatistics& function : functions) {
+        const std::string label = std::to_string(function.functionCode);
+        printCsvRow(stream, label, "recorded", function.transactions, function.mismatches, function.recorded);
+        printCsvRow(stream, label, "replayed", function.transactions, function.mismatches, function.replayed);
+    }
+    printCsvRow(stream, "total", "recorded", transactions, mismatches, recorded);
+    printCsvRow(stream, "total", "replayed", transactions, mismatches, replayed);
+}
+
+test_modbus_485::ModbusReplayMaster::ModbusReplayMaster(ModbusUtils& modbus,
+                                                        modbus_t*& contextReference,
+                                                        const ModbusReplayOptions& options)
+    : modbus_(modbus),
+      contextReference_(contextReference),
+      options_(options),
+      stopRequested_(false) {}
+
+bool test_modbus_485::ModbusReplayMaster::run(ModbusReplaySource& source) {
+    reset();
+    stopRequested_.store(false);
+    const int64_t started = monotonicNow();
+    uint64_t firstTimestamp = 0;
+    bool first = true;
+
+    ModbusReplayTransaction transaction;
+    while (!stopRequested_.load(std::memory_order_relaxed) && source.next(transaction)) {
+        if (first) {
+            firstTimestamp = transaction.timestamp;
+            first = false;
+        }
+        const int64_t offset = static_cast<int64_t>(transaction.timestamp - firstTimestamp);
+        if (options_.speed > 0.0) {
+            const int64_t due = started + static_cast<int64_t>(static_cast<double>(offset) / options_.speed);
+            const int64_t now = monotonicNow();
+            if (now < due) {
+                sleepUntil(due);
+            } else {
+                counters_.maximumLag = std::max(counters_.maximumLag, std::chrono::nanoseconds(now - due));
+            }
+        }
+        counters_.recordedSpan = std::chrono::nanoseconds(offset);
+
+        const int outcome = replay(transaction);
+        if (outcome < 0) {
+            ++counters_.unsupported;
+            continue;
+        }
+        ++counters_.transactions;
+        if (outcome > 0) {
+            ++counters_.matched;
+        } else {
+            ++counters_.mismatches;
+        }
+    }
+    counters_.replayDuration = std::chrono::nanoseconds(monotonicNow() - started);
+    return counters_.mismatches == 0;
+}
+
+void test_modbus_485::ModbusReplayMaster::stop() {
+    stopRequested_.store(true);
+}
+
+test_modbus_485::ModbusReplayStatistics test_modbus_485::ModbusReplayMaster::statistics() const {
+    ModbusReplayStatistics statistics = counters_;
+    statistics.recorded = recorded_.snapshot();
+    statistics.replayed = replayed_.snapshot();
+    statistics.functions.clear();
+    for (size_t functionCode = 0; functionCode < functions_.size(); ++functionCode) {
+        const FunctionCounters& counters = functions_[functionCode];
+        if (counters.transactions == 0) {
+            continue;
+        }
+        ModbusReplayFunctionStatistics function;
+        function.functionCode = static_cast<int>(functionCode);
+        function.transactions = counters.transactions;
+        function.mismatches = counters.mismatches;
+        function.recorded = counters.recorded.snapshot();
+        function.replayed = counters.replayed.snapshot();
+        statistics.functions.push_back(function);
+    }
+    return statistics;
+}
+
+int test_modbus_485::ModbusReplayMaster::replay(const ModbusReplayTransaction& transaction) {
+    const uint8_t* pdu = transaction.request + 1;
+    const int pduLength = transaction.requestLength - 3;
+    const int slaveIdentifier = transaction.request[0];
+    const int functionCode = transaction.request[1];
+    if (pduLength < 5 || functionCode >= static_cast<int>(functions_.size())) {
+        return -1;
+    }
+    const int address = readWord(pdu + 1);
+    const int count = readWord(pdu + 3);
+
+    uint16_t registers[MODBUS_MAX_WR_WRITE_REGISTERS + MODBUS_MAX_READ_REGISTERS];
+    uint8_t bits[MODBUS_MAX_READ_BITS];
+    modbus_.setSlave(contextReference_, slaveIdentifier);
+
+    const int64_t started = monotonicNow();
+    int result = -1;
+    switch (functionCode) {
+    case MODBUS_FC_READ_COILS:
+    case MODBUS_FC_READ_DISCRETE_INPUTS:
+        if (count > MODBUS_MAX_READ_BITS) {
+            return -1;
+        }
+        result = functionCode == MODBUS_FC_READ_COILS
+                     ? modbus_.readCoils(contextReference_, address, count, bits)
+                     : modbus_.readDiscreteInputs(contextReference_, address, count, bits);
+        break;
+    case MODBUS_FC_READ_HOLDING_REGISTERS:
+    case MODBUS_FC_READ_INPUT_REGISTERS:
+        if (count > MODBUS_MAX_READ_REGISTERS) {
+            return -1;
+        }
+        result = functionCode == MODBUS_FC_READ_HOLDING_REGISTERS
+                     ? modbus_.readHoldingRegisters(contextReference_, address, count, registers)
+                     : modbus_.readInputRegisters(contextReference_, address, count, registers);
+        break;
+    case MODBUS_FC_WRITE_SINGLE_COIL:
+        result = modbus_.writeSingleCoil(contextReference_, address, count == 0xFF00) ? 1 : -1;
+        break;
+    case MODBUS_FC_WRITE_SINGLE_REGISTER:
+        result = modbus_.writeSingleRegister(contextReference_, address, static_cast<uint16_t>(count)) ? 1 : -1;
+        break;
+    case MODBUS_FC_WRITE_MULTIPLE_COILS:
+        if (count > MODBUS_MAX_WRITE_BITS || pduLength < 6 + (count + 7) / 8) {
+            return -1;
+        }
+        for (int i = 0; i < count; ++i) {
+            bits[i] = (pdu[6 + i / 8] >> (i % 8)) & 1;
+        }
+        result = modbus_.writeMultipleCoils(contextReference_, address, bits, count);
+        break;
+    case MODBUS_FC_WRITE_MULTIPLE_REGISTERS:
+        if (count > MODBUS_MAX_WRITE_REGISTERS || pduLength < 6 + 2 * count) {
+            return -1;
+        }
+        for (int i = 0; i < count; ++i) {
+            registers[i] = static_cast<uint16_t>(readWord(pdu + 6 + 2 * i));
+        }
+        result = modbus_.writeMultipleRegisters(contextReference_, address, registers, count);
+        break;
+    case MODBUS_FC_MASK_WRITE_REGISTER:
+        if (pduLength < 7) {
+            return -1;
+        }
+        result = modbus_.maskWriteRegister(contextReference_, address, static_cast<uint16_t>(count),
+                                           static_cast<uint16_t>(readWord(pdu + 5)))
+                     ? 1
+                     : -1;
+        break;
+    case MODBUS_FC_WRITE_AND_READ_REGISTERS: {
+        // Read address and count come first in the PDU, then the write block.
+        const int writeAddress = pduLength >= 9 ? readWord(pdu + 5) : 0;
+        const int writeCount = pduLength >= 9 ? readWord(pdu + 7) : 0;
+        if (pduLength < 10 + 2 * writeCount || count > MODBUS_MAX_WR_READ_REGISTERS ||
+            writeCount > MODBUS_MAX_WR_WRITE_REGISTERS) {
+            return -1;
+        }
+        uint16_t* source = registers + MODBUS_MAX_READ_REGISTERS;
+        for (int i = 0; i < writeCount; ++i) {
+            source[i] = static_cast<uint16_t>(readWord(pdu + 10 + 2 * i));
+        }
+        result = modbus_.writeAndReadRegisters(contextReference_, writeAddress, source, writeCount, address, count,
+                                               registers);
+        break;
+    }
+    default:
+        return -1;
+    }
+    const int errorCode = errno;
+    const std::chrono::nanoseconds elapsed(monotonicNow() - started);
+
+    // What the recording says should have happened.
+    bool matched = false;
+    const char* expected = "a response";
+    if (!transaction.response) {
+        expected = slaveIdentifier == MODBUS_BROADCAST_ADDRESS ? "no reply" : "a timeout";
+        matched = slaveIdentifier == MODBUS_BROADCAST_ADDRESS
+                      ? result != -1
+                      : result == -1 && classifyModbusError(errorCode) == ModbusErrorClass::Transient;
+    } else if (transaction.response[1] & 0x80) {
+        expected = "an exception";
+        matched = result == -1 && errorCode == MODBUS_ENOBASE + transaction.response[2];
+    } else if (result != -1) {
+        const uint8_t* responsePdu = transaction.response + 1;
+        const int responsePduLength = transaction.responseLength - 3;
+        matched = true;
+        if (functionCode == MODBUS_FC_READ_COILS || functionCode == MODBUS_FC_READ_DISCRETE_INPUTS) {
+            uint8_t recordedBits[MODBUS_MAX_READ_BITS];
+            matched = decodeBits(responsePdu, responsePduLength, recordedBits, count) == count &&
+                      std::memcmp(recordedBits, bits, static_cast<size_t>(count)) == 0;
+        } else if (functionCode == MODBUS_FC_READ_HOLDING_REGISTERS ||
+                   functionCode == MODBUS_FC_READ_INPUT_REGISTERS ||
+                   functionCode == MODBUS_FC_WRITE_AND_READ_REGISTERS) {
+            uint16_t recordedRegisters[MODBUS_MAX_READ_REGISTERS];
+            matched = decodeRegisters(responsePdu, responsePduLength, recordedRegisters, count) == count &&
+                      std::memcmp(recordedRegisters, registers, sizeof(uint16_t) * static_cast<size_t>(count)) == 0;
+        }
+    }
+
+    FunctionCounters& counters = functions_[functionCode];
+    ++counters.transactions;
+    if (transaction.response) {
+        const std::chrono::nanoseconds recorded(transaction.responseTimestamp - transaction.timestamp);
+        counters.recorded.record(recorded);
+        counters.replayed.record(elapsed);
+        recorded_.record(recorded);
+        replayed_.record(elapsed);
+    }
+    if (!matched) {
+        ++counters.mismatches;
+        if (counters_.mismatches < reportedMismatches) {
+            std::cerr << "[ModbusReplayMaster] transaction " << counters_.transactions << " (slave "
+                      << slaveIdentifier << ", FC" << functionCode << "): recorded " << expected << ", got "
+                      << (result == -1 ? modbus_strerror(errorCode) : "different data") << "\n";
+        }
+    }
+    return matched ? 1 : 0;
+}
+
+void test_modbus_485::ModbusReplayMaster::reset() {
+    for (FunctionCounters& counters : functions_) {
+        counters.transactions = 0;
+        counters.mismatches = 0;
+        counters.recorded.reset();
+        counters.replayed.reset();
+    }
+    recorded_.reset();
+    replayed_.reset();
+    counters_ = ModbusReplayStatistics();
+}
+
+test_modbus_485::ModbusReplaySlave::ModbusReplaySlave(ModbusReplaySource& source,
+                                                      const ModbusReplayOptions& options,
+                                                      int lookahead)
+    : source_(source),
+      options_(options),
+      lookahead_(static_cast<size_t>(std::max(lookahead, 1))),
+      exhausted_(false),
+      fileDescriptor_(-1),
+      running_(false) {}
+
+test_modbus_485::ModbusReplaySlave::~ModbusReplaySlave() {
+    stop();
+}
+
+int test_modbus_485::ModbusReplaySlave::answer(const uint8_t* request,
+                                               int length,
+                                               uint8_t* response,
+                                               std::chrono::nanoseconds& delay) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++counters_.requests;
+    size_t position = 0;
+    for (;; ++position) {
+        if (position == window_.size()) {
+            ModbusReplayTransaction transaction;
+            if (window_.size() >= lookahead_ || exhausted_) {
+                ++counters_.unexpected;
+                return -1;
+            }
+            if (!source_.next(transaction)) {
+                exhausted_ = true;
+                ++counters_.unexpected;
+                return -1;
+            }
+            window_.push_back(transaction);
+        }
+        const ModbusReplayTransaction& candidate = window_[position];
+        if (candidate.requestLength == length &&
+            std::memcmp(candidate.request, request, static_cast<size_t>(length)) == 0) {
+            break;
+        }
+    }
+
+    const ModbusReplayTransaction transaction = window_[position];
+    counters_.skipped += position;
+    window_.erase(window_.begin(), window_.begin() + static_cast<std::ptrdiff_t>(position) + 1);
+    delay = scaledResponseTime(transaction, options_.speed);
+    if (!transaction.response) {
+        ++counters_.silent;
+        return 0;
+    }
+    std::memcpy(response, transaction.response, static_cast<size_t>(transaction.responseLength));
+    ++counters_.answered;
+    return transaction.responseLength;
+}
+
+bool test_modbus_485::ModbusReplaySlave::start(int fileDescriptor) {
+    if (running_.load()) {
+        std::cerr << "[ModbusReplaySlave::start] already running\n";
+        return false;
+    }
+    fileDescriptor_ = fileDescriptor;
+    running_.store(true);
+    thread_ = std::thread(&ModbusReplaySlave::run, this);
+    return true;
+}
+
+void test_modbus_485::ModbusReplaySlave::stop() {
+    running_.store(false);
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+bool test_modbus_485::ModbusReplaySlave::finished() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return exhausted_ && window_.empty();
+}
+
+test_modbus_485::ModbusReplaySlaveStatistics test_modbus_485::ModbusReplaySlave::statistics() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return counters_;
+}
+
+void test_modbus_485::ModbusReplaySlave::run() {
+    uint8_t buffer[2 * MODBUS_RTU_MAX_ADU_LENGTH];
+    uint8_t response[MODBUS_RTU_MAX_ADU_LENGTH];
+    int length = 0;
+    // Silence that ends a partial frame; generous because a pty is not paced.
+    constexpr int frameSilenceMilliseconds = 20;
+
+    while (running_.load(std::memory_order_relaxed)) {
+        pollfd descriptor{fileDescriptor_, POLLIN, 0};
+        int ready = ::poll(&descriptor, 1, length > 0 ? frameSilenceMilliseconds : 50);
+        if (ready < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("[ModbusReplaySlave] poll");
+            break;
+        }
+        if (ready == 0) {
+            length = 0;
+            continue;
+        }
+        ssize_t received = ::read(fileDescriptor_, buffer + length, sizeof(buffer) - length);
+        if (received < 0) {
+            if (errno == EAGAIN || errno == EINTR) {
+                continue;
+            }
+            if (errno == EIO) {
+                // pty master with no slave end open: wait for the master to connect.
+                ::usleep(10000);
+                continue;
+            }
+            perror("[ModbusReplaySlave] read");
+            break;
+        }
+        const int64_t arrived = monotonicNow();
+        length += static_cast<int>(received);
+
+        while (length > 0) {
+            const int frameLength = rtuRequestLength(buffer, length);
+            if (frameLength < 0 || frameLength > MODBUS_RTU_MAX_ADU_LENGTH) {
+                length = 0;
+                break;
+            }
+            if (frameLength == 0 || length < frameLength) {
+                break;
+            }
+            std::chrono::nanoseconds delay(0);
+            const int responseLength = checkCrc(buffer, frameLength) ? answer(buffer, frameLength, response, delay) : -1;
+            if (responseLength > 0) {
+                sleepUntil(arrived + delay.count());
+                for (int written = 0; written < responseLength;) {
+                    const ssize_t chunk = ::write(fileDescriptor_, response + written, responseLength - written);
+                    if (chunk < 0 && errno != EAGAIN && errno != EINTR) {
+                        perror("[ModbusReplaySlave] write");
+                        break;
+                    }
+                    written += chunk > 0 ? static_cast<int>(chunk) : 0;
+                }
+            }
+            std::memmove(buffer, buffer + frameLength, length - frameLength);
+            length -= frameLength;
+        }
+    }
+}
+
+test_modbus_485::ModbusReplayTransport::ModbusReplayTransport(ModbusReplaySlave& slave)
+    : slave_(slave) {}
+
+int test_modbus_485::ModbusReplayTransport::transact(int slaveIdentifier,
+                                                     const uint8_t* request,
+                                                     int requestLength,
+                                                     uint8_t* response,
+                                                     int responseCapacity) {
+    if (requestLength < 1 || requestLength > MODBUS_MAX_PDU_LENGTH ||
+        slaveIdentifier < 0 || slaveIdentifier > 247) {
+        errno = EINVAL;
+        return -1;
+    }
+    const int64_t started = monotonicNow();
+    uint8_t requestAdu[MODBUS_RTU_MAX_ADU_LENGTH];
+    requestAdu[0] = static_cast<uint8_t>(slaveIdentifier);
+    std::memcpy(requestAdu + 1, request, requestLength);
+    const int requestAduLength = appendCrc(requestAdu, requestLength + 1);
+
+    uint8_t responseAdu[MODBUS_RTU_MAX_ADU_LENGTH];
+    std::chrono::nanoseconds delay(0);
+    const int responseAduLength = slave_.answer(requestAdu, requestAduLength, responseAdu, delay);
+    if (slaveIdentifier == MODBUS_BROADCAST_ADDRESS && responseAduLength >= 0) {
+        return 0;
+    }
+    if (responseAduLength <= 0) {
+        errno = ETIMEDOUT;
+        return -1;
+    }
+    sleepUntil(started + delay.count());
+    if (responseAdu[1] & 0x80) {
+        errno = MODBUS_ENOBASE + responseAdu[2];
+        return -1;
+    }
+    const int pduLength = responseAduLength - 3;
+    if (pduLength > responseCapacity) {
+        errno = EMBBADDATA;
+        return -1;
+    }
+    std::memcpy(response, responseAdu + 1, pduLength);
+    return pduLength;
+}
+
+void test_modbus_485::ModbusReplayTransport::setTimeouts(std::chrono::microseconds /*responseTimeout*/,
+                                                         std::chrono::microseconds /*byteTimeout*/) {}
+
+void test_modbus_485::ModbusReplayTransport::flush() {}
+
+bool test_modbus_485::ModbusReplayTransport::reconnect() {
+    return true;
+}
+
+int test_modbus_485::ModbusReplayTransport::baudRate() const {
+    return 0;
+}
+
+int test_modbus_485::ModbusReplayTransport::bitsPerCharacter() const {
+    return 10;
+}
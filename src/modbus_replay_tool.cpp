@@ -0,0 +1,186 @@
+// src/modbus_replay_tool.cpp
+//
+// Replays a capture written by modbus_sniffer.
+//   both   : ModbusUtils replays the master, the recording answers as the
+//            slaves, in-process (--link=loopback) or over a pty pair
+//            (--link=pty, which adds libmodbus and the tty layer).
+//   master : ModbusUtils replays the requests on --device, against real or
+//            simulated slaves in the recorded state.
+//   slave  : the recording answers on --device, or on a new pty whose path
+//            is printed (--link=pty), for a master under test.
+// --speed=1 keeps the recorded timing, --speed=N runs N times faster and
+// --speed=max as fast as the link allows. Recorded and replayed response
+// times are printed per function code; the exit status is 1 on any mismatch.
+//
+// usage: modbus_replay <capture-file> [--role=both|master|slave] [--link=loopback|pty]
+//                      [--device=PATH] [--baud=N] [--speed=N|max] [--from=s] [--to=s] [--csv]
+
+#include "modbus_capture.h"
+#include "modbus_pty.h"
+#include "modbus_replay.h"
+#include "modbus_utils.h"
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <thread>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+test_modbus_485::ModbusReplayMaster* runningMaster = nullptr;
+volatile std::sig_atomic_t stopRequested = 0;
+
+void onSignal(int) {
+    stopRequested = 1;
+    if (runningMaster) {
+        runningMaster->stop();
+    }
+}
+
+uint64_t toTimestamp(const test_modbus_485::ModbusCaptureReader& reader, double seconds) {
+    const int64_t offset = static_cast<int64_t>(seconds * 1e9);
+    const uint64_t start = reader.header().startMonotonic;
+    return offset < 0 && static_cast<uint64_t>(-offset) > start ? 0 : start + static_cast<uint64_t>(offset);
+}
+
+void printSlave(const test_modbus_485::ModbusReplaySlaveStatistics& statistics) {
+    std::cout << "  slave: requests " << statistics.requests << ", answered " << statistics.answered
+              << ", silent " << statistics.silent << ", unexpected " << statistics.unexpected
+              << ", skipped " << statistics.skipped << "\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "usage: modbus_replay <capture-file> [--role=both|master|slave] [--link=loopback|pty]\n"
+                     "                     [--device=PATH] [--baud=N] [--speed=N|max] [--from=s] [--to=s] [--csv]\n";
+        return 1;
+    }
+    // The master and the slave side each read the capture through their own mapping.
+    test_modbus_485::ModbusCaptureReader masterReader;
+    test_modbus_485::ModbusCaptureReader slaveReader;
+    if (!masterReader.open(argv[1]) || !slaveReader.open(argv[1])) {
+        return 1;
+    }
+
+    std::string role = "both";
+    std::string link = "loopback";
+    std::string device;
+    int baud = static_cast<int>(masterReader.header().baudRate);
+    test_modbus_485::ModbusReplayOptions options;
+    uint64_t from = 0;
+    uint64_t to = std::numeric_limits<uint64_t>::max();
+    bool csv = false;
+    for (int i = 2; i < argc; ++i) {
+        if (std::strncmp(argv[i], "--role=", 7) == 0) {
+            role = argv[i] + 7;
+        } else if (std::strncmp(argv[i], "--link=", 7) == 0) {
+            link = argv[i] + 7;
+        } else if (std::strncmp(argv[i], "--device=", 9) == 0) {
+            device = argv[i] + 9;
+        } else if (std::strncmp(argv[i], "--baud=", 7) == 0) {
+            baud = std::atoi(argv[i] + 7);
+        } else if (std::strncmp(argv[i], "--speed=", 8) == 0) {
+            options.speed = std::strcmp(argv[i] + 8, "max") == 0 ? 0.0 : std::atof(argv[i] + 8);
+        } else if (std::strncmp(argv[i], "--from=", 7) == 0) {
+            from = toTimestamp(masterReader, std::atof(argv[i] + 7));
+        } else if (std::strncmp(argv[i], "--to=", 5) == 0) {
+            to = toTimestamp(masterReader, std::atof(argv[i] + 5));
+        } else if (std::strcmp(argv[i], "--csv") == 0) {
+            csv = true;
+        } else {
+            std::cerr << "unknown argument: " << argv[i] << "\n";
+            return 1;
+        }
+    }
+    if (baud <= 0) {
+        baud = 115200;
+    }
+    const bool playMaster = role == "both" || role == "master";
+    const bool playSlave = role == "both" || role == "slave";
+    if ((!playMaster && !playSlave) || (link != "loopback" && link != "pty") ||
+        (role == "master" && device.empty()) || (role == "slave" && device.empty() && link != "pty")) {
+        std::cerr << "ERROR: --role=master needs --device, --role=slave needs --device or --link=pty\n";
+        return 1;
+    }
+
+    std::signal(SIGINT, onSignal);
+    test_modbus_485::ModbusReplaySource slaveSource(slaveReader, from, to);
+    test_modbus_485::ModbusReplaySlave slave(slaveSource, options);
+    test_modbus_485::ModbusReplayTransport transport(slave);
+
+    // Slave side: a descriptor served by the replay slave, unless both sides run in-process.
+    int slaveFileDescriptor = -1;
+    if (playSlave && !(playMaster && link == "loopback")) {
+        if (link == "pty") {
+            std::string path;
+            if (!test_modbus_485::openPtyPair(slaveFileDescriptor, path)) {
+                std::cerr << "ERROR: cannot open pty pair\n";
+                return 1;
+            }
+            device = path;
+            if (!playMaster) {
+                std::cout << "replay slave listening on " << path << std::endl;
+            }
+        } else {
+            slaveFileDescriptor = open(device.c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+            if (slaveFileDescriptor == -1 || !test_modbus_485::configureRtuLine(slaveFileDescriptor, baud, 'N', 8, 1)) {
+                std::cerr << "ERROR: cannot open " << device << "\n";
+                return 1;
+            }
+        }
+        slave.start(slaveFileDescriptor);
+    }
+
+    bool passed = true;
+    if (playMaster) {
+        test_modbus_485::ModbusUtils modbus;
+        modbus_t* context = nullptr;
+        // Retries of the original master are already in the capture.
+        test_modbus_485::ModbusRecoveryPolicy recovery = modbus.recoveryPolicy();
+        recovery.maximumResyncRetries = 0;
+        modbus.setRecoveryPolicy(recovery);
+        if (playSlave && link == "loopback") {
+            modbus.attachTransport(&transport);
+        } else if (!modbus.openRtu(context, device, baud, 'N', 8, 1)) {
+            std::cerr << "ERROR: cannot open " << device << "\n";
+            return 1;
+        }
+
+        test_modbus_485::ModbusReplaySource masterSource(masterReader, from, to);
+        test_modbus_485::ModbusReplayMaster master(modbus, context, options);
+        runningMaster = &master;
+        passed = master.run(masterSource);
+        runningMaster = nullptr;
+        if (context) {
+            modbus.closeRtu(context);
+        }
+
+        const test_modbus_485::ModbusReplayStatistics statistics = master.statistics();
+        if (csv) {
+            statistics.printCsv(std::cout);
+        } else {
+            statistics.print(std::cout);
+        }
+    } else {
+        while (!stopRequested && !slave.finished()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+    }
+
+    slave.stop();
+    if (slaveFileDescriptor != -1) {
+        close(slaveFileDescriptor);
+    }
+    if (playSlave && !csv) {
+        printSlave(slave.statistics());
+    }
+    return passed && slave.statistics().unexpected == 0 ? 0 : 1;
+}
@@ -0,0 +1,316 @@
+// src/modbus_rtu_codec.cpp
+
+#include "modbus_rtu_codec.h"
+#include <modbus.h>
+
+namespace {
+
+// entries[0] is the classic byte table; entries[k][b] is the CRC contribution
+// of byte b followed by k zero bytes, for slicing-by-8.
+struct Crc16Table {
+    uint16_t entries[8][256];
+
+    Crc16Table() {
+        for (int value = 0; value < 256; ++value) {
+            uint16_t crc = static_cast<uint16_t>(value);
+            for (int bit = 0; bit < 8; ++bit) {
+                crc = (crc & 1u) ? static_cast<uint16_t>((crc >> 1) ^ 0xA001u) : static_cast<uint16_t>(crc >> 1);
+            }
+            entries[0][value] = crc;
+        }
+        for (int slice = 1; slice < 8; ++slice) {
+            for (int value = 0; value < 256; ++value) {
+                uint16_t previous = entries[slice - 1][value];
+                entries[slice][value] = static_cast<uint16_t>((previous >> 8) ^ entries[0][previous & 0xFF]);
+            }
+        }
+    }
+};
+
+const Crc16Table crcTable;
+
+void putUint16(uint8_t* destination, int value) {
+    destination[0] = static_cast<uint8_t>((value >> 8) & 0xFF);
+    destination[1] = static_cast<uint8_t>(value & 0xFF);
+}
+
+uint16_t getUint16(const uint8_t* source) {
+    return static_cast<uint16_t>((source[0] << 8) | source[1]);
+}
+
+} // namespace
+
+uint16_t test_modbus_485::crc16(const uint8_t* data, size_t length) {
+    return crc16Update(crc16Initial, data, length);
+}
+
+uint16_t test_modbus_485::crc16Update(uint16_t crc, const uint8_t* data, size_t length) {
+    const uint16_t (*table)[256] = crcTable.entries;
+    while (length >= 8) {
+        // The 16-bit state only overlaps the first two bytes of the slice.
+        crc = static_cast<uint16_t>(table[7][(data[0] ^ crc) & 0xFF] ^
+                                    table[6][(data[1] ^ (crc >> 8)) & 0xFF] ^
+                                    table[5][data[2]] ^ table[4][data[3]] ^
+                                    table[3][data[4]] ^ table[2][data[5]] ^
+                                    table[1][data[6]] ^ table[0][data[7]]);
+        data += 8;
+        length -= 8;
+    }
+    return crc16UpdateBytewise(crc, data, length);
+}
+
+uint16_t test_modbus_485::crc16UpdateBytewise(uint16_t crc, const uint8_t* data, size_t length) {
+    for (size_t i = 0; i < length; ++i) {
+        crc = static_cast<uint16_t>((crc >> 8) ^ crcTable.entries[0][(crc ^ data[i]) & 0xFF]);
+    }
+    return crc;
+}
+
+uint16_t test_modbus_485::crc16UpdateBitwise(uint16_t crc, const uint8_t* data, size_t length) {
+    for (size_t i = 0; i < length; ++i) {
+        crc = static_cast<uint16_t>(crc ^ data[i]);
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc & 1u) ? static_cast<uint16_t>((crc >> 1) ^ 0xA001u) : static_cast<uint16_t>(crc >> 1);
+        }
+    }
+    return crc;
+}
+
+int test_modbus_485::appendCrc(uint8_t* frame, int length) {
+    uint16_t crc = crc16(frame, static_cast<size_t>(length));
+    frame[length] = static_cast<uint8_t>(crc & 0xFF);
+    frame[length + 1] = static_cast<uint8_t>(crc >> 8);
+    return length + 2;
+}
+
+bool test_modbus_485::checkCrc(const uint8_t* frame, int length) {
+    if (length < 4) {
+        return false;
+    }
+    uint16_t crc = crc16(frame, static_cast<size_t>(length - 2));
+    return frame[length - 2] == (crc & 0xFF) && frame[length - 1] == (crc >> 8);
+}
+
+int test_modbus_485::encodeReadRequest(uint8_t functionCode, int startAddress, int count, uint8_t* pdu) {
+    pdu[0] = functionCode;
+    putUint16(pdu + 1, startAddress);
+    putUint16(pdu + 3, count);
+    return 5;
+}
+
+int test_modbus_485::encodeWriteSingleCoil(int coilAddress, bool coilStatus, uint8_t* pdu) {
+    pdu[0] = MODBUS_FC_WRITE_SINGLE_COIL;
+    putUint16(pdu + 1, coilAddress);
+    putUint16(pdu + 3, coilStatus ? 0xFF00 : 0x0000);
+    return 5;
+}
+
+int test_modbus_485::encodeWriteSingleRegister(int registerAddress, uint16_t registerValue, uint8_t* pdu) {
+    pdu[0] = MODBUS_FC_WRITE_SINGLE_REGISTER;
+    putUint16(pdu + 1, registerAddress);
+    putUint16(pdu + 3, registerValue);
+    return 5;
+}
+
+int test_modbus_485::encodeWriteMultipleCoils(int startAddress, const uint8_t* source, int count, uint8_t* pdu) {
+    int byteCount = (count + 7) / 8;
+    pdu[0] = MODBUS_FC_WRITE_MULTIPLE_COILS;
+    putUint16(pdu + 1, startAddress);
+    putUint16(pdu + 3, count);
+    pdu[5] = static_cast<uint8_t>(byteCount);
+    for (int i = 0; i < byteCount; ++i) {
+        pdu[6 + i] = 0;
+    }
+    for (int i = 0; i < count; ++i) {
+        if (source[i]) {
+            pdu[6 + i / 8] |= static_cast<uint8_t>(1u << (i % 8));
+        }
+    }
+    return 6 + byteCount;
+}
+
+int test_modbus_485::encodeWriteMultipleRegisters(int startAddress, const uint16_t* source, int count, uint8_t* pdu) {
+    pdu[0] = MODBUS_FC_WRITE_MULTIPLE_REGISTERS;
+    putUint16(pdu + 1, startAddress);
+    putUint16(pdu + 3, count);
+    pdu[5] = static_cast<uint8_t>(count * 2);
+    for (int i = 0; i < count; ++i) {
+        putUint16(pdu + 6 + 2 * i, source[i]);
+    }
+    return 6 + 2 * count;
+}
+
+int test_modbus_485::encodeWriteAndReadRegisters(int writeAddress, const uint16_t* source, int writeCount,
+                                                 int readAddress, int readCount, uint8_t* pdu) {
+    pdu[0] = MODBUS_FC_WRITE_AND_READ_REGISTERS;
+    putUint16(pdu + 1, readAddress);
+    putUint16(pdu + 3, readCount);
+    putUint16(pdu + 5, writeAddress);
+    putUint16(pdu + 7, writeCount);
+    pdu[9] = static_cast<uint8_t>(writeCount * 2);
+    for (int i = 0; i < writeCount; ++i) {
+        putUint16(pdu + 10 + 2 * i, source[i]);
+    }
+    return 10 + 2 * writeCount;
+}
+
+int test_modbus_485::encodeReadFileRecord(int fileNumber, int recordNumber, int count, uint8_t* pdu) {
+    pdu[0] = modbusFcReadFileRecord;
+    pdu[1] = 7;
+    pdu[2] = 6;
+    putUint16(pdu + 3, fileNumber);
+    putUint16(pdu + 5, recordNumber);
+    putUint16(pdu + 7, count);
+    return 9;
+}
+
+int test_modbus_485::encodeWriteFileRecord(int fileNumber, int recordNumber, const uint16_t* source, int count,
+                                           uint8_t* pdu) {
+    pdu[0] = modbusFcWriteFileRecord;
+    pdu[1] = static_cast<uint8_t>(7 + 2 * count);
+    pdu[2] = 6;
+    putUint16(pdu + 3, fileNumber);
+    putUint16(pdu + 5, recordNumber);
+    putUint16(pdu + 7, count);
+    for (int i = 0; i < count; ++i) {
+        putUint16(pdu + 9 + 2 * i, source[i]);
+    }
+    return 9 + 2 * count;
+}
+
+int test_modbus_485::decodeRegisters(const uint8_t* pdu, int length, uint16_t* destination, int count) {
+    if (length < 2 || pdu[1] != count * 2 || length < 2 + count * 2) {
+        return -1;
+    }
+    for (int i = 0; i < count; ++i) {
+        destination[i] = getUint16(pdu + 2 + 2 * i);
+    }
+    return count;
+}
+
+int test_modbus_485::decodeBits(const uint8_t* pdu, int length, uint8_t* destination, int count) {
+    int byteCount = (count + 7) / 8;
+    if (length < 2 || pdu[1] != byteCount || length < 2 + byteCount) {
+        return -1;
+    }
+    for (int i = 0; i < count; ++i) {
+        destination[i] = static_cast<uint8_t>((pdu[2 + i / 8] >> (i % 8)) & 1u);
+    }
+    return count;
+}
+
+int test_modbus_485::decodeFileRecord(const uint8_t* pdu, int length, uint16_t* destination, int count) {
+    if (length < 4 || pdu[1] != 2 + count * 2 || pdu[2] != 1 + count * 2 || pdu[3] != 6 ||
+        length < 4 + count * 2) {
+        return -1;
+    }
+    for (int i = 0; i < count; ++i) {
+        destination[i] = getUint16(pdu + 4 + 2 * i);
+    }
+    return count;
+}
+
+int test_modbus_485::expectedRtuResponseLength(const uint8_t* requestAdu, int length) {
+    if (length < 2) {
+        return -1;
+    }
+    if (requestAdu[0] == MODBUS_BROADCAST_ADDRESS) {
+        return 0;
+    }
+    switch (requestAdu[1]) {
+        case MODBUS_FC_READ_COILS:
+        case MODBUS_FC_READ_DISCRETE_INPUTS:
+            return length >= 6 ? 5 + (getUint16(requestAdu + 4) + 7) / 8 : -1;
+        case MODBUS_FC_READ_HOLDING_REGISTERS:
+        case MODBUS_FC_READ_INPUT_REGISTERS:
+            return length >= 6 ? 5 + 2 * getUint16(requestAdu + 4) : -1;
+        case MODBUS_FC_WRITE_AND_READ_REGISTERS:
+            return length >= 6 ? 5 + 2 * getUint16(requestAdu + 4) : -1;
+        case MODBUS_FC_WRITE_SINGLE_COIL:
+        case MODBUS_FC_WRITE_SINGLE_REGISTER:
+        case MODBUS_FC_WRITE_MULTIPLE_COILS:
+        case MODBUS_FC_WRITE_MULTIPLE_REGISTERS:
+            return 8;
+        case MODBUS_FC_MASK_WRITE_REGISTER:
+            return 10;
+        case MODBUS_FC_READ_EXCEPTION_STATUS:
+            return 5;
+        case modbusFcReadFileRecord: {
+            // Each 7-byte sub-request is answered by its length, its reference type and the records.
+            if (length < 3 || length < 5 + requestAdu[2]) {
+                return -1;
+            }
+            int responseLength = 5;
+            for (int offset = 3; offset + 7 <= 3 + requestAdu[2]; offset += 7) {
+                responseLength += 2 + 2 * getUint16(requestAdu + offset + 5);
+            }
+            return responseLength;
+        }
+        case modbusFcWriteFileRecord:
+            // The reply echoes the request.
+            return length >= 3 ? 5 + requestAdu[2] : -1;
+        default:
+            return -1;
+    }
+}
+
+int test_modbus_485::rtuResponseLength(const uint8_t* adu, int available) {
+    if (available < 2) {
+        return 0;
+    }
+    if (adu[1] & 0x80) {
+        return 5;
+    }
+    switch (adu[1]) {
+        case MODBUS_FC_READ_COILS:
+        case MODBUS_FC_READ_DISCRETE_INPUTS:
+        case MODBUS_FC_READ_HOLDING_REGISTERS:
+        case MODBUS_FC_READ_INPUT_REGISTERS:
+        case MODBUS_FC_WRITE_AND_READ_REGISTERS:
+        case MODBUS_FC_REPORT_SLAVE_ID:
+        case modbusFcReadFileRecord:
+        case modbusFcWriteFileRecord:
+            return available < 3 ? 0 : 5 + adu[2];
+        case MODBUS_FC_WRITE_SINGLE_COIL:
+        case MODBUS_FC_WRITE_SINGLE_REGISTER:
+        case MODBUS_FC_WRITE_MULTIPLE_COILS:
+        case MODBUS_FC_WRITE_MULTIPLE_REGISTERS:
+            return 8;
+        case MODBUS_FC_MASK_WRITE_REGISTER:
+            return 10;
+        case MODBUS_FC_READ_EXCEPTION_STATUS:
+            return 5;
+        default:
+            return -1;
+    }
+}
+
+int test_modbus_485::rtuRequestLength(const uint8_t* adu, int available) {
+    if (available < 2) {
+        return 0;
+    }
+    switch (adu[1]) {
+        case MODBUS_FC_READ_COILS:
+        case MODBUS_FC_READ_DISCRETE_INPUTS:
+        case MODBUS_FC_READ_HOLDING_REGISTERS:
+        case MODBUS_FC_READ_INPUT_REGISTERS:
+        case MODBUS_FC_WRITE_SINGLE_COIL:
+        case MODBUS_FC_WRITE_SINGLE_REGISTER:
+            return 8;
+        case MODBUS_FC_READ_EXCEPTION_STATUS:
+        case MODBUS_FC_REPORT_SLAVE_ID:
+            return 4;
+        case MODBUS_FC_WRITE_MULTIPLE_COILS:
+        case MODBUS_FC_WRITE_MULTIPLE_REGISTERS:
+            return available < 7 ? 0 : 9 + adu[6];
+        case MODBUS_FC_MASK_WRITE_REGISTER:
+            return 10;
+        case MODBUS_FC_WRITE_AND_READ_REGISTERS:
+            return available < 11 ? 0 : 13 + adu[10];
+        case modbusFcReadFileRecord:
+        case modbusFcWriteFileRecord:
+            return available < 3 ? 0 : 5 + adu[2];
+        default:
+            return -1;
+    }
+}
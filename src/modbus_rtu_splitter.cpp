@@ -0,0 +1,147 @@
+// src/modbus_rtu_splitter.cpp
+
+#include "modbus_rtu_splitter.h"
+#include "modbus_rtu_codec.h"
+#include <modbus.h>
+#include <algorithm>
+#include <utility>
+
+test_modbus_485::ModbusRtuFrameSplitter::ModbusRtuFrameSplitter(FrameCallback onFrame, FrameCallback onDiscard)
+    : onFrame_(std::move(onFrame)),
+      onDiscard_(std::move(onDiscard)) {}
+
+void test_modbus_485::ModbusRtuFrameSplitter::push(const uint8_t* data, size_t length) {
+    buffer_.insert(buffer_.end(), data, data + length);
+    while (front_ < buffer_.size()) {
+        int frameLength = frameAtFront(false);
+        if (frameLength == 0) {
+            break;
+        }
+        if (frameLength < 0) {
+            discard();
+        } else {
+            emit(frameLength);
+        }
+    }
+    compact();
+}
+
+void test_modbus_485::ModbusRtuFrameSplitter::gap() {
+    while (front_ < buffer_.size()) {
+        int frameLength = frameAtFront(true);
+        if (frameLength <= 0) {
+            discard();
+        } else {
+            emit(frameLength);
+        }
+    }
+    flushDiscarded();
+    compact();
+}
+
+uint64_t test_modbus_485::ModbusRtuFrameSplitter::frameCount() const {
+    return frames_;
+}
+
+uint64_t test_modbus_485::ModbusRtuFrameSplitter::discardedBytes() const {
+    return discarded_;
+}
+
+int test_modbus_485::ModbusRtuFrameSplitter::frameAtFront(bool final) const {
+    const uint8_t* frame = buffer_.data() + front_;
+    const int available = static_cast<int>(std::min<size_t>(buffer_.size() - front_, MODBUS_RTU_MAX_ADU_LENGTH));
+    if (available < 4) {
+        return final ? -1 : 0;
+    }
+    if (frame[0] > 247) {
+        return -1;
+    }
+
+    // A frame must be one of the two lengths its header implies and carry a valid CRC.
+    bool waiting = false;
+    bool known = false;
+    const int candidates[] = {rtuRequestLength(frame, available), rtuResponseLength(frame, available)};
+    for (int candidate : candidates) {
+        known = known || candidate >= 0;
+        if (candidate == 0 || candidate > available) {
+            waiting = waiting || candidate <= MODBUS_RTU_MAX_ADU_LENGTH;
+            continue;
+        }
+        if (candidate >= 4 && crc16Update(crc16Initial, frame, static_cast<size_t>(candidate)) == 0) {
+            return candidate;
+        }
+    }
+    if (waiting && !final) {
+        return 0;
+    }
+    if (known) {
+        return -1;
+    }
+
+    // Unknown function code: the nearest zero residue ends the frame, unless
+    // a frame of known length starts inside it, which makes the residue a fluke.
+    uint16_t crc = crc16Update(crc16Initial, frame, 3);
+    for (int length = 4; length <= available; ++length) {
+        crc = crc16Update(crc, frame + length - 1, 1);
+        if (crc == 0) {
+            for (int offset = 1; offset < length; ++offset) {
+                if (knownFrameAt(frame + offset, available - offset)) {
+                    return -1;
+                }
+            }
+            return length;
+        }
+    }
+    return !final && available < MODBUS_RTU_MAX_ADU_LENGTH ? 0 : -1;
+}
+
+bool test_modbus_485::ModbusRtuFrameSplitter::knownFrameAt(const uint8_t* frame, int available) {
+    if (available < 4 || frame[0] > 247) {
+        return false;
+    }
+    const int candidates[] = {rtuRequestLength(frame, available), rtuResponseLength(frame, available)};
+    for (int candidate : candidates) {
+        if (candidate >= 4 && candidate <= available &&
+            crc16Update(crc16Initial, frame, static_cast<size_t>(candidate)) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void test_modbus_485::ModbusRtuFrameSplitter::discard() {
+    ++discarded_;
+    if (onDiscard_) {
+        discardedRun_.push_back(buffer_[front_]);
+        if (discardedRun_.size() >= MODBUS_RTU_MAX_ADU_LENGTH) {
+            flushDiscarded();
+        }
+    }
+    ++front_;
+}
+
+void test_modbus_485::ModbusRtuFrameSplitter::emit(int length) {
+    flushDiscarded();
+    ++frames_;
+    if (onFrame_) {
+        onFrame_(buffer_.data() + front_, length);
+    }
+    front_ += static_cast<size_t>(length);
+}
+
+void test_modbus_485::ModbusRtuFrameSplitter::flushDiscarded() {
+    if (!discardedRun_.empty()) {
+        onDiscard_(discardedRun_.data(), static_cast<int>(discardedRun_.size()));
+        discardedRun_.clear();
+    }
+}
+
+void test_modbus_485::ModbusRtuFrameSplitter::compact() {
+    if (front_ == buffer_.size()) {
+        buffer_.clear();
+        front_ = 0;
+    } else if (front_ >= 4096) {
+        buffer_.erase(buffer_.begin(), buffer_.begin() + static_cast<std::ptrdiff_t>(front_));
+        front_ = 0;
+    }
+}
@@ -0,0 +1,99 @@
+// src/modbus_serial_speed.cpp
+//
+// Uses the kernel's termios2 interface, whose headers clash with <termios.h>;
+// keep this translation unit free of glibc terminal headers.
+
+#include "modbus_serial_speed.h"
+#include <asm/ioctls.h>
+#include <asm/termbits.h>
+#include <cstdio>
+#include <sys/ioctl.h>
+
+bool test_modbus_485::standardBaudRateConstant(int baudRate, unsigned int& speedConstant) {
+    switch (baudRate) {
+        case 50:      speedConstant = B50;      return true;
+        case 75:      speedConstant = B75;      return true;
+        case 110:     speedConstant = B110;     return true;
+        case 134:     speedConstant = B134;     return true;
+        case 150:     speedConstant = B150;     return true;
+        case 200:     speedConstant = B200;     return true;
+        case 300:     speedConstant = B300;     return true;
+        case 600:     speedConstant = B600;     return true;
+        case 1200:    speedConstant = B1200;    return true;
+        case 1800:    speedConstant = B1800;    return true;
+        case 2400:    speedConstant = B2400;    return true;
+        case 4800:    speedConstant = B4800;    return true;
+        case 9600:    speedConstant = B9600;    return true;
+        case 19200:   speedConstant = B19200;   return true;
+        case 38400:   speedConstant = B38400;   return true;
+        case 57600:   speedConstant = B57600;   return true;
+        case 115200:  speedConstant = B115200;  return true;
+        case 230400:  speedConstant = B230400;  return true;
+#ifdef B460800
+        case 460800:  speedConstant = B460800;  return true;
+#endif
+#ifdef B500000
+        case 500000:  speedConstant = B500000;  return true;
+#endif
+#ifdef B576000
+        case 576000:  speedConstant = B576000;  return true;
+#endif
+#ifdef B921600
+        case 921600:  speedConstant = B921600;  return true;
+#endif
+#ifdef B1000000
+        case 1000000: speedConstant = B1000000; return true;
+#endif
+#ifdef B1152000
+        case 1152000: speedConstant = B1152000; return true;
+#endif
+#ifdef B1500000
+        case 1500000: speedConstant = B1500000; return true;
+#endif
+#ifdef B2000000
+        case 2000000: speedConstant = B2000000; return true;
+#endif
+#ifdef B2500000
+        case 2500000: speedConstant = B2500000; return true;
+#endif
+#ifdef B3000000
+        case 3000000: speedConstant = B3000000; return true;
+#endif
+#ifdef B3500000
+        case 3500000: speedConstant = B3500000; return true;
+#endif
+#ifdef B4000000
+        case 4000000: speedConstant = B4000000; return true;
+#endif
+        default:
+            return false;
+    }
+}
+
+bool test_modbus_485::setArbitraryBaudRate(int fileDescriptor, int baudRate) {
+    termios2 settings;
+    if (ioctl(fileDescriptor, TCGETS2, &settings) != 0) {
+        perror("[setArbitraryBaudRate] TCGETS2");
+        return false;
+    }
+    settings.c_cflag &= ~CBAUD;
+    settings.c_cflag |= BOTHER;
+    settings.c_ospeed = static_cast<speed_t>(baudRate);
+    // Input speed follows the output speed.
+    settings.c_cflag &= ~(CBAUD << IBSHIFT);
+    settings.c_ispeed = 0;
+    if (ioctl(fileDescriptor, TCSETS2, &settings) != 0) {
+        perror("[setArbitraryBaudRate] TCSETS2");
+        return false;
+    }
+    return true;
+}
+
+int test_modbus_485::readBaudRate(int fileDescriptor) {
+    termios2 settings;
+    if (ioctl(fileDescriptor, TCGETS2, &settings) != 0) {
+        perror("[readBaudRate] TCGETS2");
+        return -1;
+    }
+    return static_cast<int>(settings.c_ospeed);
+}
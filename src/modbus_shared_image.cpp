@@ -0,0 +1,405 @@
+// src/modbus_shared_image.cpp
+
+#include "modbus_shared_image.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <new>
+#include <thread>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+namespace format = test_modbus_485::shared_image_format;
+
+uint64_t clockNanoseconds(clockid_t clock) {
+    timespec now{};
+    clock_gettime(clock, &now);
+    return static_cast<uint64_t>(now.tv_sec) * 1000000000ull + static_cast<uint64_t>(now.tv_nsec);
+}
+
+bool isBitTable(test_modbus_485::ModbusTable table) {
+    return table == test_modbus_485::ModbusTable::Coils || table == test_modbus_485::ModbusTable::DiscreteInputs;
+}
+
+// Spins before a reader starts yielding, yields between writer liveness
+// checks, and yields before it gives up on a block that stays locked.
+constexpr int spinAttempts = 64;
+constexpr int livenessCheckInterval = 1024;
+constexpr int maximumReadAttempts = 1 << 16;
+
+size_t segmentBytes(uint32_t maximumBlocks, uint64_t dataWords) {
+    return sizeof(format::Header) + maximumBlocks * sizeof(format::BlockHeader) +
+           static_cast<size_t>(dataWords) * sizeof(std::atomic<uint16_t>);
+}
+
+} // namespace
+
+test_modbus_485::ModbusSharedImageWriter::ModbusSharedImageWriter()
+    : fileDescriptor_(-1),
+      mapping_(nullptr),
+      mappingBytes_(0),
+      header_(nullptr),
+      blocks_(nullptr),
+      data_(nullptr),
+      dataUsed_(0) {}
+
+test_modbus_485::ModbusSharedImageWriter::~ModbusSharedImageWriter() {
+    close();
+}
+
+bool test_modbus_485::ModbusSharedImageWriter::create(const std::string& name, const ModbusSharedImageOptions& options) {
+    close();
+    if (options.maximumBlocks < 1 || options.dataWords < 1) {
+        std::cerr << "[ModbusSharedImageWriter::create] empty image\n";
+        return false;
+    }
+    // Readers still mapping an earlier image keep it; they see it closed.
+    ::shm_unlink(name.c_str());
+    fileDescriptor_ = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    if (fileDescriptor_ == -1) {
+        perror("[ModbusSharedImageWriter::create] shm_open");
+        return false;
+    }
+    name_ = name;
+    mappingBytes_ = segmentBytes(options.maximumBlocks, options.dataWords);
+    if (ftruncate(fileDescriptor_, static_cast<off_t>(mappingBytes_)) == -1) {
+        perror("[ModbusSharedImageWriter::create] ftruncate");
+        close();
+        return false;
+    }
+    void* mapping = mmap(nullptr, mappingBytes_, PROT_READ | PROT_WRITE, MAP_SHARED, fileDescriptor_, 0);
+    if (mapping == MAP_FAILED) {
+        perror("[ModbusSharedImageWriter::create] mmap");
+        mappingBytes_ = 0;
+        close();
+        return false;
+    }
+    mapping_ = static_cast<uint8_t*>(mapping);
+
+    // The segment is zero-filled; construct the shared objects in place.
+    header_ = new (mapping_) format::Header();
+    blocks_ = reinterpret_cast<format::BlockHeader*>(mapping_ + sizeof(format::Header));
+    for (uint32_t i = 0; i < options.maximumBlocks; ++i) {
+        new (blocks_ + i) format::BlockHeader();
+    }
+    data_ = reinterpret_cast<std::atomic<uint16_t>*>(blocks_ + options.maximumBlocks);
+    for (size_t i = 0; i < options.dataWords; ++i) {
+        new (data_ + i) std::atomic<uint16_t>(0);
+    }
+    std::memcpy(header_->magic, format::magic, sizeof(header_->magic));
+    header_->state.store(format::stateLive, std::memory_order_relaxed);
+    header_->maximumBlocks = options.maximumBlocks;
+    header_->dataWords = options.dataWords;
+    header_->startRealtime = clockNanoseconds(CLOCK_REALTIME);
+    header_->blockCount.store(0, std::memory_order_relaxed);
+    header_->writerProcess = static_cast<uint32_t>(getpid());
+    header_->version.store(format::version, std::memory_order_release);
+    dataUsed_ = 0;
+    blockIndex_.clear();
+    return true;
+}
+
+void test_modbus_485::ModbusSharedImageWriter::close(bool keep) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (mapping_) {
+        header_->state.store(format::stateClosed, std::memory_order_release);
+        munmap(mapping_, mappingBytes_);
+        mapping_ = nullptr;
+        mappingBytes_ = 0;
+        header_ = nullptr;
+        blocks_ = nullptr;
+        data_ = nullptr;
+    }
+    if (fileDescriptor_ != -1) {
+        ::close(fileDescriptor_);
+        fileDescriptor_ = -1;
+        if (!keep) {
+            ::shm_unlink(name_.c_str());
+        }
+    }
+    blockIndex_.clear();
+}
+
+bool test_modbus_485::ModbusSharedImageWriter::publishRegisters(int slaveIdentifier,
+                                                                ModbusTable table,
+                                                                int startAddress,
+                                                                int count,
+                                                                const uint16_t* values,
+                                                                uint64_t timestamp) {
+    if (isBitTable(table)) {
+        return false;
+    }
+    return publish(slaveIdentifier, table, startAddress, count, values, timestamp);
+}
+
+bool test_modbus_485::ModbusSharedImageWriter::publishBits(int slaveIdentifier,
+                                                           ModbusTable table,
+                                                           int startAddress,
+                                                           int count,
+                                                           const uint8_t* values,
+                                                           uint64_t timestamp) {
+    if (!isBitTable(table)) {
+        return false;
+    }
+    return publish(slaveIdentifier, table, startAddress, count, values, timestamp);
+}
+
+uint64_t test_modbus_485::ModbusSharedImageWriter::now() {
+    return clockNanoseconds(CLOCK_MONOTONIC);
+}
+
+template<typename Value>
+bool test_modbus_485::ModbusSharedImageWriter::publish(int slaveIdentifier,
+                                                       ModbusTable table,
+                                                       int startAddress,
+                                                       int count,
+                                                       const Value* values,
+                                                       uint64_t timestamp) {
+    if (timestamp == 0) {
+        timestamp = now();
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    const int index = block(slaveIdentifier, table, startAddress, count);
+    if (index < 0) {
+        return false;
+    }
+    format::BlockHeader& header = blocks_[index];
+    std::atomic<uint16_t>* data = data_ + header.dataOffset;
+
+    // Odd while stores are in progress; the fence keeps them from moving above the increment.
+    const uint32_t sequence = header.sequence.load(std::memory_order_relaxed);
+    header.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (int i = 0; i < count; ++i) {
+        data[i].store(static_cast<uint16_t>(values[i]), std::memory_order_relaxed);
+    }
+    header.generation.store(header.generation.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    header.timestamp.store(timestamp, std::memory_order_relaxed);
+    header.sequence.store(sequence + 2, std::memory_order_release);
+    return true;
+}
+
+int test_modbus_485::ModbusSharedImageWriter::block(int slaveIdentifier,
+                                                    ModbusTable table,
+                                                    int startAddress,
+                                                    int count) {
+    if (!mapping_ || slaveIdentifier < 0 || slaveIdentifier > 247 || startAddress < 0 || count < 1 ||
+        startAddress + count > 65536) {
+        return -1;
+    }
+    const auto key = std::make_tuple(slaveIdentifier, static_cast<int>(table), startAddress, count);
+    auto entry = blockIndex_.find(key);
+    if (entry != blockIndex_.end()) {
+        return entry->second;
+    }
+    const uint32_t index = header_->blockCount.load(std::memory_order_relaxed);
+    if (index >= header_->maximumBlocks || dataUsed_ + static_cast<uint64_t>(count) > header_->dataWords) {
+        std::cerr << "[ModbusSharedImageWriter] image full, slave " << slaveIdentifier << " @" << startAddress
+                  << " x" << count << " not published\n";
+        blockIndex_[key] = -1;
+        return -1;
+    }
+    format::BlockHeader& header = blocks_[index];
+    header.slaveIdentifier = static_cast<uint8_t>(slaveIdentifier);
+    header.table = static_cast<uint8_t>(table);
+    header.startAddress = static_cast<uint32_t>(startAddress);
+    header.count = static_cast<uint32_t>(count);
+    header.dataOffset = static_cast<uint32_t>(dataUsed_);
+    dataUsed_ += static_cast<uint64_t>(count);
+    // Readers see the entry only once it is filled in.
+    header_->blockCount.store(index + 1, std::memory_order_release);
+    blockIndex_[key] = static_cast<int>(index);
+    return static_cast<int>(index);
+}
+
+test_modbus_485::ModbusSharedImageReader::ModbusSharedImageReader()
+    : fileDescriptor_(-1),
+      mapping_(nullptr),
+      mappingBytes_(0),
+      header_(nullptr),
+      blocks_(nullptr),
+      data_(nullptr) {}
+
+test_modbus_485::ModbusSharedImageReader::~ModbusSharedImageReader() {
+    close();
+}
+
+bool test_modbus_485::ModbusSharedImageReader::open(const std::string& name) {
+    close();
+    fileDescriptor_ = ::shm_open(name.c_str(), O_RDONLY | O_CLOEXEC, 0);
+    if (fileDescriptor_ == -1) {
+        perror("[ModbusSharedImageReader::open] shm_open");
+        return false;
+    }
+    struct stat status{};
+    if (fstat(fileDescriptor_, &status) == -1 || static_cast<size_t>(status.st_size) < sizeof(format::Header)) {
+        std::cerr << "[ModbusSharedImageReader::open] " << name << " is not a shared image (yet)\n";
+        close();
+        return false;
+    }
+    mappingBytes_ = static_cast<size_t>(status.st_size);
+    void* mapping = mmap(nullptr, mappingBytes_, PROT_READ, MAP_SHARED, fileDescriptor_, 0);
+    if (mapping == MAP_FAILED) {
+        perror("[ModbusSharedImageReader::open] mmap");
+        mappingBytes_ = 0;
+        close();
+        return false;
+    }
+    mapping_ = static_cast<const uint8_t*>(mapping);
+    header_ = reinterpret_cast<const format::Header*>(mapping_);
+
+    if (header_->version.load(std::memory_order_acquire) != format::version ||
+        std::memcmp(header_->magic, format::magic, sizeof(header_->magic)) != 0 ||
+        segmentBytes(header_->maximumBlocks, header_->dataWords) > mappingBytes_) {
+        std::cerr << "[ModbusSharedImageReader::open] " << name << " is not a shared image (yet)\n";
+        close();
+        return false;
+    }
+    blocks_ = reinterpret_cast<const format::BlockHeader*>(mapping_ + sizeof(format::Header));
+    data_ = reinterpret_cast<const std::atomic<uint16_t>*>(blocks_ + header_->maximumBlocks);
+    return true;
+}
+
+void test_modbus_485::ModbusSharedImageReader::close() {
+    if (mapping_) {
+        munmap(const_cast<uint8_t*>(mapping_), mappingBytes_);
+        mapping_ = nullptr;
+        mappingBytes_ = 0;
+        header_ = nullptr;
+        blocks_ = nullptr;
+        data_ = nullptr;
+    }
+    if (fileDescriptor_ != -1) {
+        ::close(fileDescriptor_);
+        fileDescriptor_ = -1;
+    }
+}
+
+int test_modbus_485::ModbusSharedImageReader::find(int slaveIdentifier,
+                                                   ModbusTable table,
+                                                   int startAddress,
+                                                   int count) const {
+    const int blocks = blockCount();
+    for (int i = 0; i < blocks; ++i) {
+        const format::BlockHeader& header = blocks_[i];
+        if (header.slaveIdentifier == slaveIdentifier && header.table == static_cast<uint8_t>(table) &&
+            static_cast<int64_t>(header.startAddress) <= startAddress &&
+            static_cast<int64_t>(startAddress) + count <= static_cast<int64_t>(header.startAddress) + header.count) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+bool test_modbus_485::ModbusSharedImageReader::readRegisters(int block,
+                                                             int startAddress,
+                                                             int count,
+                                                             uint16_t* destination,
+                                                             ModbusSharedStamp* stamp) const {
+    return read(block, false, startAddress, count, destination, stamp);
+}
+
+bool test_modbus_485::ModbusSharedImageReader::readBits(int block,
+                                                        int startAddress,
+                                                        int count,
+                                                        uint8_t* destination,
+                                                        ModbusSharedStamp* stamp) const {
+    return read(block, true, startAddress, count, destination, stamp);
+}
+
+bool test_modbus_485::ModbusSharedImageReader::readRegisters(int slaveIdentifier,
+                                                             ModbusTable table,
+                                                             int startAddress,
+                                                             int count,
+                                                             uint16_t* destination,
+                                                             ModbusSharedStamp* stamp) const {
+    return readRegisters(find(slaveIdentifier, table, startAddress, count), startAddress, count, destination, stamp);
+}
+
+bool test_modbus_485::ModbusSharedImageReader::readBits(int slaveIdentifier,
+                                                        ModbusTable table,
+                                                        int startAddress,
+                                                        int count,
+                                                        uint8_t* destination,
+                                                        ModbusSharedStamp* stamp) const {
+    return readBits(find(slaveIdentifier, table, startAddress, count), startAddress, count, destination, stamp);
+}
+
+int test_modbus_485::ModbusSharedImageReader::blockCount() const {
+    if (!header_) {
+        return 0;
+    }
+    const uint32_t blocks = header_->blockCount.load(std::memory_order_acquire);
+    return static_cast<int>(blocks < header_->maximumBlocks ? blocks : header_->maximumBlocks);
+}
+
+const test_modbus_485::shared_image_format::BlockHeader&
+test_modbus_485::ModbusSharedImageReader::blockHeader(int block) const {
+    return blocks_[block];
+}
+
+bool test_modbus_485::ModbusSharedImageReader::writerClosed() const {
+    return !header_ || header_->state.load(std::memory_order_acquire) == format::stateClosed;
+}
+
+bool test_modbus_485::ModbusSharedImageReader::writerAlive() const {
+    if (writerClosed()) {
+        return false;
+    }
+    const pid_t writer = static_cast<pid_t>(header_->writerProcess);
+    return ::kill(writer, 0) == 0 || errno == EPERM;
+}
+
+template<typename Value>
+bool test_modbus_485::ModbusSharedImageReader::read(int block,
+                                                    bool bits,
+                                                    int startAddress,
+                                                    int count,
+                                                    Value* destination,
+                                                    ModbusSharedStamp* stamp) const {
+    if (block < 0 || block >= blockCount()) {
+        return false;
+    }
+    const format::BlockHeader& header = blocks_[block];
+    const int offset = startAddress - static_cast<int>(header.startAddress);
+    if (isBitTable(static_cast<ModbusTable>(header.table)) != bits || offset < 0 || count < 0 ||
+        offset + count > static_cast<int>(header.count)) {
+        return false;
+    }
+    const std::atomic<uint16_t>* data = data_ + header.dataOffset + offset;
+    for (int attempt = 0;; ++attempt) {
+        const uint32_t before = header.sequence.load(std::memory_order_acquire);
+        if ((before & 1u) == 0) {
+            for (int i = 0; i < count; ++i) {
+                destination[i] = static_cast<Value>(data[i].load(std::memory_order_relaxed));
+            }
+            const uint64_t generation = header.generation.load(std::memory_order_relaxed);
+            const uint64_t timestamp = header.timestamp.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (header.sequence.load(std::memory_order_relaxed) == before) {
+                if (stamp) {
+                    *stamp = ModbusSharedStamp{generation, timestamp};
+                }
+                return true;
+            }
+        }
+        // The writer is inside this block; it holds it for one copy unless it
+        // was preempted, or died, which leaves the sequence odd for good.
+        if (attempt >= maximumReadAttempts) {
+            return false;
+        }
+        if (attempt >= spinAttempts) {
+            if (attempt % livenessCheckInterval == 0 && !writerAlive()) {
+                return false;
+            }
+            std::this_thread::yield();
+        }
+    }
+}
@@ -0,0 +1,194 @@
+// src/modbus_slave_simulator.cpp
+
+#include "modbus_slave_simulator.h"
+#include "modbus_data_model.h"
+#include "modbus_rtu_codec.h"
+#include "modbus_timing.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <poll.h>
+#include <unistd.h>
+
+test_modbus_485::ModbusSlaveSimulator::ModbusSlaveSimulator()
+    : fileDescriptor_(-1),
+      context_(nullptr),
+      running_(false),
+      requests_(0),
+      dropped_(0) {}
+
+test_modbus_485::ModbusSlaveSimulator::~ModbusSlaveSimulator() {
+    stop();
+    for (auto& entry : slaves_) {
+        ::modbus_mapping_free(entry.second);
+    }
+}
+
+bool test_modbus_485::ModbusSlaveSimulator::addSlave(int slaveIdentifier, int numberOfBits, int numberOfRegisters) {
+    if (running_.load() || slaveIdentifier < 1 || slaveIdentifier > 247 || slaves_.count(slaveIdentifier)) {
+        std::cerr << "[addSlave] invalid or duplicate slave " << slaveIdentifier << "\n";
+        return false;
+    }
+    modbus_mapping_t* mapping = ::modbus_mapping_new(numberOfBits, numberOfBits, numberOfRegisters, numberOfRegisters);
+    if (!mapping) {
+        std::cerr << "[addSlave] modbus_mapping_new failed: " << modbus_strerror(errno) << "\n";
+        return false;
+    }
+    slaves_[slaveIdentifier] = mapping;
+    return true;
+}
+
+modbus_mapping_t* test_modbus_485::ModbusSlaveSimulator::mapping(int slaveIdentifier) {
+    auto entry = slaves_.find(slaveIdentifier);
+    return entry == slaves_.end() ? nullptr : entry->second;
+}
+
+bool test_modbus_485::ModbusSlaveSimulator::start(int fileDescriptor, const ModbusSimulatorOptions& options) {
+    if (running_.load()) {
+        std::cerr << "[start] already running\n";
+        return false;
+    }
+    // The context only formats replies; it never opens a device.
+    context_ = ::modbus_new_rtu("/dev/null", options.baudRate, 'N', 8, 1);
+    if (!context_ || ::modbus_set_socket(context_, fileDescriptor) == -1) {
+        std::cerr << "[start] cannot create reply context: " << modbus_strerror(errno) << "\n";
+        if (context_) {
+            ::modbus_free(context_);
+            context_ = nullptr;
+        }
+        return false;
+    }
+    fileDescriptor_ = fileDescriptor;
+    options_ = options;
+    running_.store(true);
+    thread_ = std::thread(&ModbusSlaveSimulator::run, this);
+    return true;
+}
+
+void test_modbus_485::ModbusSlaveSimulator::stop() {
+    running_.store(false);
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    if (context_) {
+        ::modbus_free(context_);
+        context_ = nullptr;
+    }
+}
+
+uint64_t test_modbus_485::ModbusSlaveSimulator::requestCount() const {
+    return requests_.load(std::memory_order_relaxed);
+}
+
+uint64_t test_modbus_485::ModbusSlaveSimulator::droppedCount() const {
+    return dropped_.load(std::memory_order_relaxed);
+}
+
+void test_modbus_485::ModbusSlaveSimulator::run() {
+    uint8_t buffer[2 * MODBUS_RTU_MAX_ADU_LENGTH];
+    int length = 0;
+    // Silence that ends a partial frame; generous because the pty is not paced.
+    constexpr int frameSilenceMilliseconds = 20;
+
+    while (running_.load(std::memory_order_relaxed)) {
+        pollfd descriptor{fileDescriptor_, POLLIN, 0};
+        int ready = ::poll(&descriptor, 1, length > 0 ? frameSilenceMilliseconds : 50);
+        if (ready < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("[ModbusSlaveSimulator] poll");
+            break;
+        }
+        if (ready == 0) {
+            if (length > 0) {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                length = 0;
+            }
+            continue;
+        }
+
+        ssize_t received = ::read(fileDescriptor_, buffer + length, sizeof(buffer) - length);
+        if (received < 0) {
+            if (errno == EAGAIN || errno == EINTR) {
+                continue;
+            }
+            if (errno == EIO) {
+                // pty master with no slave end open: wait for the next master to connect.
+                ::usleep(10000);
+                continue;
+            }
+            perror("[ModbusSlaveSimulator] read");
+            break;
+        }
+        length += static_cast<int>(received);
+
+        while (length > 0) {
+            int frameLength = rtuRequestLength(buffer, length);
+            if (frameLength < 0 || frameLength > MODBUS_RTU_MAX_ADU_LENGTH) {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                length = 0;
+                break;
+            }
+            if (frameLength == 0 || length < frameLength) {
+                break;
+            }
+            if (checkCrc(buffer, frameLength)) {
+                serve(buffer, frameLength);
+            } else {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+            }
+            std::memmove(buffer, buffer + frameLength, length - frameLength);
+            length -= frameLength;
+        }
+    }
+}
+
+void test_modbus_485::ModbusSlaveSimulator::serve(const uint8_t* request, int length) {
+    const int slaveIdentifier = request[0];
+    if (slaveIdentifier == MODBUS_BROADCAST_ADDRESS) {
+        // libmodbus applies a broadcast to the mapping but sends nothing back in RTU mode.
+        for (auto& entry : slaves_) {
+            ::modbus_reply(context_, request, length, entry.second);
+        }
+        requests_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    auto slave = slaves_.find(slaveIdentifier);
+    if (slave == slaves_.end()) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    std::chrono::nanoseconds delay = options_.turnaround;
+    if (options_.emulateWireTime) {
+        int responseLength = expectedRtuResponseLength(request, length);
+        std::chrono::nanoseconds character = characterTime(options_.baudRate, options_.bitsPerCharacter);
+        delay += character * (length + (responseLength > 0 ? responseLength : 0))
+                 + interFrameDelay(options_.baudRate, options_.bitsPerCharacter);
+    }
+    if (delay.count() > 0) {
+        std::this_thread::sleep_for(delay);
+    }
+
+    if (request[1] == modbusFcReadFileRecord || request[1] == modbusFcWriteFileRecord) {
+        // libmodbus has no file record support; the records are views of the holding registers.
+        uint8_t response[MODBUS_RTU_MAX_ADU_LENGTH];
+        response[0] = static_cast<uint8_t>(slaveIdentifier);
+        int responseLength = processFileRecordRequest(request + 1, length - 3, slave->second->tab_registers,
+                                                      slave->second->nb_registers, response + 1);
+        responseLength = appendCrc(response, responseLength + 1);
+        if (::write(fileDescriptor_, response, responseLength) != responseLength) {
+            perror("[ModbusSlaveSimulator] write");
+        }
+        requests_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    ::modbus_set_slave(context_, slaveIdentifier);
+    if (::modbus_reply(context_, request, length, slave->second) == -1) {
+        std::cerr << "[ModbusSlaveSimulator] reply failed: " << modbus_strerror(errno) << "\n";
+    }
+    requests_.fetch_add(1, std::memory_order_relaxed);
+}
@@ -0,0 +1,118 @@
+// src/modbus_sniffer.cpp
+//
+// Passive RS-485 recorder: listens on a tapped line without ever writing to
+// it and stores every request, response and run of garbage bytes in a
+// capture file, stamped with CLOCK_MONOTONIC nanoseconds. Memory use is one
+// capture segment; with a segment limit the file becomes a ring holding the
+// most recent traffic, so the recorder can run unattended for days.
+// Read the file back with modbus_capture.
+//
+// usage: modbus_sniffer <serial-device> <baud> <capture-file> [segment-MiB] [max-segments]
+
+#include "modbus_capture.h"
+#include "modbus_timing.h"
+#include "modbus_utils.h"
+#include <cerrno>
+#include <csignal>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+namespace {
+
+volatile std::sig_atomic_t stopRequested = 0;
+
+void onSignal(int) {
+    stopRequested = 1;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 4) {
+        std::cerr << "usage: modbus_sniffer <serial-device> <baud> <capture-file> [segment-MiB] [max-segments]\n";
+        return 1;
+    }
+    const char* device         = argv[1];
+    const int baud             = std::atoi(argv[2]);
+    const char* capturePath    = argv[3];
+    const int segmentMebibytes = (argc > 4 ? std::atoi(argv[4]) : 1);
+    const int maximumSegments  = (argc > 5 ? std::atoi(argv[5]) : 0);
+    constexpr char parity      = 'N';
+    constexpr int dataBits     = 8;
+    constexpr int stopBits     = 1;
+
+    const int characterBits = test_modbus_485::bitsPerCharacter(parity, dataBits, stopBits);
+    const int fileDescriptor = open(device, O_RDONLY | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+    if (fileDescriptor == -1) {
+        perror("[modbus_sniffer] open");
+        return 1;
+    }
+    if (!test_modbus_485::configureRtuLine(fileDescriptor, baud, parity, dataBits, stopBits)) {
+        std::cerr << "ERROR: cannot configure " << device << "\n";
+        close(fileDescriptor);
+        return 1;
+    }
+    // Bytes queued before now have no usable arrival time.
+    tcflush(fileDescriptor, TCIFLUSH);
+
+    test_modbus_485::ModbusCaptureOptions options;
+    options.segmentBytes = static_cast<size_t>(segmentMebibytes > 0 ? segmentMebibytes : 1) << 20;
+    options.maximumSegments = static_cast<uint32_t>(maximumSegments > 0 ? maximumSegments : 0);
+    options.baudRate = static_cast<uint32_t>(baud);
+    options.bitsPerCharacter = static_cast<uint32_t>(characterBits);
+    test_modbus_485::ModbusCaptureWriter writer;
+    if (!writer.open(capturePath, options)) {
+        close(fileDescriptor);
+        return 1;
+    }
+    test_modbus_485::ModbusCaptureRecorder recorder(writer, baud, characterBits);
+
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+    std::cout << "recording " << device << " @ " << baud << " to " << capturePath << " (Ctrl-C to stop)\n";
+
+    // A silence of t3.5 ends a frame; poll for it directly.
+    const int64_t frameGap = test_modbus_485::interFrameDelay(baud, characterBits).count();
+    const timespec gapTimeout{static_cast<time_t>(frameGap / 1000000000), static_cast<long>(frameGap % 1000000000)};
+    uint8_t buffer[4096];
+    bool dataSinceGap = false;
+    while (!stopRequested) {
+        pollfd descriptor{fileDescriptor, POLLIN, 0};
+        const int ready = ppoll(&descriptor, 1, dataSinceGap ? &gapTimeout : nullptr, nullptr);
+        if (ready == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("[modbus_sniffer] ppoll");
+            break;
+        }
+        if (ready == 0) {
+            recorder.gap();
+            dataSinceGap = false;
+            continue;
+        }
+        const ssize_t received = read(fileDescriptor, buffer, sizeof(buffer));
+        const uint64_t receivedAt = test_modbus_485::ModbusCaptureWriter::now();
+        if (received > 0) {
+            recorder.push(buffer, static_cast<size_t>(received), receivedAt);
+            dataSinceGap = true;
+        } else if (received == -1 && errno != EAGAIN && errno != EINTR) {
+            perror("[modbus_sniffer] read");
+            break;
+        }
+    }
+    recorder.gap();
+    writer.close();
+    close(fileDescriptor);
+
+    std::cout << "frames " << recorder.frameCount() << ", garbage bytes " << recorder.garbageBytes()
+              << ", records written " << writer.recordCount() << ", dropped " << recorder.droppedRecords() << "\n";
+    return recorder.droppedRecords() ? 1 : 0;
+}
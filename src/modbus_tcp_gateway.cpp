@@ -0,0 +1,386 @@
+// src/modbus_tcp_gateway.cpp
+
+#include "modbus_tcp_gateway.h"
+#include <modbus.h>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+
+bool isRead(uint8_t functionCode) {
+    return functionCode == MODBUS_FC_READ_COILS ||
+           functionCode == MODBUS_FC_READ_DISCRETE_INPUTS ||
+           functionCode == MODBUS_FC_READ_HOLDING_REGISTERS ||
+           functionCode == MODBUS_FC_READ_INPUT_REGISTERS;
+}
+
+/**
+ * @brief Exception code a gateway returns for a transaction that failed on the bus.
+ */
+int gatewayExceptionCode(int errorCode) {
+    if (errorCode > MODBUS_ENOBASE && errorCode < MODBUS_ENOBASE + MODBUS_EXCEPTION_MAX) {
+        return errorCode - MODBUS_ENOBASE;
+    }
+    switch (errorCode) {
+        case ETIMEDOUT:
+        case EMBBADCRC:
+        case EMBBADDATA:
+        case EMBBADSLAVE:
+            return MODBUS_EXCEPTION_GATEWAY_TARGET;
+        default:
+            return MODBUS_EXCEPTION_GATEWAY_PATH;
+    }
+}
+
+} // namespace
+
+test_modbus_485::ModbusTcpGateway::ModbusTcpGateway(ModbusAsyncEngine& engine,
+                                                    int portHandle,
+                                                    const ModbusGatewayOptions& options)
+    : engine_(engine),
+      portHandle_(portHandle),
+      options_(options),
+      listenFileDescriptor_(-1),
+      localPort_(-1),
+      nextClientIdentifier_(1),
+      busy_(false) {}
+
+test_modbus_485::ModbusTcpGateway::~ModbusTcpGateway() {
+    close();
+}
+
+bool test_modbus_485::ModbusTcpGateway::listen(const std::string& address, int port) {
+    if (listenFileDescriptor_ >= 0) {
+        std::cerr << "[listen] already listening\n";
+        return false;
+    }
+    sockaddr_in socketAddress{};
+    socketAddress.sin_family = AF_INET;
+    socketAddress.sin_port = htons(static_cast<uint16_t>(port));
+    if (::inet_pton(AF_INET, address.c_str(), &socketAddress.sin_addr) != 1) {
+        std::cerr << "[listen] invalid address " << address << "\n";
+        return false;
+    }
+
+    int fileDescriptor = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fileDescriptor < 0) {
+        perror("[listen] socket");
+        return false;
+    }
+    int enable = 1;
+    ::setsockopt(fileDescriptor, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+    if (::bind(fileDescriptor, reinterpret_cast<sockaddr*>(&socketAddress), sizeof(socketAddress)) != 0 ||
+        ::listen(fileDescriptor, SOMAXCONN) != 0) {
+        perror("[listen] bind/listen");
+        ::close(fileDescriptor);
+        return false;
+    }
+    socklen_t addressLength = sizeof(socketAddress);
+    ::getsockname(fileDescriptor, reinterpret_cast<sockaddr*>(&socketAddress), &addressLength);
+
+    if (!engine_.watch(fileDescriptor, EPOLLIN, [this](uint32_t) { onAccept(); })) {
+        ::close(fileDescriptor);
+        return false;
+    }
+    listenFileDescriptor_ = fileDescriptor;
+    localPort_ = ntohs(socketAddress.sin_port);
+    return true;
+}
+
+void test_modbus_485::ModbusTcpGateway::close() {
+    if (listenFileDescriptor_ >= 0) {
+        engine_.unwatch(listenFileDescriptor_);
+        ::close(listenFileDescriptor_);
+        listenFileDescriptor_ = -1;
+        localPort_ = -1;
+    }
+    while (!clients_.empty()) {
+        dropClient(clients_.begin()->first);
+    }
+    roundRobin_.clear();
+}
+
+int test_modbus_485::ModbusTcpGateway::localPort() const {
+    return localPort_;
+}
+
+size_t test_modbus_485::ModbusTcpGateway::clientCount() const {
+    return clients_.size();
+}
+
+const test_modbus_485::ModbusGatewayStatistics& test_modbus_485::ModbusTcpGateway::statistics() const {
+    return statistics_;
+}
+
+void test_modbus_485::ModbusTcpGateway::onAccept() {
+    for (;;) {
+        int fileDescriptor = ::accept4(listenFileDescriptor_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fileDescriptor < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                perror("[onAccept] accept4");
+            }
+            return;
+        }
+        if (static_cast<int>(clients_.size()) >= options_.maximumClients) {
+            ::close(fileDescriptor);
+            continue;
+        }
+        int enable = 1;
+        ::setsockopt(fileDescriptor, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+
+        const uint64_t identifier = nextClientIdentifier_++;
+        if (!engine_.watch(fileDescriptor, EPOLLIN,
+                           [this, identifier](uint32_t events) { onClientEvent(identifier, events); })) {
+            ::close(fileDescriptor);
+            continue;
+        }
+        std::unique_ptr<Client> client(new Client());
+        client->fileDescriptor = fileDescriptor;
+        client->identifier = identifier;
+        client->scheduled = false;
+        client->waitingForWritable = false;
+        clients_[identifier] = std::move(client);
+        ++statistics_.clientsAccepted;
+    }
+}
+
+void test_modbus_485::ModbusTcpGateway::onClientEvent(uint64_t clientIdentifier, uint32_t events) {
+    auto found = clients_.find(clientIdentifier);
+    if (found == clients_.end()) {
+        return;
+    }
+    Client& client = *found->second;
+    if (events & (EPOLLERR | EPOLLHUP)) {
+        dropClient(clientIdentifier);
+        return;
+    }
+    if (events & EPOLLOUT) {
+        if (!flushOutput(client)) {
+            dropClient(clientIdentifier);
+            return;
+        }
+    }
+    if (events & EPOLLIN) {
+        uint8_t buffer[4096];
+        for (;;) {
+            ssize_t received = ::read(client.fileDescriptor, buffer, sizeof(buffer));
+            if (received > 0) {
+                client.input.insert(client.input.end(), buffer, buffer + received);
+                continue;
+            }
+            if (received < 0 && errno == EINTR) {
+                continue;
+            }
+            if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                break;
+            }
+            // Orderly shutdown or a socket error.
+            dropClient(clientIdentifier);
+            return;
+        }
+        parseFrames(client);
+        if (clients_.find(clientIdentifier) == clients_.end()) {
+            return;
+        }
+    }
+    dispatch();
+}
+
+void test_modbus_485::ModbusTcpGateway::parseFrames(Client& client) {
+    size_t offset = 0;
+    while (client.input.size() - offset >= 7) {
+        const uint8_t* frame = client.input.data() + offset;
+        const int protocolIdentifier = (frame[2] << 8) | frame[3];
+        const int length = (frame[4] << 8) | frame[5];
+        if (protocolIdentifier != 0 || length < 2 || length > 254) {
+            std::cerr << "[ModbusTcpGateway] malformed MBAP header, closing client " << client.identifier << "\n";
+            dropClient(client.identifier);
+            return;
+        }
+        if (client.input.size() - offset < static_cast<size_t>(6 + length)) {
+            break;
+        }
+
+        Request request;
+        request.clientIdentifier = client.identifier;
+        request.transactionIdentifier = static_cast<uint16_t>((frame[0] << 8) | frame[1]);
+        request.unitIdentifier = frame[6];
+        request.pduLength = length - 1;
+        std::memcpy(request.pdu, frame + 7, request.pduLength);
+        offset += 6 + length;
+        ++statistics_.requests;
+
+        if (static_cast<int>(client.queue.size()) >= options_.maximumQueuedPerClient) {
+            ++statistics_.rejected;
+            respondException(request, MODBUS_EXCEPTION_SLAVE_OR_SERVER_BUSY);
+            continue;
+        }
+        client.queue.push_back(request);
+        if (!client.scheduled) {
+            client.scheduled = true;
+            roundRobin_.push_back(client.identifier);
+        }
+    }
+    client.input.erase(client.input.begin(), client.input.begin() + offset);
+}
+
+void test_modbus_485::ModbusTcpGateway::dispatch() {
+    while (!busy_ && !roundRobin_.empty()) {
+        const uint64_t identifier = roundRobin_.front();
+        roundRobin_.pop_front();
+        auto found = clients_.find(identifier);
+        if (found == clients_.end()) {
+            continue;
+        }
+        Client& client = *found->second;
+        if (client.queue.empty()) {
+            client.scheduled = false;
+            continue;
+        }
+
+        inFlight_.clear();
+        inFlight_.push_back(client.queue.front());
+        client.queue.pop_front();
+        if (client.queue.empty()) {
+            client.scheduled = false;
+        } else {
+            roundRobin_.push_back(identifier);
+        }
+
+        // Take every identical read still waiting, in any client's queue. A
+        // client's queue is only scanned up to its first non-read, so a read
+        // never overtakes a write the same client sent before it.
+        if (options_.coalesceReads && inFlight_[0].unitIdentifier != MODBUS_BROADCAST_ADDRESS &&
+            isRead(inFlight_[0].pdu[0])) {
+            for (uint64_t waiting : roundRobin_) {
+                auto other = clients_.find(waiting);
+                if (other == clients_.end()) {
+                    continue;
+                }
+                std::deque<Request>& queue = other->second->queue;
+                for (auto entry = queue.begin(); entry != queue.end() && isRead(entry->pdu[0]);) {
+                    if (entry->unitIdentifier == inFlight_[0].unitIdentifier &&
+                        entry->pduLength == inFlight_[0].pduLength &&
+                        std::memcmp(entry->pdu, inFlight_[0].pdu, entry->pduLength) == 0) {
+                        inFlight_.push_back(*entry);
+                        entry = queue.erase(entry);
+                        ++statistics_.coalesced;
+                    } else {
+                        ++entry;
+                    }
+                }
+            }
+        }
+
+        busy_ = true;
+        ++statistics_.busTransactions;
+        const Request& head = inFlight_[0];
+        if (!engine_.submit(portHandle_, head.unitIdentifier, head.pdu, head.pduLength,
+                            [this](const ModbusAsyncResult& result) { onCompletion(result); })) {
+            busy_ = false;
+            ++statistics_.busErrors;
+            for (const Request& request : inFlight_) {
+                respondException(request, MODBUS_EXCEPTION_GATEWAY_PATH);
+            }
+            inFlight_.clear();
+        }
+    }
+}
+
+void test_modbus_485::ModbusTcpGateway::onCompletion(const ModbusAsyncResult& result) {
+    busy_ = false;
+    if (result.errorCode != 0 && (result.errorCode <= MODBUS_ENOBASE ||
+                                  result.errorCode >= MODBUS_ENOBASE + MODBUS_EXCEPTION_MAX)) {
+        ++statistics_.busErrors;
+    }
+    for (const Request& request : inFlight_) {
+        if (request.unitIdentifier == MODBUS_BROADCAST_ADDRESS) {
+            continue;
+        }
+        if (result.errorCode == 0) {
+            respond(request, result.response.data(), static_cast<int>(result.response.size()));
+        } else {
+            respondException(request, gatewayExceptionCode(result.errorCode));
+        }
+    }
+    inFlight_.clear();
+    dispatch();
+}
+
+void test_modbus_485::ModbusTcpGateway::respond(const Request& request, const uint8_t* pdu, int pduLength) {
+    auto found = clients_.find(request.clientIdentifier);
+    if (found == clients_.end()) {
+        return;
+    }
+    Client& client = *found->second;
+    const uint8_t header[7] = {static_cast<uint8_t>(request.transactionIdentifier >> 8),
+                               static_cast<uint8_t>(request.transactionIdentifier & 0xFF),
+                               0,
+                               0,
+                               static_cast<uint8_t>((pduLength + 1) >> 8),
+                               static_cast<uint8_t>((pduLength + 1) & 0xFF),
+                               request.unitIdentifier};
+    const bool idle = client.output.empty();
+    client.output.insert(client.output.end(), header, header + 7);
+    client.output.insert(client.output.end(), pdu, pdu + pduLength);
+    // A failed send shows up as EPOLLERR/EPOLLHUP, which drops the client.
+    if (idle) {
+        flushOutput(client);
+    }
+}
+
+void test_modbus_485::ModbusTcpGateway::respondException(const Request& request, int exceptionCode) {
+    const uint8_t pdu[2] = {static_cast<uint8_t>(request.pdu[0] | 0x80), static_cast<uint8_t>(exceptionCode)};
+    respond(request, pdu, 2);
+}
+
+bool test_modbus_485::ModbusTcpGateway::flushOutput(Client& client) {
+    size_t sent = 0;
+    while (sent < client.output.size()) {
+        ssize_t written = ::send(client.fileDescriptor, client.output.data() + sent,
+                                 client.output.size() - sent, MSG_NOSIGNAL);
+        if (written > 0) {
+            sent += static_cast<size_t>(written);
+            continue;
+        }
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        }
+        client.output.clear();
+        return false;
+    }
+    client.output.erase(client.output.begin(), client.output.begin() + sent);
+    const bool waitForWritable = !client.output.empty();
+    if (waitForWritable != client.waitingForWritable) {
+        engine_.modifyWatch(client.fileDescriptor,
+                            waitForWritable ? static_cast<uint32_t>(EPOLLIN | EPOLLOUT)
+                                            : static_cast<uint32_t>(EPOLLIN));
+        client.waitingForWritable = waitForWritable;
+    }
+    return true;
+}
+
+void test_modbus_485::ModbusTcpGateway::dropClient(uint64_t clientIdentifier) {
+    auto found = clients_.find(clientIdentifier);
+    if (found == clients_.end()) {
+        return;
+    }
+    // Its queued requests go with it; answers to in-flight ones are discarded.
+    engine_.unwatch(found->second->fileDescriptor);
+    ::close(found->second->fileDescriptor);
+    clients_.erase(found);
+}
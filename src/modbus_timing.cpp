@@ -0,0 +1,56 @@
+// src/modbus_timing.cpp
+
+#include "modbus_timing.h"
+#include "modbus_rtu_codec.h"
+#include <modbus.h>
+
+int test_modbus_485::bitsPerCharacter(char parityMode, int dataBits, int stopBits) {
+    return 1 + dataBits + (parityMode == 'N' ? 0 : 1) + stopBits;
+}
+
+std::chrono::nanoseconds test_modbus_485::characterTime(int baudRate, int bitsPerCharacter) {
+    if (baudRate <= 0) {
+        return std::chrono::nanoseconds(0);
+    }
+    return std::chrono::nanoseconds(1000000000LL * bitsPerCharacter / baudRate);
+}
+
+std::chrono::nanoseconds test_modbus_485::interCharacterTimeout(int baudRate, int bitsPerCharacter) {
+    return baudRate > 19200 ? std::chrono::nanoseconds(750000)
+                            : characterTime(baudRate, bitsPerCharacter) * 3 / 2;
+}
+
+std::chrono::nanoseconds test_modbus_485::interFrameDelay(int baudRate, int bitsPerCharacter) {
+    return baudRate > 19200 ? std::chrono::nanoseconds(1750000)
+                            : characterTime(baudRate, bitsPerCharacter) * 7 / 2;
+}
+
+int test_modbus_485::expectedFrameBytes(int functionCode, int quantity) {
+    switch (functionCode) {
+        case MODBUS_FC_READ_COILS:
+        case MODBUS_FC_READ_DISCRETE_INPUTS:
+            return 8 + 5 + (quantity + 7) / 8;
+        case MODBUS_FC_READ_HOLDING_REGISTERS:
+        case MODBUS_FC_READ_INPUT_REGISTERS:
+            return 8 + 5 + 2 * quantity;
+        case MODBUS_FC_WRITE_SINGLE_COIL:
+        case MODBUS_FC_WRITE_SINGLE_REGISTER:
+            return 8 + 8;
+        case MODBUS_FC_WRITE_MULTIPLE_COILS:
+            return 9 + (quantity + 7) / 8 + 8;
+        case MODBUS_FC_WRITE_MULTIPLE_REGISTERS:
+            return 9 + 2 * quantity + 8;
+        case MODBUS_FC_MASK_WRITE_REGISTER:
+            return 10 + 10;
+        case MODBUS_FC_WRITE_AND_READ_REGISTERS:
+            return 13 + 5 + 2 * quantity;
+        case MODBUS_FC_REPORT_SLAVE_ID:
+            return 4 + 5 + quantity;
+        case modbusFcReadFileRecord:
+            return 12 + 7 + 2 * quantity;
+        case modbusFcWriteFileRecord:
+            return 2 * (12 + 2 * quantity);
+        default:
+            return 2 * MODBUS_RTU_MAX_ADU_LENGTH;
+    }
+}
@@ -1,9 +1,18 @@
 // src/modbus_utils.cpp
 
 #include "modbus_utils.h"
+#include "modbus_read_cache.h"
+#include "modbus_rtu_codec.h"
+#include "modbus_serial_speed.h"
+#include "modbus_shared_image.h"
+#include <algorithm>
 #include <cerrno>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <poll.h>
 #include <termios.h>
+#include <thread>
 #include <unistd.h>
 #include <sys/time.h>
 
@@ -26,6 +35,17 @@ bool test_modbus_485::ModbusUtils::openRtu(modbus_t*& contextReference,
                                            int stopBits,
                                            int slaveIdentifier) {
     std::lock_guard<std::mutex> lock(contextMutex_);
+    return openRtuUnlocked(contextReference, serialDevicePath, baudRate, parityMode, dataBits, stopBits,
+                           slaveIdentifier);
+}
+
+bool test_modbus_485::ModbusUtils::openRtuUnlocked(modbus_t*& contextReference,
+                                                   const std::string& serialDevicePath,
+                                                   int baudRate,
+                                                   char parityMode,
+                                                   int dataBits,
+                                                   int stopBits,
+                                                   int slaveIdentifier) {
     contextReference = ::modbus_new_rtu(serialDevicePath.c_str(), baudRate, parityMode, dataBits, stopBits);
     if (!contextReference) {
         std::cerr << "[openRtu] modbus_new_rtu failed\n";
@@ -39,10 +59,9 @@ bool test_modbus_485::ModbusUtils::openRtu(modbus_t*& contextReference,
         contextReference = nullptr;
         return false;
     }
-    ::modbus_set_error_recovery(
-        contextReference,
-        static_cast<modbus_error_recovery_mode>(
-            MODBUS_ERROR_RECOVERY_LINK | MODBUS_ERROR_RECOVERY_PROTOCOL));
+    // Recovery is done by executeWithReconnect(); libmodbus' own protocol
+    // recovery would sleep a whole response timeout before flushing.
+    ::modbus_set_error_recovery(contextReference, MODBUS_ERROR_RECOVERY_NONE);
 
     lastSerialDevicePath_ = serialDevicePath;
     lastBaudRate_ = baudRate;
@@ -59,42 +78,15 @@ bool test_modbus_485::ModbusUtils::openRtu(modbus_t*& contextReference,
         return false;
     }
 
-    // Set timeouts (seconds, microseconds)
-    uint32_t timeoutSeconds = 2;
-    uint32_t timeoutMicroseconds = 0;
-    ::modbus_set_response_timeout(contextReference, timeoutSeconds, timeoutMicroseconds);
-    ::modbus_set_byte_timeout    (contextReference, timeoutSeconds, timeoutMicroseconds);
-
-    termios terminalSettings;
-    if (tcgetattr(fileDescriptor, &terminalSettings) != 0) {
-        perror("[openRtu] tcgetattr");
-        ::modbus_free(contextReference);
-        contextReference = nullptr;
-        return false;
-    }
-    cfmakeraw(&terminalSettings);
-
-    speed_t speed;
-    switch (baudRate) {
-        case 9600:   speed = B9600;  break;
-        case 19200:  speed = B19200; break;
-        case 115200: speed = B115200;break;
-        default:     speed = B115200;break;
-    }
-    cfsetispeed(&terminalSettings, speed);
-    cfsetospeed(&terminalSettings, speed);
-
-    terminalSettings.c_cflag = (terminalSettings.c_cflag & ~CSIZE) | (dataBits == 7 ? CS7 : CS8);
-    terminalSettings.c_cflag = (stopBits == 2 ? (terminalSettings.c_cflag | CSTOPB)
-                                              : (terminalSettings.c_cflag & ~CSTOPB));
-    terminalSettings.c_cflag = (parityMode == 'E' ? (terminalSettings.c_cflag | PARENB)
-                                                 : (terminalSettings.c_cflag & ~PARENB));
-    terminalSettings.c_cflag |= (CLOCAL | CREAD);
-    terminalSettings.c_iflag &= ~(IXON | IXOFF | IXANY);
-    terminalSettings.c_oflag &= ~OPOST;
+    // Timeouts follow the line parameters; see setTimeoutPolicy().
+    const int characterBits = bitsPerCharacter(parityMode, dataBits, stopBits);
+    characterTime_ = characterTime(baudRate, characterBits);
+    interFrameDelay_ = interFrameDelay(baudRate, characterBits);
+    lastResponseTimeout_ = std::chrono::microseconds(0);
+    appliedByteTimeout_ = std::chrono::microseconds(0);
+    beginTransaction(contextReference, MODBUS_FC_READ_HOLDING_REGISTERS, MODBUS_MAX_READ_REGISTERS);
 
-    if (tcsetattr(fileDescriptor, TCSANOW, &terminalSettings) != 0) {
-        perror("[openRtu] tcsetattr");
+    if (!configureRtuLine(fileDescriptor, baudRate, parityMode, dataBits, stopBits)) {
         ::modbus_free(contextReference);
         contextReference = nullptr;
         return false;
@@ -122,13 +114,607 @@ bool test_modbus_485::ModbusUtils::reconnectRtu(modbus_t*& contextReference) {
         ::modbus_free(contextReference);
         contextReference = nullptr;
     }
-    return openRtu(contextReference,
-                   lastSerialDevicePath_,
-                   lastBaudRate_,
-                   lastParityMode_,
-                   lastDataBits_,
-                   lastStopBits_,
-                   lastSlaveIdentifier_);
+    bool reopened = openRtuUnlocked(contextReference,
+                                    lastSerialDevicePath_,
+                                    lastBaudRate_,
+                                    lastParityMode_,
+                                    lastDataBits_,
+                                    lastStopBits_,
+                                    lastSlaveIdentifier_);
+    metrics_.recordReconnect(reopened);
+    return reopened;
+}
+
+bool test_modbus_485::ModbusUtils::setSlave(modbus_t* contextPointer, int slaveIdentifier) {
+    if (transport_) {
+        if (slaveIdentifier < 0 || slaveIdentifier > 247) {
+            std::cerr << "[setSlave] invalid slave " << slaveIdentifier << "\n";
+            return false;
+        }
+        lastSlaveIdentifier_ = slaveIdentifier;
+        return true;
+    }
+    if (!ensureContext(contextPointer, __func__)) {
+        return false;
+    }
+    if (::modbus_set_slave(contextPointer, slaveIdentifier) == -1) {
+        std::cerr << "[setSlave] " << modbus_strerror(errno) << "\n";
+        return false;
+    }
+    lastSlaveIdentifier_ = slaveIdentifier;
+    return true;
+}
+
+void test_modbus_485::ModbusUtils::setTimeoutPolicy(const ModbusTimeoutPolicy& policy) {
+    timeoutPolicy_ = policy;
+    lastResponseTimeout_ = std::chrono::microseconds(0);
+    appliedByteTimeout_ = std::chrono::microseconds(0);
+    for (std::unique_ptr<TurnaroundTracker>& tracker : turnarounds_) {
+        tracker.reset();
+    }
+}
+
+const test_modbus_485::ModbusTimeoutPolicy& test_modbus_485::ModbusUtils::timeoutPolicy() const {
+    return timeoutPolicy_;
+}
+
+std::chrono::microseconds test_modbus_485::ModbusUtils::effectiveByteTimeout() const {
+    if (timeoutPolicy_.mode == ModbusTimeoutMode::Fixed) {
+        return timeoutPolicy_.fixedTimeout;
+    }
+    return std::chrono::duration_cast<std::chrono::microseconds>(interFrameDelay_) + timeoutPolicy_.byteTimeoutSlack;
+}
+
+std::chrono::microseconds test_modbus_485::ModbusUtils::effectiveResponseTimeout(int slaveIdentifier,
+                                                                                 int functionCode,
+                                                                                 int quantity) const {
+    if (timeoutPolicy_.mode == ModbusTimeoutMode::Fixed) {
+        return timeoutPolicy_.fixedTimeout;
+    }
+    // libmodbus starts the clock once the request is queued, so the request and
+    // reply wire times both count, plus the gaps around the reply.
+    std::chrono::microseconds turnaround = timeoutPolicy_.turnaroundAllowance;
+    if (timeoutPolicy_.mode == ModbusTimeoutMode::Adaptive) {
+        std::chrono::microseconds observed = observedTurnaround(slaveIdentifier);
+        if (observed.count() > 0) {
+            turnaround = observed + timeoutPolicy_.adaptiveMargin;
+        }
+    }
+    std::chrono::microseconds timeout =
+        std::chrono::duration_cast<std::chrono::microseconds>(wireTime(functionCode, quantity) + 2 * interFrameDelay_)
+        + turnaround;
+    return std::min(std::max(timeout, timeoutPolicy_.minimumResponseTimeout), timeoutPolicy_.maximumResponseTimeout);
+}
+
+std::chrono::microseconds test_modbus_485::ModbusUtils::lastResponseTimeout() const {
+    return lastResponseTimeout_;
+}
+
+std::chrono::microseconds test_modbus_485::ModbusUtils::observedTurnaround(int slaveIdentifier) const {
+    if (slaveIdentifier < 0 || slaveIdentifier >= static_cast<int>(turnarounds_.size()) ||
+        !turnarounds_[slaveIdentifier] ||
+        turnarounds_[slaveIdentifier]->count < timeoutPolicy_.adaptiveMinimumSamples) {
+        return std::chrono::microseconds(0);
+    }
+    return std::chrono::microseconds(turnarounds_[slaveIdentifier]->quantileMicroseconds);
+}
+
+std::chrono::nanoseconds test_modbus_485::ModbusUtils::wireTime(int functionCode, int quantity) const {
+    return characterTime_ * expectedFrameBytes(functionCode, quantity);
+}
+
+int test_modbus_485::ModbusUtils::currentSlave(modbus_t* contextPointer) const {
+    return transport_ || !contextPointer ? lastSlaveIdentifier_ : ::modbus_get_slave(contextPointer);
+}
+
+bool test_modbus_485::ModbusUtils::broadcasting(modbus_t* contextPointer) const {
+    return !transport_ && contextPointer && ::modbus_get_slave(contextPointer) == MODBUS_BROADCAST_ADDRESS;
+}
+
+void test_modbus_485::ModbusUtils::beginTransaction(modbus_t* contextPointer, int functionCode, int quantity) {
+    // Slaves are still applying a broadcast and would miss the start of the next request.
+    if (broadcastQuietUntil_ != std::chrono::steady_clock::time_point()) {
+        std::this_thread::sleep_until(broadcastQuietUntil_);
+        broadcastQuietUntil_ = std::chrono::steady_clock::time_point();
+    }
+    std::chrono::microseconds responseTimeout =
+        effectiveResponseTimeout(currentSlave(contextPointer), functionCode, quantity);
+    std::chrono::microseconds byteTimeout = effectiveByteTimeout();
+    if (transport_) {
+        if (responseTimeout != lastResponseTimeout_ || byteTimeout != appliedByteTimeout_) {
+            transport_->setTimeouts(responseTimeout, byteTimeout);
+            lastResponseTimeout_ = responseTimeout;
+            appliedByteTimeout_ = byteTimeout;
+        }
+        return;
+    }
+    if (responseTimeout != lastResponseTimeout_) {
+        ::modbus_set_response_timeout(contextPointer,
+                                      static_cast<uint32_t>(responseTimeout.count() / 1000000),
+                                      static_cast<uint32_t>(responseTimeout.count() % 1000000));
+        lastResponseTimeout_ = responseTimeout;
+    }
+    if (byteTimeout != appliedByteTimeout_) {
+        ::modbus_set_byte_timeout(contextPointer,
+                                  static_cast<uint32_t>(byteTimeout.count() / 1000000),
+                                  static_cast<uint32_t>(byteTimeout.count() % 1000000));
+        appliedByteTimeout_ = byteTimeout;
+    }
+}
+
+void test_modbus_485::ModbusUtils::endTransaction(modbus_t* contextPointer,
+                                                  int functionCode,
+                                                  int quantity,
+                                                  int result,
+                                                  std::chrono::steady_clock::time_point started) {
+    const int errorCode = result == -1 ? errno : 0;
+    const std::chrono::steady_clock::time_point finished = std::chrono::steady_clock::now();
+    const auto elapsed = finished - started;
+    const int slaveIdentifier = currentSlave(contextPointer);
+    metrics_.recordTransaction(slaveIdentifier, functionCode, elapsed, errorCode);
+    if (slaveIdentifier == MODBUS_BROADCAST_ADDRESS && result != -1) {
+        // The frame may still be in the UART; count its wire time from here.
+        broadcastQuietUntil_ = finished + wireTime(functionCode, quantity) + timeoutPolicy_.broadcastTurnaround;
+    }
+
+    if (timeoutPolicy_.mode != ModbusTimeoutMode::Adaptive ||
+        slaveIdentifier < 1 || slaveIdentifier >= static_cast<int>(turnarounds_.size())) {
+        errno = errorCode;
+        return;
+    }
+    std::unique_ptr<TurnaroundTracker>& tracker = turnarounds_[slaveIdentifier];
+    if (result == -1) {
+        errno = errorCode;
+        // A timeout means the learned bound was too tight: fall back to the derived one.
+        // Drop the quantile with the samples so relearning recomputes it
+        // instead of serving the stale bound for up to 16 more replies.
+        if (errorCode == ETIMEDOUT && tracker) {
+            tracker->count = 0;
+            tracker->next = 0;
+            tracker->sinceUpdate = 0;
+            tracker->quantileMicroseconds = 0;
+        }
+        return;
+    }
+    if (!tracker) {
+        tracker.reset(new TurnaroundTracker());
+    }
+
+    auto turnaround = std::chrono::duration_cast<std::chrono::microseconds>(
+        elapsed - wireTime(functionCode, quantity) - interFrameDelay_);
+    tracker->samplesMicroseconds[tracker->next] = static_cast<uint32_t>(std::max<long long>(turnaround.count(), 1));
+    tracker->next = (tracker->next + 1) % static_cast<int>(tracker->samplesMicroseconds.size());
+    tracker->count = std::min(tracker->count + 1, static_cast<int>(tracker->samplesMicroseconds.size()));
+
+    if (tracker->count >= timeoutPolicy_.adaptiveMinimumSamples &&
+        (++tracker->sinceUpdate >= 16 || tracker->quantileMicroseconds == 0)) {
+        std::array<uint32_t, 128> sorted = tracker->samplesMicroseconds;
+        int rank = std::min(tracker->count - 1,
+                            static_cast<int>(timeoutPolicy_.adaptivePercentile * tracker->count));
+        std::nth_element(sorted.begin(), sorted.begin() + rank, sorted.begin() + tracker->count);
+        tracker->quantileMicroseconds = sorted[rank];
+        tracker->sinceUpdate = 0;
+    }
+}
+
+test_modbus_485::ModbusMetrics& test_modbus_485::ModbusUtils::metrics() {
+    return metrics_;
+}
+
+const test_modbus_485::ModbusMetrics& test_modbus_485::ModbusUtils::metrics() const {
+    return metrics_;
+}
+
+void test_modbus_485::ModbusUtils::setRecoveryPolicy(const ModbusRecoveryPolicy& policy) {
+    recoveryPolicy_ = policy;
+}
+
+const test_modbus_485::ModbusRecoveryPolicy& test_modbus_485::ModbusUtils::recoveryPolicy() const {
+    return recoveryPolicy_;
+}
+
+void test_modbus_485::ModbusUtils::attachTransport(ModbusTransport* transport) {
+    std::lock_guard<std::mutex> lock(contextMutex_);
+    transport_ = transport;
+    if (transport_) {
+        characterTime_ = characterTime(transport_->baudRate(), transport_->bitsPerCharacter());
+        interFrameDelay_ = interFrameDelay(transport_->baudRate(), transport_->bitsPerCharacter());
+    }
+    lastResponseTimeout_ = std::chrono::microseconds(0);
+    appliedByteTimeout_ = std::chrono::microseconds(0);
+    reopenBackoff_ = std::chrono::milliseconds(0);
+    nextReopenAttempt_ = std::chrono::steady_clock::time_point();
+}
+
+test_modbus_485::ModbusTransport* test_modbus_485::ModbusUtils::transport() const {
+    return transport_;
+}
+
+void test_modbus_485::ModbusUtils::attachReadCache(ModbusReadCache* cache) {
+    readCache_ = cache;
+}
+
+test_modbus_485::ModbusReadCache* test_modbus_485::ModbusUtils::readCache() const {
+    return readCache_;
+}
+
+void test_modbus_485::ModbusUtils::attachSharedImage(ModbusSharedImageWriter* image) {
+    sharedImage_ = image;
+}
+
+test_modbus_485::ModbusSharedImageWriter* test_modbus_485::ModbusUtils::sharedImage() const {
+    return sharedImage_;
+}
+
+void test_modbus_485::ModbusUtils::invalidateReadCache(modbus_t* contextPointer,
+                                                       ModbusTable table,
+                                                       int startAddress,
+                                                       int count) {
+    if (readCache_) {
+        readCache_->invalidate(currentSlave(contextPointer), table, startAddress, count);
+    }
+}
+
+test_modbus_485::ModbusErrorClass test_modbus_485::classifyModbusError(int errorCode) {
+    if (errorCode == 0) {
+        return ModbusErrorClass::None;
+    }
+    if (errorCode >= EMBXILFUN && errorCode <= EMBXGTAR) {
+        return ModbusErrorClass::Exception;
+    }
+    switch (errorCode) {
+        case ETIMEDOUT:
+        case EMBBADCRC:
+        case EMBBADDATA:
+        case EMBBADEXC:
+        case EMBUNKEXC:
+        case EMBBADSLAVE:
+            return ModbusErrorClass::Transient;
+        case EINVAL:
+        case EMBMDATA:
+        case ENOMEM:
+        case ENOTSUP:
+            return ModbusErrorClass::Request;
+        default:
+            // EIO, EBADF, ENXIO, ENODEV, EPIPE and anything unexpected from the port.
+            return ModbusErrorClass::Link;
+    }
+}
+
+void test_modbus_485::ModbusUtils::resynchronize(modbus_t* contextPointer) {
+    // Let the rest of the frame arrive, then drop it together with anything unsent.
+    std::this_thread::sleep_for(interFrameDelay_);
+    if (transport_) {
+        transport_->flush();
+        return;
+    }
+    int fileDescriptor = ::modbus_get_socket(contextPointer);
+    if (fileDescriptor >= 0 && tcflush(fileDescriptor, TCIOFLUSH) != 0) {
+        perror("[resynchronize] tcflush");
+    }
+}
+
+bool test_modbus_485::ModbusUtils::reopenForRecovery(modbus_t*& contextReference) {
+    if (!transport_ && lastSerialDevicePath_.empty()) {
+        // Not opened by openRtu(): nothing to reopen, whether or not a context is set.
+        std::cerr << "[reopenForRecovery] no port to reopen\n";
+        errno = EBADF;
+        return false;
+    }
+    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    if (now < nextReopenAttempt_) {
+        errno = EBADF;
+        return false;
+    }
+    bool reopened = false;
+    if (transport_) {
+        std::cerr << "[reopenForRecovery] reconnecting transport\n";
+        reopened = transport_->reconnect();
+        metrics_.recordReconnect(reopened);
+    } else {
+        reopened = reconnectRtu(contextReference);
+    }
+    if (reopened) {
+        reopenBackoff_ = std::chrono::milliseconds(0);
+        nextReopenAttempt_ = std::chrono::steady_clock::time_point();
+        return true;
+    }
+    reopenBackoff_ = reopenBackoff_.count() == 0
+                     ? recoveryPolicy_.initialReopenBackoff
+                     : std::min(reopenBackoff_ * 2, recoveryPolicy_.maximumReopenBackoff);
+    nextReopenAttempt_ = now + reopenBackoff_;
+    std::cerr << "[reopenForRecovery] reopen failed, next attempt in " << reopenBackoff_.count() << " ms\n";
+    errno = EBADF;
+    return false;
+}
+
+void test_modbus_485::ModbusUtils::finishRecovery(ModbusErrorClass recovering,
+                                                  std::chrono::steady_clock::time_point failedAt,
+                                                  bool recovered) {
+    if (recovering == ModbusErrorClass::None) {
+        return;
+    }
+    metrics_.recordRecovery(recovering == ModbusErrorClass::Link ? ModbusRecoveryKind::Reopen
+                                                                 : ModbusRecoveryKind::Resync,
+                            std::chrono::steady_clock::now() - failedAt,
+                            recovered);
+}
+
+bool test_modbus_485::configureRtuLine(int fileDescriptor,
+                                       int baudRate,
+                                       char parityMode,
+                                       int dataBits,
+                                       int stopBits) {
+    termios terminalSettings;
+    if (tcgetattr(fileDescriptor, &terminalSettings) != 0) {
+        perror("[configureRtuLine] tcgetattr");
+        return false;
+    }
+    cfmakeraw(&terminalSettings);
+
+    // Rates without a Bxxx constant are set through termios2 after tcsetattr().
+    unsigned int speedConstant = 0;
+    const bool standardSpeed = standardBaudRateConstant(baudRate, speedConstant);
+    if (standardSpeed) {
+        cfsetispeed(&terminalSettings, static_cast<speed_t>(speedConstant));
+        cfsetospeed(&terminalSettings, static_cast<speed_t>(speedConstant));
+    }
+
+    terminalSettings.c_cflag = (terminalSettings.c_cflag & ~CSIZE) | (dataBits == 7 ? CS7 : CS8);
+    terminalSettings.c_cflag = (stopBits == 2 ? (terminalSettings.c_cflag | CSTOPB)
+                                              : (terminalSettings.c_cflag & ~CSTOPB));
+    terminalSettings.c_cflag &= ~(PARENB | PARODD);
+    terminalSettings.c_iflag &= ~INPCK;
+    if (parityMode == 'E' || parityMode == 'O') {
+        terminalSettings.c_cflag |= (parityMode == 'O' ? (PARENB | PARODD) : PARENB);
+        terminalSettings.c_iflag |= INPCK;
+    }
+    terminalSettings.c_cflag |= (CLOCAL | CREAD);
+    terminalSettings.c_iflag &= ~(IXON | IXOFF | IXANY);
+    terminalSettings.c_oflag &= ~OPOST;
+
+    if (tcsetattr(fileDescriptor, TCSANOW, &terminalSettings) != 0) {
+        perror("[configureRtuLine] tcsetattr");
+        return false;
+    }
+    if (!standardSpeed && !setArbitraryBaudRate(fileDescriptor, baudRate)) {
+        return false;
+    }
+
+    // UARTs derive the rate from a divisor; accept what a receiver tolerates (2 %).
+    int appliedBaudRate = readBaudRate(fileDescriptor);
+    if (appliedBaudRate > 0 && std::abs(appliedBaudRate - baudRate) * 50 > baudRate) {
+        std::cerr << "[configureRtuLine] requested " << baudRate << " baud, driver applied " << appliedBaudRate << "\n";
+        return false;
+    }
+
+    return true;
+}
+
+int test_modbus_485::receiveRtuResponse(int fileDescriptor,
+                                        uint8_t* adu,
+                                        int capacity,
+                                        std::chrono::microseconds responseTimeout,
+                                        std::chrono::microseconds byteTimeout) {
+    int length = 0;
+    std::chrono::microseconds timeout = responseTimeout;
+    for (;;) {
+        pollfd descriptor{fileDescriptor, POLLIN, 0};
+        int ready = ::poll(&descriptor, 1, static_cast<int>((timeout.count() + 999) / 1000));
+        if (ready < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        if (ready == 0) {
+            errno = ETIMEDOUT;
+            return -1;
+        }
+        ssize_t received = ::read(fileDescriptor, adu + length, static_cast<size_t>(capacity - length));
+        if (received < 0) {
+            if (errno == EINTR || errno == EAGAIN) {
+                continue;
+            }
+            return -1;
+        }
+        if (received == 0) {
+            errno = EIO;
+            return -1;
+        }
+        length += static_cast<int>(received);
+        const int frameLength = rtuResponseLength(adu, length);
+        if (frameLength < 0 || frameLength > capacity) {
+            errno = EMBBADDATA;
+            return -1;
+        }
+        if (frameLength > 0 && length >= frameLength) {
+            if (!checkCrc(adu, frameLength)) {
+                errno = EMBBADCRC;
+                return -1;
+            }
+            return frameLength;
+        }
+        timeout = byteTimeout;
+    }
+}
+
+int test_modbus_485::ModbusUtils::exchange(modbus_t* contextPointer,
+                                           const uint8_t* request,
+                                           int requestLength,
+                                           uint8_t* response,
+                                           int responseCapacity) {
+    if (transport_) {
+        return transport_->transact(lastSlaveIdentifier_, request, requestLength, response, responseCapacity);
+    }
+    const int slaveIdentifier = ::modbus_get_slave(contextPointer);
+    uint8_t rawRequest[MODBUS_MAX_PDU_LENGTH + 1];
+    rawRequest[0] = static_cast<uint8_t>(slaveIdentifier);
+    std::memcpy(rawRequest + 1, request, requestLength);
+    if (::modbus_send_raw_request(contextPointer, rawRequest, requestLength + 1) == -1) {
+        return -1;
+    }
+    if (slaveIdentifier == MODBUS_BROADCAST_ADDRESS) {
+        return 0;
+    }
+
+    uint8_t adu[MODBUS_RTU_MAX_ADU_LENGTH];
+    int received = receiveRtuResponse(::modbus_get_socket(contextPointer), adu, static_cast<int>(sizeof(adu)),
+                                      lastResponseTimeout_, appliedByteTimeout_);
+    if (received == -1) {
+        return -1;
+    }
+    const int length = received - 3;
+    if (adu[0] != slaveIdentifier) {
+        errno = EMBBADSLAVE;
+        return -1;
+    }
+    if (length < 2 || length > responseCapacity) {
+        errno = EMBBADDATA;
+        return -1;
+    }
+    if (adu[1] & 0x80) {
+        errno = MODBUS_ENOBASE + adu[2];
+        return -1;
+    }
+    std::memcpy(response, adu + 1, length);
+    return length;
+}
+
+template<typename Decode>
+int test_modbus_485::ModbusUtils::transportTransaction(modbus_t*& contextReference,
+                                                       int functionCode,
+                                                       int quantity,
+                                                       const uint8_t* request,
+                                                       int requestLength,
+                                                       Decode decode) {
+    return executeWithRecovery(contextReference, functionCode, quantity, [&]() {
+        uint8_t response[MODBUS_MAX_PDU_LENGTH];
+        int length = exchange(contextReference, request, requestLength, response, static_cast<int>(sizeof(response)));
+        if (length == -1) {
+            return -1;
+        }
+        // A reply that does not match the request is handled like a corrupt frame.
+        if (length > 0 && response[0] != functionCode) {
+            errno = EMBBADDATA;
+            return -1;
+        }
+        int result = decode(response, length);
+        if (result == -1) {
+            errno = EMBBADDATA;
+        }
+        return result;
+    });
+}
+
+int test_modbus_485::ModbusUtils::transportReadBits(modbus_t*& contextReference,
+                                                    int functionCode,
+                                                    int startAddress,
+                                                    int count,
+                                                    uint8_t* destination) {
+    if (count < 1 || count > MODBUS_MAX_READ_BITS) {
+        errno = EMBMDATA;
+        return -1;
+    }
+    uint8_t request[5];
+    int requestLength = encodeReadRequest(static_cast<uint8_t>(functionCode), startAddress, count, request);
+    return transportTransaction(contextReference, functionCode, count, request, requestLength,
+                                [&](const uint8_t* response, int length) {
+                                    return decodeBits(response, length, destination, count);
+                                });
+}
+
+int test_modbus_485::ModbusUtils::transportReadRegisters(modbus_t*& contextReference,
+                                                         int functionCode,
+                                                         int startAddress,
+                                                         int count,
+                                                         uint16_t* destination) {
+    if (count < 1 || count > MODBUS_MAX_READ_REGISTERS) {
+        errno = EMBMDATA;
+        return -1;
+    }
+    uint8_t request[5];
+    int requestLength = encodeReadRequest(static_cast<uint8_t>(functionCode), startAddress, count, request);
+    return transportTransaction(contextReference, functionCode, count, request, requestLength,
+                                [&](const uint8_t* response, int length) {
+                                    return decodeRegisters(response, length, destination, count);
+                                });
+}
+
+int test_modbus_485::ModbusUtils::transportWrite(modbus_t*& contextReference,
+                                                 int functionCode,
+                                                 int quantity,
+                                                 const uint8_t* request,
+                                                 int requestLength) {
+    if (!transport_) {
+        // A broadcast through the context: send the frame and do not wait for a reply.
+        return executeWithRecovery(contextReference, functionCode, quantity, [&]() {
+            uint8_t rawRequest[MODBUS_MAX_PDU_LENGTH + 1];
+            rawRequest[0] = MODBUS_BROADCAST_ADDRESS;
+            std::memcpy(rawRequest + 1, request, requestLength);
+            return ::modbus_send_raw_request(contextReference, rawRequest, requestLength + 1) == -1 ? -1 : quantity;
+        });
+    }
+    // Write replies echo the request header; a broadcast gets none.
+    return transportTransaction(contextReference, functionCode, quantity, request, requestLength,
+                                [&](const uint8_t* /*response*/, int length) {
+                                    return length == 0 || length >= 5 ? quantity : -1;
+                                });
+}
+
+template<typename Chunk>
+int test_modbus_485::ModbusUtils::transferBlock(int startAddress,
+                                                int count,
+                                                int chunkLimit,
+                                                int addressLimit,
+                                                Chunk chunk) {
+    ModbusBlockTransfer& transfer = lastBlockTransfer_;
+    transfer = ModbusBlockTransfer();
+    if (count <= chunkLimit) {
+        // One PDU; an invalid count is rejected below as before.
+        transfer.chunks = 1;
+        int result = chunk(startAddress, 0, count);
+        if (result == -1) {
+            transfer.failedChunks = 1;
+            transfer.firstFailedAddress = startAddress;
+            transfer.errorCode = errno;
+        } else {
+            transfer.transferred = result;
+        }
+        return result;
+    }
+    if (startAddress < 0 || startAddress + count > addressLimit) {
+        transfer.errorCode = EMBMDATA;
+        errno = EMBMDATA;
+        return -1;
+    }
+
+    for (int offset = 0; offset < count; offset += chunkLimit) {
+        const int length = std::min(chunkLimit, count - offset);
+        ++transfer.chunks;
+        if (chunk(startAddress + offset, offset, length) != -1) {
+            transfer.transferred += length;
+            continue;
+        }
+        const int errorCode = errno;
+        if (transfer.failedChunks++ == 0) {
+            transfer.firstFailedAddress = startAddress + offset;
+            transfer.errorCode = errorCode;
+        }
+        // Recovery already failed to reopen the port: every further chunk would fail the same way.
+        if (classifyModbusError(errorCode) == ModbusErrorClass::Link) {
+            break;
+        }
+    }
+    if (transfer.failedChunks > 0) {
+        errno = transfer.errorCode;
+        return -1;
+    }
+    return count;
+}
+
+const test_modbus_485::ModbusBlockTransfer& test_modbus_485::ModbusUtils::lastBlockTransfer() const {
+    return lastBlockTransfer_;
 }
 
 int test_modbus_485::ModbusUtils::getFileDescriptor(modbus_t* contextPointer) {
@@ -137,152 +723,486 @@ int test_modbus_485::ModbusUtils::getFileDescriptor(modbus_t* contextPointer) {
            : -1;
 }
 
-int test_modbus_485::ModbusUtils::readCoils(modbus_t* contextPointer,
+int test_modbus_485::ModbusUtils::readCoils(modbus_t*& contextReference,
                                             int startAddress,
                                             int numberOfCoils,
                                             std::vector<uint8_t>& destination) {
     destination.assign(numberOfCoils, 0);
-    return executeWithReconnect(contextPointer,
-                                ::modbus_read_bits,
-                                startAddress,
-                                numberOfCoils,
-                                destination.data());
+    return readCoils(contextReference, startAddress, numberOfCoils, destination.data());
 }
 
-int test_modbus_485::ModbusUtils::readDiscreteInputs(modbus_t* contextPointer,
+int test_modbus_485::ModbusUtils::readCoils(modbus_t*& contextReference,
+                                            int startAddress,
+                                            int numberOfCoils,
+                                            uint8_t* destination) {
+    return transferBlock(startAddress, numberOfCoils, MODBUS_MAX_READ_BITS, 65536,
+                         [&](int address, int offset, int count) {
+                             return readBits(contextReference, ModbusTable::Coils, address, count,
+                                             destination + offset);
+                         });
+}
+
+int test_modbus_485::ModbusUtils::readDiscreteInputs(modbus_t*& contextReference,
                                                      int startAddress,
                                                      int numberOfInputs,
                                                      std::vector<uint8_t>& destination) {
     destination.assign(numberOfInputs, 0);
-    return executeWithReconnect(contextPointer,
-                                ::modbus_read_input_bits,
-                                startAddress,
-                                numberOfInputs,
-                                destination.data());
+    return readDiscreteInputs(contextReference, startAddress, numberOfInputs, destination.data());
 }
 
-int test_modbus_485::ModbusUtils::readHoldingRegisters(modbus_t* contextPointer,
+int test_modbus_485::ModbusUtils::readDiscreteInputs(modbus_t*& contextReference,
+                                                     int startAddress,
+                                                     int numberOfInputs,
+                                                     uint8_t* destination) {
+    return transferBlock(startAddress, numberOfInputs, MODBUS_MAX_READ_BITS, 65536,
+                         [&](int address, int offset, int count) {
+                             return readBits(contextReference, ModbusTable::DiscreteInputs, address, count,
+                                             destination + offset);
+                         });
+}
+
+int test_modbus_485::ModbusUtils::readHoldingRegisters(modbus_t*& contextReference,
                                                        int startAddress,
                                                        int numberOfRegisters,
                                                        std::vector<uint16_t>& destination) {
     destination.assign(numberOfRegisters, 0);
-    return executeWithReconnect(contextPointer,
-                                ::modbus_read_registers,
-                                startAddress,
-                                numberOfRegisters,
-                                destination.data());
+    return readHoldingRegisters(contextReference, startAddress, numberOfRegisters, destination.data());
 }
 
-int test_modbus_485::ModbusUtils::readInputRegisters(modbus_t* contextPointer,
+int test_modbus_485::ModbusUtils::readHoldingRegisters(modbus_t*& contextReference,
+                                                       int startAddress,
+                                                       int numberOfRegisters,
+                                                       uint16_t* destination) {
+    return transferBlock(startAddress, numberOfRegisters, MODBUS_MAX_READ_REGISTERS, 65536,
+                         [&](int address, int offset, int count) {
+                             return readRegisters(contextReference, ModbusTable::HoldingRegisters, address, count,
+                                                  destination + offset);
+                         });
+}
+
+int test_modbus_485::ModbusUtils::readInputRegisters(modbus_t*& contextReference,
                                                      int startAddress,
                                                      int numberOfRegisters,
                                                      std::vector<uint16_t>& destination) {
     destination.assign(numberOfRegisters, 0);
-    return executeWithReconnect(contextPointer,
-                                ::modbus_read_input_registers,
-                                startAddress,
-                                numberOfRegisters,
-                                destination.data());
+    return readInputRegisters(contextReference, startAddress, numberOfRegisters, destination.data());
+}
+
+int test_modbus_485::ModbusUtils::readInputRegisters(modbus_t*& contextReference,
+                                                     int startAddress,
+                                                     int numberOfRegisters,
+                                                     uint16_t* destination) {
+    return transferBlock(startAddress, numberOfRegisters, MODBUS_MAX_READ_REGISTERS, 65536,
+                         [&](int address, int offset, int count) {
+                             return readRegisters(contextReference, ModbusTable::InputRegisters, address, count,
+                                                  destination + offset);
+                         });
+}
+
+int test_modbus_485::ModbusUtils::readBits(modbus_t*& contextReference,
+                                           ModbusTable table,
+                                           int startAddress,
+                                           int count,
+                                           uint8_t* destination) {
+    if (readCache_) {
+        return readCache_->read(currentSlave(contextReference), table, startAddress, count, destination, [&]() {
+            return fetchBits(contextReference, table, startAddress, count, destination);
+        });
+    }
+    return fetchBits(contextReference, table, startAddress, count, destination);
+}
+
+int test_modbus_485::ModbusUtils::readRegisters(modbus_t*& contextReference,
+                                                ModbusTable table,
+                                                int startAddress,
+                                                int count,
+                                                uint16_t* destination) {
+    if (readCache_) {
+        return readCache_->read(currentSlave(contextReference), table, startAddress, count, destination, [&]() {
+            return fetchRegisters(contextReference, table, startAddress, count, destination);
+        });
+    }
+    return fetchRegisters(contextReference, table, startAddress, count, destination);
 }
 
-bool test_modbus_485::ModbusUtils::writeSingleCoil(modbus_t* contextPointer,
+int test_modbus_485::ModbusUtils::fetchBits(modbus_t*& contextReference,
+                                            ModbusTable table,
+                                            int startAddress,
+                                            int count,
+                                            uint8_t* destination) {
+    const int functionCode =
+        table == ModbusTable::Coils ? MODBUS_FC_READ_COILS : MODBUS_FC_READ_DISCRETE_INPUTS;
+    const int result =
+        transport_ ? transportReadBits(contextReference, functionCode, startAddress, count, destination)
+                   : executeWithReconnect(contextReference,
+                                          functionCode,
+                                          count,
+                                          table == ModbusTable::Coils ? ::modbus_read_bits : ::modbus_read_input_bits,
+                                          startAddress,
+                                          count,
+                                          destination);
+    if (sharedImage_ && result == count) {
+        sharedImage_->publishBits(currentSlave(contextReference), table, startAddress, count, destination);
+    }
+    return result;
+}
+
+int test_modbus_485::ModbusUtils::fetchRegisters(modbus_t*& contextReference,
+                                                 ModbusTable table,
+                                                 int startAddress,
+                                                 int count,
+                                                 uint16_t* destination) {
+    const int functionCode =
+        table == ModbusTable::HoldingRegisters ? MODBUS_FC_READ_HOLDING_REGISTERS : MODBUS_FC_READ_INPUT_REGISTERS;
+    const int result =
+        transport_ ? transportReadRegisters(contextReference, functionCode, startAddress, count, destination)
+                   : executeWithReconnect(contextReference,
+                                          functionCode,
+                                          count,
+                                          table == ModbusTable::HoldingRegisters ? ::modbus_read_registers
+                                                                                 : ::modbus_read_input_registers,
+                                          startAddress,
+                                          count,
+                                          destination);
+    if (sharedImage_ && result == count) {
+        sharedImage_->publishRegisters(currentSlave(contextReference), table, startAddress, count, destination);
+    }
+    return result;
+}
+
+bool test_modbus_485::ModbusUtils::writeSingleCoil(modbus_t*& contextReference,
                                                    int coilAddress,
                                                    bool coilStatus) {
-    int result = executeWithReconnect(contextPointer,
+    if (transport_ || broadcasting(contextReference)) {
+        uint8_t request[5];
+        int requestLength = encodeWriteSingleCoil(coilAddress, coilStatus, request);
+        int result = transportWrite(contextReference, MODBUS_FC_WRITE_SINGLE_COIL, 1, request, requestLength);
+        invalidateReadCache(contextReference, ModbusTable::Coils, coilAddress, 1);
+        return result != -1;
+    }
+    int result = executeWithReconnect(contextReference,
+                                      MODBUS_FC_WRITE_SINGLE_COIL,
+                                      1,
                                       ::modbus_write_bit,
                                       coilAddress,
                                       coilStatus ? 1 : 0);
+    invalidateReadCache(contextReference, ModbusTable::Coils, coilAddress, 1);
     return result != -1;
 }
 
-bool test_modbus_485::ModbusUtils::writeSingleRegister(modbus_t* contextPointer,
+bool test_modbus_485::ModbusUtils::writeSingleRegister(modbus_t*& contextReference,
                                                        int registerAddress,
                                                        uint16_t registerValue) {
-    int result = executeWithReconnect(contextPointer,
+    if (transport_ || broadcasting(contextReference)) {
+        uint8_t request[5];
+        int requestLength = encodeWriteSingleRegister(registerAddress, registerValue, request);
+        int result = transportWrite(contextReference, MODBUS_FC_WRITE_SINGLE_REGISTER, 1, request, requestLength);
+        invalidateReadCache(contextReference, ModbusTable::HoldingRegisters, registerAddress, 1);
+        return result != -1;
+    }
+    int result = executeWithReconnect(contextReference,
+                                      MODBUS_FC_WRITE_SINGLE_REGISTER,
+                                      1,
                                       ::modbus_write_register,
                                       registerAddress,
                                       registerValue);
+    invalidateReadCache(contextReference, ModbusTable::HoldingRegisters, registerAddress, 1);
     return result != -1;
 }
 
-int test_modbus_485::ModbusUtils::writeMultipleCoils(modbus_t* contextPointer,
+int test_modbus_485::ModbusUtils::writeMultipleCoils(modbus_t*& contextReference,
                                                      int startAddress,
                                                      const std::vector<uint8_t>& source) {
-    return executeWithReconnect(contextPointer,
-                                ::modbus_write_bits,
-                                startAddress,
-                                static_cast<int>(source.size()),
-                                source.data());
+    return writeMultipleCoils(contextReference, startAddress, source.data(), static_cast<int>(source.size()));
 }
 
-int test_modbus_485::ModbusUtils::writeMultipleRegisters(modbus_t* contextPointer,
+int test_modbus_485::ModbusUtils::writeMultipleCoils(modbus_t*& contextReference,
+                                                     int startAddress,
+                                                     const uint8_t* source,
+                                                     int count) {
+    return transferBlock(startAddress, count, MODBUS_MAX_WRITE_BITS, 65536, [&](int address, int offset, int length) {
+        return storeBits(contextReference, address, source + offset, length);
+    });
+}
+
+int test_modbus_485::ModbusUtils::writeMultipleRegisters(modbus_t*& contextReference,
                                                          int startAddress,
                                                          const std::vector<uint16_t>& source) {
-    return executeWithReconnect(contextPointer,
-                                ::modbus_write_registers,
-                                startAddress,
-                                static_cast<int>(source.size()),
-                                source.data());
+    return writeMultipleRegisters(contextReference, startAddress, source.data(), static_cast<int>(source.size()));
+}
+
+int test_modbus_485::ModbusUtils::writeMultipleRegisters(modbus_t*& contextReference,
+                                                         int startAddress,
+                                                         const uint16_t* source,
+                                                         int count) {
+    return transferBlock(startAddress, count, MODBUS_MAX_WRITE_REGISTERS, 65536,
+                         [&](int address, int offset, int length) {
+                             return storeRegisters(contextReference, address, source + offset, length);
+                         });
+}
+
+int test_modbus_485::ModbusUtils::storeBits(modbus_t*& contextReference,
+                                            int startAddress,
+                                            const uint8_t* source,
+                                            int count) {
+    if (transport_ || broadcasting(contextReference)) {
+        if (count < 1 || count > MODBUS_MAX_WRITE_BITS) {
+            errno = EMBMDATA;
+            return -1;
+        }
+        uint8_t request[MODBUS_MAX_PDU_LENGTH];
+        int requestLength = encodeWriteMultipleCoils(startAddress, source, count, request);
+        int result = transportWrite(contextReference, MODBUS_FC_WRITE_MULTIPLE_COILS, count, request, requestLength);
+        invalidateReadCache(contextReference, ModbusTable::Coils, startAddress, count);
+        return result;
+    }
+    int result = executeWithReconnect(contextReference,
+                                      MODBUS_FC_WRITE_MULTIPLE_COILS,
+                                      count,
+                                      ::modbus_write_bits,
+                                      startAddress,
+                                      count,
+                                      source);
+    invalidateReadCache(contextReference, ModbusTable::Coils, startAddress, count);
+    return result;
+}
+
+int test_modbus_485::ModbusUtils::storeRegisters(modbus_t*& contextReference,
+                                                 int startAddress,
+                                                 const uint16_t* source,
+                                                 int count) {
+    if (transport_ || broadcasting(contextReference)) {
+        if (count < 1 || count > MODBUS_MAX_WRITE_REGISTERS) {
+            errno = EMBMDATA;
+            return -1;
+        }
+        uint8_t request[MODBUS_MAX_PDU_LENGTH];
+        int requestLength = encodeWriteMultipleRegisters(startAddress, source, count, request);
+        int result =
+            transportWrite(contextReference, MODBUS_FC_WRITE_MULTIPLE_REGISTERS, count, request, requestLength);
+        invalidateReadCache(contextReference, ModbusTable::HoldingRegisters, startAddress, count);
+        return result;
+    }
+    int result = executeWithReconnect(contextReference,
+                                      MODBUS_FC_WRITE_MULTIPLE_REGISTERS,
+                                      count,
+                                      ::modbus_write_registers,
+                                      startAddress,
+                                      count,
+                                      source);
+    invalidateReadCache(contextReference, ModbusTable::HoldingRegisters, startAddress, count);
+    return result;
 }
 
-bool test_modbus_485::ModbusUtils::maskWriteRegister(modbus_t* contextPointer,
+bool test_modbus_485::ModbusUtils::maskWriteRegister(modbus_t*& contextReference,
                                                      int registerAddress,
                                                      uint16_t andMask,
                                                      uint16_t orMask) {
-    int result = executeWithReconnect(contextPointer,
+    if (transport_ || broadcasting(contextReference)) {
+        const uint8_t request[7] = {MODBUS_FC_MASK_WRITE_REGISTER,
+                                    static_cast<uint8_t>(registerAddress >> 8), static_cast<uint8_t>(registerAddress),
+                                    static_cast<uint8_t>(andMask >> 8), static_cast<uint8_t>(andMask),
+                                    static_cast<uint8_t>(orMask >> 8), static_cast<uint8_t>(orMask)};
+        int result = transportWrite(contextReference, MODBUS_FC_MASK_WRITE_REGISTER, 1, request, 7);
+        invalidateReadCache(contextReference, ModbusTable::HoldingRegisters, registerAddress, 1);
+        return result != -1;
+    }
+    int result = executeWithReconnect(contextReference,
+                                      MODBUS_FC_MASK_WRITE_REGISTER,
+                                      1,
                                       ::modbus_mask_write_register,
                                       registerAddress,
                                       andMask,
                                       orMask);
+    invalidateReadCache(contextReference, ModbusTable::HoldingRegisters, registerAddress, 1);
     return result != -1;
 }
 
-int test_modbus_485::ModbusUtils::writeAndReadRegisters(modbus_t* contextPointer,
+int test_modbus_485::ModbusUtils::writeAndReadRegisters(modbus_t*& contextReference,
                                                         int writeAddress,
                                                         const std::vector<uint16_t>& source,
                                                         int readAddress,
                                                         int numberOfRegisters,
                                                         std::vector<uint16_t>& destination) {
     destination.assign(numberOfRegisters, 0);
-    return executeWithReconnect(contextPointer,
-                                ::modbus_write_and_read_registers,
-                                writeAddress,
-                                static_cast<int>(source.size()),
-                                source.data(),
-                                readAddress,
-                                numberOfRegisters,
-                                destination.data());
+    return writeAndReadRegisters(contextReference, writeAddress, source.data(), static_cast<int>(source.size()),
+                                 readAddress, numberOfRegisters, destination.data());
+}
+
+int test_modbus_485::ModbusUtils::writeAndReadRegisters(modbus_t*& contextReference,
+                                                        int writeAddress,
+                                                        const uint16_t* source,
+                                                        int writeCount,
+                                                        int readAddress,
+                                                        int numberOfRegisters,
+                                                        uint16_t* destination) {
+    if (transport_) {
+        if (writeCount < 1 || writeCount > MODBUS_MAX_WR_WRITE_REGISTERS ||
+            numberOfRegisters < 1 || numberOfRegisters > MODBUS_MAX_WR_READ_REGISTERS) {
+            errno = EMBMDATA;
+            return -1;
+        }
+        uint8_t request[MODBUS_MAX_PDU_LENGTH];
+        int requestLength = encodeWriteAndReadRegisters(writeAddress, source, writeCount,
+                                                        readAddress, numberOfRegisters, request);
+        int result = transportTransaction(contextReference, MODBUS_FC_WRITE_AND_READ_REGISTERS,
+                                          writeCount + numberOfRegisters, request, requestLength,
+                                          [&](const uint8_t* response, int length) {
+                                              return decodeRegisters(response, length, destination,
+                                                                     numberOfRegisters);
+                                          });
+        invalidateReadCache(contextReference, ModbusTable::HoldingRegisters, writeAddress, writeCount);
+        if (sharedImage_ && result == numberOfRegisters) {
+            sharedImage_->publishRegisters(currentSlave(contextReference), ModbusTable::HoldingRegisters, readAddress,
+                                           numberOfRegisters, destination);
+        }
+        return result;
+    }
+    int result = executeWithReconnect(contextReference,
+                                      MODBUS_FC_WRITE_AND_READ_REGISTERS,
+                                      writeCount + numberOfRegisters,
+                                      ::modbus_write_and_read_registers,
+                                      writeAddress,
+                                      writeCount,
+                                      source,
+                                      readAddress,
+                                      numberOfRegisters,
+                                      destination);
+    invalidateReadCache(contextReference, ModbusTable::HoldingRegisters, writeAddress, writeCount);
+    if (sharedImage_ && result == numberOfRegisters) {
+        sharedImage_->publishRegisters(currentSlave(contextReference), ModbusTable::HoldingRegisters, readAddress,
+                                       numberOfRegisters, destination);
+    }
+    return result;
 }
 
-int test_modbus_485::ModbusUtils::reportSlaveIdentifier(modbus_t* contextPointer,
+int test_modbus_485::ModbusUtils::reportSlaveIdentifier(modbus_t*& contextReference,
                                                        int maximumBytes,
                                                        std::vector<uint8_t>& destination) {
     destination.assign(maximumBytes, 0);
-    return executeWithReconnect(contextPointer,
+    return reportSlaveIdentifier(contextReference, maximumBytes, destination.data());
+}
+
+int test_modbus_485::ModbusUtils::reportSlaveIdentifier(modbus_t*& contextReference,
+                                                       int maximumBytes,
+                                                       uint8_t* destination) {
+    if (transport_) {
+        const uint8_t request[1] = {MODBUS_FC_REPORT_SLAVE_ID};
+        return transportTransaction(contextReference, MODBUS_FC_REPORT_SLAVE_ID, maximumBytes, request, 1,
+                                    [&](const uint8_t* response, int length) {
+                                        if (length < 2 || length < 2 + response[1]) {
+                                            return -1;
+                                        }
+                                        for (int i = 0; i < response[1] && i < maximumBytes; ++i) {
+                                            destination[i] = response[2 + i];
+                                        }
+                                        return static_cast<int>(response[1]);
+                                    });
+    }
+    return executeWithReconnect(contextReference,
+                                MODBUS_FC_REPORT_SLAVE_ID,
+                                maximumBytes,
                                 ::modbus_report_slave_id,
                                 maximumBytes,
-                                destination.data());
+                                destination);
+}
+
+int test_modbus_485::ModbusUtils::readFileRecord(modbus_t*& contextReference,
+                                                 int fileNumber,
+                                                 int recordNumber,
+                                                 int numberOfRecords,
+                                                 std::vector<uint16_t>& destination) {
+    destination.assign(numberOfRecords, 0);
+    return readFileRecord(contextReference, fileNumber, recordNumber, numberOfRecords, destination.data());
+}
+
+int test_modbus_485::ModbusUtils::readFileRecord(modbus_t*& contextReference,
+                                                 int fileNumber,
+                                                 int recordNumber,
+                                                 int numberOfRecords,
+                                                 uint16_t* destination) {
+    return transferBlock(recordNumber, numberOfRecords, modbusMaxReadFileRecords, modbusFileRecordCount,
+                         [&](int record, int offset, int count) {
+                             return fetchFileRecord(contextReference, fileNumber, record, count,
+                                                    destination + offset);
+                         });
+}
+
+int test_modbus_485::ModbusUtils::writeFileRecord(modbus_t*& contextReference,
+                                                  int fileNumber,
+                                                  int recordNumber,
+                                                  const std::vector<uint16_t>& source) {
+    return writeFileRecord(contextReference, fileNumber, recordNumber, source.data(),
+                           static_cast<int>(source.size()));
+}
+
+int test_modbus_485::ModbusUtils::writeFileRecord(modbus_t*& contextReference,
+                                                  int fileNumber,
+                                                  int recordNumber,
+                                                  const uint16_t* source,
+                                                  int count) {
+    return transferBlock(recordNumber, count, modbusMaxWriteFileRecords, modbusFileRecordCount,
+                         [&](int record, int offset, int length) {
+                             return storeFileRecord(contextReference, fileNumber, record, source + offset, length);
+                         });
+}
+
+int test_modbus_485::ModbusUtils::fetchFileRecord(modbus_t*& contextReference,
+                                                  int fileNumber,
+                                                  int recordNumber,
+                                                  int count,
+                                                  uint16_t* destination) {
+    if (fileNumber < 1 || fileNumber > 0xFFFF || recordNumber < 0 || count < 1 ||
+        count > modbusMaxReadFileRecords || recordNumber + count > modbusFileRecordCount) {
+        errno = EMBMDATA;
+        return -1;
+    }
+    uint8_t request[9];
+    int requestLength = encodeReadFileRecord(fileNumber, recordNumber, count, request);
+    return transportTransaction(contextReference, modbusFcReadFileRecord, count, request, requestLength,
+                                [&](const uint8_t* response, int length) {
+                                    return decodeFileRecord(response, length, destination, count);
+                                });
+}
+
+int test_modbus_485::ModbusUtils::storeFileRecord(modbus_t*& contextReference,
+                                                  int fileNumber,
+                                                  int recordNumber,
+                                                  const uint16_t* source,
+                                                  int count) {
+    if (fileNumber < 1 || fileNumber > 0xFFFF || recordNumber < 0 || count < 1 ||
+        count > modbusMaxWriteFileRecords || recordNumber + count > modbusFileRecordCount) {
+        errno = EMBMDATA;
+        return -1;
+    }
+    uint8_t request[MODBUS_MAX_PDU_LENGTH];
+    int requestLength = encodeWriteFileRecord(fileNumber, recordNumber, source, count, request);
+    // The reply echoes the request; a broadcast gets none.
+    return transportTransaction(contextReference, modbusFcWriteFileRecord, count, request, requestLength,
+                                [&](const uint8_t* /*response*/, int length) {
+                                    return length == 0 || length == requestLength ? count : -1;
+                                });
 }
 
-bool test_modbus_485::ModbusUtils::readSingleCoil(modbus_t* contextPointer,
+bool test_modbus_485::ModbusUtils::readSingleCoil(modbus_t*& contextReference,
                                                   int coilAddress,
                                                   bool& coilStatus) {
-    std::vector<uint8_t> buffer;
-    int result = readCoils(contextPointer, coilAddress, 1, buffer);
+    uint8_t value = 0;
+    int result = readCoils(contextReference, coilAddress, 1, &value);
     if (result > 0) {
-        coilStatus = (buffer[0] != 0);
+        coilStatus = (value != 0);
         return true;
     }
     return false;
 }
 
-bool test_modbus_485::ModbusUtils::readSingleRegister(modbus_t* contextPointer,
+bool test_modbus_485::ModbusUtils::readSingleRegister(modbus_t*& contextReference,
                                                       int registerAddress,
                                                       uint16_t& registerValue) {
-    std::vector<uint16_t> buffer;
-    int result = readHoldingRegisters(contextPointer, registerAddress, 1, buffer);
+    uint16_t value = 0;
+    int result = readHoldingRegisters(contextReference, registerAddress, 1, &value);
     if (result > 0) {
-        registerValue = buffer[0];
+        registerValue = value;
         return true;
     }
     return false;
@@ -0,0 +1,147 @@
+// src/modbus_write_coalescer.cpp
+
+#include "modbus_write_coalescer.h"
+#include <cerrno>
+#include <iomanip>
+#include <utility>
+
+void test_modbus_485::ModbusWriteCoalescerStatistics::print(std::ostream& stream) const {
+    std::ios::fmtflags flags = stream.flags();
+    std::streamsize precision = stream.precision();
+
+    const LatencySummary summary = age.summary();
+    stream << "  posted " << posted << ", merged " << merged << ", written " << written << " (broadcast "
+           << broadcasts << "), failed " << failed << ", dropped " << dropped << "\n"
+           << std::fixed << std::setprecision(0)
+           << "  setpoint age (us): p50 " << summary.p50 << ", p99 " << summary.p99 << ", max " << summary.max
+           << "\n";
+
+    stream.flags(flags);
+    stream.precision(precision);
+}
+
+test_modbus_485::ModbusWriteCoalescer::ModbusWriteCoalescer(ModbusBusOwner& owner, ModbusRequestPriority priority)
+    : owner_(owner),
+      priority_(priority) {}
+
+std::shared_future<test_modbus_485::ModbusBusResult>
+test_modbus_485::ModbusWriteCoalescer::writeRegisters(int slaveIdentifier,
+                                                      int startAddress,
+                                                      std::vector<uint16_t> values) {
+    const int count = static_cast<int>(values.size());
+    return post(slaveIdentifier, ModbusTable::HoldingRegisters, startAddress, count, std::move(values), {});
+}
+
+std::shared_future<test_modbus_485::ModbusBusResult>
+test_modbus_485::ModbusWriteCoalescer::writeCoils(int slaveIdentifier, int startAddress, std::vector<uint8_t> values) {
+    const int count = static_cast<int>(values.size());
+    return post(slaveIdentifier, ModbusTable::Coils, startAddress, count, {}, std::move(values));
+}
+
+size_t test_modbus_485::ModbusWriteCoalescer::pending() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return pending_.size();
+}
+
+test_modbus_485::ModbusWriteCoalescerStatistics test_modbus_485::ModbusWriteCoalescer::statistics() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ModbusWriteCoalescerStatistics result = counters_;
+    result.age = age_.snapshot();
+    return result;
+}
+
+std::shared_future<test_modbus_485::ModbusBusResult>
+test_modbus_485::ModbusWriteCoalescer::post(int slaveIdentifier,
+                                            ModbusTable table,
+                                            int startAddress,
+                                            int count,
+                                            std::vector<uint16_t> registers,
+                                            std::vector<uint8_t> bits) {
+    const Key key(slaveIdentifier, static_cast<int>(table), startAddress, count);
+    std::shared_ptr<std::promise<ModbusBusResult>> promise;
+    std::shared_future<ModbusBusResult> future;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++counters_.posted;
+        auto found = pending_.find(key);
+        if (found != pending_.end()) {
+            // Still queued: the older values are never sent.
+            found->second.registers = std::move(registers);
+            found->second.bits = std::move(bits);
+            found->second.posted = Clock::now();
+            ++counters_.merged;
+            return found->second.future;
+        }
+        Pending& entry = pending_[key];
+        entry.registers = std::move(registers);
+        entry.bits = std::move(bits);
+        entry.posted = Clock::now();
+        entry.promise = std::make_shared<std::promise<ModbusBusResult>>();
+        entry.future = entry.promise->get_future().share();
+        promise = entry.promise;
+        future = entry.future;
+    }
+
+    // Outside the lock: a stopped owner completes the request from inside submit().
+    owner_.submit(slaveIdentifier, priority_,
+                  [this, key](ModbusUtils& modbus, modbus_t*& contextReference, ModbusBusResult&) {
+                      return flush(key, modbus, contextReference);
+                  },
+                  [this, key, promise](const ModbusBusResult& result) {
+                      {
+                          std::lock_guard<std::mutex> lock(mutex_);
+                          // Still pending with our promise: flush() never ran.
+                          auto found = pending_.find(key);
+                          if (found != pending_.end() && found->second.promise == promise) {
+                              pending_.erase(found);
+                              ++counters_.dropped;
+                          }
+                      }
+                      promise->set_value(result);
+                  });
+    return future;
+}
+
+int test_modbus_485::ModbusWriteCoalescer::flush(const Key& key, ModbusUtils& modbus, modbus_t*& contextReference) {
+    Pending entry;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto found = pending_.find(key);
+        if (found == pending_.end()) {
+            errno = ECANCELED;
+            return -1;
+        }
+        // Later posts queue a new write instead of changing this one.
+        entry = std::move(found->second);
+        pending_.erase(found);
+    }
+
+    const int slaveIdentifier = std::get<0>(key);
+    const int startAddress = std::get<2>(key);
+    const int count = std::get<3>(key);
+    int result = -1;
+    if (static_cast<ModbusTable>(std::get<1>(key)) == ModbusTable::Coils) {
+        result = count == 1 ? (modbus.writeSingleCoil(contextReference, startAddress, entry.bits[0] != 0) ? 1 : -1)
+                            : modbus.writeMultipleCoils(contextReference, startAddress, entry.bits);
+    } else {
+        result = count == 1
+                 ? (modbus.writeSingleRegister(contextReference, startAddress, entry.registers[0]) ? 1 : -1)
+                 : modbus.writeMultipleRegisters(contextReference, startAddress, entry.registers);
+    }
+    const int errorCode = errno;
+
+    age_.record(Clock::now() - entry.posted);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (result == -1) {
+            ++counters_.failed;
+        } else {
+            ++counters_.written;
+            if (slaveIdentifier == MODBUS_BROADCAST_ADDRESS) {
+                ++counters_.broadcasts;
+            }
+        }
+    }
+    errno = errorCode;
+    return result;
+}
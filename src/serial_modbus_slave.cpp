@@ -1,95 +1,141 @@
 // src/serial_modbus_slave.cpp
+//
+// Device simulator for serial_modbus_master. Requests are answered by a
+// ModbusImageSlave thread straight from a register image; the simulated
+// battery, charger and error bits are refreshed by a producer thread every
+// update period, and the master's writes are logged from the main thread,
+// so none of it sits between a request and its reply. The whole 0..65535
+// range of every table is served; only pages that were written use memory.
+// Ctrl-C prints the turnaround the slave added.
+//
+// usage: serial_modbus_slave [device] [slave-id] [baud] [update-ms]
 
+#include "modbus_drive_points.h"
+#include "modbus_image_slave.h"
+#include "modbus_register_image.h"
+#include "modbus_timing.h"
 #include "modbus_utils.h"
-#include <random>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
 #include <iostream>
-#include <cassert>
+#include <random>
+#include <thread>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+volatile std::sig_atomic_t stopRequested = 0;
+
+void onSignal(int) {
+    stopRequested = 1;
+}
+
+} // namespace
 
 int main(int argc, char** argv) {
-    const char* device   = (argc > 1 ? argv[1] : "/dev/ttyS0");
-    constexpr int slaveId = 1;
-    constexpr int baud      = 115200;
+    const char* device      = (argc > 1 ? argv[1] : "/dev/ttyS0");
+    const int slaveId       = (argc > 2 ? std::atoi(argv[2]) : 1);
+    const int baud          = (argc > 3 ? std::atoi(argv[3]) : 115200);
+    const int updatePeriod  = (argc > 4 ? std::atoi(argv[4]) : 10);
     constexpr char parity   = 'N';
     constexpr int dataBits  = 8;
     constexpr int stopBits  = 1;
 
-    test_modbus_485::ModbusUtils mb;
-    modbus_t* ctx = nullptr;
-    if (!mb.openRtu(ctx, device, baud, parity, dataBits, stopBits, slaveId)) {
-        std::cerr << "ERROR: cannot open RTU port\n";
+    const int fileDescriptor = open(device, O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+    if (fileDescriptor == -1) {
+        perror("[serial_modbus_slave] open");
+        return 1;
+    }
+    if (!test_modbus_485::configureRtuLine(fileDescriptor, baud, parity, dataBits, stopBits)) {
+        std::cerr << "ERROR: cannot configure " << device << "\n";
+        close(fileDescriptor);
         return 1;
     }
 
-    // Create mapping for 10 coils, 0 discrete inputs, 100 registers, 0 input registers
-    modbus_mapping_t* mb_map = modbus_mapping_new(10, 0, 100, 0);
-    assert(mb_map);
-
+    // Same layout the master decodes, see modbus_drive_points.h.
+    namespace points = test_modbus_485::drive_points;
+    test_modbus_485::ModbusRegisterImage image;
+    test_modbus_485::ModbusImageSlave slave(image, slaveId);
+    if (!slave.start(fileDescriptor, baud, test_modbus_485::bitsPerCharacter(parity, dataBits, stopBits))) {
+        close(fileDescriptor);
+        return 1;
+    }
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
     std::cout << "Modbus RTU Slave on " << device
               << ", ID=" << slaveId << ", waiting for requests...\n";
 
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_int_distribution<> d_v(0, 8000), d_i(-10000,10000),
-                               d_soc(0,1000), d_t(-50,125), d_err(0,0x3F),
-                               d_cycle(0,20000);
-
-    uint8_t query[MODBUS_RTU_MAX_ADU_LENGTH];
-    while (true) {
-        int rc = modbus_receive(ctx, query);
-        if (rc <= 0) {
-            // 에러 혹은 타임아웃: 컨텍스트 리셋 시도
-            mb.closeRtu(ctx);
-            if (!mb.openRtu(ctx, device, baud, parity, dataBits, stopBits, slaveId)) {
-                std::cerr << "[Slave] reconnection failed\n";
-                break;
+    // 랜덤하게 상태 갱신: 응답 경로 밖에서, 한 번의 Update 로 묶어 반쯤 갱신된 값이 나가지 않도록
+    std::atomic<bool> producing(true);
+    std::thread producer([&image, &producing, updatePeriod] {
+        std::random_device rd;
+        std::mt19937 gen(rd());
+        std::uniform_int_distribution<> d_v(0, 8000), d_i(-10000,10000),
+                                   d_soc(0,1000), d_t(-50,125), d_err(0,0x3F),
+                                   d_cycle(0,20000);
+        uint16_t batteryBlock[points::battery.count()];
+        uint16_t chargerBlock[points::charger.count()];
+        uint8_t errorBits[6];
+        while (producing.load(std::memory_order_relaxed)) {
+            const double battery[] = {d_v(gen) / 10.0, d_i(gen) / 100.0, d_soc(gen) / 10.0, double(d_t(gen))};
+            points::battery.encode(battery, batteryBlock);
+            const double charger[] = {d_v(gen) / 10.0, d_i(gen) / 100.0, double(d_cycle(gen))};
+            points::charger.encode(charger, chargerBlock);
+            const int errs = d_err(gen);
+            for (int b = 0; b < 6; ++b) {
+                errorBits[b] = (errs >> b) & 1;
+            }
+            {
+                test_modbus_485::ModbusRegisterImage::Update update(image);
+                update.setRegisters(test_modbus_485::ModbusTable::HoldingRegisters, points::battery.startAddress(),
+                                    batteryBlock, points::battery.count());
+                update.setRegisters(test_modbus_485::ModbusTable::HoldingRegisters, points::charger.startAddress(),
+                                    chargerBlock, points::charger.count());
+                update.setBits(test_modbus_485::ModbusTable::Coils, 4, errorBits, 6);
             }
-            continue;
+            std::this_thread::sleep_for(std::chrono::milliseconds(updatePeriod > 0 ? updatePeriod : 1));
         }
+    });
 
-        uint8_t functionCode = query[1];
-        if (functionCode == MODBUS_FC_WRITE_MULTIPLE_REGISTERS && rc >= 7) {
-            int addr = (query[2] << 8) | query[3];
-            int qty  = (query[4] << 8) | query[5];
-            std::cout << "[Slave] WRITE_REGS @" << addr << " cnt=" << qty
-                      << " → RPM=" << mb_map->tab_registers[0]
-                      << " Angle=" << (int16_t(mb_map->tab_registers[1]) / 100.0) << "°\n";
+    // Log what the master wrote, from the image rather than from the reply path.
+    uint16_t setpoints[points::setpoints.count()] = {};
+    uint8_t commands[4] = {};
+    while (!stopRequested) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        uint16_t currentSetpoints[points::setpoints.count()];
+        uint8_t currentCommands[4];
+        image.readRegisters(test_modbus_485::ModbusTable::HoldingRegisters, points::setpoints.startAddress(),
+                            points::setpoints.count(), currentSetpoints);
+        image.readBits(test_modbus_485::ModbusTable::Coils, 0, 4, currentCommands);
+        if (!std::equal(currentSetpoints, currentSetpoints + points::setpoints.count(), setpoints)) {
+            std::copy(currentSetpoints, currentSetpoints + points::setpoints.count(), setpoints);
+            std::cout << "[Slave] WRITE_REGS → RPM=" << points::setpoints.value<points::Rpm>(setpoints)
+                      << " Angle=" << points::setpoints.value<points::Angle>(setpoints) << "°\n";
         }
-        else if (functionCode == MODBUS_FC_WRITE_MULTIPLE_COILS && rc >= 7) {
-            int addr = (query[2] << 8) | query[3];
-            int qty  = (query[4] << 8) | query[5];
-            std::cout << "[Slave] WRITE_COILS @" << addr << " cnt=" << qty << ":";
-            for (int i = 0; i < qty && addr + i < mb_map->nb_bits; ++i)
-                std::cout << ' ' << int(mb_map->tab_bits[addr + i]);
+        if (!std::equal(currentCommands, currentCommands + 4, commands)) {
+            std::copy(currentCommands, currentCommands + 4, commands);
+            std::cout << "[Slave] WRITE_COILS:";
+            for (uint8_t command : commands)
+                std::cout << ' ' << int(command);
             std::cout << "\n";
         }
-
-        // 랜덤하게 상태 갱신
-        mb_map->tab_registers[10] = d_v(gen);
-        mb_map->tab_registers[11] = uint16_t(int16_t(d_i(gen)));
-        mb_map->tab_registers[12] = d_soc(gen);
-        mb_map->tab_registers[13] = uint16_t(int16_t(d_t(gen)));
-
-        mb_map->tab_registers[20] = d_v(gen);
-        mb_map->tab_registers[21] = uint16_t(int16_t(d_i(gen)));
-        mb_map->tab_registers[22] = d_cycle(gen);
-
-        int errs = d_err(gen);
-        for (int b = 0; b < 6; ++b) {
-            mb_map->tab_bits[4 + b] = (errs >> b) & 1;
-        }
-
-        // reply with mapping
-        if (modbus_reply(ctx, query, rc, mb_map) < 0) {
-            std::cerr << "[Slave] reply failed, resetting connection\n";
-            mb.closeRtu(ctx);
-            if (!mb.openRtu(ctx, device, baud, parity, dataBits, stopBits, slaveId)) {
-                std::cerr << "[Slave] reconnection failed\n";
-                break;
-            }
-        }
     }
 
-    modbus_mapping_free(mb_map);
-    mb.closeRtu(ctx);
+    producing.store(false);
+    producer.join();
+    slave.stop();
+    close(fileDescriptor);
+
+    const test_modbus_485::ModbusImageSlaveStatistics statistics = slave.statistics();
+    const test_modbus_485::LatencySummary turnaround = statistics.turnaround.summary();
+    std::cout << "requests " << statistics.requests << ", dropped " << statistics.dropped
+              << ", image pages " << image.pageCount() << ", read retries " << image.readRetries() << "\n"
+              << "turnaround us: p50 " << turnaround.p50 << ", p99 " << turnaround.p99
+              << ", max " << turnaround.max << "\n";
     return 0;
 }
@@ -0,0 +1,185 @@
+// tests/modbus_allocation_test.cpp
+//
+// Steady-state allocation check. A cycle planner, a point reader and the
+// single-value reads talk to a libmodbus RTU server on the other end of a
+// pty pair; after a warm-up that plans and sizes every buffer, a global
+// operator new counts heap allocations over many further cycles. Any
+// allocation fails the test (exit status 1).
+//
+// usage: modbus_allocation_test [--cycles=1000]
+
+#include "modbus_cycle_planner.h"
+#include "modbus_point_reader.h"
+#include "modbus_pty.h"
+#include "modbus_utils.h"
+#include <modbus.h>
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+
+std::atomic<bool>     countingEnabled{false};
+std::atomic<uint64_t> allocationCount{0};
+
+void* countedAllocate(std::size_t size) {
+    if (countingEnabled.load(std::memory_order_relaxed)) {
+        allocationCount.fetch_add(1, std::memory_order_relaxed);
+    }
+    void* pointer = std::malloc(size == 0 ? 1 : size);
+    if (!pointer) {
+        throw std::bad_alloc();
+    }
+    return pointer;
+}
+
+constexpr int warmupCycles = 16;
+
+bool runCycle(test_modbus_485::ModbusUtils& mb,
+              test_modbus_485::ModbusCyclePlanner& planner,
+              test_modbus_485::ModbusPointReader& reader,
+              modbus_t*& ctx,
+              int cycle) {
+    uint16_t* setpoints = planner.registerBuffer(0);
+    for (int i = 0; i < 8; ++i) {
+        setpoints[i] = static_cast<uint16_t>(cycle + i);
+    }
+    planner.coilBuffer(1)[0] = static_cast<uint8_t>(cycle & 1);
+    if (!planner.execute(ctx)) {
+        std::cerr << "[cycle " << cycle << "] planner failed, fc " << planner.failedFunctionCode() << "\n";
+        return false;
+    }
+    if (planner.registerBuffer(2)[0] != static_cast<uint16_t>(cycle)) {
+        std::cerr << "[cycle " << cycle << "] read back " << planner.registerBuffer(2)[0] << "\n";
+        return false;
+    }
+    if (!reader.read(ctx)) {
+        std::cerr << "[cycle " << cycle << "] point reader failed\n";
+        return false;
+    }
+    uint16_t registerValue = 0;
+    bool coilStatus = false;
+    if (!mb.readSingleRegister(ctx, 100, registerValue) || registerValue != static_cast<uint16_t>(cycle) ||
+        !mb.readSingleCoil(ctx, 40, coilStatus) || coilStatus != static_cast<bool>(cycle & 1)) {
+        std::cerr << "[cycle " << cycle << "] single reads failed\n";
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+void* operator new(std::size_t size) {
+    return countedAllocate(size);
+}
+
+void* operator new[](std::size_t size) {
+    return countedAllocate(size);
+}
+
+void operator delete(void* pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept {
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer, std::size_t) noexcept {
+    std::free(pointer);
+}
+
+int main(int argc, char* argv[]) {
+    int cycles = 1000;
+    for (int i = 1; i < argc; ++i) {
+        const std::string argument = argv[i];
+        if (argument.compare(0, 9, "--cycles=") == 0) {
+            cycles = std::atoi(argument.c_str() + 9);
+        } else {
+            std::cerr << "usage: " << argv[0] << " [--cycles=1000]\n";
+            return 2;
+        }
+    }
+
+    // Slave: libmodbus' own RTU server on the pty master, answering from a mapping.
+    int serverFileDescriptor = -1;
+    std::string devicePath;
+    if (!test_modbus_485::openPtyPair(serverFileDescriptor, devicePath)) {
+        return 1;
+    }
+    modbus_t* server = ::modbus_new_rtu(devicePath.c_str(), 115200, 'N', 8, 1);
+    modbus_mapping_t* mapping = ::modbus_mapping_new(2000, 2000, 2000, 2000);
+    if (!server || !mapping) {
+        return 1;
+    }
+    ::modbus_set_slave(server, 1);
+    ::modbus_set_socket(server, serverFileDescriptor);
+
+    test_modbus_485::ModbusUtils mb;
+    modbus_t* ctx = nullptr;
+    if (!mb.openRtu(ctx, devicePath, 115200, 'N', 8, 1, 1)) {
+        return 1;
+    }
+
+    std::atomic<bool> serving(true);
+    std::thread serverThread([server, mapping, &serving] {
+        uint8_t query[MODBUS_RTU_MAX_ADU_LENGTH];
+        while (serving.load()) {
+            int length = ::modbus_receive(server, query);
+            if (length > 0) {
+                ::modbus_reply(server, query, length, mapping);
+            }
+        }
+    });
+
+    // Write-then-read of the same registers lets a cycle check its own data.
+    test_modbus_485::ModbusCyclePlanner planner(mb);
+    planner.addRegisterWrite(100, 8);
+    planner.addCoilWrite(40, 1);
+    planner.addRegisterRead(100, 1);
+    planner.addRegisterRead(110, 20);
+    planner.addCoilRead(0, 64);
+
+    test_modbus_485::ModbusPointReader reader(mb);
+    for (int address : {0, 3, 9, 200, 205, 1000}) {
+        reader.addPoint(test_modbus_485::ModbusTable::HoldingRegisters, address);
+    }
+    for (int address : {5, 6, 70}) {
+        reader.addPoint(test_modbus_485::ModbusTable::Coils, address);
+    }
+    reader.addPoint(test_modbus_485::ModbusTable::InputRegisters, 12);
+
+    bool success = planner.plan() && reader.plan();
+    if (!success) {
+        std::cerr << "[plan] operations or points rejected\n";
+    }
+    for (int cycle = 0; cycle < warmupCycles && success; ++cycle) {
+        success = runCycle(mb, planner, reader, ctx, cycle);
+    }
+
+    countingEnabled = true;
+    for (int cycle = warmupCycles; cycle < warmupCycles + cycles && success; ++cycle) {
+        success = runCycle(mb, planner, reader, ctx, cycle);
+    }
+    countingEnabled = false;
+    const uint64_t allocations = allocationCount.load();
+
+    // Closing the master's end makes the server's receive fail, which ends its loop.
+    serving = false;
+    mb.closeRtu(ctx);
+    serverThread.join();
+    ::modbus_free(server);
+    ::modbus_mapping_free(mapping);
+    ::close(serverFileDescriptor);
+
+    std::cout << cycles << " cycles, " << allocations << " heap allocations\n";
+    return success && allocations == 0 ? 0 : 1;
+}
@@ -0,0 +1,148 @@
+// tests/modbus_bus_scheduler_test.cpp
+//
+// ModbusBusScheduler over a ModbusLoopbackTransport: slaves 1 and 2 answer
+// from data models, slave 3 never answers. The first round must poll the
+// due groups by priority, then by due time; values must come from the right
+// slave; the dead slave must be polled at backoff intervals that double up
+// to the maximum while the live ones keep their period; and once it
+// answers again its backoff must clear. Any mismatch exits with status 1.
+//
+// usage: modbus_bus_scheduler_test
+
+#include "modbus_bus_scheduler.h"
+#include "modbus_data_model.h"
+#include "modbus_loopback_transport.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = test_modbus_485::ModbusBusScheduler::Clock;
+
+constexpr std::chrono::milliseconds period(10);
+constexpr std::chrono::milliseconds initialBackoff(20);
+constexpr std::chrono::milliseconds maximumBackoff(80);
+
+struct Poll {
+    int               groupHandle;
+    bool              success;
+    Clock::time_point time;
+};
+
+bool check(bool condition, const char* what) {
+    if (!condition) {
+        std::cerr << "FAILED: " << what << "\n";
+    }
+    return condition;
+}
+
+const test_modbus_485::ModbusSlaveStatistics* findSlave(
+        const std::vector<test_modbus_485::ModbusSlaveStatistics>& statistics, int slaveIdentifier) {
+    for (const test_modbus_485::ModbusSlaveStatistics& slave : statistics) {
+        if (slave.slaveIdentifier == slaveIdentifier) {
+            return &slave;
+        }
+    }
+    return nullptr;
+}
+
+} // namespace
+
+int main() {
+    test_modbus_485::ModbusDataModel firstModel(100, 100);
+    test_modbus_485::ModbusDataModel secondModel(100, 100);
+    test_modbus_485::ModbusDataModel thirdModel(100, 100);
+    firstModel.holdingRegisters()[7] = 0x0101;
+    secondModel.holdingRegisters()[7] = 0x0202;
+    thirdModel.holdingRegisters()[7] = 0x0303;
+
+    test_modbus_485::ModbusLoopbackTransport loopback;
+    loopback.addSlave(1, firstModel);
+    loopback.addSlave(2, secondModel);
+
+    std::vector<Poll> polls;
+    auto record = [&polls](int groupHandle, bool success) {
+        polls.push_back(Poll{groupHandle, success, Clock::now()});
+    };
+
+    test_modbus_485::ModbusBusScheduler scheduler;
+    scheduler.attachTransport(&loopback);
+    scheduler.setBackoff(initialBackoff, maximumBackoff);
+    const int firstGroup  = scheduler.addPollGroup(1, period, 0, record);
+    const int secondGroup = scheduler.addPollGroup(2, period, 5, record);
+    const int deadGroup   = scheduler.addPollGroup(3, period, 0, record);
+    scheduler.addPoint(firstGroup, test_modbus_485::ModbusTable::HoldingRegisters, 7);
+    scheduler.addPoint(secondGroup, test_modbus_485::ModbusTable::HoldingRegisters, 7);
+    scheduler.addPoint(deadGroup, test_modbus_485::ModbusTable::HoldingRegisters, 7);
+
+    // All three are due at once: priority first, then the earlier due time.
+    while (scheduler.pollOnce()) {
+    }
+    bool passed = check(polls.size() == 3, "one poll per due group");
+    passed = passed && check(polls[0].groupHandle == secondGroup && polls[1].groupHandle == firstGroup &&
+                             polls[2].groupHandle == deadGroup,
+                             "due groups polled by priority, then by due time");
+    passed = passed && check(polls[0].success && polls[1].success && !polls[2].success,
+                             "live slaves answer, the dead one fails");
+    passed = check(scheduler.group(firstGroup).value(0) == 0x0101 &&
+                   scheduler.group(secondGroup).value(0) == 0x0202,
+                   "each group reads its own slave") && passed;
+
+    // Let run() go on for a while and look at when the dead slave was tried.
+    std::atomic<bool> running(true);
+    std::thread pollingThread([&scheduler, &running] { scheduler.run(running); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(400));
+    running = false;
+    pollingThread.join();
+
+    std::vector<Clock::time_point> deadPolls;
+    int livePolls = 0;
+    for (const Poll& poll : polls) {
+        if (poll.groupHandle == deadGroup) {
+            deadPolls.push_back(poll.time);
+        } else if (poll.groupHandle == firstGroup && poll.success) {
+            ++livePolls;
+        }
+    }
+    passed = check(deadPolls.size() >= 5, "dead slave retried after its backoff") && passed;
+    // 20 + 40 + 80 + 80 + ... ms: at most 7 tries in 400 ms, instead of one per 10 ms period.
+    passed = check(deadPolls.size() <= 7, "dead slave not polled every period") && passed;
+    std::chrono::milliseconds expectedGap = initialBackoff;
+    bool spaced = true;
+    for (size_t i = 1; i < deadPolls.size(); ++i) {
+        // The backoff is counted from the end of the failed poll, just before its callback.
+        spaced = spaced && deadPolls[i] - deadPolls[i - 1] >= expectedGap - std::chrono::milliseconds(1);
+        expectedGap = std::min(expectedGap * 2, maximumBackoff);
+    }
+    passed = check(spaced, "retries spaced by the doubling backoff") && passed;
+    passed = check(livePolls >= 20, "live slave keeps its period while the dead one backs off") && passed;
+
+    std::vector<test_modbus_485::ModbusSlaveStatistics> statistics = scheduler.statistics();
+    const test_modbus_485::ModbusSlaveStatistics* dead = findSlave(statistics, 3);
+    passed = check(dead && dead->backingOff && dead->skippedForBackoff > 0 && dead->failures == dead->polls,
+                   "statistics show the dead slave backing off") && passed;
+
+    // Slave 3 comes back: the next try succeeds and clears its backoff.
+    loopback.addSlave(3, thirdModel);
+    const Clock::time_point giveUp = Clock::now() + 2 * maximumBackoff;
+    bool recovered = false;
+    while (!recovered && Clock::now() < giveUp) {
+        if (!scheduler.pollOnce()) {
+            std::this_thread::sleep_until(std::min(scheduler.nextDeadline(), giveUp));
+            continue;
+        }
+        recovered = polls.back().groupHandle == deadGroup && polls.back().success;
+    }
+    statistics = scheduler.statistics();
+    dead = findSlave(statistics, 3);
+    passed = check(recovered && scheduler.group(deadGroup).value(0) == 0x0303 && dead && !dead->backingOff,
+                   "revived slave polled again without backoff") && passed;
+
+    scheduler.attachTransport(nullptr);
+    std::cout << (passed ? "bus scheduler passed\n" : "bus scheduler FAILED\n");
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,192 @@
+// tests/modbus_gateway_test.cpp
+//
+// Per-client ordering through ModbusTcpGateway with read coalescing on. A
+// ModbusSlaveSimulator serves one end of a pty pair at 9600 baud wire time;
+// the gateway drives the other end. Client B keeps the bus busy with a long
+// read and queues a short read behind it; client A then sends a write and
+// the same short read in one segment. A's read must not be answered from
+// B's transaction, which goes out before A's write: it has to return the
+// value A just wrote. Any mismatch exits with status 1.
+//
+// usage: modbus_gateway_test
+
+#include "modbus_async_engine.h"
+#include "modbus_pty.h"
+#include "modbus_slave_simulator.h"
+#include "modbus_tcp_gateway.h"
+#include "modbus_utils.h"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+
+constexpr int baud = 9600;
+constexpr int slave = 1;
+constexpr int probedRegister = 10;
+constexpr uint16_t writtenValue = 0x1234;
+
+int connectClient(int port) {
+    int fileDescriptor = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (fileDescriptor < 0) {
+        perror("[connectClient] socket");
+        return -1;
+    }
+    timeval timeout{2, 0};
+    ::setsockopt(fileDescriptor, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    sockaddr_in socketAddress{};
+    socketAddress.sin_family = AF_INET;
+    socketAddress.sin_port = htons(static_cast<uint16_t>(port));
+    socketAddress.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (::connect(fileDescriptor, reinterpret_cast<sockaddr*>(&socketAddress), sizeof(socketAddress)) != 0) {
+        perror("[connectClient] connect");
+        ::close(fileDescriptor);
+        return -1;
+    }
+    return fileDescriptor;
+}
+
+/**
+ * @brief Append an MBAP frame carrying a PDU of function code, address and value/quantity.
+ */
+void appendRequest(std::string& frames, uint16_t transactionIdentifier, uint8_t functionCode,
+                   uint16_t address, uint16_t valueOrQuantity) {
+    const uint8_t frame[12] = {static_cast<uint8_t>(transactionIdentifier >> 8),
+                               static_cast<uint8_t>(transactionIdentifier & 0xFF),
+                               0, 0, 0, 6, slave, functionCode,
+                               static_cast<uint8_t>(address >> 8),
+                               static_cast<uint8_t>(address & 0xFF),
+                               static_cast<uint8_t>(valueOrQuantity >> 8),
+                               static_cast<uint8_t>(valueOrQuantity & 0xFF)};
+    frames.append(reinterpret_cast<const char*>(frame), sizeof(frame));
+}
+
+bool sendAll(int fileDescriptor, const std::string& frames) {
+    return ::send(fileDescriptor, frames.data(), frames.size(), MSG_NOSIGNAL) ==
+           static_cast<ssize_t>(frames.size());
+}
+
+bool receiveExactly(int fileDescriptor, uint8_t* buffer, size_t length) {
+    size_t received = 0;
+    while (received < length) {
+        ssize_t count = ::recv(fileDescriptor, buffer + received, length - received, 0);
+        if (count <= 0) {
+            return false;
+        }
+        received += static_cast<size_t>(count);
+    }
+    return true;
+}
+
+/**
+ * @brief Receive one MBAP reply; its PDU lands in pdu and its length in pduLength.
+ */
+bool receiveReply(int fileDescriptor, uint16_t& transactionIdentifier, uint8_t* pdu, int& pduLength) {
+    uint8_t header[7];
+    if (!receiveExactly(fileDescriptor, header, sizeof(header))) {
+        return false;
+    }
+    transactionIdentifier = static_cast<uint16_t>((header[0] << 8) | header[1]);
+    pduLength = ((header[4] << 8) | header[5]) - 1;
+    return pduLength > 0 && pduLength <= 253 && receiveExactly(fileDescriptor, pdu, pduLength);
+}
+
+bool check(bool condition, const char* what) {
+    if (!condition) {
+        std::cerr << "FAILED: " << what << "\n";
+    }
+    return condition;
+}
+
+} // namespace
+
+int main() {
+    int simulatorFileDescriptor = -1;
+    std::string devicePath;
+    if (!test_modbus_485::openPtyPair(simulatorFileDescriptor, devicePath)) {
+        return 1;
+    }
+    test_modbus_485::ModbusSlaveSimulator simulator;
+    test_modbus_485::ModbusSimulatorOptions simulatorOptions;
+    simulatorOptions.baudRate = baud;
+    if (!simulator.addSlave(slave) || !simulator.start(simulatorFileDescriptor, simulatorOptions)) {
+        return 1;
+    }
+
+    test_modbus_485::ModbusUtils mb;
+    modbus_t* ctx = nullptr;
+    if (!mb.openRtu(ctx, devicePath, baud, 'N', 8, 1, slave)) {
+        return 1;
+    }
+    test_modbus_485::ModbusAsyncEngine engine;
+    if (!engine.initialize()) {
+        return 1;
+    }
+    test_modbus_485::ModbusAsyncPortOptions portOptions;
+    portOptions.baudRate = baud;
+    const int portHandle = engine.addPort(mb.getFileDescriptor(ctx), portOptions);
+    if (portHandle < 0) {
+        return 1;
+    }
+    test_modbus_485::ModbusTcpGateway gateway(engine, portHandle);
+    if (!gateway.listen("127.0.0.1", 0)) {
+        return 1;
+    }
+    std::thread engineThread([&engine] { engine.run(); });
+
+    const int clientA = connectClient(gateway.localPort());
+    const int clientB = connectClient(gateway.localPort());
+    bool passed = check(clientA >= 0 && clientB >= 0, "connect to the gateway");
+
+    // B: 100 registers hold the bus for about 0.2 s at 9600 baud; the short read waits behind them.
+    std::string framesB;
+    appendRequest(framesB, 1, MODBUS_FC_READ_HOLDING_REGISTERS, 200, 100);
+    appendRequest(framesB, 2, MODBUS_FC_READ_HOLDING_REGISTERS, probedRegister, 1);
+    passed = passed && check(sendAll(clientB, framesB), "send B's reads");
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    // A: write, then the same short read B has queued.
+    std::string framesA;
+    appendRequest(framesA, 1, MODBUS_FC_WRITE_SINGLE_REGISTER, probedRegister, writtenValue);
+    appendRequest(framesA, 2, MODBUS_FC_READ_HOLDING_REGISTERS, probedRegister, 1);
+    passed = passed && check(sendAll(clientA, framesA), "send A's write and read");
+
+    uint8_t pdu[253];
+    int pduLength = 0;
+    uint16_t transactionIdentifier = 0;
+    for (uint16_t expected = 1; passed && expected <= 2; ++expected) {
+        passed = check(receiveReply(clientB, transactionIdentifier, pdu, pduLength) &&
+                       transactionIdentifier == expected && pdu[0] == MODBUS_FC_READ_HOLDING_REGISTERS,
+                       "B's replies in order");
+    }
+    passed = passed && check(receiveReply(clientA, transactionIdentifier, pdu, pduLength) &&
+                             transactionIdentifier == 1 && pdu[0] == MODBUS_FC_WRITE_SINGLE_REGISTER,
+                             "A's write acknowledged first");
+    passed = passed && check(receiveReply(clientA, transactionIdentifier, pdu, pduLength) &&
+                             transactionIdentifier == 2 && pdu[0] == MODBUS_FC_READ_HOLDING_REGISTERS &&
+                             pduLength == 4 && ((pdu[2] << 8) | pdu[3]) == writtenValue,
+                             "A's read returns the value A wrote before it");
+
+    if (clientA >= 0) {
+        ::close(clientA);
+    }
+    if (clientB >= 0) {
+        ::close(clientB);
+    }
+    engine.stop();
+    engineThread.join();
+    gateway.close();
+    engine.removePort(portHandle);
+    mb.closeRtu(ctx);
+    simulator.stop();
+    ::close(simulatorFileDescriptor);
+    std::cout << (passed ? "gateway per-client ordering passed\n" : "gateway per-client ordering FAILED\n");
+    return passed ? 0 : 1;
+}